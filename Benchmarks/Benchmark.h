@@ -0,0 +1,43 @@
+//
+// Benchmark.h - Timing helpers shared by the benchmark programs
+//
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <limits>
+
+
+namespace Benchmark
+{
+    // Passing --quick shrinks every run to a smoke test; ctest runs the benchmarks that way.
+    inline bool IsQuickRun(int argc, char* argv[]) noexcept
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            if (std::strcmp(argv[i], "--quick") == 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Calls function repetitions times and returns the fastest call in nanoseconds.
+    // The fastest run is the one least disturbed by the rest of the machine.
+    template<typename Function>
+    double MeasureBestNs(int repetitions, Function&& function)
+    {
+        double best = std::numeric_limits<double>::max();
+        for (int i = 0; i < repetitions; i++)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            function();
+            const auto end = std::chrono::steady_clock::now();
+            best = std::min(best, std::chrono::duration<double, std::nano>(end - start).count());
+        }
+        return best;
+    }
+}
@@ -0,0 +1,138 @@
+//
+// CpuProfilerBenchmark.cpp - Cost of an empty nested ProfileScope on one thread and on many at once
+//
+
+#include "Benchmark.h"
+
+#include "CpuProfiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <thread>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    // The budget the profiler was built to: one scope, begin and end, on the recording thread.
+    const double c_BudgetNs = 50.0;
+
+    const unsigned c_ThreadCounts[] = { 1, 2, 4, 8, 16 };
+
+    // Scopes nested per iteration, as in a frame: Render, RenderGraph::Execute, a pass, a draw.
+    const size_t c_Depth = 4;
+
+    void RecordNestedScopes(CpuProfiler& profiler, size_t iterations)
+    {
+        for (size_t i = 0; i < iterations; i++)
+        {
+            ProfileScope render(profiler, "Render");
+            ProfileScope execute(profiler, "RenderGraph::Execute");
+            ProfileScope pass(profiler, "RenderGraph pass");
+            ProfileScope draw(profiler, "Draw");
+        }
+    }
+
+    // Every thread records its scopes at the same time, between two EndFrame calls so the rings never fill.
+    // Returns the best ns per scope of the slowest thread.
+    double MeasureScopeNs(CpuProfiler& profiler, unsigned threadCount, size_t iterations, int repetitions)
+    {
+        double best = std::numeric_limits<double>::max();
+        for (int repetition = 0; repetition < repetitions; repetition++)
+        {
+            std::atomic<unsigned> ready{ 0 };
+            std::atomic<bool> start{ false };
+            std::vector<double> threadNs(threadCount);
+
+            auto record = [&](unsigned thread)
+            {
+                // Register the thread's ring before the clock starts.
+                profiler.BeginScope("Warm up");
+                profiler.EndScope();
+
+                ready.fetch_add(1);
+                while (!start.load())
+                {
+                    std::this_thread::yield();
+                }
+
+                const auto begin = std::chrono::steady_clock::now();
+                RecordNestedScopes(profiler, iterations);
+                const auto end = std::chrono::steady_clock::now();
+                threadNs[thread] = std::chrono::duration<double, std::nano>(end - begin).count();
+            };
+
+            std::vector<std::thread> threads;
+            for (unsigned thread = 1; thread < threadCount; thread++)
+            {
+                threads.emplace_back(record, thread);
+            }
+            while (ready.load() != threadCount - 1)
+            {
+                std::this_thread::yield();
+            }
+            start.store(true);
+            record(0);
+            for (auto& thread : threads)
+            {
+                thread.join();
+            }
+
+            profiler.EndFrame();
+            best = std::min(best, *std::max_element(threadNs.begin(), threadNs.end()));
+        }
+
+        return best / double(iterations * c_Depth);
+    }
+
+    // Scopes begun while the profiler is disabled: the cost left in a shipping build that keeps the scopes.
+    double MeasureDisabledNs(CpuProfiler& profiler, size_t iterations, int repetitions)
+    {
+        profiler.SetEnabled(false);
+        const double ns = Benchmark::MeasureBestNs(repetitions, [&]() { RecordNestedScopes(profiler, iterations); });
+        profiler.SetEnabled(true);
+        return ns / double(iterations * c_Depth);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const bool quick = Benchmark::IsQuickRun(argc, argv);
+    const size_t iterations = quick ? 1000 : 100000;
+    const int repetitions = quick ? 1 : 10;
+
+    // Room for every event of a repetition, so no scope is dropped.
+    CpuProfiler profiler(iterations * c_Depth * 2 + 2, 1);
+
+    std::printf("CpuProfilerBenchmark: %u hardware threads, %zu iterations of %zu nested scopes per thread, budget %.0f ns/scope\n",
+                std::thread::hardware_concurrency(), iterations, c_Depth, c_BudgetNs);
+    std::printf("%8s %12s %8s\n", "threads", "ns/scope", "budget");
+
+    for (const unsigned threadCount : c_ThreadCounts)
+    {
+        // Threads sharing a core would measure each other's time slices, not the profiler.
+        if (threadCount > 1 && threadCount > std::thread::hardware_concurrency())
+        {
+            std::printf("%8u %12s\n", threadCount, "skipped");
+            continue;
+        }
+
+        const double ns = MeasureScopeNs(profiler, threadCount, iterations, repetitions);
+        std::printf("%8u %12.1f %8s\n", threadCount, ns, ns <= c_BudgetNs ? "ok" : "OVER");
+    }
+
+    std::printf("%8s %12.1f\n", "disabled", MeasureDisabledNs(profiler, iterations, repetitions));
+
+    if (profiler.GetDroppedScopeCount() != 0)
+    {
+        std::fprintf(stderr, "CpuProfilerBenchmark: %llu scopes dropped\n",
+                     static_cast<unsigned long long>(profiler.GetDroppedScopeCount()));
+        return EXIT_FAILURE;
+    }
+    return 0;
+}
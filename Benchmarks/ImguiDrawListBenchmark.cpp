@@ -0,0 +1,190 @@
+//
+// ImguiDrawListBenchmark.cpp - Scaling of the deferred ImGui draw list builds from 1 thread to all of them
+//
+
+#include "Benchmark.h"
+
+#include "JobSystem.h"
+
+#include "imgui.h"
+#include "backends/imgui_impl_headless.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    // A dashboard of plot windows, each drawn by a deferred draw list.
+    const int c_WindowCount = 24;
+    const int c_WarmUpFrames = 10;
+
+    struct Plot
+    {
+        int     pointCount;
+        float   phase;
+    };
+
+    // Four anti-aliased sine curves and a label across the window's clip rectangle.
+    void BuildPlot(ImDrawList* drawList, void* userData)
+    {
+        const Plot& plot = *static_cast<const Plot*>(userData);
+        const ImVec2 min = drawList->GetClipRectMin();
+        const ImVec2 max = drawList->GetClipRectMax();
+        for (int curve = 0; curve < 4; curve++)
+        {
+            drawList->PathClear();
+            for (int i = 0; i < plot.pointCount; i++)
+            {
+                const float x = min.x + (max.x - min.x) * float(i) / float(plot.pointCount);
+                const float y = (min.y + max.y) * 0.5f + std::sin(float(i) * 0.05f + plot.phase + float(curve)) * 40.f;
+                drawList->PathLineTo(ImVec2(x, y));
+            }
+            drawList->PathStroke(IM_COL32(255, 200, 0, 255), ImDrawFlags_None, 1.5f);
+        }
+        drawList->AddText(min, IM_COL32_WHITE, "deferred");
+    }
+
+    // io.RunDrawListJobsFn on a DX::JobSystem, one job per draw list, as ImguiLayerBase::SetJobSystem sets it up.
+    void RunJobs(void* userData, int count, void (*job)(void* jobData, int index), void* jobData)
+    {
+        static_cast<JobSystem*>(userData)->ParallelFor(size_t(count), 1, [job, jobData](size_t begin, size_t end)
+        {
+            for (size_t index = begin; index < end; index++)
+            {
+                job(jobData, int(index));
+            }
+        });
+    }
+
+    // FNV-1a over the draw data's vertices, indices and commands, to check that every thread count builds the same frame.
+    uint64_t HashDrawData(const ImDrawData* drawData, uint64_t hash)
+    {
+        const auto append = [&hash](const void* data, size_t size)
+        {
+            for (size_t i = 0; i < size; i++)
+            {
+                hash = (hash ^ static_cast<const unsigned char*>(data)[i]) * 1099511628211ull;
+            }
+        };
+
+        for (int list = 0; list < drawData->CmdListsCount; list++)
+        {
+            const ImDrawList* drawList = drawData->CmdLists[list];
+            append(drawList->VtxBuffer.Data, size_t(drawList->VtxBuffer.Size) * sizeof(ImDrawVert));
+            append(drawList->IdxBuffer.Data, size_t(drawList->IdxBuffer.Size) * sizeof(ImDrawIdx));
+            for (const ImDrawCmd& command : drawList->CmdBuffer)
+            {
+                append(&command.ClipRect, sizeof(command.ClipRect));
+                append(&command.ElemCount, sizeof(command.ElemCount));
+                append(&command.IdxOffset, sizeof(command.IdxOffset));
+                append(&command.VtxOffset, sizeof(command.VtxOffset));
+            }
+        }
+        return hash;
+    }
+
+    struct Result
+    {
+        double      frameNs;
+        double      renderNs;
+        int         verticesPerFrame;
+        uint64_t    hash;
+    };
+
+    Result Run(unsigned threadCount, int pointCount, int frameCount)
+    {
+        // The thread that calls ImGui::Render runs jobs too.
+        JobSystem jobSystem(threadCount - 1);
+
+        ImGui::CreateContext();
+        ImGuiIO& io = ImGui::GetIO();
+        io.IniFilename = nullptr;
+        io.RunDrawListJobsFn = RunJobs;
+        io.RunDrawListJobsUserData = &jobSystem;
+        ImGui_ImplHeadless_Init(ImVec2(1920.f, 1080.f));
+
+        std::vector<Plot> plots(c_WindowCount);
+        Result result = {};
+        result.hash = 14695981039346656037ull;
+        double renderNs = 0.0;
+        for (int frame = 0; frame < c_WarmUpFrames + frameCount; frame++)
+        {
+            if (frame == c_WarmUpFrames)
+            {
+                ImGui_ImplHeadless_ResetStats();
+                renderNs = 0.0;
+            }
+
+            ImGui_ImplHeadless_NewFrame();
+            ImGui::NewFrame();
+            for (int window = 0; window < c_WindowCount; window++)
+            {
+                char name[32];
+                std::snprintf(name, sizeof(name), "Plot %d", window);
+                ImGui::SetNextWindowPos(ImVec2(float(window % 6) * 310.f, float(window / 6) * 260.f), ImGuiCond_Always);
+                ImGui::SetNextWindowSize(ImVec2(300.f, 250.f), ImGuiCond_Always);
+                ImGui::Begin(name);
+                ImGui::Text("Window %d", window);
+                plots[window] = { pointCount, float(frame) * 0.1f + float(window) };
+                ImGui::AddDeferredDrawList(BuildPlot, &plots[window]);
+                ImGui::End();
+            }
+
+            const auto start = std::chrono::steady_clock::now();
+            ImGui::Render();
+            renderNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+            ImGui_ImplHeadless_RenderDrawData(ImGui::GetDrawData());
+            result.hash = HashDrawData(ImGui::GetDrawData(), result.hash);
+        }
+
+        const ImGui_ImplHeadless_FrameStats& total = ImGui_ImplHeadless_GetTotalStats();
+        result.frameNs = total.CpuTimeNs / double(total.Frames);
+        result.renderNs = renderNs / double(total.Frames);
+        result.verticesPerFrame = total.Vertices / total.Frames;
+
+        ImGui_ImplHeadless_Shutdown();
+        ImGui::DestroyContext();
+        return result;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const bool quick = Benchmark::IsQuickRun(argc, argv);
+    const int pointCount = quick ? 100 : 4000;
+    const int frameCount = quick ? 2 : 100;
+
+    // Up to twice the hardware threads, and at least 8.
+    const unsigned maxThreadCount = std::max(8u, 2 * std::thread::hardware_concurrency());
+
+    std::printf("ImguiDrawListBenchmark: %d windows of 4 x %d point plots, %u hardware threads, averages per frame\n",
+                c_WindowCount, pointCount, std::thread::hardware_concurrency());
+    std::printf("%8s %12s %12s %10s %8s\n", "threads", "frame ms", "Render ms", "vertices", "speedup");
+
+    Result singleThread = {};
+    for (unsigned threadCount = 1; threadCount <= maxThreadCount; threadCount *= 2)
+    {
+        const Result result = Run(threadCount, pointCount, frameCount);
+        if (threadCount == 1)
+        {
+            singleThread = result;
+        }
+        else if (result.hash != singleThread.hash)
+        {
+            std::fprintf(stderr, "ImguiDrawListBenchmark: %u threads built different draw data than 1 thread\n", threadCount);
+            std::exit(EXIT_FAILURE);
+        }
+
+        std::printf("%8u %12.3f %12.3f %10d %8.2f\n", threadCount, result.frameNs / 1e6, result.renderNs / 1e6,
+                    result.verticesPerFrame, singleThread.renderNs / result.renderNs);
+    }
+    return 0;
+}
@@ -0,0 +1,204 @@
+//
+// ImguiFontAtlasBenchmark.cpp - ImFontAtlas::Build at startup: rasterized on one thread or on the job system,
+// and with the build cache cold (rasterized and saved) or warm (loaded back)
+//
+// The repo ships no font file, so the built-in sets use the embedded ProggyClean. Pass a font with many glyphs,
+// e.g. a CJK one, to measure a realistic startup:
+//
+//     ./build/Benchmarks/ImguiFontAtlasBenchmark --font /usr/share/fonts/opentype/noto/NotoSansCJK-Regular.ttc
+//
+
+#include "Benchmark.h"
+
+#include "JobSystem.h"
+
+#include "imgui.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    const char* const c_CacheFilename = "ImguiFontAtlasBenchmark.cache";
+
+    // Every glyph of the Basic Multilingual Plane the font has.
+    const ImWchar c_AllGlyphRanges[] = { 0x0020, 0xFFFF, 0 };
+
+    struct FontSet
+    {
+        std::string name;
+        std::string path;   // Embedded ProggyClean when empty
+        std::vector<float> sizes;
+        int oversample;
+    };
+
+    // ImFontAtlas::BuildJobsFn on a DX::JobSystem, as ImguiLayerBase::SetJobSystem sets it up.
+    void RunJobs(void* userData, int count, void (*job)(void* jobData, int index), void* jobData)
+    {
+        static_cast<JobSystem*>(userData)->ParallelFor(size_t(count), 1, [job, jobData](size_t begin, size_t end)
+        {
+            for (size_t index = begin; index < end; index++)
+            {
+                job(jobData, int(index));
+            }
+        });
+    }
+
+    void AddFonts(ImFontAtlas& atlas, const FontSet& fontSet)
+    {
+        for (const float size : fontSet.sizes)
+        {
+            ImFontConfig config;
+            config.SizePixels = size;
+            config.OversampleH = fontSet.oversample;
+            config.OversampleV = fontSet.oversample > 1 ? 2 : 1;
+            if (fontSet.path.empty())
+            {
+                atlas.AddFontDefault(&config);
+            }
+            else if (!atlas.AddFontFromFileTTF(fontSet.path.c_str(), size, &config, c_AllGlyphRanges))
+            {
+                std::fprintf(stderr, "ImguiFontAtlasBenchmark: cannot load %s\n", fontSet.path.c_str());
+                std::exit(EXIT_FAILURE);
+            }
+        }
+    }
+
+    // FNV-1a over the texture and every glyph, to check that each way of building gives the same atlas.
+    uint64_t HashAtlas(const ImFontAtlas& atlas)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        const auto append = [&hash](const void* data, size_t size)
+        {
+            for (size_t i = 0; i < size; i++)
+            {
+                hash = (hash ^ static_cast<const unsigned char*>(data)[i]) * 1099511628211ull;
+            }
+        };
+
+        append(&atlas.TexWidth, sizeof(atlas.TexWidth));
+        append(&atlas.TexHeight, sizeof(atlas.TexHeight));
+        append(atlas.TexPixelsAlpha8, size_t(atlas.TexWidth) * size_t(atlas.TexHeight));
+        for (const ImFont* font : atlas.Fonts)
+        {
+            append(font->Glyphs.Data, size_t(font->Glyphs.size_in_bytes()));
+            append(&font->Ascent, sizeof(font->Ascent));
+            append(&font->Descent, sizeof(font->Descent));
+        }
+        return hash;
+    }
+
+    struct Build
+    {
+        double      ms;
+        int         glyphCount;
+        int         texWidth;
+        int         texHeight;
+        uint64_t    hash;
+    };
+
+    // Builds a new atlas of the font set and times ImFontAtlas::Build alone, not loading the fonts.
+    Build BuildAtlas(const FontSet& fontSet, JobSystem* jobSystem, bool useCache)
+    {
+        ImFontAtlas atlas;
+        AddFonts(atlas, fontSet);
+        atlas.BuildCacheFilename = useCache ? c_CacheFilename : nullptr;
+        atlas.BuildJobsFn = jobSystem ? RunJobs : nullptr;
+        atlas.BuildJobsUserData = jobSystem;
+
+        const auto start = std::chrono::steady_clock::now();
+        if (!atlas.Build())
+        {
+            std::fprintf(stderr, "ImguiFontAtlasBenchmark: %s failed to build\n", fontSet.name.c_str());
+            std::exit(EXIT_FAILURE);
+        }
+        Build build = {};
+        build.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        for (const ImFont* font : atlas.Fonts)
+        {
+            build.glyphCount += font->Glyphs.Size;
+        }
+        build.texWidth = atlas.TexWidth;
+        build.texHeight = atlas.TexHeight;
+        build.hash = HashAtlas(atlas);
+        return build;
+    }
+
+    void CheckSameAtlas(const FontSet& fontSet, const Build& build, const Build& reference, const char* mode)
+    {
+        if (build.hash != reference.hash)
+        {
+            std::fprintf(stderr, "ImguiFontAtlasBenchmark: %s built %s differs from one thread\n", fontSet.name.c_str(), mode);
+            std::exit(EXIT_FAILURE);
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const bool quick = Benchmark::IsQuickRun(argc, argv);
+    const int repetitions = quick ? 1 : 5;
+
+    std::vector<FontSet> fontSets =
+    {
+        { "ProggyClean 13px", "", { 13.f }, 1 },
+        { "ProggyClean 4 sizes 3x", "", { 13.f, 18.f, 26.f, 40.f }, 3 },
+    };
+    for (int i = 1; i + 1 < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--font") == 0)
+        {
+            fontSets.push_back({ std::filesystem::path(argv[i + 1]).filename().string() + " 18px 2x", argv[i + 1], { 18.f }, 2 });
+        }
+    }
+
+    // The thread that calls Build runs jobs too.
+    const unsigned threadCount = std::max(1u, std::thread::hardware_concurrency());
+    JobSystem jobSystem(threadCount - 1);
+
+    std::printf("ImguiFontAtlasBenchmark: ImFontAtlas::Build, %u threads on the job system, fastest of the runs in ms\n", threadCount);
+    std::printf("%-28s %8s %10s %10s %10s %10s %10s\n", "fonts", "glyphs", "texture", "1 thread", "jobs", "cold", "warm");
+
+    for (const auto& fontSet : fontSets)
+    {
+        Build reference = {};
+        double singleMs = 1e30, jobsMs = 1e30, coldMs = 1e30, warmMs = 1e30;
+        for (int repetition = 0; repetition < repetitions; repetition++)
+        {
+            const Build single = BuildAtlas(fontSet, nullptr, false);
+            reference = single;
+            singleMs = std::min(singleMs, single.ms);
+
+            const Build jobs = BuildAtlas(fontSet, &jobSystem, false);
+            CheckSameAtlas(fontSet, jobs, reference, "on the job system");
+            jobsMs = std::min(jobsMs, jobs.ms);
+
+            // Cold: no cache file, the build rasterizes on the job system and saves one.
+            std::remove(c_CacheFilename);
+            const Build cold = BuildAtlas(fontSet, &jobSystem, true);
+            CheckSameAtlas(fontSet, cold, reference, "with a cold cache");
+            coldMs = std::min(coldMs, cold.ms);
+
+            const Build warm = BuildAtlas(fontSet, &jobSystem, true);
+            CheckSameAtlas(fontSet, warm, reference, "from the cache");
+            warmMs = std::min(warmMs, warm.ms);
+        }
+        std::remove(c_CacheFilename);
+
+        char texture[32];
+        std::snprintf(texture, sizeof(texture), "%dx%d", reference.texWidth, reference.texHeight);
+        std::printf("%-28s %8d %10s %10.2f %10.2f %10.2f %10.2f\n", fontSet.name.c_str(), reference.glyphCount, texture,
+                    singleMs, jobsMs, coldMs, warmMs);
+    }
+    return 0;
+}
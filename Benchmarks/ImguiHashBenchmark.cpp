@@ -0,0 +1,222 @@
+//
+// ImguiHashBenchmark.cpp - ImHashStr and ImHashData throughput over a widget label corpus and large blocks
+//
+// Every ID is checked against the byte-at-a-time CRC32 that Dear ImGui used before, so .ini files stay compatible.
+//
+
+#include "Benchmark.h"
+
+#include "imgui.h"
+#include "imgui_internal.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+
+namespace
+{
+    ImU32 g_referenceTable[256];
+
+    // Receives every hash, so the measured loops are not optimized away.
+    volatile ImGuiID g_sink;
+
+    void InitReferenceTable()
+    {
+        for (ImU32 i = 0; i < 256; i++)
+        {
+            ImU32 crc = i;
+            for (int bit = 0; bit < 8; bit++)
+            {
+                crc = (crc >> 1) ^ ((crc & 1) ? 0xEDB88320u : 0u);
+            }
+            g_referenceTable[i] = crc;
+        }
+    }
+
+    // The previous ImHashData: one dependent table lookup per byte.
+    ImGuiID ReferenceHashData(const void* data, size_t dataSize, ImU32 seed)
+    {
+        ImU32 crc = ~seed;
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        while (dataSize-- != 0)
+        {
+            crc = (crc >> 8) ^ g_referenceTable[(crc & 0xFF) ^ *bytes++];
+        }
+        return ~crc;
+    }
+
+    // The previous ImHashStr on a zero-terminated string: "###" restarts the hash from the seed.
+    ImGuiID ReferenceHashStr(const char* str, ImU32 seed)
+    {
+        seed = ~seed;
+        ImU32 crc = seed;
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(str);
+        while (unsigned char c = *bytes++)
+        {
+            if (c == '#' && bytes[0] == '#' && bytes[1] == '#')
+            {
+                crc = seed;
+            }
+            crc = (crc >> 8) ^ g_referenceTable[(crc & 0xFF) ^ c];
+        }
+        return ~crc;
+    }
+
+    // Labels as an application passes them to widgets: plain captions, hidden "##" labels, "##" suffixes that
+    // disambiguate repeated captions, "###" window titles with a changing part, and the odd long sentence.
+    std::vector<std::string> MakeLabelCorpus(int count)
+    {
+        static const char* const c_Words[] =
+        {
+            "Color", "Size", "Enabled", "Value", "Name", "Open", "Delete", "Scale", "Speed", "Position",
+            "Rotation", "Visible", "Texture", "Filter", "Mode", "Items", "Advanced", "Reset", "Apply", "Layer",
+        };
+        const int wordCount = int(sizeof(c_Words) / sizeof(c_Words[0]));
+
+        std::vector<std::string> labels;
+        labels.reserve(count);
+        ImU32 random = 12345;
+        auto next = [&random](int range)
+        {
+            random = random * 1664525u + 1013904223u;
+            return int((random >> 8) % ImU32(range));
+        };
+        for (int i = 0; i < count; i++)
+        {
+            const std::string word = c_Words[next(wordCount)];
+            switch (next(10))
+            {
+            case 0:
+            case 1:
+            case 2:
+                labels.push_back(word);
+                break;
+            case 3:
+                labels.push_back("##" + word);
+                break;
+            case 4:
+            case 5:
+                labels.push_back(word + "##" + std::to_string(next(1000)));
+                break;
+            case 6:
+                labels.push_back(word + " " + c_Words[next(wordCount)]);
+                break;
+            case 7:
+                labels.push_back(word + " (" + std::to_string(next(100000)) + " ms)###" + word);
+                break;
+            case 8:
+                labels.push_back(word + "/" + c_Words[next(wordCount)] + "/" + c_Words[next(wordCount)]);
+                break;
+            default:
+                labels.push_back("Drag the " + word + " handle to change every selected " + c_Words[next(wordCount)]);
+                break;
+            }
+        }
+        return labels;
+    }
+
+    void Fail(const char* what)
+    {
+        std::fprintf(stderr, "ImguiHashBenchmark: %s differs from the byte-at-a-time CRC32\n", what);
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const bool quick = Benchmark::IsQuickRun(argc, argv);
+    const int labelCount = quick ? 1000 : 100000;
+    const int repetitions = quick ? 1 : 20;
+
+    InitReferenceTable();
+
+    const std::vector<std::string> labels = MakeLabelCorpus(labelCount);
+    size_t labelBytes = 0;
+    for (const auto& label : labels)
+    {
+        labelBytes += label.size();
+    }
+
+    // Each label is hashed with the ID of the one before as its seed, like widgets nested in an ID stack.
+    ImU32 seed = 0;
+    for (const auto& label : labels)
+    {
+        const ImGuiID id = ReferenceHashStr(label.c_str(), seed);
+        if (ImHashStr(label.c_str(), 0, seed) != id || ImHashStr(label.data(), label.size(), seed) != id)
+        {
+            Fail(label.c_str());
+        }
+        seed = id;
+    }
+
+    ImGuiID sink = 0;
+    const double zeroTerminatedNs = Benchmark::MeasureBestNs(repetitions, [&]()
+    {
+        for (const auto& label : labels)
+        {
+            sink += ImHashStr(label.c_str(), 0, sink);
+        }
+    });
+    const double lengthNs = Benchmark::MeasureBestNs(repetitions, [&]()
+    {
+        for (const auto& label : labels)
+        {
+            sink += ImHashStr(label.data(), label.size(), sink);
+        }
+    });
+    const double referenceNs = Benchmark::MeasureBestNs(repetitions, [&]()
+    {
+        for (const auto& label : labels)
+        {
+            sink += ReferenceHashStr(label.c_str(), sink);
+        }
+    });
+
+    // PushID(int) and PushID(const void*) hash 4 and 8 bytes.
+    const double scalarNs = Benchmark::MeasureBestNs(repetitions, [&]()
+    {
+        for (int i = 0; i < labelCount; i++)
+        {
+            const void* pointer = &labels[i];
+            sink = ImHashData(&i, sizeof(i), sink);
+            sink = ImHashData(&pointer, sizeof(pointer), sink);
+        }
+    });
+
+    // Large blocks, e.g. the text layout cache keys.
+    std::vector<unsigned char> block(quick ? 4096 : 1 << 20);
+    for (size_t i = 0; i < block.size(); i++)
+    {
+        block[i] = static_cast<unsigned char>(i * 31 + (i >> 8));
+    }
+    for (size_t offset = 0; offset < 8; offset++)
+    {
+        const size_t size = block.size() - offset - 3;
+        if (ImHashData(block.data() + offset, size, 0x1234) != ReferenceHashData(block.data() + offset, size, 0x1234))
+        {
+            Fail("ImHashData on an unaligned block");
+        }
+    }
+    const double blockNs = Benchmark::MeasureBestNs(repetitions, [&]()
+    {
+        sink = ImHashData(block.data(), block.size(), sink);
+    });
+    const double referenceBlockNs = Benchmark::MeasureBestNs(repetitions, [&]()
+    {
+        sink = ReferenceHashData(block.data(), block.size(), sink);
+    });
+
+    std::printf("ImguiHashBenchmark: %d labels, %.1f bytes on average, fastest of the runs\n", labelCount, double(labelBytes) / labelCount);
+    std::printf("%-32s %12s %12s\n", "hash", "ns/label", "MB/s");
+    std::printf("%-32s %12.2f %12.1f\n", "ImHashStr, zero-terminated", zeroTerminatedNs / labelCount, labelBytes * 1e3 / zeroTerminatedNs);
+    std::printf("%-32s %12.2f %12.1f\n", "ImHashStr, with length", lengthNs / labelCount, labelBytes * 1e3 / lengthNs);
+    std::printf("%-32s %12.2f %12.1f\n", "byte-at-a-time, zero-terminated", referenceNs / labelCount, labelBytes * 1e3 / referenceNs);
+    std::printf("%-32s %12.2f\n", "ImHashData, int + pointer", scalarNs / labelCount);
+    std::printf("%-32s %12s %12.1f\n", "ImHashData, block", "", block.size() * 1e3 / blockNs);
+    std::printf("%-32s %12s %12.1f\n", "byte-at-a-time, block", "", block.size() * 1e3 / referenceBlockNs);
+
+    g_sink = sink;
+    return 0;
+}
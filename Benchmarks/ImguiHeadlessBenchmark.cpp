@@ -0,0 +1,168 @@
+//
+// ImguiHeadlessBenchmark.cpp - CPU cost per frame of the Dear ImGui demo window, on the headless backend
+//
+
+#include "Benchmark.h"
+
+#include "imgui.h"
+#include "backends/imgui_impl_headless.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+
+namespace
+{
+    const ImVec2 c_DisplaySize(1280.f, 720.f);
+
+    // Frames run before the statistics are reset, so building the font atlas and first-use allocations are not measured.
+    const int c_WarmUpFrames = 30;
+
+    // The demo window opens at (650, 20) with a size of 550 x 680; its collapsing headers start about 60 pixels down.
+    const float c_DemoLeft = 650.f;
+    const float c_DemoTop = 20.f;
+
+    void QueueMousePos(int frame, float x, float y)
+    {
+        ImGui_ImplHeadless_InputEvent inputEvent = {};
+        inputEvent.Frame = frame;
+        inputEvent.Type = ImGui_ImplHeadless_InputType_MousePos;
+        inputEvent.MousePos = ImVec2(x, y);
+        ImGui_ImplHeadless_QueueInputEvent(inputEvent);
+    }
+
+    void QueueMouseButton(int frame, bool down)
+    {
+        ImGui_ImplHeadless_InputEvent inputEvent = {};
+        inputEvent.Frame = frame;
+        inputEvent.Type = ImGui_ImplHeadless_InputType_MouseButton;
+        inputEvent.Index = 0;
+        inputEvent.Down = down;
+        ImGui_ImplHeadless_QueueInputEvent(inputEvent);
+    }
+
+    void QueueMouseWheel(int frame, float wheel)
+    {
+        ImGui_ImplHeadless_InputEvent inputEvent = {};
+        inputEvent.Frame = frame;
+        inputEvent.Type = ImGui_ImplHeadless_InputType_MouseWheel;
+        inputEvent.Wheel = wheel;
+        ImGui_ImplHeadless_QueueInputEvent(inputEvent);
+    }
+
+    void QueueChar(int frame, ImWchar c)
+    {
+        ImGui_ImplHeadless_InputEvent inputEvent = {};
+        inputEvent.Frame = frame;
+        inputEvent.Type = ImGui_ImplHeadless_InputType_Char;
+        inputEvent.Char = c;
+        ImGui_ImplHeadless_QueueInputEvent(inputEvent);
+    }
+
+    // Nothing happens: the cost of rebuilding an unchanged UI.
+    void QueueNoInput(int)
+    {
+    }
+
+    // A user exploring the demo: the mouse sweeps over the window, clicks the headers down its left edge open and
+    // closed, scrolls, and types into whatever has focus.
+    void QueueExploringInput(int frameCount)
+    {
+        for (int frame = 0; frame < frameCount; frame++)
+        {
+            const int phase = frame % 120;
+            if (phase < 60)
+            {
+                QueueMousePos(frame, c_DemoLeft + 40.f + 8.f * float(phase), c_DemoTop + 60.f + 4.f * float(phase));
+            }
+            else if (phase % 10 == 0)
+            {
+                // Headers are about 23 pixels apart.
+                const float y = c_DemoTop + 60.f + 23.f * float((frame / 10) % 12);
+                QueueMousePos(frame, c_DemoLeft + 40.f, y);
+                QueueMouseButton(frame + 1, true);
+                QueueMouseButton(frame + 2, false);
+            }
+            else if (phase % 10 == 5)
+            {
+                QueueMouseWheel(frame, phase < 90 ? -1.f : 1.f);
+                QueueChar(frame, ImWchar('a' + frame % 26));
+            }
+        }
+    }
+
+    struct Scenario
+    {
+        const char*     name;
+        void            (*queueInput)(int frameCount);
+    };
+
+    const Scenario c_Scenarios[] =
+    {
+        { "idle",       QueueNoInput },
+        { "exploring",  QueueExploringInput },
+    };
+
+    // Runs NewFrame, ShowDemoWindow and Render in a fresh context and prints the averages per measured frame.
+    void Run(const Scenario& scenario, int frameCount)
+    {
+        ImGui::CreateContext();
+        ImGuiIO& io = ImGui::GetIO();
+        io.ConfigFlags |= ImGuiConfigFlags_DockingEnable | ImGuiConfigFlags_NavEnableKeyboard;
+        io.IniFilename = nullptr;
+        ImGui_ImplHeadless_Init(c_DisplaySize);
+
+        scenario.queueInput(c_WarmUpFrames + frameCount);
+
+        double maxFrameNs = 0.0;
+        for (int frame = 0; frame < c_WarmUpFrames + frameCount; frame++)
+        {
+            if (frame == c_WarmUpFrames)
+            {
+                ImGui_ImplHeadless_ResetStats();
+            }
+
+            ImGui_ImplHeadless_NewFrame();
+            ImGui::NewFrame();
+            ImGui::ShowDemoWindow();
+            ImGui::Render();
+            ImGui_ImplHeadless_RenderDrawData(ImGui::GetDrawData());
+
+            if (frame >= c_WarmUpFrames)
+            {
+                maxFrameNs = std::max(maxFrameNs, ImGui_ImplHeadless_GetLastFrameStats().CpuTimeNs);
+            }
+        }
+
+        const ImGui_ImplHeadless_FrameStats& total = ImGui_ImplHeadless_GetTotalStats();
+        if (total.Frames != frameCount || total.Vertices == 0 || total.DrawCalls == 0)
+        {
+            std::fprintf(stderr, "ImguiHeadlessBenchmark: %s measured %d frames with %d vertices\n", scenario.name, total.Frames, total.Vertices);
+            std::exit(EXIT_FAILURE);
+        }
+
+        const double frames = double(total.Frames);
+        std::printf("%-10s %7d %10.0f %10.0f %10.0f %10.0f %8.1f %8.2f\n", scenario.name, total.Frames,
+                    total.CpuTimeNs / frames, maxFrameNs, double(total.Vertices) / frames, double(total.Indices) / frames,
+                    double(total.DrawCalls) / frames, double(total.Allocations) / frames);
+
+        ImGui_ImplHeadless_Shutdown();
+        ImGui::DestroyContext();
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const int frameCount = Benchmark::IsQuickRun(argc, argv) ? 10 : 1000;
+
+    std::printf("ImguiHeadlessBenchmark: ImGui::ShowDemoWindow at %.0f x %.0f, averages per frame after %d warm-up frames\n",
+                c_DisplaySize.x, c_DisplaySize.y, c_WarmUpFrames);
+    std::printf("%-10s %7s %10s %10s %10s %10s %8s %8s\n", "input", "frames", "ns", "max ns", "vertices", "indices", "draws", "allocs");
+
+    for (const auto& scenario : c_Scenarios)
+    {
+        Run(scenario, frameCount);
+    }
+    return 0;
+}
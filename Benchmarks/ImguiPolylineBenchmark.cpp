@@ -0,0 +1,102 @@
+//
+// ImguiPolylineBenchmark.cpp - Anti-aliased ImDrawList::AddPolyline tessellation from 10k to 1M points
+//
+// Configure with -DCMAKE_CXX_FLAGS=-DIMGUI_DISABLE_SSE to measure the scalar path.
+//
+
+#include "Benchmark.h"
+
+#include "imgui.h"
+#include "imgui_internal.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+
+namespace
+{
+    // A line mode of AddPolyline: thin lines take the 1-pixel fringe path, textured ones sample ImFontAtlas's baked lines.
+    struct LineStyle
+    {
+        const char*     name;
+        float           thickness;
+        ImDrawListFlags flags;
+    };
+
+    const LineStyle c_LineStyles[] =
+    {
+        { "thin",       1.f,    ImDrawListFlags_AntiAliasedLines },
+        { "thick",      3.f,    ImDrawListFlags_AntiAliasedLines },
+        { "textured",   3.f,    ImDrawListFlags_AntiAliasedLines | ImDrawListFlags_AntiAliasedLinesUseTex },
+    };
+
+    // A plot-like sine wave, so consecutive segments turn by small angles as in a chart.
+    std::vector<ImVec2> MakePlot(int pointCount)
+    {
+        std::vector<ImVec2> points(pointCount);
+        for (int i = 0; i < pointCount; i++)
+        {
+            points[i] = ImVec2(float(i) * 0.01f, std::sin(float(i) * 0.05f) * 100.f);
+        }
+        return points;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const bool quick = Benchmark::IsQuickRun(argc, argv);
+    const std::vector<int> pointCounts = quick ? std::vector<int>{ 1000 } : std::vector<int>{ 10000, 100000, 1000000 };
+
+    // What ImFontAtlas::Build sets up for a draw list: a white pixel and the baked line textures.
+    ImDrawListSharedData sharedData;
+    sharedData.TexUvWhitePixel = ImVec2(0.5f, 0.5f);
+    ImVec4 texUvLines[IM_DRAWLIST_TEX_LINES_WIDTH_MAX + 1];
+    for (int width = 0; width <= IM_DRAWLIST_TEX_LINES_WIDTH_MAX; width++)
+    {
+        texUvLines[width] = ImVec4(0.f, float(width) / 64.f, 1.f, float(width) / 64.f);
+    }
+    sharedData.TexUvLines = texUvLines;
+
+    ImDrawList drawList(&sharedData);
+
+#ifdef IMGUI_DISABLE_SSE
+    std::printf("ImguiPolylineBenchmark: scalar path, fastest of the runs\n");
+#else
+    std::printf("ImguiPolylineBenchmark: SSE2 path, fastest of the runs\n");
+#endif
+    std::printf("%-10s %10s %12s %12s %12s\n", "style", "points", "ns/point", "vertices", "closed ns/pt");
+
+    for (const auto& style : c_LineStyles)
+    {
+        for (const int pointCount : pointCounts)
+        {
+            const std::vector<ImVec2> points = MakePlot(pointCount);
+            const int repetitions = quick ? 1 : std::max(3, 20000000 / pointCount);
+
+            double nsPerPoint[2] = {};
+            for (int closed = 0; closed < 2; closed++)
+            {
+                const ImDrawFlags flags = closed ? ImDrawFlags_Closed : ImDrawFlags_None;
+                const double ns = Benchmark::MeasureBestNs(repetitions, [&]()
+                {
+                    // Keeps the buffers' capacity, like a draw list from one frame to the next.
+                    drawList._ResetForNewFrame();
+                    drawList.Flags = style.flags;
+                    drawList.AddPolyline(points.data(), pointCount, IM_COL32(255, 200, 0, 255), flags, style.thickness);
+                });
+                nsPerPoint[closed] = ns / double(pointCount);
+            }
+
+            if (drawList.VtxBuffer.Size < pointCount * 2)
+            {
+                std::fprintf(stderr, "ImguiPolylineBenchmark: %d vertices for %d points\n", drawList.VtxBuffer.Size, pointCount);
+                std::exit(EXIT_FAILURE);
+            }
+
+            std::printf("%-10s %10d %12.2f %12d %12.2f\n", style.name, pointCount, nsPerPoint[0], drawList.VtxBuffer.Size, nsPerPoint[1]);
+        }
+    }
+    return 0;
+}
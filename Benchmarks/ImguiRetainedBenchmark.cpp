@@ -0,0 +1,126 @@
+//
+// ImguiRetainedBenchmark.cpp - CPU cost per frame of rebuilding the UI every frame versus ImguiLayerBase's retained mode
+//
+
+#include "Benchmark.h"
+
+#include "CpuProfiler.h"
+#include "ImguiLayerBase.h"
+
+#include "imgui.h"
+#include "backends/imgui_impl_headless.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+
+namespace
+{
+    const int c_Width = 1280;
+    const int c_Height = 720;
+
+    // Frames run before the statistics are reset: the font atlas build and the first builds, before retained mode
+    // has seen two identical frames.
+    const int c_WarmUpFrames = 30;
+
+    // The demo window alone: the demo layer's profiler window changes with every frame's timings, so it is never reused.
+    class DemoWindowLayer : public ImguiLayerBase
+    {
+    public:
+        void CreateGUI() override { ImGui::ShowDemoWindow(); }
+    };
+
+    // How often the mouse moves, over an empty part of the screen, so only the input changes and not the UI.
+    struct Scenario
+    {
+        const char*     name;
+        int             inputInterval;      // frames between mouse moves, 0 for none
+    };
+
+    const Scenario c_Scenarios[] =
+    {
+        { "idle",           0 },
+        { "input 2/s",      30 },
+        { "input 20/s",     3 },
+        { "input always",   1 },
+    };
+
+    struct Result
+    {
+        double      nsPerFrame;
+        double      allocationsPerFrame;
+        uint64_t    rebuiltFrames;
+        uint64_t    reusedFrames;
+    };
+
+    Result Run(const Scenario& scenario, bool retained, int frameCount)
+    {
+        DemoWindowLayer layer;
+        ImGui::GetIO().IniFilename = nullptr;
+        layer.OnHeadlessCreated(c_Width, c_Height);
+        layer.SetRetainedMode(retained);
+
+        if (scenario.inputInterval != 0)
+        {
+            for (int frame = 0; frame < c_WarmUpFrames + frameCount; frame += scenario.inputInterval)
+            {
+                ImGui_ImplHeadless_InputEvent inputEvent = {};
+                inputEvent.Frame = frame;
+                inputEvent.Type = ImGui_ImplHeadless_InputType_MousePos;
+                inputEvent.MousePos = ImVec2(20.f + float(frame % 2), float(c_Height - 20));
+                ImGui_ImplHeadless_QueueInputEvent(inputEvent);
+            }
+        }
+
+        uint64_t rebuiltBefore = 0;
+        uint64_t reusedBefore = 0;
+        for (int frame = 0; frame < c_WarmUpFrames + frameCount; frame++)
+        {
+            if (frame == c_WarmUpFrames)
+            {
+                ImGui_ImplHeadless_ResetStats();
+                rebuiltBefore = layer.GetRebuiltFrameCount();
+                reusedBefore = layer.GetReusedFrameCount();
+            }
+
+            layer.OnNewFrame();
+            layer.OnRecord(nullptr);
+            DX::CpuProfiler::GetInstance().EndFrame();
+        }
+
+        const ImGui_ImplHeadless_FrameStats& total = ImGui_ImplHeadless_GetTotalStats();
+        Result result = {};
+        result.nsPerFrame = total.CpuTimeNs / double(total.Frames);
+        result.allocationsPerFrame = double(total.Allocations) / double(total.Frames);
+        result.rebuiltFrames = layer.GetRebuiltFrameCount() - rebuiltBefore;
+        result.reusedFrames = layer.GetReusedFrameCount() - reusedBefore;
+
+        if (result.rebuiltFrames + result.reusedFrames != uint64_t(frameCount) || (!retained && result.reusedFrames != 0))
+        {
+            std::fprintf(stderr, "ImguiRetainedBenchmark: %s counted %llu rebuilt and %llu reused frames of %d\n", scenario.name,
+                         (unsigned long long)result.rebuiltFrames, (unsigned long long)result.reusedFrames, frameCount);
+            std::exit(EXIT_FAILURE);
+        }
+        return result;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const int frameCount = Benchmark::IsQuickRun(argc, argv) ? 10 : 1000;
+
+    std::printf("ImguiRetainedBenchmark: ImGui::ShowDemoWindow through ImguiLayerBase at %d x %d, 60 Hz, after %d warm-up frames\n",
+                c_Width, c_Height, c_WarmUpFrames);
+    std::printf("%-13s %12s %12s %10s %10s %12s %8s\n", "input", "rebuild ns", "retained ns", "rebuilt", "reused", "allocs", "speedup");
+
+    for (const auto& scenario : c_Scenarios)
+    {
+        const Result rebuild = Run(scenario, false, frameCount);
+        const Result retained = Run(scenario, true, frameCount);
+
+        std::printf("%-13s %12.0f %12.0f %10llu %10llu %5.2f/%5.2f %8.2f\n", scenario.name, rebuild.nsPerFrame, retained.nsPerFrame,
+                    (unsigned long long)retained.rebuiltFrames, (unsigned long long)retained.reusedFrames,
+                    rebuild.allocationsPerFrame, retained.allocationsPerFrame, rebuild.nsPerFrame / retained.nsPerFrame);
+    }
+    return 0;
+}
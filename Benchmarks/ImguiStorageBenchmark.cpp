@@ -0,0 +1,153 @@
+//
+// ImguiStorageBenchmark.cpp - ImGuiStorage insertion, lookup and iteration from 100 to 1M keys
+//
+// Built twice: ImguiStorageBenchmark measures the default sorted vector, ImguiOpenAddressingStorageBenchmark
+// the same code on Dear ImGui built with IMGUI_USE_OPEN_ADDRESSING_STORAGE.
+//
+
+#include "Benchmark.h"
+
+#include "imgui.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+
+namespace
+{
+#ifdef IMGUI_USE_OPEN_ADDRESSING_STORAGE
+    const char* const c_EngineName = "open addressing";
+
+    // Inserting one key at a time stays O(1) at every size.
+    const int c_MaxIncrementalInsertKeys = INT32_MAX;
+
+    size_t GetStorageBytes(const ImGuiStorage& storage)
+    {
+        return size_t(storage.Data.size_in_bytes()) + size_t(storage.Keys.size_in_bytes());
+    }
+#else
+    const char* const c_EngineName = "sorted vector";
+
+    // Every insertion shifts the tail: a million keys inserted one at a time would take hours, so larger
+    // storages are built the way ImGuiStorage documents for a full rebuild, appended then sorted once.
+    const int c_MaxIncrementalInsertKeys = 100000;
+
+    size_t GetStorageBytes(const ImGuiStorage& storage)
+    {
+        return size_t(storage.Data.size_in_bytes());
+    }
+#endif
+
+    // Receives every lookup, so the measured loops are not optimized away.
+    volatile int64_t g_sink;
+
+    // Distinct random IDs, as ImHashStr gives them. xorshift never yields 0, the ID of no item.
+    std::vector<ImGuiID> MakeKeys(int count)
+    {
+        std::vector<ImGuiID> keys(count);
+        ImU32 random = 12345;
+        for (auto& key : keys)
+        {
+            random ^= random << 13;
+            random ^= random >> 17;
+            random ^= random << 5;
+            key = random;
+        }
+        return keys;
+    }
+
+    void Fail(const char* what, int keyCount)
+    {
+        std::fprintf(stderr, "ImguiStorageBenchmark: %s failed with %d keys\n", what, keyCount);
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const bool quick = Benchmark::IsQuickRun(argc, argv);
+    const std::vector<int> keyCounts = quick ? std::vector<int>{ 100, 1000 } : std::vector<int>{ 100, 1000, 10000, 100000, 1000000 };
+    const int lookupCount = quick ? 10000 : 2000000;
+
+    std::printf("ImguiStorageBenchmark: %s, random keys, fastest of the runs\n", c_EngineName);
+    std::printf("%8s %10s %12s %12s %14s %12s\n", "keys", "insert", "ns/insert", "ns/lookup", "ns/key iterate", "bytes/key");
+
+    int64_t sink = 0;
+    for (const int keyCount : keyCounts)
+    {
+        const std::vector<ImGuiID> keys = MakeKeys(keyCount);
+        const bool bulk = keyCount > c_MaxIncrementalInsertKeys;
+        const int repetitions = quick ? 1 : std::max(1, 1000000 / keyCount);
+
+        ImGuiStorage storage;
+        const double insertNs = Benchmark::MeasureBestNs(repetitions, [&]()
+        {
+            storage.Clear();
+            if (bulk)
+            {
+                for (const ImGuiID key : keys)
+                {
+                    storage.Data.push_back(ImGuiStorage::ImGuiStoragePair(key, int(key)));
+                }
+                storage.BuildSortByKey();
+            }
+            else
+            {
+                for (const ImGuiID key : keys)
+                {
+                    storage.SetInt(key, int(key));
+                }
+            }
+        });
+
+        for (const ImGuiID key : keys)
+        {
+            if (storage.GetInt(key, 0) != int(key))
+            {
+                Fail("Lookup", keyCount);
+            }
+        }
+
+        // Strided through the keys, so large storages miss the cache as a window's tree nodes would.
+        const double lookupNs = Benchmark::MeasureBestNs(quick ? 1 : 5, [&]()
+        {
+            for (int i = 0; i < lookupCount; i++)
+            {
+                sink += storage.GetInt(keys[size_t(i) * 7919 % size_t(keyCount)]);
+            }
+        });
+
+        // What SetAllInt and the .ini writers do: walk every pair.
+        const int iterations = std::max(1, lookupCount / keyCount);
+        int64_t sum = 0;
+        const double iterateNs = Benchmark::MeasureBestNs(quick ? 1 : 5, [&]()
+        {
+            sum = 0;
+            for (int iteration = 0; iteration < iterations; iteration++)
+            {
+                for (const auto& pair : storage.Data)
+                {
+                    sum += pair.val_i;
+                }
+            }
+        });
+        int64_t expectedSum = 0;
+        for (const ImGuiID key : keys)
+        {
+            expectedSum += int(key);
+        }
+        if (sum != expectedSum * iterations)
+        {
+            Fail("Iteration", keyCount);
+        }
+        sink += sum;
+
+        std::printf("%8d %10s %12.1f %12.1f %14.2f %12.1f\n", keyCount, bulk ? "bulk" : "one by one", insertNs / keyCount,
+                    lookupNs / lookupCount, iterateNs / (double(iterations) * keyCount), double(GetStorageBytes(storage)) / keyCount);
+    }
+
+    g_sink = sink;
+    return 0;
+}
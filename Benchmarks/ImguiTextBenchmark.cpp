@@ -0,0 +1,278 @@
+//
+// ImguiTextBenchmark.cpp - Text measurement over a long log, uncached and through the text layout cache of CalcTextSize
+//
+// Every cached size is checked against ImFont::CalcTextSizeA measuring the same text, including texts of the same length
+// which differ in a few bytes or even hash the same. The embedded ProggyClean is monospace; pass a proportional font to measure one:
+//
+//     ./build/Benchmarks/ImguiTextBenchmark --font /usr/share/fonts/truetype/dejavu/DejaVuSans.ttf
+//
+
+#include "Benchmark.h"
+
+#include "imgui.h"
+#include "imgui_internal.h"
+#include "backends/imgui_impl_headless.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+
+
+namespace
+{
+    const ImVec2 c_DisplaySize(1280.f, 720.f);
+    const float c_WrapWidth = 800.f;
+
+    // Receives every size, so the measured loops are not optimized away.
+    volatile float g_sink;
+
+    // Lines as a game's log window shows them: a timestamp, a level, a system and a sentence with numbers.
+    std::string MakeLog(int lineCount)
+    {
+        static const char* const c_Levels[] = { "info", "warn", "debug", "error" };
+        static const char* const c_Systems[] = { "Renderer", "JobSystem", "Audio", "Network", "Physics" };
+
+        std::string log;
+        ImU32 random = 12345;
+        for (int line = 0; line < lineCount; line++)
+        {
+            random = random * 1664525u + 1013904223u;
+            char buffer[256];
+            std::snprintf(buffer, sizeof(buffer), "[%02d:%02d:%02d.%03u] [%s] %s: frame %d took %.3f ms, %u draw calls, queue depth %u; retrying upload of buffer #%u.\n",
+                          line / 3600 % 24, line / 60 % 60, line % 60, random % 1000, c_Levels[random % 4], c_Systems[(random >> 4) % 5],
+                          line, double(random % 10000) / 1000.0, (random >> 8) % 5000, (random >> 12) % 64, (random >> 16) % 100000);
+            log += buffer;
+        }
+        return log;
+    }
+
+    // The log with one more line break, and 4 bytes of its first line changed so that ImHashData gives the same hash with any
+    // seed. ImHashData is a CRC32, so hash(a) ^ hash(b) only depends on a ^ b for texts of the same length: the 4 bytes are
+    // solved for by Gaussian elimination over the 32 bits the hash changes by when each of their bits is flipped.
+    std::string MakeHashCollision(const std::string& text)
+    {
+        const size_t lineBreakOffset = text.size() / 2;
+        const size_t patchOffset = 4;
+        std::string collision = text;
+        collision[lineBreakOffset] = '\n';
+
+        const auto hash = [](const std::string& data) { return ImHashData(data.data(), data.size(), 0); };
+        const ImU32 target = hash(collision) ^ hash(text);
+        ImU32 rows[32];
+        ImU32 patches[32];
+        for (int bit = 0; bit < 32; bit++)
+        {
+            std::string flipped = text;
+            flipped[patchOffset + bit / 8] ^= char(1 << (bit % 8));
+            rows[bit] = hash(flipped) ^ hash(text);
+            patches[bit] = 1u << bit;
+        }
+
+        // Reduce the rows to one per hash bit, then combine the patches of the bits set in target.
+        for (int bit = 0; bit < 32; bit++)
+        {
+            const ImU32 mask = 1u << bit;
+            int pivot = bit;
+            while (pivot < 32 && !(rows[pivot] & mask))
+            {
+                pivot++;
+            }
+            if (pivot == 32)
+            {
+                std::fprintf(stderr, "ImguiTextBenchmark: cannot make a hash collision\n");
+                std::exit(EXIT_FAILURE);
+            }
+            std::swap(rows[bit], rows[pivot]);
+            std::swap(patches[bit], patches[pivot]);
+            for (int row = 0; row < 32; row++)
+            {
+                if (row != bit && (rows[row] & mask))
+                {
+                    rows[row] ^= rows[bit];
+                    patches[row] ^= patches[bit];
+                }
+            }
+        }
+        ImU32 patch = 0;
+        for (int bit = 0; bit < 32; bit++)
+        {
+            if (target & (1u << bit))
+            {
+                patch ^= patches[bit];
+            }
+        }
+        for (size_t byte = 0; byte < 4; byte++)
+        {
+            collision[patchOffset + byte] ^= char(patch >> (byte * 8));
+        }
+        if (hash(collision) != hash(text) || ImHashData(collision.data(), collision.size(), 0x1234) != ImHashData(text.data(), text.size(), 0x1234))
+        {
+            std::fprintf(stderr, "ImguiTextBenchmark: the hash collision does not collide\n");
+            std::exit(EXIT_FAILURE);
+        }
+        return collision;
+    }
+
+    // What ImGui::CalcTextSize returns: ImFont::CalcTextSizeA with the width rounded up.
+    ImVec2 MeasureUncached(const std::string& text, float wrapWidth)
+    {
+        const ImVec2 size = ImGui::GetFont()->CalcTextSizeA(ImGui::GetFontSize(), FLT_MAX, wrapWidth, text.data(), text.data() + text.size());
+        return ImVec2(std::floor(size.x + 0.99999f), size.y);
+    }
+
+    void CheckSize(const std::string& text, float wrapWidth, const char* what)
+    {
+        const ImVec2 cached = ImGui::CalcTextSize(text.data(), text.data() + text.size(), false, wrapWidth);
+        const ImVec2 expected = MeasureUncached(text, wrapWidth);
+        if (cached.x != expected.x || cached.y != expected.y)
+        {
+            std::fprintf(stderr, "ImguiTextBenchmark: CalcTextSize of %s measured %.1f x %.1f instead of %.1f x %.1f\n",
+                         what, cached.x, cached.y, expected.x, expected.y);
+            std::exit(EXIT_FAILURE);
+        }
+    }
+
+    void BeginFrame()
+    {
+        ImGui_ImplHeadless_NewFrame();
+        ImGui::NewFrame();
+        ImGui::SetNextWindowPos(ImVec2(0.f, 0.f), ImGuiCond_Always);
+        ImGui::SetNextWindowSize(ImVec2(900.f, 700.f), ImGuiCond_Always);
+        ImGui::Begin("Log");
+    }
+
+    void EndFrame()
+    {
+        ImGui::End();
+        ImGui::Render();
+        ImGui_ImplHeadless_RenderDrawData(ImGui::GetDrawData());
+    }
+
+    void PrintRow(const char* name, double ns, size_t bytes)
+    {
+        std::printf("%-36s %12.3f %12.1f\n", name, ns / 1e6, double(bytes) * 1e3 / ns);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const bool quick = Benchmark::IsQuickRun(argc, argv);
+    const int repetitions = quick ? 1 : 20;
+    const std::string log = MakeLog(quick ? 300 : 3000);
+
+    ImGui::CreateContext();
+    ImGuiIO& io = ImGui::GetIO();
+    io.IniFilename = nullptr;
+    const char* fontName = "ProggyClean 13px";
+    for (int i = 1; i + 1 < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--font") == 0)
+        {
+            if (!io.Fonts->AddFontFromFileTTF(argv[i + 1], 16.f))
+            {
+                std::fprintf(stderr, "ImguiTextBenchmark: cannot load %s\n", argv[i + 1]);
+                return EXIT_FAILURE;
+            }
+            fontName = argv[i + 1];
+        }
+    }
+    ImGui_ImplHeadless_Init(c_DisplaySize);
+
+    // Measured once, then found in the cache: over several frames, so the layouts also survive the garbage collection.
+    for (int frame = 0; frame < 3; frame++)
+    {
+        BeginFrame();
+        CheckSize(log, 0.f, "the log");
+        CheckSize(log, c_WrapWidth, "the wrapped log");
+        EndFrame();
+    }
+
+    // Texts of the same length as the log which differ in a few bytes must not get its layout. Spaces turned into
+    // underscores join words, which changes where the wrapped lines break.
+    BeginFrame();
+    std::string edited = log;
+    for (size_t offset = 0; offset < edited.size(); offset += edited.size() / 7)
+    {
+        edited[offset] = edited[offset] == ' ' ? '_' : ' ';
+        CheckSize(edited, 0.f, "an edited log");
+        CheckSize(edited, c_WrapWidth, "an edited wrapped log");
+    }
+    EndFrame();
+
+    // Nor a text which hashes the same: it is measured, and replaces the layout of the log.
+    const std::string collision = MakeHashCollision(log);
+    for (int frame = 0; frame < 2; frame++)
+    {
+        BeginFrame();
+        CheckSize(log, 0.f, "the log");
+        CheckSize(collision, 0.f, "a text hashing as the log");
+        CheckSize(log, c_WrapWidth, "the wrapped log");
+        CheckSize(collision, c_WrapWidth, "a wrapped text hashing as the log");
+        EndFrame();
+    }
+
+    // Each measurement runs within a frame, as widgets measure their text.
+    float sink = 0.f;
+    BeginFrame();
+    const double uncachedNs = Benchmark::MeasureBestNs(repetitions, [&]()
+    {
+        sink += MeasureUncached(log, 0.f).y;
+    });
+    const double uncachedWrappedNs = Benchmark::MeasureBestNs(repetitions, [&]()
+    {
+        sink += MeasureUncached(log, c_WrapWidth).y;
+    });
+    const double cachedNs = Benchmark::MeasureBestNs(repetitions, [&]()
+    {
+        sink += ImGui::CalcTextSize(log.data(), log.data() + log.size()).y;
+    });
+    const double cachedWrappedNs = Benchmark::MeasureBestNs(repetitions, [&]()
+    {
+        sink += ImGui::CalcTextSize(log.data(), log.data() + log.size(), false, c_WrapWidth).y;
+    });
+    // A log whose last line changes every time, e.g. a progress counter: every measurement misses the cache.
+    std::string changing = log + "Uploaded 000000 buffers\n";
+    const size_t counterOffset = changing.size() - 15;
+    int counter = 0;
+    const double changedNs = Benchmark::MeasureBestNs(repetitions, [&]()
+    {
+        char digits[8];
+        std::snprintf(digits, sizeof(digits), "%06d", ++counter);
+        changing.replace(counterOffset, 6, digits);
+        sink += ImGui::CalcTextSize(changing.data(), changing.data() + changing.size(), false, c_WrapWidth).y;
+    });
+    EndFrame();
+
+    // Whole frames of a log window: TextWrapped measures the log and draws the visible lines.
+    const double textWrappedNs = Benchmark::MeasureBestNs(repetitions, [&]()
+    {
+        BeginFrame();
+        ImGui::TextWrapped("%s", log.c_str());
+        EndFrame();
+    });
+    const double textUnformattedNs = Benchmark::MeasureBestNs(repetitions, [&]()
+    {
+        BeginFrame();
+        ImGui::TextUnformatted(log.data(), log.data() + log.size());
+        EndFrame();
+    });
+
+    std::printf("ImguiTextBenchmark: %s, log of %zu bytes, fastest of the runs\n", fontName, log.size());
+    std::printf("%-36s %12s %12s\n", "measurement", "ms", "MB/s");
+    PrintRow("CalcTextSizeA", uncachedNs, log.size());
+    PrintRow("CalcTextSizeA, wrapped", uncachedWrappedNs, log.size());
+    PrintRow("CalcTextSize, cached", cachedNs, log.size());
+    PrintRow("CalcTextSize, cached, wrapped", cachedWrappedNs, log.size());
+    PrintRow("CalcTextSize, last line changing", changedNs, log.size());
+    PrintRow("Frame of TextWrapped", textWrappedNs, log.size());
+    PrintRow("Frame of TextUnformatted", textUnformattedNs, log.size());
+
+    ImGui_ImplHeadless_Shutdown();
+    ImGui::DestroyContext();
+
+    g_sink = sink;
+    return 0;
+}
@@ -0,0 +1,119 @@
+//
+// JobSystemBenchmark.cpp - Scheduling overhead per job and ParallelFor scaling from 1 to 64 threads
+//
+
+#include "Benchmark.h"
+
+#include "JobSystem.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    // The thread that waits runs jobs too, so n threads is a job system with n - 1 workers.
+    const unsigned c_ThreadCounts[] = { 1, 2, 4, 8, 16, 32, 64 };
+
+    // Schedules empty jobs from the owning thread and waits for all of them: the cost of a job with no work.
+    double MeasureScheduleNs(JobSystem& jobSystem, size_t jobCount, int repetitions)
+    {
+        std::vector<JobHandle> jobs(jobCount);
+        std::atomic<size_t> executed{ 0 };
+
+        const double ns = Benchmark::MeasureBestNs(repetitions, [&]()
+        {
+            for (auto& job : jobs)
+            {
+                job = jobSystem.Schedule([&executed]() { executed.fetch_add(1, std::memory_order_relaxed); });
+            }
+            for (const auto& job : jobs)
+            {
+                jobSystem.Wait(job);
+            }
+        });
+
+        if (executed != jobCount * size_t(repetitions))
+        {
+            std::fprintf(stderr, "JobSystemBenchmark: %zu of %zu jobs ran\n", executed.load(), jobCount * size_t(repetitions));
+            std::exit(EXIT_FAILURE);
+        }
+        return ns / double(jobCount);
+    }
+
+    // A chain where every job depends on the previous one, so nothing runs in parallel: the cost of a dependency.
+    double MeasureChainNs(JobSystem& jobSystem, size_t jobCount, int repetitions)
+    {
+        const double ns = Benchmark::MeasureBestNs(repetitions, [&]()
+        {
+            JobHandle previous;
+            for (size_t i = 0; i < jobCount; i++)
+            {
+                previous = jobSystem.Schedule([]() {}, 1, &previous);
+            }
+            jobSystem.Wait(previous);
+        });
+        return ns / double(jobCount);
+    }
+
+    // Compute-bound work split by ParallelFor: the speedup over one thread is the scheduler's scaling.
+    double MeasureParallelForNs(JobSystem& jobSystem, size_t itemCount, size_t grainSize, int repetitions)
+    {
+        std::atomic<uint64_t> checksum{ 0 };
+
+        const double ns = Benchmark::MeasureBestNs(repetitions, [&]()
+        {
+            jobSystem.ParallelFor(itemCount, grainSize, [&checksum](size_t begin, size_t end)
+            {
+                double sum = 0.0;
+                for (size_t i = begin; i < end; i++)
+                {
+                    sum += std::sqrt(double(i));
+                }
+                checksum.fetch_add(uint64_t(sum), std::memory_order_relaxed);
+            });
+        });
+
+        if (checksum == 0)
+        {
+            std::fprintf(stderr, "JobSystemBenchmark: ParallelFor did no work\n");
+            std::exit(EXIT_FAILURE);
+        }
+        return ns;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const bool quick = Benchmark::IsQuickRun(argc, argv);
+    const size_t jobCount = quick ? 1000 : 100000;
+    const size_t itemCount = quick ? (1 << 16) : (1 << 24);
+    const size_t grainSize = quick ? 1024 : 16384;
+    const int repetitions = quick ? 1 : 5;
+
+    std::printf("JobSystemBenchmark: %u hardware threads, %zu jobs, ParallelFor over %zu items in chunks of %zu\n",
+                std::thread::hardware_concurrency(), jobCount, itemCount, grainSize);
+    std::printf("%8s %14s %14s %16s %8s\n", "threads", "schedule ns/job", "chain ns/job", "ParallelFor ms", "speedup");
+
+    double singleThreadNs = 0.0;
+    for (const unsigned threadCount : c_ThreadCounts)
+    {
+        JobSystem jobSystem(threadCount - 1);
+
+        const double scheduleNs = MeasureScheduleNs(jobSystem, jobCount, repetitions);
+        const double chainNs = MeasureChainNs(jobSystem, jobCount, repetitions);
+        const double parallelForNs = MeasureParallelForNs(jobSystem, itemCount, grainSize, repetitions);
+        if (threadCount == 1)
+        {
+            singleThreadNs = parallelForNs;
+        }
+
+        std::printf("%8u %14.0f %14.0f %16.3f %8.2f\n",
+                    threadCount, scheduleNs, chainNs, parallelForNs / 1e6, singleThreadNs / parallelForNs);
+    }
+    return 0;
+}
@@ -0,0 +1,135 @@
+//
+// PrimitiveBatcherBenchmark.cpp - Fill, sort and pack throughput of the primitive batcher
+//
+
+#include "Benchmark.h"
+
+#include "PrimitiveBatcher.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    // How the states of the instances are spread, which decides how many radix sort passes run.
+    struct Scenario
+    {
+        const char*     name;
+        uint32_t        textureCount;
+        uint16_t        materialCount;
+        uint16_t        layerCount;
+    };
+
+    const Scenario c_Scenarios[] =
+    {
+        { "one texture",        1,      1,  1 },
+        { "64 textures",        64,     2,  1 },
+        { "4096 textures",      4096,   2,  4 },
+    };
+
+    struct PhaseTimes
+    {
+        double  fillNs = 1e30;
+        double  buildNs = 1e30;
+        double  packNs = 1e30;
+    };
+
+    double ElapsedNs(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+    {
+        return std::chrono::duration<double, std::nano>(end - start).count();
+    }
+
+    // Fills the batcher with half sprites and half triangles in random states, then builds and packs it.
+    // Each phase keeps its fastest run; storage is reused between runs as in a frame loop.
+    PhaseTimes Measure(const Scenario& scenario, size_t instanceCount, int repetitions, size_t& batchCount)
+    {
+        PrimitiveBatcher batcher(instanceCount);
+        std::vector<BatchInstancePositions> positions(instanceCount);
+        std::vector<BatchInstanceTexcoords> texcoords(instanceCount);
+        std::vector<BatchInstanceAttributes> attributes(instanceCount);
+
+        std::vector<BatchState> states(instanceCount);
+        std::mt19937 random(1);
+        for (auto& state : states)
+        {
+            state = {};
+            state.texture = random() % scenario.textureCount;
+            state.material = uint16_t(random() % scenario.materialCount);
+            state.layer = uint16_t(random() % scenario.layerCount);
+        }
+
+        PhaseTimes times;
+        for (int run = 0; run < repetitions; run++)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            batcher.Clear();
+            for (size_t i = 0; i < instanceCount; i++)
+            {
+                const float x = float(i % 1024);
+                const float y = float(i / 1024);
+                if (i & 1)
+                {
+                    batcher.AddTriangle({ x, y, 0.f, 0.f }, { x + 8.f, y, 1.f, 0.f }, { x, y + 8.f, 0.f, 1.f }, states[i]);
+                }
+                else
+                {
+                    batcher.AddSprite(x, y, x + 8.f, y + 8.f, states[i]);
+                }
+            }
+
+            const auto filled = std::chrono::steady_clock::now();
+            batcher.Build();
+            const auto built = std::chrono::steady_clock::now();
+            batcher.Pack({ positions.data(), texcoords.data(), attributes.data() });
+            const auto packed = std::chrono::steady_clock::now();
+
+            times.fillNs = std::min(times.fillNs, ElapsedNs(start, filled));
+            times.buildNs = std::min(times.buildNs, ElapsedNs(filled, built));
+            times.packNs = std::min(times.packNs, ElapsedNs(built, packed));
+        }
+
+        size_t batchedInstances = 0;
+        for (const auto& batch : batcher.GetBatches())
+        {
+            batchedInstances += batch.instanceCount;
+        }
+        if (batchedInstances != instanceCount)
+        {
+            std::fprintf(stderr, "PrimitiveBatcherBenchmark: %zu of %zu instances batched\n", batchedInstances, instanceCount);
+            std::exit(EXIT_FAILURE);
+        }
+
+        batchCount = batcher.GetBatches().size();
+        return times;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const bool quick = Benchmark::IsQuickRun(argc, argv);
+    const std::vector<size_t> instanceCounts = quick ? std::vector<size_t>{ 1000 } : std::vector<size_t>{ 10000, 100000, 500000 };
+    const int repetitions = quick ? 1 : 5;
+
+    std::printf("PrimitiveBatcherBenchmark: fastest of %d runs, in millions of instances per second\n", repetitions);
+    std::printf("%-14s %10s %8s %10s %10s %10s\n", "states", "instances", "batches", "fill", "build", "pack");
+
+    for (const auto& scenario : c_Scenarios)
+    {
+        for (const size_t instanceCount : instanceCounts)
+        {
+            size_t batchCount = 0;
+            const PhaseTimes times = Measure(scenario, instanceCount, repetitions, batchCount);
+
+            // Instances per nanosecond times 1000 is millions per second.
+            const double scale = double(instanceCount) * 1e3;
+            std::printf("%-14s %10zu %8zu %10.1f %10.1f %10.1f\n", scenario.name, instanceCount, batchCount,
+                        scale / times.fillNs, scale / times.buildNs, scale / times.packNs);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,73 @@
+//
+// Clock.cpp - Monotonic time sources that StepTimer reads
+//
+
+#include "Clock.h"
+
+#include <chrono>
+#include <stdexcept>
+
+using namespace DX;
+
+namespace
+{
+    using SteadyPeriod = std::chrono::steady_clock::period;
+
+    static_assert(std::chrono::steady_clock::is_steady, "steady_clock must be monotonic");
+    static_assert(SteadyPeriod::num == 1, "steady_clock must tick in whole fractions of a second");
+}
+
+uint64_t SteadyClock::GetFrequency() const noexcept
+{
+    return static_cast<uint64_t>(SteadyPeriod::den);
+}
+
+uint64_t SteadyClock::GetTime()
+{
+    return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+}
+
+SteadyClock& SteadyClock::GetInstance() noexcept
+{
+    static SteadyClock s_instance;
+    return s_instance;
+}
+
+// Constructor for ReplayClock.
+ReplayClock::ReplayClock(uint64_t frequency, uint64_t defaultStep) noexcept(false) :
+    m_frequency(frequency),
+    m_defaultStep(defaultStep),
+    m_time(0),
+    m_readCount(0)
+{
+    if (frequency == 0)
+    {
+        throw std::out_of_range("frequency must not be 0");
+    }
+}
+
+uint64_t ReplayClock::GetTime()
+{
+    if (!m_deltas.empty())
+    {
+        m_time += m_deltas.front();
+        m_deltas.pop_front();
+    }
+    else
+    {
+        m_time += m_defaultStep;
+    }
+
+    m_readCount++;
+    return m_time;
+}
+
+void ReplayClock::Queue(uint64_t delta)
+{
+    m_deltas.push_back(delta);
+}
+
+void ReplayClock::Queue(const uint64_t* deltas, size_t count)
+{
+    m_deltas.insert(m_deltas.end(), deltas, deltas + count);
+}
@@ -0,0 +1,74 @@
+//
+// Clock.h - Monotonic time sources that StepTimer reads
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+
+namespace DX
+{
+    // A monotonic time source, read in its own units.
+    class IClock
+    {
+    public:
+        virtual ~IClock() = default;
+
+        // Units per second.
+        virtual uint64_t GetFrequency() const noexcept = 0;
+
+        // The current time. Never less than a previous result.
+        virtual uint64_t GetTime() = 0;
+    };
+
+    // std::chrono::steady_clock, which is QueryPerformanceCounter on Windows.
+    class SteadyClock final : public IClock
+    {
+    public:
+        uint64_t GetFrequency() const noexcept override;
+        uint64_t GetTime() override;
+
+        // Stateless, so one instance serves every timer that is not given a clock.
+        static SteadyClock& GetInstance() noexcept;
+    };
+
+    // Time only moves when told to. Every GetTime first advances by the next queued delta, or by the default
+    // step once the queue is empty, so a timer ticked against it sees exactly those deltas: feeding the deltas
+    // of a recorded session reproduces its fixed-step catch-up sequence, and a benchmark can tick thousands
+    // of simulated frames per second. Not thread-safe.
+    class ReplayClock final : public IClock
+    {
+    public:
+        // The default frequency is StepTimer's tick rate, so deltas convert to ticks without rounding.
+        static const uint64_t c_DefaultFrequency = 10000000;
+
+        explicit ReplayClock(uint64_t frequency = c_DefaultFrequency, uint64_t defaultStep = 0) noexcept(false);
+
+        uint64_t GetFrequency() const noexcept override { return m_frequency; }
+        uint64_t GetTime() override;
+
+        // Append deltas for the following GetTime calls.
+        void Queue(uint64_t delta);
+        void Queue(const uint64_t* deltas, size_t count);
+
+        // The delta used once the queue is empty; 0 stops the clock.
+        void SetDefaultStep(uint64_t step) noexcept { m_defaultStep = step; }
+
+        // Move the time forward without consuming a queued delta, e.g. to simulate a stall.
+        void Advance(uint64_t delta) noexcept { m_time += delta; }
+
+        uint64_t GetCurrentTime() const noexcept { return m_time; }
+        size_t GetQueuedCount() const noexcept { return m_deltas.size(); }
+        uint64_t GetReadCount() const noexcept { return m_readCount; }
+
+    private:
+        uint64_t                m_frequency;
+        uint64_t                m_defaultStep;
+        uint64_t                m_time;
+        uint64_t                m_readCount;
+        std::deque<uint64_t>    m_deltas;
+    };
+}
@@ -0,0 +1,229 @@
+//
+// CookedTexture.cpp - Memory-mappable container for pre-decoded, pre-mipped texel data
+//
+
+#include "CookedTexture.h"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <system_error>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace DX;
+
+namespace
+{
+    const uint64_t c_DataAlignment = 16;
+
+    inline uint64_t GetDataOffset(uint32_t mipLevels) noexcept
+    {
+        const uint64_t tableEnd = sizeof(CookedTextureHeader) + uint64_t(mipLevels) * sizeof(CookedTextureMip);
+        return (tableEnd + c_DataAlignment - 1) & ~(c_DataAlignment - 1);
+    }
+}
+
+// Constructor for MappedFile.
+MappedFile::MappedFile(const std::filesystem::path& path) noexcept(false) :
+    m_data(nullptr),
+    m_size(0)
+{
+#ifdef _WIN32
+    m_file = nullptr;
+    m_mapping = nullptr;
+
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        throw std::system_error(static_cast<int>(GetLastError()), std::system_category(), "CreateFileW");
+    }
+    m_file = file;
+
+    LARGE_INTEGER size = {};
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+    {
+        CloseHandle(file);
+        throw std::runtime_error("Mapped file is empty");
+    }
+    m_size = static_cast<uint64_t>(size.QuadPart);
+
+    m_mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (m_mapping)
+    {
+        m_data = static_cast<const uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+    }
+
+    if (!m_data)
+    {
+        const auto error = static_cast<int>(GetLastError());
+        if (m_mapping)
+        {
+            CloseHandle(m_mapping);
+        }
+        CloseHandle(file);
+        throw std::system_error(error, std::system_category(), "MapViewOfFile");
+    }
+#else
+    m_file = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (m_file < 0)
+    {
+        throw std::system_error(errno, std::generic_category(), "open");
+    }
+
+    struct stat status = {};
+    if (fstat(m_file, &status) != 0 || status.st_size == 0)
+    {
+        close(m_file);
+        throw std::runtime_error("Mapped file is empty");
+    }
+    m_size = static_cast<uint64_t>(status.st_size);
+
+    void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_file, 0);
+    if (data == MAP_FAILED)
+    {
+        const int error = errno;
+        close(m_file);
+        throw std::system_error(error, std::generic_category(), "mmap");
+    }
+    m_data = static_cast<const uint8_t*>(data);
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+#ifdef _WIN32
+    UnmapViewOfFile(m_data);
+    CloseHandle(m_mapping);
+    CloseHandle(m_file);
+#else
+    munmap(const_cast<uint8_t*>(m_data), m_size);
+    close(m_file);
+#endif
+}
+
+std::filesystem::path DX::GetCookedTexturePath(const std::filesystem::path& sourcePath)
+{
+    auto cookedPath = sourcePath;
+    cookedPath.replace_extension(c_CookedTextureExtension);
+    return cookedPath;
+}
+
+bool DX::IsCookedTextureCurrent(const std::filesystem::path& sourcePath, const std::filesystem::path& cookedPath)
+{
+    std::error_code error;
+    const auto cookedTime = std::filesystem::last_write_time(cookedPath, error);
+    if (error)
+        return false;
+
+    // A cooked file without its source, e.g. in a shipped build, is always current.
+    const auto sourceTime = std::filesystem::last_write_time(sourcePath, error);
+    return error || cookedTime >= sourceTime;
+}
+
+void DX::LoadCookedTexture(const std::filesystem::path& path, StreamedImage& image)
+{
+    auto file = std::make_shared<MappedFile>(path);
+    const uint8_t* data = file->GetData();
+
+    if (file->GetSize() < sizeof(CookedTextureHeader))
+    {
+        throw std::runtime_error("Cooked texture is truncated");
+    }
+
+    CookedTextureHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if (header.magic != c_CookedTextureMagic || header.version != c_CookedTextureVersion)
+    {
+        throw std::runtime_error("Not a cooked texture, or cooked by another version");
+    }
+
+    // More mip levels than a full chain has would make the layout ambiguous.
+    if (header.width == 0 || header.height == 0 || (header.blockSize != 1 && header.blockSize != 4) || header.bytesPerBlock == 0
+        || header.mipLevels == 0 || header.mipLevels > 32 || (std::max(header.width, header.height) >> (header.mipLevels - 1)) == 0)
+    {
+        throw std::runtime_error("Cooked texture header is invalid");
+    }
+
+    image.width = header.width;
+    image.height = header.height;
+    image.mipLevels = header.mipLevels;
+    image.format = header.format;
+    image.blockSize = header.blockSize;
+    image.bytesPerBlock = header.bytesPerBlock;
+
+    // The table must describe exactly the layout the image implies, with all of it inside the file.
+    const uint64_t dataOffset = GetDataOffset(header.mipLevels);
+    if (file->GetSize() < dataOffset || file->GetSize() - dataOffset < image.GetMipOffset(image.mipLevels))
+    {
+        throw std::runtime_error("Cooked texture is truncated");
+    }
+
+    for (uint32_t mip = 0; mip < header.mipLevels; mip++)
+    {
+        CookedTextureMip entry;
+        std::memcpy(&entry, data + sizeof(header) + mip * sizeof(entry), sizeof(entry));
+        if (entry.offset != dataOffset + image.GetMipOffset(mip) || entry.size != image.GetMipSize(mip))
+        {
+            throw std::runtime_error("Cooked texture mip table is inconsistent");
+        }
+    }
+
+    image.texels = std::shared_ptr<const uint8_t>(file, data + dataOffset);
+}
+
+void DX::WriteCookedTexture(const std::filesystem::path& path, const StreamedImage& image)
+{
+    CookedTextureHeader header = {};
+    header.magic = c_CookedTextureMagic;
+    header.version = c_CookedTextureVersion;
+    header.width = image.width;
+    header.height = image.height;
+    header.mipLevels = image.mipLevels;
+    header.format = image.format;
+    header.blockSize = image.blockSize;
+    header.bytesPerBlock = image.bytesPerBlock;
+
+    const uint64_t dataOffset = GetDataOffset(image.mipLevels);
+    std::vector<CookedTextureMip> table(image.mipLevels);
+    for (uint32_t mip = 0; mip < image.mipLevels; mip++)
+    {
+        table[mip] = { dataOffset + image.GetMipOffset(mip), image.GetMipSize(mip) };
+    }
+
+    auto temporaryPath = path;
+    temporaryPath += L".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        const char padding[c_DataAlignment] = {};
+        const uint64_t tableEnd = sizeof(header) + table.size() * sizeof(CookedTextureMip);
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(table.data()), static_cast<std::streamsize>(table.size() * sizeof(CookedTextureMip)));
+        file.write(padding, static_cast<std::streamsize>(dataOffset - tableEnd));
+        file.write(reinterpret_cast<const char*>(image.texels.get()), static_cast<std::streamsize>(image.GetMipOffset(image.mipLevels)));
+        file.close();
+
+        if (!file)
+        {
+            std::error_code ignored;
+            std::filesystem::remove(temporaryPath, ignored);
+            throw std::runtime_error("Failed to write cooked texture");
+        }
+    }
+
+    std::filesystem::rename(temporaryPath, path);
+}
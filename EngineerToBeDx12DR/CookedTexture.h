@@ -0,0 +1,81 @@
+//
+// CookedTexture.h - Memory-mappable container for pre-decoded, pre-mipped texel data
+//
+
+#pragma once
+
+#include "StreamedImage.h"
+
+#include <filesystem>
+
+
+namespace DX
+{
+    // File layout, all little endian:
+    //   CookedTextureHeader
+    //   CookedTextureMip[mipLevels]     offsets from the start of the file
+    //   texel data                      mip levels in order, tightly packed rows, starting at a 16-byte boundary
+    // The texel data is exactly StreamedImage::texels, so a loaded image points straight into the mapping.
+    struct CookedTextureHeader
+    {
+        uint32_t    magic;
+        uint32_t    version;
+        uint32_t    width;
+        uint32_t    height;
+        uint32_t    mipLevels;
+        uint32_t    format;         // DXGI_FORMAT
+        uint32_t    blockSize;
+        uint32_t    bytesPerBlock;
+    };
+
+    struct CookedTextureMip
+    {
+        uint64_t    offset;
+        uint64_t    size;
+    };
+
+    const uint32_t c_CookedTextureMagic = 0x58455454; // "TTEX"
+    const uint32_t c_CookedTextureVersion = 1;
+    const wchar_t* const c_CookedTextureExtension = L".ttex";
+
+    // A read-only view of a whole file. Pages are loaded on first access, so only the ranges that are
+    // actually copied are read from disk.
+    class MappedFile
+    {
+    public:
+        explicit MappedFile(const std::filesystem::path& path) noexcept(false);
+        ~MappedFile();
+
+        MappedFile(MappedFile&&) = delete;
+        MappedFile& operator= (MappedFile&&) = delete;
+
+        MappedFile(MappedFile const&) = delete;
+        MappedFile& operator= (MappedFile const&) = delete;
+
+        const uint8_t* GetData() const noexcept { return m_data; }
+        uint64_t GetSize() const noexcept { return m_size; }
+
+    private:
+        const uint8_t*  m_data;
+        uint64_t        m_size;
+#ifdef _WIN32
+        void*           m_file;
+        void*           m_mapping;
+#else
+        int             m_file;
+#endif
+    };
+
+    // The cooked file that sits next to a source image, e.g. kiti.ttex for kiti.jpg.
+    std::filesystem::path GetCookedTexturePath(const std::filesystem::path& sourcePath);
+
+    // True if the cooked file exists and is at least as new as the source.
+    bool IsCookedTextureCurrent(const std::filesystem::path& sourcePath, const std::filesystem::path& cookedPath);
+
+    // Map a cooked file and point image.texels into the mapping, which the image keeps alive.
+    // Throws std::runtime_error if the file is truncated or inconsistent.
+    void LoadCookedTexture(const std::filesystem::path& path, StreamedImage& image);
+
+    // Write through a temporary file that is renamed into place, so readers never see a partial file.
+    void WriteCookedTexture(const std::filesystem::path& path, const StreamedImage& image);
+}
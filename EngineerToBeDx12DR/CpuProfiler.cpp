@@ -0,0 +1,402 @@
+//
+// CpuProfiler.cpp - Hierarchical CPU profiler with lock-free per-thread event buffers
+//
+
+#include "CpuProfiler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <ostream>
+#include <stdexcept>
+
+using namespace DX;
+
+namespace
+{
+    std::atomic<uint64_t> s_nextProfilerId(1);
+
+    // The calling thread's buffer in the profiler it last recorded into. Profiler ids are never reused,
+    // so a cache entry left behind by a destroyed profiler cannot match.
+    struct ThreadBufferCache
+    {
+        uint64_t    profilerId;
+        void*       buffer;
+    };
+
+    thread_local ThreadBufferCache t_threadBuffer = {};
+
+    void WriteJsonString(std::ostream& stream, const char* text)
+    {
+        stream << '"';
+        for (; *text; text++)
+        {
+            const char c = *text;
+            if (c == '"' || c == '\\')
+            {
+                stream << '\\' << c;
+            }
+            else if (static_cast<unsigned char>(c) < 0x20)
+            {
+                char escaped[8] = {};
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned int>(c));
+                stream << escaped;
+            }
+            else
+            {
+                stream << c;
+            }
+        }
+        stream << '"';
+    }
+
+    // Microseconds with nanosecond precision, independent of the stream's locale and precision.
+    void WriteMicroseconds(std::ostream& stream, uint64_t ticks)
+    {
+        const uint64_t frequency = CpuProfiler::GetFrequency();
+        const uint64_t nanoseconds = ticks / frequency * 1000000000ull + ticks % frequency * 1000000000ull / frequency;
+        char text[32] = {};
+        std::snprintf(text, sizeof(text), "%llu.%03llu",
+                      static_cast<unsigned long long>(nanoseconds / 1000), static_cast<unsigned long long>(nanoseconds % 1000));
+        stream << text;
+    }
+}
+
+CpuProfiler::ThreadBuffer::ThreadBuffer(size_t capacity, std::thread::id id, uint32_t index_) :
+    events(std::make_unique<Event[]>(capacity)),
+    mask(capacity - 1),
+    threadId(id),
+    index(index_),
+    head(0),
+    cachedTail(0),
+    openDepth(0),
+    droppedDepth(0),
+    droppedScopes(0),
+    tail(0)
+{
+}
+
+// Constructor for CpuProfiler.
+CpuProfiler::CpuProfiler(size_t eventsPerThread, size_t frameHistory) noexcept(false) :
+    m_id(s_nextProfilerId.fetch_add(1)),
+    m_enabled(true),
+    m_eventsPerThread(2),
+    m_frameHistory(frameHistory),
+    m_frameNumber(0),
+    m_frameBegin(GetTime())
+{
+    // Calibrate now rather than in the first EndFrame.
+    GetFrequency();
+
+    if (eventsPerThread < 2 || eventsPerThread > (size_t(1) << 30))
+    {
+        throw std::out_of_range("eventsPerThread must be between 2 and 2^30");
+    }
+
+    if (frameHistory == 0)
+    {
+        throw std::out_of_range("frameHistory must not be 0");
+    }
+
+    while (m_eventsPerThread < eventsPerThread)
+    {
+        m_eventsPerThread *= 2;
+    }
+}
+
+uint64_t CpuProfiler::GetFrequency() noexcept
+{
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+    // Spin for a few milliseconds; long enough for a frequency within a few parts per million.
+    static const uint64_t s_frequency = []()
+    {
+        using namespace std::chrono;
+
+        const auto steadyBegin = steady_clock::now();
+        const uint64_t ticksBegin = GetTime();
+        auto steadyEnd = steadyBegin;
+        while (steadyEnd - steadyBegin < milliseconds(5))
+        {
+            steadyEnd = steady_clock::now();
+        }
+        const uint64_t ticksEnd = GetTime();
+
+        const double seconds = duration<double>(steadyEnd - steadyBegin).count();
+        return static_cast<uint64_t>(double(ticksEnd - ticksBegin) / seconds);
+    }();
+
+    return s_frequency;
+#else
+    return static_cast<uint64_t>(std::chrono::steady_clock::period::den);
+#endif
+}
+
+CpuProfiler& CpuProfiler::GetInstance()
+{
+    static CpuProfiler s_instance;
+    return s_instance;
+}
+
+bool CpuProfiler::BeginScope(const char* name) noexcept
+{
+    if (!m_enabled.load(std::memory_order_relaxed))
+        return false;
+
+    ThreadBuffer* buffer = GetThreadBuffer();
+    if (!buffer)
+        return false;
+
+    // Everything nested in a dropped scope is dropped too, so that ends keep pairing with their begins.
+    if (buffer->droppedDepth > 0)
+    {
+        buffer->droppedDepth++;
+        return true;
+    }
+
+    // Keep room for this scope's end and the end of every scope that is still open.
+    const uint64_t head = buffer->head.load(std::memory_order_relaxed);
+    const uint64_t required = buffer->openDepth + 2;
+    if (buffer->mask + 1 - (head - buffer->cachedTail) < required)
+    {
+        buffer->cachedTail = buffer->tail.load(std::memory_order_acquire);
+        if (buffer->mask + 1 - (head - buffer->cachedTail) < required)
+        {
+            buffer->droppedDepth = 1;
+            buffer->droppedScopes.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    buffer->events[head & buffer->mask] = { name, GetTime() };
+    buffer->head.store(head + 1, std::memory_order_release);
+    buffer->openDepth++;
+    return true;
+}
+
+void CpuProfiler::EndScope() noexcept
+{
+    ThreadBuffer* buffer = GetThreadBuffer();
+    if (!buffer)
+        return;
+
+    if (buffer->droppedDepth > 0)
+    {
+        buffer->droppedDepth--;
+        return;
+    }
+
+    if (buffer->openDepth == 0)
+        return;
+
+    // BeginScope reserved this slot.
+    const uint64_t head = buffer->head.load(std::memory_order_relaxed);
+    buffer->events[head & buffer->mask] = { nullptr, GetTime() };
+    buffer->head.store(head + 1, std::memory_order_release);
+    buffer->openDepth--;
+}
+
+CpuProfiler::ThreadBuffer* CpuProfiler::GetThreadBuffer() noexcept
+{
+    if (t_threadBuffer.profilerId == m_id)
+        return static_cast<ThreadBuffer*>(t_threadBuffer.buffer);
+
+    try
+    {
+        ThreadBuffer* buffer = RegisterThread();
+        t_threadBuffer = { m_id, buffer };
+        return buffer;
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+// Finds the calling thread's buffer, e.g. after it recorded into another profiler, or adds one.
+CpuProfiler::ThreadBuffer* CpuProfiler::RegisterThread()
+{
+    const auto threadId = std::this_thread::get_id();
+
+    std::lock_guard<std::mutex> lock(m_threadsMutex);
+    for (const auto& thread : m_threads)
+    {
+        if (thread->threadId == threadId)
+            return thread.get();
+    }
+
+    const auto index = static_cast<uint32_t>(m_threads.size());
+    auto buffer = std::make_unique<ThreadBuffer>(m_eventsPerThread, threadId, index);
+    buffer->name = "Thread " + std::to_string(index);
+    m_threads.push_back(std::move(buffer));
+    return m_threads.back().get();
+}
+
+void CpuProfiler::SetThreadName(const std::string& name)
+{
+    ThreadBuffer* buffer = GetThreadBuffer();
+    if (!buffer)
+    {
+        throw std::bad_alloc();
+    }
+
+    std::lock_guard<std::mutex> lock(m_threadsMutex);
+    buffer->name = name;
+}
+
+std::vector<std::string> CpuProfiler::GetThreadNames() const
+{
+    std::lock_guard<std::mutex> lock(m_threadsMutex);
+
+    std::vector<std::string> names;
+    names.reserve(m_threads.size());
+    for (const auto& thread : m_threads)
+    {
+        names.push_back(thread->name);
+    }
+
+    return names;
+}
+
+uint64_t CpuProfiler::GetDroppedScopeCount() const
+{
+    std::lock_guard<std::mutex> lock(m_threadsMutex);
+
+    uint64_t count = 0;
+    for (const auto& thread : m_threads)
+    {
+        count += thread->droppedScopes.load(std::memory_order_relaxed);
+    }
+
+    return count;
+}
+
+void CpuProfiler::EndFrame()
+{
+    ProfileFrame frame = {};
+    frame.number = m_frameNumber++;
+    frame.begin = m_frameBegin;
+    frame.end = GetTime();
+    m_frameBegin = frame.end;
+
+    // Threads registered after the snapshot are collected next frame.
+    std::vector<ThreadBuffer*> threads;
+    {
+        std::lock_guard<std::mutex> lock(m_threadsMutex);
+        threads.reserve(m_threads.size());
+        for (const auto& thread : m_threads)
+        {
+            threads.push_back(thread.get());
+        }
+    }
+
+    for (ThreadBuffer* thread : threads)
+    {
+        const uint64_t head = thread->head.load(std::memory_order_acquire);
+        uint64_t tail = thread->tail.load(std::memory_order_relaxed);
+
+        const size_t firstSample = frame.samples.size();
+        for (; tail != head; tail++)
+        {
+            const Event& event = thread->events[tail & thread->mask];
+            if (event.name)
+            {
+                thread->open.push_back({ event.name, event.time });
+                continue;
+            }
+
+            const OpenScope scope = thread->open.back();
+            thread->open.pop_back();
+            frame.samples.push_back({ scope.name, scope.begin, event.time, thread->index, static_cast<uint32_t>(thread->open.size()) });
+        }
+
+        thread->tail.store(tail, std::memory_order_release);
+
+        // Samples come out in end order; the flame graph wants parents before children.
+        std::sort(frame.samples.begin() + firstSample, frame.samples.end(),
+            [](const ProfileSample& a, const ProfileSample& b)
+            {
+                return a.begin != b.begin ? a.begin < b.begin : a.depth < b.depth;
+            });
+    }
+
+    m_frames.push_back(std::move(frame));
+    while (m_frames.size() > m_frameHistory)
+    {
+        m_frames.pop_front();
+    }
+}
+
+void CpuProfiler::WriteChromeTrace(std::ostream& stream) const
+{
+    const auto names = GetThreadNames();
+    // Scopes may have begun before the first frame.
+    uint64_t origin = m_frames.empty() ? 0 : m_frames.front().begin;
+    for (const auto& frame : m_frames)
+    {
+        for (const auto& sample : frame.samples)
+        {
+            origin = std::min(origin, sample.begin);
+        }
+    }
+
+    stream << "{\"traceEvents\":[\n";
+
+    bool first = true;
+    auto separator = [&]()
+    {
+        stream << (first ? "" : ",\n");
+        first = false;
+    };
+
+    for (size_t thread = 0; thread < names.size(); thread++)
+    {
+        separator();
+        stream << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread << ",\"args\":{\"name\":";
+        WriteJsonString(stream, names[thread].c_str());
+        stream << "}}";
+    }
+
+    auto writeEvent = [&](const ProfileSample& sample, char phase, uint64_t time)
+    {
+        separator();
+        stream << "{\"name\":";
+        WriteJsonString(stream, sample.name);
+        stream << ",\"ph\":\"" << phase << "\",\"pid\":1,\"tid\":" << sample.thread << ",\"ts\":";
+        WriteMicroseconds(stream, time - origin);
+        stream << "}";
+    };
+
+    std::vector<const ProfileSample*> open;
+    auto endScopes = [&](uint32_t depth)
+    {
+        for (; !open.empty() && open.back()->depth >= depth; open.pop_back())
+        {
+            writeEvent(*open.back(), 'E', open.back()->end);
+        }
+    };
+
+    for (const auto& frame : m_frames)
+    {
+        separator();
+        stream << "{\"name\":\"Frame " << frame.number << "\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":0,\"ts\":";
+        WriteMicroseconds(stream, frame.begin - origin);
+        stream << "}";
+
+        // Samples are sorted by thread, then by begin time with parents first, so ending the open scopes at least
+        // as deep as the next sample writes every thread as properly nested begin and end events. Unlike complete
+        // events, these keep parents and children apart when they share a timestamp at the trace's precision.
+        for (const auto& sample : frame.samples)
+        {
+            if (!open.empty() && open.back()->thread != sample.thread)
+            {
+                endScopes(0);
+            }
+            endScopes(sample.depth);
+
+            writeEvent(sample, 'B', sample.begin);
+            open.push_back(&sample);
+        }
+        endScopes(0);
+    }
+
+    stream << "\n]}\n";
+}
@@ -0,0 +1,192 @@
+//
+// CpuProfiler.h - Hierarchical CPU profiler with lock-free per-thread event buffers
+//
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace DX
+{
+    // A completed scope. Times are in CpuProfiler ticks.
+    struct ProfileSample
+    {
+        const char*     name;
+        uint64_t        begin;
+        uint64_t        end;
+        uint32_t        thread;     // index into CpuProfiler::GetThreadNames
+        uint32_t        depth;      // number of enclosing scopes on the same thread
+    };
+
+    // The scopes that ended between two EndFrame calls, sorted by thread, then begin time. A scope that
+    // started in an earlier frame begins before the frame does.
+    struct ProfileFrame
+    {
+        uint64_t                    number;
+        uint64_t                    begin;
+        uint64_t                    end;
+        std::vector<ProfileSample>  samples;
+    };
+
+    // Records nested begin/end timestamps per thread into a single-producer ring buffer, so recording never
+    // takes a lock: BeginScope and EndScope cost a clock read and one release store. EndFrame drains every
+    // ring on the collecting thread, pairs the events into samples and keeps a history of frames that can be
+    // shown as a flame graph or written as a Chrome trace.
+    //
+    // A scope that does not fit its thread's ring is dropped along with everything nested in it, and room
+    // for the end of every open scope is reserved, so the recorded events always pair up.
+    class CpuProfiler
+    {
+    public:
+        static const size_t c_DefaultEventsPerThread = 64 * 1024;
+        static const size_t c_DefaultFrameHistory = 300;
+
+        // eventsPerThread is rounded up to a power of two.
+        explicit CpuProfiler(size_t eventsPerThread = c_DefaultEventsPerThread,
+                             size_t frameHistory = c_DefaultFrameHistory) noexcept(false);
+
+        CpuProfiler(CpuProfiler&&) = delete;
+        CpuProfiler& operator= (CpuProfiler&&) = delete;
+
+        CpuProfiler(CpuProfiler const&) = delete;
+        CpuProfiler& operator= (CpuProfiler const&) = delete;
+
+        // The process-wide profiler that ProfileScope records into by default.
+        static CpuProfiler& GetInstance();
+
+        // The profiler's time base: the time stamp counter on x86, which is invariant on every CPU that runs
+        // Direct3D 12 and reads several times faster than QueryPerformanceCounter, else std::chrono::steady_clock.
+        static uint64_t GetTime() noexcept
+        {
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+            return __rdtsc();
+#else
+            return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+        }
+
+        // Ticks per second. The time stamp counter is measured against steady_clock once, on first use.
+        static uint64_t GetFrequency() noexcept;
+
+        // Begin a scope on the calling thread. name must outlive the profiler, e.g. be a string literal.
+        // Returns false if nothing was recorded because the profiler is disabled; EndScope must be called
+        // exactly when true is returned, from the same thread.
+        bool BeginScope(const char* name) noexcept;
+        void EndScope() noexcept;
+
+        // Name the calling thread in the flame graph and the trace.
+        void SetThreadName(const std::string& name);
+
+        // Scopes begun while disabled are not recorded; scopes already begun still end.
+        void SetEnabled(bool enabled) noexcept { m_enabled.store(enabled, std::memory_order_relaxed); }
+        bool IsEnabled() const noexcept { return m_enabled.load(std::memory_order_relaxed); }
+
+        // Collect the events every thread recorded since the previous call into a new frame. The frame
+        // accessors below must only be used from the thread that calls EndFrame.
+        void EndFrame();
+
+        // Oldest first.
+        const std::deque<ProfileFrame>& GetFrames() const noexcept { return m_frames; }
+        const ProfileFrame* GetLastFrame() const noexcept { return m_frames.empty() ? nullptr : &m_frames.back(); }
+
+        std::vector<std::string> GetThreadNames() const;
+        uint64_t GetDroppedScopeCount() const;
+
+        // Write the frame history in the Chrome trace event format, for chrome://tracing or Perfetto: a begin
+        // and an end event per scope, nested per thread.
+        void WriteChromeTrace(std::ostream& stream) const;
+
+    private:
+        // An end event has no name.
+        struct Event
+        {
+            const char*     name;
+            uint64_t        time;
+        };
+
+        struct OpenScope
+        {
+            const char*     name;
+            uint64_t        begin;
+        };
+
+        struct ThreadBuffer
+        {
+            ThreadBuffer(size_t capacity, std::thread::id id, uint32_t index);
+
+            std::unique_ptr<Event[]>        events;
+            uint64_t                        mask;
+            std::thread::id                 threadId;
+            uint32_t                        index;
+
+            // Written by the owning thread.
+            alignas(64) std::atomic<uint64_t> head;
+            uint64_t                        cachedTail;
+            uint64_t                        openDepth;      // recorded scopes that have not ended
+            uint64_t                        droppedDepth;   // dropped scopes that have not ended
+            std::atomic<uint64_t>           droppedScopes;
+
+            // Written by EndFrame.
+            alignas(64) std::atomic<uint64_t> tail;
+            std::vector<OpenScope>          open;
+            std::string                     name;           // guarded by m_threadsMutex
+        };
+
+        ThreadBuffer* GetThreadBuffer() noexcept;
+        ThreadBuffer* RegisterThread();
+
+        uint64_t                                    m_id;
+        std::atomic<bool>                           m_enabled;
+        size_t                                      m_eventsPerThread;
+        size_t                                      m_frameHistory;
+
+        // Buffers are only ever added, so a thread's buffer stays valid for the profiler's lifetime.
+        mutable std::mutex                          m_threadsMutex;
+        std::vector<std::unique_ptr<ThreadBuffer>>  m_threads;
+
+        std::deque<ProfileFrame>                    m_frames;
+        uint64_t                                    m_frameNumber;
+        uint64_t                                    m_frameBegin;
+    };
+
+    // Times the enclosing block. Usage: DX::ProfileScope scope("Update");
+    class ProfileScope
+    {
+    public:
+        explicit ProfileScope(const char* name) noexcept :
+            ProfileScope(CpuProfiler::GetInstance(), name) {}
+        ProfileScope(CpuProfiler& profiler, const char* name) noexcept :
+            m_profiler(profiler), m_recorded(profiler.BeginScope(name)) {}
+
+        ~ProfileScope()
+        {
+            if (m_recorded)
+            {
+                m_profiler.EndScope();
+            }
+        }
+
+        ProfileScope(ProfileScope const&) = delete;
+        ProfileScope& operator= (ProfileScope const&) = delete;
+
+    private:
+        CpuProfiler&    m_profiler;
+        bool            m_recorded;
+    };
+}
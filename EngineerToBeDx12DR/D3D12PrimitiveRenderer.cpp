@@ -0,0 +1,255 @@
+//
+// D3D12PrimitiveRenderer.cpp - Draws the batches of a PrimitiveBatcher with one instanced draw each
+//
+
+#include "pch.h"
+#include "D3D12PrimitiveRenderer.h"
+
+#include <d3dcompiler.h>
+
+#pragma comment(lib, "d3dcompiler")
+
+using namespace DirectX;
+using namespace DX;
+
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+    // Corners 0-2 of an instance are given; the quad's fourth corner is corner1 + corner2 - corner0.
+    // Vertices are weights along (corner1 - corner0, corner2 - corner0): triangles use the first three.
+    const char c_ShaderSource[] = R"(
+        cbuffer ScreenTransform : register(b0)
+        {
+            float2 Scale;
+            float2 Offset;
+        };
+
+        cbuffer Material : register(b1)
+        {
+            uint TextureIndex;
+        };
+
+        Texture2D Textures[] : register(t0);
+        SamplerState Sampler : register(s0);
+
+        struct Instance
+        {
+            float2 position0 : POSITION0;
+            float2 position1 : POSITION1;
+            float2 position2 : POSITION2;
+            float2 texcoord0 : TEXCOORD0;
+            float2 texcoord1 : TEXCOORD1;
+            float2 texcoord2 : TEXCOORD2;
+            float4 color     : COLOR0;
+            float  depth     : DEPTH0;
+        };
+
+        struct Interpolants
+        {
+            float4 position : SV_Position;
+            float2 texcoord : TEXCOORD0;
+            float4 color    : COLOR0;
+        };
+
+        static const float2 Weights[6] = { float2(0, 0), float2(1, 0), float2(0, 1), float2(0, 1), float2(1, 0), float2(1, 1) };
+
+        Interpolants VSMain(Instance instance, uint vertexId : SV_VertexID)
+        {
+            const float2 w = Weights[vertexId];
+            const float2 position = instance.position0 + w.x * (instance.position1 - instance.position0)
+                                                       + w.y * (instance.position2 - instance.position0);
+
+            Interpolants output;
+            output.position = float4(position * Scale + Offset, instance.depth, 1);
+            output.texcoord = instance.texcoord0 + w.x * (instance.texcoord1 - instance.texcoord0)
+                                                 + w.y * (instance.texcoord2 - instance.texcoord0);
+            output.color = instance.color;
+            return output;
+        }
+
+        float4 PSMain(Interpolants input) : SV_Target
+        {
+            return Textures[TextureIndex].Sample(Sampler, input.texcoord) * input.color;
+        }
+    )";
+
+    ComPtr<ID3DBlob> CompileShader(const char* entryPoint, const char* target)
+    {
+        ComPtr<ID3DBlob> code;
+        ComPtr<ID3DBlob> errors;
+        const HRESULT hr = D3DCompile(c_ShaderSource, sizeof(c_ShaderSource) - 1, "PrimitiveRenderer", nullptr, nullptr,
+                                      entryPoint, target, D3DCOMPILE_OPTIMIZATION_LEVEL3, 0, &code, &errors);
+        if (FAILED(hr))
+        {
+#ifdef _DEBUG
+            if (errors)
+            {
+                OutputDebugStringA(static_cast<const char*>(errors->GetBufferPointer()));
+            }
+#endif
+            ThrowIfFailed(hr);
+        }
+
+        return code;
+    }
+
+    const D3D12_INPUT_ELEMENT_DESC c_InputElements[] =
+    {
+        { "POSITION", 0, DXGI_FORMAT_R32G32_FLOAT,   0, 0,  D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+        { "POSITION", 1, DXGI_FORMAT_R32G32_FLOAT,   0, 8,  D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+        { "POSITION", 2, DXGI_FORMAT_R32G32_FLOAT,   0, 16, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+        { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT,   1, 0,  D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+        { "TEXCOORD", 1, DXGI_FORMAT_R32G32_FLOAT,   1, 8,  D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+        { "TEXCOORD", 2, DXGI_FORMAT_R32G32_FLOAT,   1, 16, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+        { "COLOR",    0, DXGI_FORMAT_R8G8B8A8_UNORM, 2, 0,  D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+        { "DEPTH",    0, DXGI_FORMAT_R32_FLOAT,      2, 4,  D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+    };
+
+    static_assert(sizeof(BatchInstancePositions) == 24 && sizeof(BatchInstanceTexcoords) == 24
+                  && sizeof(BatchInstanceAttributes) == 8, "Instance streams must match the input layout");
+
+    const uint64_t c_StreamAlignment = 16;
+}
+
+// Constructor for D3D12PrimitiveRenderer.
+D3D12PrimitiveRenderer::D3D12PrimitiveRenderer(DeviceResources* deviceResources, DXGI_FORMAT renderTargetFormat,
+                                               DXGI_FORMAT depthBufferFormat) noexcept(false) :
+    m_deviceResources(deviceResources),
+    m_screenTransform{ 1.f, 1.f, 0.f, 0.f }
+{
+    auto device = m_deviceResources->GetD3DDevice();
+
+    // Root constants for the screen transform and the batch's texture index, one SRV table spanning the whole
+    // shared heap, bound once per Render, and a static sampler.
+    CD3DX12_DESCRIPTOR_RANGE textureRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV,
+        m_deviceResources->GetDescriptorAllocator().GetDescriptorCount(), 0);
+    CD3DX12_ROOT_PARAMETER rootParameters[3];
+    rootParameters[0].InitAsConstants(4, 0, 0, D3D12_SHADER_VISIBILITY_VERTEX);
+    rootParameters[1].InitAsConstants(1, 1, 0, D3D12_SHADER_VISIBILITY_PIXEL);
+    rootParameters[2].InitAsDescriptorTable(1, &textureRange, D3D12_SHADER_VISIBILITY_PIXEL);
+
+    const CD3DX12_STATIC_SAMPLER_DESC sampler(0, D3D12_FILTER_MIN_MAG_MIP_LINEAR,
+        D3D12_TEXTURE_ADDRESS_MODE_CLAMP, D3D12_TEXTURE_ADDRESS_MODE_CLAMP, D3D12_TEXTURE_ADDRESS_MODE_CLAMP);
+
+    const CD3DX12_ROOT_SIGNATURE_DESC rootSignatureDesc(static_cast<UINT>(std::size(rootParameters)), rootParameters, 1, &sampler,
+        D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
+    ThrowIfFailed(CreateRootSignature(device, &rootSignatureDesc, m_rootSignature.ReleaseAndGetAddressOf()));
+
+    m_rootSignature->SetName(L"PrimitiveRenderer");
+
+    // Shader model 5.1 for the descriptor array.
+    const auto vertexShader = CompileShader("VSMain", "vs_5_1");
+    const auto pixelShader = CompileShader("PSMain", "ps_5_1");
+
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc = {};
+    psoDesc.pRootSignature = m_rootSignature.Get();
+    psoDesc.VS = { vertexShader->GetBufferPointer(), vertexShader->GetBufferSize() };
+    psoDesc.PS = { pixelShader->GetBufferPointer(), pixelShader->GetBufferSize() };
+    psoDesc.SampleMask = UINT_MAX;
+    psoDesc.RasterizerState = CommonStates::CullNone;
+    psoDesc.InputLayout = { c_InputElements, static_cast<UINT>(std::size(c_InputElements)) };
+    psoDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+    psoDesc.NumRenderTargets = 1;
+    psoDesc.RTVFormats[0] = renderTargetFormat;
+    psoDesc.DSVFormat = depthBufferFormat;
+    psoDesc.SampleDesc.Count = 1;
+
+    // Indexed by material.
+    const struct
+    {
+        const D3D12_BLEND_DESC&         blend;
+        const D3D12_DEPTH_STENCIL_DESC& depthStencil;
+        const wchar_t*                  name;
+    } materials[] =
+    {
+        { CommonStates::Opaque,           CommonStates::DepthDefault, L"PrimitiveRenderer Opaque" },
+        { CommonStates::NonPremultiplied, CommonStates::DepthRead,    L"PrimitiveRenderer AlphaBlend" },
+    };
+
+    for (const auto& material : materials)
+    {
+        psoDesc.BlendState = material.blend;
+        psoDesc.DepthStencilState = material.depthStencil;
+
+        ComPtr<ID3D12PipelineState> pipelineState;
+        ThrowIfFailed(device->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(pipelineState.ReleaseAndGetAddressOf())));
+
+        pipelineState->SetName(material.name);
+        m_pipelineStates.push_back(std::move(pipelineState));
+    }
+}
+
+void D3D12PrimitiveRenderer::SetViewportSize(int width, int height)
+{
+    if (width <= 0 || height <= 0)
+    {
+        throw std::invalid_argument("Viewport size must be positive");
+    }
+
+    // Pixels, y down, to normalized device coordinates.
+    m_screenTransform[0] = 2.f / float(width);
+    m_screenTransform[1] = -2.f / float(height);
+    m_screenTransform[2] = -1.f;
+    m_screenTransform[3] = 1.f;
+}
+
+bool D3D12PrimitiveRenderer::Render(ID3D12GraphicsCommandList* commandList, const PrimitiveBatcher& batcher) const
+{
+    const uint64_t instanceCount = batcher.GetInstanceCount();
+    if (instanceCount == 0)
+        return true;
+
+    auto& uploadRing = m_deviceResources->GetUploadRing();
+    const auto positions = uploadRing.TryAllocate(instanceCount * sizeof(BatchInstancePositions), c_StreamAlignment);
+    const auto texcoords = uploadRing.TryAllocate(instanceCount * sizeof(BatchInstanceTexcoords), c_StreamAlignment);
+    const auto attributes = uploadRing.TryAllocate(instanceCount * sizeof(BatchInstanceAttributes), c_StreamAlignment);
+    if (!positions || !texcoords || !attributes)
+    {
+#ifdef _DEBUG
+        char buff[96] = {};
+        sprintf_s(buff, "PrimitiveRenderer: no upload ring space for %llu instances\n", instanceCount);
+        OutputDebugStringA(buff);
+#endif
+        return false;
+    }
+
+    BatchStreams streams = {};
+    streams.positions = reinterpret_cast<BatchInstancePositions*>(positions.cpuAddress);
+    streams.texcoords = reinterpret_cast<BatchInstanceTexcoords*>(texcoords.cpuAddress);
+    streams.attributes = reinterpret_cast<BatchInstanceAttributes*>(attributes.cpuAddress);
+    batcher.Pack(streams);
+
+    const D3D12_VERTEX_BUFFER_VIEW vertexBuffers[] =
+    {
+        { positions.gpuAddress,  static_cast<UINT>(instanceCount * sizeof(BatchInstancePositions)),  sizeof(BatchInstancePositions) },
+        { texcoords.gpuAddress,  static_cast<UINT>(instanceCount * sizeof(BatchInstanceTexcoords)),  sizeof(BatchInstanceTexcoords) },
+        { attributes.gpuAddress, static_cast<UINT>(instanceCount * sizeof(BatchInstanceAttributes)), sizeof(BatchInstanceAttributes) },
+    };
+
+    commandList->SetGraphicsRootSignature(m_rootSignature.Get());
+    commandList->SetGraphicsRoot32BitConstants(0, 4, m_screenTransform, 0);
+    commandList->SetGraphicsRootDescriptorTable(2, m_deviceResources->GetGpuDescriptorHandle(0));
+    commandList->IASetVertexBuffers(0, static_cast<UINT>(std::size(vertexBuffers)), vertexBuffers);
+    commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+    // Batches are sorted by material, then texture, so state only changes between groups.
+    const Batch* previous = nullptr;
+    for (const auto& batch : batcher.GetBatches())
+    {
+        if (!previous || batch.material != previous->material)
+        {
+            commandList->SetPipelineState(m_pipelineStates.at(batch.material).Get());
+        }
+
+        if (!previous || batch.texture != previous->texture)
+        {
+            commandList->SetGraphicsRoot32BitConstant(1, batch.texture, 0);
+        }
+
+        commandList->DrawInstanced(batch.GetVertexCountPerInstance(), batch.instanceCount, 0, batch.firstInstance);
+        previous = &batch;
+    }
+
+    return true;
+}
@@ -0,0 +1,48 @@
+//
+// D3D12PrimitiveRenderer.h - Draws the batches of a PrimitiveBatcher with one instanced draw each
+//
+
+#pragma once
+
+#include "DeviceResources.h"
+#include "PrimitiveBatcher.h"
+
+#include <vector>
+
+
+namespace DX
+{
+    // Packs a built batcher's instance streams into the upload ring, binds them as three per-instance vertex
+    // buffers and issues one DrawInstanced per batch. The vertex shader expands each instance from SV_VertexID,
+    // so no per-vertex data exists at all. A batch's texture is an index into the device's shared descriptor
+    // heap, read by the pixel shader from a root constant, and its material an index into the renderer's
+    // pipeline states.
+    class D3D12PrimitiveRenderer
+    {
+    public:
+        static const uint16_t c_OpaqueMaterial = 0;         // depth tested and written
+        static const uint16_t c_AlphaBlendMaterial = 1;     // straight alpha, depth tested only
+
+        D3D12PrimitiveRenderer(DeviceResources* deviceResources, DXGI_FORMAT renderTargetFormat,
+                               DXGI_FORMAT depthBufferFormat) noexcept(false);
+
+        D3D12PrimitiveRenderer(D3D12PrimitiveRenderer&&) = default;
+        D3D12PrimitiveRenderer& operator= (D3D12PrimitiveRenderer&&) = default;
+
+        D3D12PrimitiveRenderer(D3D12PrimitiveRenderer const&) = delete;
+        D3D12PrimitiveRenderer& operator= (D3D12PrimitiveRenderer const&) = delete;
+
+        // Size of the render target in pixels, which batch coordinates are given in.
+        void SetViewportSize(int width, int height);
+
+        // The render target must already be bound; the shared heap is bound by the device resources. Thread-safe
+        // for different command lists. Returns false, drawing nothing, if the upload ring has no room this frame.
+        bool Render(ID3D12GraphicsCommandList* commandList, const PrimitiveBatcher& batcher) const;
+
+    private:
+        DeviceResources*                                        m_deviceResources;
+        Microsoft::WRL::ComPtr<ID3D12RootSignature>             m_rootSignature;
+        std::vector<Microsoft::WRL::ComPtr<ID3D12PipelineState>> m_pipelineStates;   // by material
+        float                                                   m_screenTransform[4];
+    };
+}
@@ -0,0 +1,234 @@
+//
+// D3D12TextureStreamingBackend.cpp - Texture streaming on Direct3D 12 with WIC decoding
+//
+
+#include "pch.h"
+#include "D3D12TextureStreamingBackend.h"
+
+#include "CookedTexture.h"
+
+#include <mutex>
+#include <wincodec.h>
+
+using namespace DirectX;
+using namespace DX;
+
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+    // Created once and shared by all decode jobs, like the DirectXTK loaders do. The factory is free-threaded
+    // and the job system workers join the process MTA set up in wWinMain. Intentionally never released.
+    IWICImagingFactory2* GetWICFactory()
+    {
+        static std::once_flag s_once;
+        static IWICImagingFactory2* s_factory = nullptr;
+
+        std::call_once(s_once, []
+        {
+            ThrowIfFailed(CoCreateInstance(CLSID_WICImagingFactory2, nullptr, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(&s_factory)));
+        });
+
+        return s_factory;
+    }
+
+    inline ID3D12Resource* GetResource(ResourceHandle texture) noexcept
+    {
+        return reinterpret_cast<ID3D12Resource*>(texture);
+    }
+}
+
+// Constructor for D3D12TextureStreamingBackend.
+D3D12TextureStreamingBackend::D3D12TextureStreamingBackend(DeviceResources* deviceResources, uint32_t maxTextures,
+                                                           const TextureCookOptions& cookOptions) noexcept(false) :
+    m_deviceResources(deviceResources),
+    m_cookOptions(cookOptions)
+{
+    auto device = m_deviceResources->GetD3DDevice();
+
+    auto& allocator = m_deviceResources->GetDescriptorAllocator();
+    m_descriptors.reserve(size_t(maxTextures) + 1);
+    try
+    {
+        for (uint32_t slot = 0; slot <= maxTextures; slot++)
+        {
+            m_descriptors.push_back(allocator.Allocate());
+        }
+    }
+    catch (...)
+    {
+        for (const auto& descriptor : m_descriptors)
+        {
+            allocator.Free(descriptor);
+        }
+        throw;
+    }
+
+    // The placeholder samples as transparent black until a texture is published.
+    D3D12_SHADER_RESOURCE_VIEW_DESC placeholderDesc = {};
+    placeholderDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    placeholderDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+    placeholderDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+    placeholderDesc.Texture2D.MipLevels = 1;
+    device->CreateShaderResourceView(
+        nullptr, &placeholderDesc, m_deviceResources->GetCpuDescriptorHandle(GetDescriptorIndex(TextureStreamer::c_PlaceholderSlot))
+    );
+}
+
+// The slots are reused once the frame being recorded has completed, like the textures released with them.
+D3D12TextureStreamingBackend::~D3D12TextureStreamingBackend()
+{
+    auto& allocator = m_deviceResources->GetDescriptorAllocator();
+    for (const auto& descriptor : m_descriptors)
+    {
+        allocator.Free(descriptor);
+    }
+}
+
+void D3D12TextureStreamingBackend::Decode(const std::wstring& path, StreamedImage& image)
+{
+    // A current cooked file is mapped, and its texels are copied straight from the mapping into staging memory.
+    const auto cookedPath = GetCookedTexturePath(path);
+    if (IsCookedTextureCurrent(path, cookedPath))
+    {
+        LoadCookedTexture(cookedPath, image);
+        return;
+    }
+
+    StreamedImage source = {};
+    DecodeWIC(path, source);
+    image = CookTexture(source, m_cookOptions);
+
+    try
+    {
+        WriteCookedTexture(cookedPath, image);
+    }
+    catch (const std::exception& e)
+    {
+        // e.g. a read-only install directory. The cooked image is still used; it is cooked again next launch.
+#ifdef _DEBUG
+        char buff[256] = {};
+        sprintf_s(buff, "WARNING: Failed to write cooked texture: %s\n", e.what());
+        OutputDebugStringA(buff);
+#else
+        UNREFERENCED_PARAMETER(e);
+#endif
+    }
+}
+
+void D3D12TextureStreamingBackend::DecodeWIC(const std::wstring& path, StreamedImage& image)
+{
+    auto factory = GetWICFactory();
+
+    ComPtr<IWICBitmapDecoder> decoder;
+    ThrowIfFailed(factory->CreateDecoderFromFilename(
+        path.c_str(), nullptr, GENERIC_READ, WICDecodeMetadataCacheOnDemand, decoder.GetAddressOf()
+    ));
+
+    ComPtr<IWICBitmapFrameDecode> frame;
+    ThrowIfFailed(decoder->GetFrame(0, frame.GetAddressOf()));
+
+    UINT width, height;
+    ThrowIfFailed(frame->GetSize(&width, &height));
+
+    if (width == 0 || height == 0
+        || width > D3D12_REQ_TEXTURE2D_U_OR_V_DIMENSION || height > D3D12_REQ_TEXTURE2D_U_OR_V_DIMENSION)
+    {
+        throw std::invalid_argument("Unsupported image size");
+    }
+
+    ComPtr<IWICFormatConverter> converter;
+    ThrowIfFailed(factory->CreateFormatConverter(converter.GetAddressOf()));
+    ThrowIfFailed(converter->Initialize(
+        frame.Get(), GUID_WICPixelFormat32bppRGBA, WICBitmapDitherTypeNone, nullptr, 0, WICBitmapPaletteTypeMedianCut
+    ));
+
+    image.width = width;
+    image.height = height;
+    image.mipLevels = 1;
+    image.format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    image.blockSize = 1;
+    image.bytesPerBlock = 4;
+
+    ThrowIfFailed(converter->CopyPixels(
+        nullptr, static_cast<UINT>(image.GetRowSize(0)), static_cast<UINT>(image.GetMipSize(0)), AllocateTexels(image)
+    ));
+}
+
+uint64_t D3D12TextureStreamingBackend::GetTextureSize(const StreamedImage& image)
+{
+    const auto desc = CD3DX12_RESOURCE_DESC::Tex2D(
+        static_cast<DXGI_FORMAT>(image.format), image.width, image.height, 1, static_cast<UINT16>(image.mipLevels)
+    );
+    return m_deviceResources->GetD3DDevice()->GetResourceAllocationInfo(0, 1, &desc).SizeInBytes;
+}
+
+ResourceHandle D3D12TextureStreamingBackend::CreateTexture(const StreamedImage& image)
+{
+    const CD3DX12_HEAP_PROPERTIES defaultHeapProperties(D3D12_HEAP_TYPE_DEFAULT);
+    const auto desc = CD3DX12_RESOURCE_DESC::Tex2D(
+        static_cast<DXGI_FORMAT>(image.format), image.width, image.height, 1, static_cast<UINT16>(image.mipLevels)
+    );
+
+    ComPtr<ID3D12Resource> texture;
+    ThrowIfFailed(m_deviceResources->GetD3DDevice()->CreateCommittedResource(
+        &defaultHeapProperties,
+        D3D12_HEAP_FLAG_NONE,
+        &desc,
+        D3D12_RESOURCE_STATE_COPY_DEST,
+        nullptr,
+        IID_PPV_ARGS(texture.GetAddressOf())
+    ));
+
+    texture->SetName(L"Streamed texture");
+
+    m_textures.push_back(texture);
+    return reinterpret_cast<ResourceHandle>(texture.Get());
+}
+
+void D3D12TextureStreamingBackend::ReleaseTexture(ResourceHandle texture)
+{
+    auto entry = std::find_if(m_textures.begin(), m_textures.end(),
+        [texture](const ComPtr<ID3D12Resource>& resource) { return resource.Get() == GetResource(texture); });
+
+    if (entry == m_textures.end())
+    {
+        throw std::invalid_argument("Texture is not owned by this backend");
+    }
+
+    m_textures.erase(entry);
+}
+
+void D3D12TextureStreamingBackend::CopyRows(ResourceHandle texture, const StreamedImage& image, uint32_t mip, uint32_t firstRow,
+                                            uint32_t rowCount, uint64_t stagingOffset, uint32_t stagingPitch)
+{
+    // Footprints of block-compressed formats are in whole blocks, even for mips smaller than a block.
+    const uint32_t blockSize = image.blockSize;
+
+    D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint = {};
+    footprint.Offset = stagingOffset;
+    footprint.Footprint.Format = static_cast<DXGI_FORMAT>(image.format);
+    footprint.Footprint.Width = (image.GetMipWidth(mip) + blockSize - 1) / blockSize * blockSize;
+    footprint.Footprint.Height = rowCount * blockSize;
+    footprint.Footprint.Depth = 1;
+    footprint.Footprint.RowPitch = stagingPitch;
+
+    const CD3DX12_TEXTURE_COPY_LOCATION source(m_deviceResources->GetUploadBuffer(), footprint);
+    const CD3DX12_TEXTURE_COPY_LOCATION destination(GetResource(texture), mip);
+    m_deviceResources->GetCommandList()->CopyTextureRegion(&destination, 0, firstRow * blockSize, 0, &source, nullptr);
+}
+
+void D3D12TextureStreamingBackend::FinishUpload(ResourceHandle texture)
+{
+    TransitionResource(
+        m_deviceResources->GetCommandList(), GetResource(texture),
+        D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE
+    );
+}
+
+void D3D12TextureStreamingBackend::Publish(uint32_t slot, ResourceHandle texture)
+{
+    CreateShaderResourceView(
+        m_deviceResources->GetD3DDevice(), GetResource(texture), m_deviceResources->GetCpuDescriptorHandle(GetDescriptorIndex(slot))
+    );
+}
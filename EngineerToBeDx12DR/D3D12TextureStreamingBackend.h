@@ -0,0 +1,58 @@
+//
+// D3D12TextureStreamingBackend.h - Texture streaming on Direct3D 12 with WIC decoding
+//
+
+#pragma once
+
+#include "DeviceResources.h"
+#include "TextureCooker.h"
+#include "TextureStreamer.h"
+
+#include <vector>
+
+
+namespace DX
+{
+    // Loads cooked textures by mapping them, cooking a source image decoded with WIC the first time it is
+    // requested, and copies them from the device's upload ring buffer into committed textures. Copies are
+    // recorded into the frame's main command list so uploads run ahead of the passes.
+    // Every slot, 0 to maxTextures, owns a persistent descriptor of the device's shared heap; slot 0 holds a
+    // null SRV. Shaders index textures by GetDescriptorIndex, so no heap or table is bound per texture.
+    class D3D12TextureStreamingBackend final : public ITextureStreamingBackend
+    {
+    public:
+        D3D12TextureStreamingBackend(DeviceResources* deviceResources, uint32_t maxTextures,
+                                     const TextureCookOptions& cookOptions = {}) noexcept(false);
+        ~D3D12TextureStreamingBackend();
+
+        D3D12TextureStreamingBackend(D3D12TextureStreamingBackend&&) = delete;
+        D3D12TextureStreamingBackend& operator= (D3D12TextureStreamingBackend&&) = delete;
+
+        D3D12TextureStreamingBackend(D3D12TextureStreamingBackend const&) = delete;
+        D3D12TextureStreamingBackend& operator= (D3D12TextureStreamingBackend const&) = delete;
+
+        // ITextureStreamingBackend
+        void Decode(const std::wstring& path, StreamedImage& image) override;
+        uint64_t GetTextureSize(const StreamedImage& image) override;
+        ResourceHandle CreateTexture(const StreamedImage& image) override;
+        void ReleaseTexture(ResourceHandle texture) override;
+        void CopyRows(ResourceHandle texture, const StreamedImage& image, uint32_t mip, uint32_t firstRow,
+                      uint32_t rowCount, uint64_t stagingOffset, uint32_t stagingPitch) override;
+        void FinishUpload(ResourceHandle texture) override;
+        void Publish(uint32_t slot, ResourceHandle texture) override;
+
+        // Index of the slot's descriptor in the device's shared heap.
+        uint32_t GetDescriptorIndex(uint32_t slot) const { return m_descriptors.at(slot).index; }
+        D3D12_GPU_DESCRIPTOR_HANDLE GetGpuHandle(uint32_t slot) const { return m_deviceResources->GetGpuDescriptorHandle(GetDescriptorIndex(slot)); }
+
+        // Decode an image file to a single RGBA8 mip. Thread-safe.
+        static void DecodeWIC(const std::wstring& path, StreamedImage& image);
+
+    private:
+        DeviceResources*                                        m_deviceResources;
+        std::vector<DescriptorHandle>                           m_descriptors;     // by slot
+        TextureCookOptions                                      m_cookOptions;
+
+        std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>>     m_textures;
+    };
+}
@@ -1,5 +1,4 @@
-﻿#include "pch.h"
-#include "DemoImguiLayer.h"
+﻿#include "DemoImguiLayer.h"
 
 #include "imgui.h"
 
@@ -23,6 +22,13 @@ void DemoImguiLayer::CreateGUI()
 		ImGui::Text("This is some useful text."); // Display some text (you can use a format strings too)
 		ImGui::Checkbox("Demo Window", &m_showDemoWindow); // Edit bools storing our window open/close state
 		ImGui::Checkbox("Another Window", &m_showAnotherWindow);
+		ImGui::Checkbox("Profiler", &m_showProfiler);
+		ImGui::Checkbox("GPU timings", &m_showGpuTimings);
+		ImGui::Checkbox("Frame times", &m_showFrameTimes);
+
+		bool retained = IsRetainedMode();
+		if (ImGui::Checkbox("Retained UI", &retained)) // Reuse the last frame's UI while nothing changes
+			SetRetainedMode(retained);
 
 		ImGui::SliderFloat("float", &f, 0.0f, 1.0f); // Edit 1 float using a slider from 0.0f to 1.0f
 		ImGui::ColorEdit3("clear color", (float*)&m_clearColor); // Edit 3 floats representing a color
@@ -39,7 +45,17 @@ void DemoImguiLayer::CreateGUI()
 		ImGui::End();
 	}
 
-	// 3. Show another simple window.
+	// 3. Show the CPU profiler's last frame, the GPU time of each pass and the frame time percentiles.
+	if (m_showProfiler)
+		m_profilerWindow.Show(DX::CpuProfiler::GetInstance(), &m_showProfiler);
+
+	if (m_showGpuTimings && m_gpuProfiler)
+		m_profilerWindow.ShowGpuTimings(*m_gpuProfiler, &m_showGpuTimings);
+
+	if (m_showFrameTimes)
+		m_profilerWindow.ShowFrameTimes(m_totalFrameTimes, m_windowFrameTimes, &m_showFrameTimes);
+
+	// 4. Show another simple window.
 	if (m_showAnotherWindow)
 	{
 		ImGui::Begin("Another Window", &m_showAnotherWindow);
@@ -1,6 +1,7 @@
 ﻿#pragma once
 
 #include "ImguiLayerBase.h"
+#include "ProfilerWindow.h"
 
 class DemoImguiLayer : public ImguiLayerBase
 {
@@ -11,8 +12,27 @@ public:
 
 	void CreateGUI() override;
 
+	// The backend's GPU profiler, shown in its own window; null hides it.
+	void SetGpuProfiler(const DX::GpuProfiler * gpuProfiler) noexcept { m_gpuProfiler = gpuProfiler; }
+
+	// Frame times of the whole run and of the last closed window, shown in the frame times window.
+	void SetFrameTimeStats(const DX::FrameTimeStats & total, const DX::FrameTimeStats & window) noexcept
+	{
+		m_totalFrameTimes = total;
+		m_windowFrameTimes = window;
+	}
+	const DX::FrameTimeStats & GetTotalFrameTimeStats() const noexcept { return m_totalFrameTimes; }
+	const DX::FrameTimeStats & GetWindowFrameTimeStats() const noexcept { return m_windowFrameTimes; }
+
 private:
 	bool m_showDemoWindow;
 	bool m_showAnotherWindow;
+	bool m_showProfiler = true;
+	bool m_showGpuTimings = true;
+	bool m_showFrameTimes = true;
+	const DX::GpuProfiler * m_gpuProfiler = nullptr;
+	DX::FrameTimeStats m_totalFrameTimes = {};
+	DX::FrameTimeStats m_windowFrameTimes = {};
+	ProfilerWindow m_profilerWindow;
 	ImVec4 m_clearColor = ImVec4(0.45f, 0.55f, 0.60f, 1.00f);
 };
@@ -0,0 +1,196 @@
+//
+// DescriptorAllocator.cpp - Lock-free slot allocator for one shared, bindless descriptor heap
+//
+
+#include "DescriptorAllocator.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace DX;
+
+namespace
+{
+    const uint32_t c_EmptyStack = DescriptorHandle::c_InvalidIndex;
+
+    inline uint64_t MakeHead(uint64_t previousHead, uint32_t index) noexcept
+    {
+        return (((previousHead >> 32) + 1) << 32) | index;
+    }
+}
+
+// Constructor for DescriptorAllocator.
+DescriptorAllocator::DescriptorAllocator(uint32_t persistentCount, uint32_t transientCountPerFrame, unsigned int framesInFlight) noexcept(false) :
+    m_persistentCount(persistentCount),
+    m_transientCountPerFrame(transientCountPerFrame),
+    m_framesInFlight(framesInFlight),
+    m_freeSlots(c_EmptyStack),
+    m_freedThisFrame(c_EmptyStack),
+    m_allocatedCount(0),
+    m_transientBase(persistentCount),
+    m_transientOffset(0)
+{
+    if (framesInFlight == 0)
+    {
+        throw std::out_of_range("framesInFlight must be at least 1");
+    }
+
+    if (uint64_t(persistentCount) + uint64_t(transientCountPerFrame) * framesInFlight >= c_EmptyStack)
+    {
+        throw std::out_of_range("Too many descriptors");
+    }
+
+    m_next = std::make_unique<std::atomic<uint32_t>[]>(persistentCount);
+    m_generations = std::make_unique<std::atomic<uint32_t>[]>(persistentCount);
+    for (uint32_t index = 0; index < persistentCount; index++)
+    {
+        m_next[index].store(index + 1 < persistentCount ? index + 1 : c_EmptyStack, std::memory_order_relaxed);
+        m_generations[index].store(0, std::memory_order_relaxed);
+    }
+
+    if (persistentCount > 0)
+    {
+        m_freeSlots.store(0, std::memory_order_release);
+    }
+}
+
+DescriptorHandle DescriptorAllocator::TryAllocate() noexcept
+{
+    const uint32_t index = Pop(m_freeSlots);
+    if (index == c_EmptyStack)
+        return {};
+
+    m_allocatedCount.fetch_add(1, std::memory_order_relaxed);
+
+    DescriptorHandle handle;
+    handle.index = index;
+    handle.generation = m_generations[index].fetch_add(1, std::memory_order_acq_rel) + 1;
+    return handle;
+}
+
+DescriptorHandle DescriptorAllocator::Allocate()
+{
+    const auto handle = TryAllocate();
+    if (!handle.IsValid())
+    {
+        throw std::length_error("Descriptor heap is full");
+    }
+
+    return handle;
+}
+
+void DescriptorAllocator::Free(DescriptorHandle handle)
+{
+    // Only the first Free of an allocation moves the generation on; a second one, even racing, fails here.
+    uint32_t generation = handle.generation;
+    if (handle.index >= m_persistentCount || (generation & 1) == 0
+        || !m_generations[handle.index].compare_exchange_strong(generation, generation + 1, std::memory_order_acq_rel))
+    {
+        throw std::invalid_argument("Freed a stale or foreign descriptor handle");
+    }
+
+    m_allocatedCount.fetch_sub(1, std::memory_order_relaxed);
+    PushChain(m_freedThisFrame, handle.index, handle.index);
+}
+
+bool DescriptorAllocator::IsCurrent(DescriptorHandle handle) const noexcept
+{
+    return handle.index < m_persistentCount && (handle.generation & 1) != 0
+        && m_generations[handle.index].load(std::memory_order_acquire) == handle.generation;
+}
+
+uint32_t DescriptorAllocator::AllocateTransient(uint32_t count) noexcept
+{
+    const uint32_t offset = m_transientOffset.fetch_add(count, std::memory_order_relaxed);
+    if (count == 0 || offset > m_transientCountPerFrame || m_transientCountPerFrame - offset < count)
+        return DescriptorHandle::c_InvalidIndex;
+
+    return m_transientBase + offset;
+}
+
+uint32_t DescriptorAllocator::GetTransientUsedCount() const noexcept
+{
+    return std::min(m_transientOffset.load(std::memory_order_relaxed), m_transientCountPerFrame);
+}
+
+void DescriptorAllocator::BeginFrame(unsigned int frameIndex, uint64_t completedFenceValue)
+{
+    if (frameIndex >= m_framesInFlight)
+    {
+        throw std::out_of_range("frameIndex has no transient region");
+    }
+
+    m_transientBase = m_persistentCount + frameIndex * m_transientCountPerFrame;
+    m_transientOffset.store(0, std::memory_order_relaxed);
+
+    RecyclePending(completedFenceValue);
+}
+
+void DescriptorAllocator::EndFrame(uint64_t fenceValue)
+{
+    if (!m_pendingFrees.empty() && fenceValue < m_pendingFrees.back().fenceValue)
+    {
+        throw std::logic_error("Fence values must not decrease");
+    }
+
+    // Detach everything freed during the frame; no other thread pops from this stack, so the chain is private now.
+    uint64_t head = m_freedThisFrame.load(std::memory_order_relaxed);
+    while (!m_freedThisFrame.compare_exchange_weak(head, MakeHead(head, c_EmptyStack), std::memory_order_acquire))
+    {
+    }
+
+    const uint32_t first = static_cast<uint32_t>(head);
+    if (first == c_EmptyStack)
+        return;
+
+    uint32_t last = first;
+    for (uint32_t next = m_next[last].load(std::memory_order_relaxed); next != c_EmptyStack;
+         next = m_next[last].load(std::memory_order_relaxed))
+    {
+        last = next;
+    }
+
+    m_pendingFrees.push_back({ fenceValue, first, last });
+}
+
+void DescriptorAllocator::RetireAll() noexcept
+{
+    RecyclePending(UINT64_MAX);
+}
+
+void DescriptorAllocator::RecyclePending(uint64_t completedFenceValue) noexcept
+{
+    while (!m_pendingFrees.empty() && m_pendingFrees.front().fenceValue <= completedFenceValue)
+    {
+        const auto& frees = m_pendingFrees.front();
+        PushChain(m_freeSlots, frees.first, frees.last);
+        m_pendingFrees.pop_front();
+    }
+}
+
+// Push the linked slots first..last, whose own links are already set, in front of the stack.
+void DescriptorAllocator::PushChain(StackHead& head, uint32_t first, uint32_t last) noexcept
+{
+    uint64_t current = head.load(std::memory_order_relaxed);
+    do
+    {
+        m_next[last].store(static_cast<uint32_t>(current), std::memory_order_relaxed);
+    } while (!head.compare_exchange_weak(current, MakeHead(current, first), std::memory_order_release, std::memory_order_relaxed));
+}
+
+// The tag in the head makes the exchange fail if the slot was popped and pushed back in between, even though
+// the index matches; the stale link read from m_next is then discarded.
+uint32_t DescriptorAllocator::Pop(StackHead& head) noexcept
+{
+    uint64_t current = head.load(std::memory_order_acquire);
+    for (;;)
+    {
+        const uint32_t index = static_cast<uint32_t>(current);
+        if (index == c_EmptyStack)
+            return c_EmptyStack;
+
+        const uint32_t next = m_next[index].load(std::memory_order_relaxed);
+        if (head.compare_exchange_weak(current, MakeHead(current, next), std::memory_order_acquire, std::memory_order_acquire))
+            return index;
+    }
+}
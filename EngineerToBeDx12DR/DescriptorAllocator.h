@@ -0,0 +1,115 @@
+//
+// DescriptorAllocator.h - Lock-free slot allocator for one shared, bindless descriptor heap
+//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+
+
+namespace DX
+{
+    // A persistent descriptor slot. The generation changes every time the slot is freed, so a handle kept
+    // after Free is detected as stale instead of silently aliasing whatever reuses the slot.
+    struct DescriptorHandle
+    {
+        static const uint32_t c_InvalidIndex = UINT32_MAX;
+
+        uint32_t    index = c_InvalidIndex;
+        uint32_t    generation = 0;
+
+        bool IsValid() const noexcept { return index != c_InvalidIndex; }
+    };
+
+    // Manages the indices of a descriptor heap laid out as
+    //   [0, persistentCount)                             persistent slots, allocated and freed individually
+    //   persistentCount + frame * transientCountPerFrame  one transient region per frame in flight
+    // The memory itself belongs to the caller; the allocator only hands out indices, so it can be exercised
+    // without a device.
+    //
+    // Allocate and Free may be called from any thread without locks: free slots form an intrusive stack whose
+    // head carries a tag against ABA. A freed slot is only reused after the GPU has finished every frame that
+    // may still index it, so Free defers it to the frame's fence value. BeginFrame and EndFrame are called by
+    // the owner of the frame loop, like UploadRing's Retire and Finish.
+    //
+    // Transient descriptors are bump allocated from the current frame's region, also lock-free, and are valid
+    // until that frame index comes around again: write them every frame, e.g. for render graph transients
+    // whose resource may change from frame to frame.
+    class DescriptorAllocator
+    {
+    public:
+        DescriptorAllocator(uint32_t persistentCount, uint32_t transientCountPerFrame, unsigned int framesInFlight) noexcept(false);
+
+        DescriptorAllocator(DescriptorAllocator&&) = delete;
+        DescriptorAllocator& operator= (DescriptorAllocator&&) = delete;
+
+        DescriptorAllocator(DescriptorAllocator const&) = delete;
+        DescriptorAllocator& operator= (DescriptorAllocator const&) = delete;
+
+        // Returns an invalid handle if every persistent slot is in use.
+        DescriptorHandle TryAllocate() noexcept;
+
+        // Throws std::length_error if every persistent slot is in use.
+        DescriptorHandle Allocate();
+
+        // The slot becomes free once the frame being recorded has completed on the GPU.
+        // Throws std::invalid_argument for a handle that is stale or was not allocated here.
+        void Free(DescriptorHandle handle);
+
+        // True if the handle refers to a slot that has not been freed since it was allocated.
+        bool IsCurrent(DescriptorHandle handle) const noexcept;
+
+        // First index of count contiguous transient descriptors, or c_InvalidIndex if the frame's region is full.
+        uint32_t AllocateTransient(uint32_t count = 1) noexcept;
+
+        // Start recording frameIndex (the frame pacer's), whose previous use the GPU has finished, and
+        // recycle the slots freed in frames up to completedFenceValue.
+        void BeginFrame(unsigned int frameIndex, uint64_t completedFenceValue);
+
+        // Slots freed since the previous EndFrame stay reserved until fenceValue completes.
+        void EndFrame(uint64_t fenceValue);
+
+        // Forget all pending frees, e.g. once the GPU is idle.
+        void RetireAll() noexcept;
+
+        uint32_t GetDescriptorCount() const noexcept { return m_persistentCount + m_transientCountPerFrame * m_framesInFlight; }
+        uint32_t GetPersistentCount() const noexcept { return m_persistentCount; }
+        uint32_t GetTransientCountPerFrame() const noexcept { return m_transientCountPerFrame; }
+        uint32_t GetAllocatedCount() const noexcept { return m_allocatedCount.load(std::memory_order_relaxed); }
+        uint32_t GetTransientUsedCount() const noexcept;
+
+    private:
+        // (tag << 32) | index of the first slot, or c_InvalidIndex when empty.
+        using StackHead = std::atomic<uint64_t>;
+
+        struct PendingFrees
+        {
+            uint64_t    fenceValue;
+            uint32_t    first;
+            uint32_t    last;
+        };
+
+        void PushChain(StackHead& head, uint32_t first, uint32_t last) noexcept;
+        uint32_t Pop(StackHead& head) noexcept;
+        void RecyclePending(uint64_t completedFenceValue) noexcept;
+
+        uint32_t                                m_persistentCount;
+        uint32_t                                m_transientCountPerFrame;
+        unsigned int                            m_framesInFlight;
+
+        std::unique_ptr<std::atomic<uint32_t>[]> m_next;            // intrusive stack links, by slot
+        std::unique_ptr<std::atomic<uint32_t>[]> m_generations;     // odd while allocated
+        StackHead                               m_freeSlots;
+        StackHead                               m_freedThisFrame;
+        std::atomic<uint32_t>                   m_allocatedCount;
+
+        // Only touched by the frame loop.
+        std::deque<PendingFrees>                m_pendingFrees;
+
+        uint32_t                                m_transientBase;
+        std::atomic<uint32_t>                   m_transientOffset;
+    };
+}
@@ -29,6 +29,42 @@ namespace
         default:                                return fmt;
         }
     }
+
+    static_assert(static_cast<D3D12_RESOURCE_STATES>(ResourceState::Present) == D3D12_RESOURCE_STATE_PRESENT, "ResourceState mismatch");
+    static_assert(static_cast<D3D12_RESOURCE_STATES>(ResourceState::RenderTarget) == D3D12_RESOURCE_STATE_RENDER_TARGET, "ResourceState mismatch");
+    static_assert(static_cast<D3D12_RESOURCE_STATES>(ResourceState::DepthWrite) == D3D12_RESOURCE_STATE_DEPTH_WRITE, "ResourceState mismatch");
+    static_assert(static_cast<D3D12_RESOURCE_STATES>(ResourceState::PixelShaderResource) == D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, "ResourceState mismatch");
+    static_assert(static_cast<D3D12_RESOURCE_STATES>(ResourceState::CopyDest) == D3D12_RESOURCE_STATE_COPY_DEST, "ResourceState mismatch");
+    static_assert(static_cast<D3D12_RESOURCE_STATES>(ResourceState::GenericRead) == D3D12_RESOURCE_STATE_GENERIC_READ, "ResourceState mismatch");
+
+    inline D3D12_RESOURCE_STATES ToD3D12(ResourceState state) noexcept
+    {
+        return static_cast<D3D12_RESOURCE_STATES>(state);
+    }
+
+    void RecordBarriers(ID3D12GraphicsCommandList* commandList, uint32_t count, const ResourceBarrier* barriers)
+    {
+        // Forward in fixed-size batches so the common case needs no heap allocation.
+        D3D12_RESOURCE_BARRIER batch[16];
+        while (count > 0)
+        {
+            const uint32_t batchCount = std::min<uint32_t>(count, static_cast<uint32_t>(std::size(batch)));
+            for (uint32_t i = 0; i < batchCount; i++)
+            {
+                auto resource = reinterpret_cast<ID3D12Resource*>(barriers[i].resource);
+                switch (barriers[i].type)
+                {
+                case BarrierType::Aliasing:         batch[i] = CD3DX12_RESOURCE_BARRIER::Aliasing(nullptr, resource); break;
+                case BarrierType::UnorderedAccess:  batch[i] = CD3DX12_RESOURCE_BARRIER::UAV(resource); break;
+                default:                            batch[i] = CD3DX12_RESOURCE_BARRIER::Transition(resource, ToD3D12(barriers[i].before), ToD3D12(barriers[i].after)); break;
+                }
+            }
+
+            commandList->ResourceBarrier(batchCount, batch);
+            barriers += batchCount;
+            count -= batchCount;
+        }
+    }
 }
 
 // Constructor for DeviceResources.
@@ -39,8 +75,15 @@ DeviceResources::DeviceResources(
     D3D_FEATURE_LEVEL minFeatureLevel,
     unsigned int flags) noexcept(false) :
         m_backBufferIndex(0),
-        m_fenceValues{},
+        m_currentCommandList(nullptr),
+        m_transientAllocator(this),
+        m_uploadRing(std::make_unique<UploadRing>()),
         m_rtvDescriptorSize(0),
+        m_shaderVisibleDescriptorSize(0),
+        m_descriptorAllocator(std::make_unique<DescriptorAllocator>(
+            c_PersistentDescriptorCount, c_TransientDescriptorsPerFrame, FramePacer::c_MaxFramesInFlight)),
+        m_gpuProfiler(std::make_unique<GpuProfiler>(c_MaxGpuScopesPerFrame, FramePacer::c_MaxFramesInFlight)),
+        m_frameGpuScope(GpuProfiler::c_InvalidScope),
         m_screenViewport{},
         m_scissorRect{},
         m_backBufferFormat(backBufferFormat),
@@ -227,15 +270,20 @@ void DeviceResources::CreateDeviceResources()
         m_dsvDescriptorHeap->SetName(L"DeviceResources");
     }
 
-    // Create a command allocator for each back buffer that will be rendered to.
-    for (UINT n = 0; n < m_backBufferCount; n++)
-    {
-        ThrowIfFailed(m_d3dDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(m_commandAllocators[n].ReleaseAndGetAddressOf())));
+    // Create the shader-visible heap that every pass and ImGui share.
+    D3D12_DESCRIPTOR_HEAP_DESC shaderVisibleHeapDesc = {};
+    shaderVisibleHeapDesc.NumDescriptors = m_descriptorAllocator->GetDescriptorCount();
+    shaderVisibleHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+    shaderVisibleHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
 
-        wchar_t name[25] = {};
-        swprintf_s(name, L"Render target %u", n);
-        m_commandAllocators[n]->SetName(name);
-    }
+    ThrowIfFailed(m_d3dDevice->CreateDescriptorHeap(&shaderVisibleHeapDesc, IID_PPV_ARGS(m_shaderVisibleHeap.ReleaseAndGetAddressOf())));
+
+    m_shaderVisibleHeap->SetName(L"DeviceResources shader visible");
+
+    m_shaderVisibleDescriptorSize = m_d3dDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+    // Create a command allocator for each frame that can be in flight.
+    CreateCommandAllocators();
 
     // Create a command list for recording graphics commands.
     ThrowIfFailed(m_d3dDevice->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, m_commandAllocators[0].Get(), nullptr, IID_PPV_ARGS(m_commandList.ReleaseAndGetAddressOf())));
@@ -243,16 +291,48 @@ void DeviceResources::CreateDeviceResources()
 
     m_commandList->SetName(L"DeviceResources");
 
-    // Create a fence for tracking GPU execution progress.
-    ThrowIfFailed(m_d3dDevice->CreateFence(m_fenceValues[m_backBufferIndex], D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(m_fence.ReleaseAndGetAddressOf())));
-    m_fenceValues[m_backBufferIndex]++;
+    // Used for work recorded on the main thread after command contexts have been submitted.
+    ThrowIfFailed(m_d3dDevice->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, m_commandAllocators[0].Get(), nullptr, IID_PPV_ARGS(m_trailingCommandList.ReleaseAndGetAddressOf())));
+    ThrowIfFailed(m_trailingCommandList->Close());
 
-    m_fence->SetName(L"DeviceResources");
+    m_trailingCommandList->SetName(L"DeviceResources trailing");
+    m_currentCommandList = m_commandList.Get();
 
-    m_fenceEvent.Attach(CreateEventEx(nullptr, nullptr, 0, EVENT_MODIFY_STATE | SYNCHRONIZE));
-    if (!m_fenceEvent.IsValid())
+    // Create the upload ring's buffer. Upload heap memory may stay mapped while the GPU reads it.
+    const CD3DX12_HEAP_PROPERTIES uploadHeapProperties(D3D12_HEAP_TYPE_UPLOAD);
+    const auto uploadBufferDesc = CD3DX12_RESOURCE_DESC::Buffer(c_UploadRingSize);
+    ThrowIfFailed(m_d3dDevice->CreateCommittedResource(&uploadHeapProperties, D3D12_HEAP_FLAG_NONE, &uploadBufferDesc,
+        D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(m_uploadBuffer.ReleaseAndGetAddressOf())));
+
+    m_uploadBuffer->SetName(L"DeviceResources upload ring");
+
+    void* uploadMemory = nullptr;
+    const CD3DX12_RANGE readRange(0, 0);
+    ThrowIfFailed(m_uploadBuffer->Map(0, &readRange, &uploadMemory));
+    m_uploadRing->Initialize(static_cast<uint8_t*>(uploadMemory), m_uploadBuffer->GetGPUVirtualAddress(), c_UploadRingSize);
+
+    // Create the timestamp queries of the GPU profiler.
+    m_timestampQueries.Create(m_d3dDevice.Get(), m_commandQueue.Get(), m_gpuProfiler->GetQueryCount());
+
+    // Create a fence for tracking GPU execution progress.
+    m_fence.Create(m_d3dDevice.Get(), m_commandQueue.Get());
+    m_framePacer.Reset();
+    m_framePacer.SetFence(&m_fence);
+}
+
+// Creates any missing command allocators for the current number of frames in flight.
+void DeviceResources::CreateCommandAllocators()
+{
+    for (UINT n = 0; n < m_framePacer.GetFramesInFlight(); n++)
     {
-        throw std::system_error(std::error_code(static_cast<int>(GetLastError()), std::system_category()), "CreateEventEx");
+        if (m_commandAllocators[n])
+            continue;
+
+        ThrowIfFailed(m_d3dDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(m_commandAllocators[n].ReleaseAndGetAddressOf())));
+
+        wchar_t name[25] = {};
+        swprintf_s(name, L"Frame %u", n);
+        m_commandAllocators[n]->SetName(name);
     }
 }
 
@@ -267,11 +347,10 @@ void DeviceResources::CreateWindowSizeDependentResources()
     // Wait until all previous GPU work is complete.
     WaitForGpu();
 
-    // Release resources that are tied to the swap chain and update fence values.
+    // Release resources that are tied to the swap chain.
     for (UINT n = 0; n < m_backBufferCount; n++)
     {
         m_renderTargets[n].Reset();
-        m_fenceValues[n] = m_fenceValues[m_backBufferIndex];
     }
 
     // Determine the render target size in pixels.
@@ -464,18 +543,38 @@ void DeviceResources::HandleDeviceLost()
         m_deviceNotify->OnDeviceLost();
     }
 
-    for (UINT n = 0; n < m_backBufferCount; n++)
+    for (UINT n = 0; n < FramePacer::c_MaxFramesInFlight; n++)
     {
         m_commandAllocators[n].Reset();
+    }
+
+    for (UINT n = 0; n < m_backBufferCount; n++)
+    {
         m_renderTargets[n].Reset();
     }
 
     m_depthStencil.Reset();
+    m_transientAllocator.ReleaseResources();
+    m_uploadRing->Reset();
+    m_uploadBuffer.Reset();
     m_commandQueue.Reset();
     m_commandList.Reset();
+    m_trailingCommandList.Reset();
+    m_currentCommandList = nullptr;
+    m_submittedCommandLists.clear();
     m_fence.Reset();
     m_rtvDescriptorHeap.Reset();
     m_dsvDescriptorHeap.Reset();
+    m_shaderVisibleHeap.Reset();
+
+    // The GPU is gone, so slots freed by in-flight frames can be reused, and fence values start over.
+    m_descriptorAllocator->RetireAll();
+
+    // Timestamps of the frames in flight are lost with the GPU.
+    m_timestampQueries.Reset();
+    m_gpuProfiler->RetireAll();
+    m_frameGpuScope = GpuProfiler::c_InvalidScope;
+    m_gpuScopes.clear();
 
     m_swapChain.Reset();
     m_d3dDevice.Reset();
@@ -501,34 +600,68 @@ void DeviceResources::HandleDeviceLost()
 }
 
 // Prepare the command list and render target for rendering.
-void DeviceResources::Prepare(D3D12_RESOURCE_STATES beforeState, D3D12_RESOURCE_STATES afterState)
+void DeviceResources::Prepare(ResourceState beforeState, ResourceState afterState)
 {
     // Reset command list and allocator.
-    ThrowIfFailed(m_commandAllocators[m_backBufferIndex]->Reset());
-    ThrowIfFailed(m_commandList->Reset(m_commandAllocators[m_backBufferIndex].Get(), nullptr));
+    auto commandAllocator = m_commandAllocators[m_framePacer.GetFrameIndex()].Get();
+    ThrowIfFailed(commandAllocator->Reset());
+    ThrowIfFailed(m_commandList->Reset(commandAllocator, nullptr));
+    m_currentCommandList = m_commandList.Get();
+    m_submittedCommandLists.clear();
+
+    // Upload memory and descriptor slots of frames the GPU has finished can be reused.
+    m_uploadRing->Retire(m_framePacer.GetCompletedFenceValue());
+    m_descriptorAllocator->BeginFrame(m_framePacer.GetFrameIndex(), m_framePacer.GetCompletedFenceValue());
+    SetShaderVisibleHeap(m_commandList.Get());
+
+    // Read the timestamps of finished frames and start timing this one.
+    m_gpuProfiler->BeginFrame(m_framePacer.GetFrameIndex(), m_framePacer.GetCompletedFenceValue(), m_timestampQueries);
+    m_gpuScopes.clear();
+    m_frameGpuScope = BeginGpuScope(m_commandList.Get(), L"Frame");
 
     if (beforeState != afterState)
     {
         // Transition the render target into the correct state to allow for drawing into it.
         D3D12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(m_renderTargets[m_backBufferIndex].Get(),
-            beforeState, afterState);
+            ToD3D12(beforeState), ToD3D12(afterState));
         m_commandList->ResourceBarrier(1, &barrier);
     }
 }
 
 // Present the contents of the swap chain to the screen.
-void DeviceResources::Present(D3D12_RESOURCE_STATES beforeState)
+void DeviceResources::Present(ResourceState beforeState)
 {
-    if (beforeState != D3D12_RESOURCE_STATE_PRESENT)
+    if (beforeState != ResourceState::Present)
     {
         // Transition the render target to the state that allows it to be presented to the display.
-        D3D12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(m_renderTargets[m_backBufferIndex].Get(), beforeState, D3D12_RESOURCE_STATE_PRESENT);
-        m_commandList->ResourceBarrier(1, &barrier);
+        D3D12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(m_renderTargets[m_backBufferIndex].Get(), ToD3D12(beforeState), D3D12_RESOURCE_STATE_PRESENT);
+        m_currentCommandList->ResourceBarrier(1, &barrier);
     }
 
-    // Send the command list off to the GPU for processing.
-    ThrowIfFailed(m_commandList->Close());
-    m_commandQueue->ExecuteCommandLists(1, CommandListCast(m_commandList.GetAddressOf()));
+    // The trailing list executes last, so every timestamp of the frame has been written when it resolves them.
+    EndGpuScope(m_currentCommandList, m_frameGpuScope);
+    m_frameGpuScope = GpuProfiler::c_InvalidScope;
+    if (m_timestampQueries.IsValid())
+    {
+        uint32_t firstQuery = 0;
+        uint32_t queryCount = 0;
+        m_gpuProfiler->GetFrameQueries(firstQuery, queryCount);
+        m_timestampQueries.ResolveQueries(m_currentCommandList, firstQuery, queryCount);
+    }
+
+    // Send the command lists off to the GPU for processing, submitted contexts between the main and trailing list.
+    ThrowIfFailed(m_currentCommandList->Close());
+    if (m_submittedCommandLists.empty())
+    {
+        m_commandQueue->ExecuteCommandLists(1, CommandListCast(m_commandList.GetAddressOf()));
+    }
+    else
+    {
+        m_submittedCommandLists.push_back(m_trailingCommandList.Get());
+        m_commandQueue->ExecuteCommandLists(static_cast<UINT>(m_submittedCommandLists.size()), m_submittedCommandLists.data());
+        m_submittedCommandLists.clear();
+    }
+    m_currentCommandList = m_commandList.Get();
 	
     HRESULT hr;
     if (m_options & c_AllowTearing)
@@ -570,46 +703,325 @@ void DeviceResources::Present(D3D12_RESOURCE_STATES beforeState)
     }
 }
 
+std::unique_ptr<ICommandContext> DeviceResources::CreateContext(unsigned int frameIndex, unsigned int slot)
+{
+    return std::make_unique<D3D12CommandContext>(this, frameIndex, slot);
+}
+
+void DeviceResources::Submit(unsigned int count, ICommandContext* const* contexts)
+{
+    if (count == 0)
+        return;
+
+    if (m_submittedCommandLists.empty())
+    {
+        // Close the main list so it executes ahead of the contexts, and continue in the trailing list.
+        ThrowIfFailed(m_commandList->Close());
+        ThrowIfFailed(m_trailingCommandList->Reset(m_commandAllocators[m_framePacer.GetFrameIndex()].Get(), nullptr));
+        SetShaderVisibleHeap(m_trailingCommandList.Get());
+        m_currentCommandList = m_trailingCommandList.Get();
+        m_submittedCommandLists.push_back(m_commandList.Get());
+    }
+
+    for (unsigned int i = 0; i < count; i++)
+    {
+        m_submittedCommandLists.push_back(static_cast<D3D12CommandContext*>(contexts[i])->GetCommandList());
+    }
+}
+
+void DeviceResources::BindRenderTarget(ID3D12GraphicsCommandList* commandList) const noexcept
+{
+    const auto rtvDescriptor = GetRenderTargetView();
+    if (m_depthBufferFormat != DXGI_FORMAT_UNKNOWN)
+    {
+        const auto dsvDescriptor = GetDepthStencilView();
+        commandList->OMSetRenderTargets(1, &rtvDescriptor, FALSE, &dsvDescriptor);
+    }
+    else
+    {
+        commandList->OMSetRenderTargets(1, &rtvDescriptor, FALSE, nullptr);
+    }
+
+    commandList->RSSetViewports(1, &m_screenViewport);
+    commandList->RSSetScissorRects(1, &m_scissorRect);
+}
+
+void DeviceResources::SetShaderVisibleHeap(ID3D12GraphicsCommandList* commandList) const noexcept
+{
+    ID3D12DescriptorHeap* heaps[] = { m_shaderVisibleHeap.Get() };
+    commandList->SetDescriptorHeaps(static_cast<UINT>(std::size(heaps)), heaps);
+}
+
+uint32_t DeviceResources::BeginGpuScope(ID3D12GraphicsCommandList* commandList, const wchar_t* name) noexcept
+{
+    if (!m_timestampQueries.IsValid())
+        return GpuProfiler::c_InvalidScope;
+
+    const uint32_t scope = m_gpuProfiler->BeginScope(name);
+    if (scope != GpuProfiler::c_InvalidScope)
+    {
+        m_timestampQueries.EndQuery(commandList, m_gpuProfiler->GetBeginQuery(scope));
+    }
+
+    return scope;
+}
+
+void DeviceResources::EndGpuScope(ID3D12GraphicsCommandList* commandList, uint32_t scope) noexcept
+{
+    if (scope != GpuProfiler::c_InvalidScope && m_timestampQueries.IsValid())
+    {
+        m_timestampQueries.EndQuery(commandList, m_gpuProfiler->GetEndQuery(scope));
+        m_gpuProfiler->EndScope(scope);
+    }
+}
+
+void DeviceResources::BeginEvent(const wchar_t* name)
+{
+    PIXBeginEvent(m_currentCommandList, PIX_COLOR_DEFAULT, name);
+    m_gpuScopes.push_back(BeginGpuScope(m_currentCommandList, name));
+}
+
+void DeviceResources::EndEvent()
+{
+    if (!m_gpuScopes.empty())
+    {
+        EndGpuScope(m_currentCommandList, m_gpuScopes.back());
+        m_gpuScopes.pop_back();
+    }
+
+    PIXEndEvent(m_currentCommandList);
+}
+
+void DeviceResources::ResourceBarriers(uint32_t count, const ResourceBarrier* barriers)
+{
+    RecordBarriers(m_currentCommandList, count, barriers);
+}
+
+void DeviceResources::SetRenderTarget()
+{
+    BindRenderTarget(m_currentCommandList);
+}
+
+void DeviceResources::ClearRenderTarget(const float color[4])
+{
+    m_currentCommandList->ClearRenderTargetView(GetRenderTargetView(), color, 0, nullptr);
+}
+
+void DeviceResources::ClearDepthStencil(float depth)
+{
+    m_currentCommandList->ClearDepthStencilView(GetDepthStencilView(), D3D12_CLEAR_FLAG_DEPTH, depth, 0, 0, nullptr);
+}
+
+void DeviceResources::Draw(uint32_t vertexCount, uint32_t instanceCount)
+{
+    m_currentCommandList->DrawInstanced(vertexCount, instanceCount, 0, 0);
+}
+
+// Constructor for D3D12CommandContext.
+D3D12CommandContext::D3D12CommandContext(DeviceResources* deviceResources, unsigned int frameIndex, unsigned int slot) :
+    m_deviceResources(deviceResources)
+{
+    auto device = deviceResources->GetD3DDevice();
+
+    ThrowIfFailed(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(m_commandAllocator.ReleaseAndGetAddressOf())));
+    ThrowIfFailed(device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, m_commandAllocator.Get(), nullptr, IID_PPV_ARGS(m_commandList.ReleaseAndGetAddressOf())));
+    ThrowIfFailed(m_commandList->Close());
+
+    wchar_t name[48] = {};
+    swprintf_s(name, L"Command context %u (frame %u)", slot, frameIndex);
+    m_commandAllocator->SetName(name);
+    m_commandList->SetName(name);
+}
+
+void D3D12CommandContext::Begin()
+{
+    ThrowIfFailed(m_commandAllocator->Reset());
+    ThrowIfFailed(m_commandList->Reset(m_commandAllocator.Get(), nullptr));
+    m_deviceResources->SetShaderVisibleHeap(m_commandList.Get());
+    m_gpuScopes.clear();
+}
+
+void D3D12CommandContext::End()
+{
+    ThrowIfFailed(m_commandList->Close());
+}
+
+void D3D12CommandContext::BeginEvent(const wchar_t* name)
+{
+    PIXBeginEvent(m_commandList.Get(), PIX_COLOR_DEFAULT, name);
+    m_gpuScopes.push_back(m_deviceResources->BeginGpuScope(m_commandList.Get(), name));
+}
+
+void D3D12CommandContext::EndEvent()
+{
+    if (!m_gpuScopes.empty())
+    {
+        m_deviceResources->EndGpuScope(m_commandList.Get(), m_gpuScopes.back());
+        m_gpuScopes.pop_back();
+    }
+
+    PIXEndEvent(m_commandList.Get());
+}
+
+void D3D12CommandContext::ResourceBarriers(uint32_t count, const ResourceBarrier* barriers)
+{
+    RecordBarriers(m_commandList.Get(), count, barriers);
+}
+
+void D3D12CommandContext::SetRenderTarget()
+{
+    m_deviceResources->BindRenderTarget(m_commandList.Get());
+}
+
+void D3D12CommandContext::ClearRenderTarget(const float color[4])
+{
+    m_commandList->ClearRenderTargetView(m_deviceResources->GetRenderTargetView(), color, 0, nullptr);
+}
+
+void D3D12CommandContext::ClearDepthStencil(float depth)
+{
+    m_commandList->ClearDepthStencilView(m_deviceResources->GetDepthStencilView(), D3D12_CLEAR_FLAG_DEPTH, depth, 0, 0, nullptr);
+}
+
+void D3D12CommandContext::Draw(uint32_t vertexCount, uint32_t instanceCount)
+{
+    m_commandList->DrawInstanced(vertexCount, instanceCount, 0, 0);
+}
+
 // Wait for pending GPU work to complete.
 void DeviceResources::WaitForGpu() noexcept
 {
-    if (m_commandQueue && m_fence && m_fenceEvent.IsValid())
+    if (m_fence.IsValid())
     {
-        // Schedule a Signal command in the GPU queue.
-        UINT64 fenceValue = m_fenceValues[m_backBufferIndex];
-        if (SUCCEEDED(m_commandQueue->Signal(m_fence.Get(), fenceValue)))
+        try
         {
-            // Wait until the Signal has been processed.
-            if (SUCCEEDED(m_fence->SetEventOnCompletion(fenceValue, m_fenceEvent.Get())))
-            {
-                WaitForSingleObjectEx(m_fenceEvent.Get(), INFINITE, FALSE);
-
-                // Increment the fence value for the current frame.
-                m_fenceValues[m_backBufferIndex]++;
-            }
+            m_framePacer.WaitForIdle();
         }
+        catch (const std::exception&)
+        {
+            // Called from destructors and device-lost handling; a failed wait leaves nothing to clean up.
+        }
+    }
+}
+
+// Change how many frames the CPU may record ahead of the GPU.
+void DeviceResources::SetFramesInFlight(unsigned int framesInFlight)
+{
+    m_framePacer.SetFramesInFlight(framesInFlight);
+
+    if (m_d3dDevice)
+    {
+        CreateCommandAllocators();
     }
 }
 
 // Prepare to render the next frame.
 void DeviceResources::MoveToNextFrame()
 {
-    // Schedule a Signal command in the queue.
-    const UINT64 currentFenceValue = m_fenceValues[m_backBufferIndex];
-    ThrowIfFailed(m_commandQueue->Signal(m_fence.Get(), currentFenceValue));
+    // Everything allocated from the upload ring this frame is in use until the frame's fence value completes.
+    m_uploadRing->Finish(m_framePacer.GetCurrentFenceValue());
+    m_descriptorAllocator->EndFrame(m_framePacer.GetCurrentFenceValue());
+    m_gpuProfiler->EndFrame(m_framePacer.GetCurrentFenceValue());
+
+    // Signal the submitted frame, and only wait if the GPU still owns the next frame's allocator.
+    m_framePacer.EndFrame();
 
     // Update the back buffer index.
     m_backBufferIndex = m_swapChain->GetCurrentBackBufferIndex();
+}
+
+void D3D12TimestampQueries::Create(ID3D12Device* device, ID3D12CommandQueue* commandQueue, uint32_t queryCount)
+{
+    D3D12_QUERY_HEAP_DESC queryHeapDesc = {};
+    queryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+    queryHeapDesc.Count = queryCount;
+
+    ThrowIfFailed(device->CreateQueryHeap(&queryHeapDesc, IID_PPV_ARGS(m_queryHeap.ReleaseAndGetAddressOf())));
+
+    m_queryHeap->SetName(L"DeviceResources timestamps");
+
+    // Readback heap memory may stay mapped; the CPU only reads a frame's range after its fence completes.
+    const CD3DX12_HEAP_PROPERTIES readbackHeapProperties(D3D12_HEAP_TYPE_READBACK);
+    const auto readbackBufferDesc = CD3DX12_RESOURCE_DESC::Buffer(uint64_t(queryCount) * sizeof(uint64_t));
+    ThrowIfFailed(device->CreateCommittedResource(&readbackHeapProperties, D3D12_HEAP_FLAG_NONE, &readbackBufferDesc,
+        D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(m_readbackBuffer.ReleaseAndGetAddressOf())));
 
-    // If the next frame is not ready to be rendered yet, wait until it is ready.
-    if (m_fence->GetCompletedValue() < m_fenceValues[m_backBufferIndex])
+    m_readbackBuffer->SetName(L"DeviceResources timestamp readback");
+
+    void* readbackMemory = nullptr;
+    ThrowIfFailed(m_readbackBuffer->Map(0, nullptr, &readbackMemory));
+    m_timestamps = static_cast<const uint64_t*>(readbackMemory);
+
+    ThrowIfFailed(commandQueue->GetTimestampFrequency(&m_frequency));
+}
+
+void D3D12TimestampQueries::Reset() noexcept
+{
+    m_timestamps = nullptr;
+    m_readbackBuffer.Reset();
+    m_queryHeap.Reset();
+    m_frequency = 0;
+}
+
+void D3D12TimestampQueries::EndQuery(ID3D12GraphicsCommandList* commandList, uint32_t query) const noexcept
+{
+    commandList->EndQuery(m_queryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, query);
+}
+
+void D3D12TimestampQueries::ResolveQueries(ID3D12GraphicsCommandList* commandList, uint32_t first, uint32_t count) const noexcept
+{
+    if (count == 0)
+        return;
+
+    commandList->ResolveQueryData(m_queryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, first, count,
+        m_readbackBuffer.Get(), uint64_t(first) * sizeof(uint64_t));
+}
+
+void D3D12TimestampQueries::ReadTimestamps(uint32_t first, uint32_t count, uint64_t* timestamps)
+{
+    if (!m_timestamps)
     {
-        ThrowIfFailed(m_fence->SetEventOnCompletion(m_fenceValues[m_backBufferIndex], m_fenceEvent.Get()));
-        WaitForSingleObjectEx(m_fenceEvent.Get(), INFINITE, FALSE);
+        throw std::logic_error("Timestamp queries have not been created");
     }
 
-    // Set the fence value for the next frame.
-    m_fenceValues[m_backBufferIndex] = currentFenceValue + 1;
+    memcpy(timestamps, m_timestamps + first, count * sizeof(uint64_t));
+}
+
+void D3D12Fence::Create(ID3D12Device* device, ID3D12CommandQueue* commandQueue)
+{
+    ThrowIfFailed(device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(m_fence.ReleaseAndGetAddressOf())));
+
+    m_fence->SetName(L"DeviceResources");
+    m_commandQueue = commandQueue;
+
+    if (!m_fenceEvent.IsValid())
+    {
+        m_fenceEvent.Attach(CreateEventEx(nullptr, nullptr, 0, EVENT_MODIFY_STATE | SYNCHRONIZE));
+        if (!m_fenceEvent.IsValid())
+        {
+            throw std::system_error(std::error_code(static_cast<int>(GetLastError()), std::system_category()), "CreateEventEx");
+        }
+    }
+}
+
+void D3D12Fence::Reset() noexcept
+{
+    m_fence.Reset();
+    m_commandQueue.Reset();
+}
+
+void D3D12Fence::Signal(uint64_t value)
+{
+    ThrowIfFailed(m_commandQueue->Signal(m_fence.Get(), value));
+}
+
+void D3D12Fence::Wait(uint64_t value)
+{
+    if (m_fence->GetCompletedValue() < value)
+    {
+        ThrowIfFailed(m_fence->SetEventOnCompletion(value, m_fenceEvent.Get()));
+        WaitForSingleObjectEx(m_fenceEvent.Get(), INFINITE, FALSE);
+    }
 }
 
 // This method acquires the first available hardware adapter that supports Direct3D 12.
@@ -760,3 +1172,201 @@ void DeviceResources::UpdateColorSpace()
         ThrowIfFailed(m_swapChain->SetColorSpace1(colorSpace));
     }
 }
+
+void D3D12TransientResourceAllocator::GetAllocationInfo(const TransientResourceDesc& desc, uint64_t& size, uint64_t& alignment)
+{
+    CreateDescriptorHeap();
+
+    const auto resourceDesc = GetResourceDesc(desc);
+    const auto info = m_deviceResources->GetD3DDevice()->GetResourceAllocationInfo(0, 1, &resourceDesc);
+    if (info.SizeInBytes == UINT64_MAX)
+    {
+        throw std::invalid_argument("Unsupported transient resource description");
+    }
+
+    size = info.SizeInBytes;
+    alignment = info.Alignment;
+}
+
+void D3D12TransientResourceAllocator::Reserve(uint64_t heapSize)
+{
+    CreateDescriptorHeap();
+    m_generation++;
+
+    if (heapSize <= m_heapSize)
+        return;
+
+    // Resources in the old heap may still be in use by frames in flight.
+    m_deviceResources->WaitForGpu();
+    for (auto& placed : m_resources)
+    {
+        placed.resource.Reset();
+    }
+
+    // Round up so small changes in the graph do not recreate the heap every frame.
+    const uint64_t c_heapGranularity = 4 * 1024 * 1024;
+    m_heapSize = (heapSize + c_heapGranularity - 1) / c_heapGranularity * c_heapGranularity;
+
+    const CD3DX12_HEAP_DESC heapDesc(m_heapSize, D3D12_HEAP_TYPE_DEFAULT, 0, m_heapFlags);
+    ThrowIfFailed(m_deviceResources->GetD3DDevice()->CreateHeap(&heapDesc, IID_PPV_ARGS(m_heap.ReleaseAndGetAddressOf())));
+
+    m_heap->SetName(L"Transient resources");
+}
+
+ResourceHandle D3D12TransientResourceAllocator::Acquire(const TransientResourceDesc& desc, uint64_t heapOffset, ResourceState& state)
+{
+    for (auto& placed : m_resources)
+    {
+        if (placed.resource && placed.offset == heapOffset && placed.desc == desc)
+        {
+            placed.generation = m_generation;
+            state = placed.state;
+            return reinterpret_cast<ResourceHandle>(placed.resource.Get());
+        }
+    }
+
+    // Take a free slot, or the one unused for the longest time. The GPU may still reference it.
+    size_t slot = 0;
+    for (size_t i = 0; i < c_MaxResources; i++)
+    {
+        if (!m_resources[i].resource)
+        {
+            slot = i;
+            break;
+        }
+
+        if (m_resources[i].generation < m_resources[slot].generation)
+        {
+            slot = i;
+        }
+    }
+
+    auto& placed = m_resources[slot];
+    if (placed.resource)
+    {
+        if (placed.generation == m_generation)
+        {
+            throw std::length_error("Too many transient resources");
+        }
+
+        m_deviceResources->WaitForGpu();
+        placed.resource.Reset();
+    }
+
+    auto device = m_deviceResources->GetD3DDevice();
+    const auto resourceDesc = GetResourceDesc(desc);
+    ThrowIfFailed(device->CreatePlacedResource(m_heap.Get(), heapOffset, &resourceDesc, D3D12_RESOURCE_STATE_COMMON,
+        nullptr, IID_PPV_ARGS(placed.resource.ReleaseAndGetAddressOf())));
+
+    wchar_t name[32] = {};
+    swprintf_s(name, L"Transient %u", static_cast<unsigned int>(slot));
+    placed.resource->SetName(name);
+
+    if (desc.flags & TransientResourceFlags_RenderTarget)
+    {
+        const CD3DX12_CPU_DESCRIPTOR_HANDLE rtvDescriptor(m_rtvDescriptorHeap->GetCPUDescriptorHandleForHeapStart(),
+            static_cast<INT>(slot), m_rtvDescriptorSize);
+        device->CreateRenderTargetView(placed.resource.Get(), nullptr, rtvDescriptor);
+    }
+
+    placed.desc = desc;
+    placed.offset = heapOffset;
+    placed.state = ResourceState::Common;
+    placed.generation = m_generation;
+
+    state = placed.state;
+    return reinterpret_cast<ResourceHandle>(placed.resource.Get());
+}
+
+void D3D12TransientResourceAllocator::Release(ResourceHandle resource, ResourceState state)
+{
+    m_resources[FindSlot(resource)].state = state;
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE D3D12TransientResourceAllocator::GetRenderTargetView(ResourceHandle resource) const
+{
+    const size_t slot = FindSlot(resource);
+    if (!(m_resources[slot].desc.flags & TransientResourceFlags_RenderTarget))
+    {
+        throw std::invalid_argument("Transient resource is not a render target");
+    }
+
+    return CD3DX12_CPU_DESCRIPTOR_HANDLE(m_rtvDescriptorHeap->GetCPUDescriptorHandleForHeapStart(),
+        static_cast<INT>(slot), m_rtvDescriptorSize);
+}
+
+void D3D12TransientResourceAllocator::ReleaseResources() noexcept
+{
+    for (auto& placed : m_resources)
+    {
+        placed.resource.Reset();
+    }
+
+    m_heap.Reset();
+    m_heapSize = 0;
+    m_rtvDescriptorHeap.Reset();
+}
+
+D3D12_RESOURCE_DESC D3D12TransientResourceAllocator::GetResourceDesc(const TransientResourceDesc& desc) const
+{
+    D3D12_RESOURCE_FLAGS flags = D3D12_RESOURCE_FLAG_NONE;
+    if (desc.flags & TransientResourceFlags_RenderTarget)
+        flags |= D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET;
+    if (desc.flags & TransientResourceFlags_DepthStencil)
+        flags |= D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
+    if (desc.flags & TransientResourceFlags_UnorderedAccess)
+        flags |= D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+
+    if (m_heapFlags == D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES
+        && (desc.type != TransientResourceType::Texture2D || !(desc.flags & (TransientResourceFlags_RenderTarget | TransientResourceFlags_DepthStencil))))
+    {
+        throw std::invalid_argument("Resource heap tier 1 only supports render target and depth stencil transients");
+    }
+
+    if (desc.type == TransientResourceType::Buffer)
+    {
+        return CD3DX12_RESOURCE_DESC::Buffer(desc.width, flags);
+    }
+
+    return CD3DX12_RESOURCE_DESC::Tex2D(static_cast<DXGI_FORMAT>(desc.format), desc.width, desc.height, 1, 1, 1, 0, flags);
+}
+
+void D3D12TransientResourceAllocator::CreateDescriptorHeap()
+{
+    if (m_rtvDescriptorHeap)
+        return;
+
+    auto device = m_deviceResources->GetD3DDevice();
+
+    D3D12_DESCRIPTOR_HEAP_DESC rtvDescriptorHeapDesc = {};
+    rtvDescriptorHeapDesc.NumDescriptors = c_MaxResources;
+    rtvDescriptorHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
+
+    ThrowIfFailed(device->CreateDescriptorHeap(&rtvDescriptorHeapDesc, IID_PPV_ARGS(m_rtvDescriptorHeap.ReleaseAndGetAddressOf())));
+
+    m_rtvDescriptorHeap->SetName(L"Transient resources");
+    m_rtvDescriptorSize = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
+
+    // Tier 1 hardware cannot mix render targets with other resources in one heap.
+    D3D12_FEATURE_DATA_D3D12_OPTIONS options = {};
+    if (SUCCEEDED(device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS, &options, sizeof(options)))
+        && options.ResourceHeapTier >= D3D12_RESOURCE_HEAP_TIER_2)
+    {
+        m_heapFlags = D3D12_HEAP_FLAG_NONE;
+    }
+    else
+    {
+        m_heapFlags = D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES;
+    }
+}
+
+size_t D3D12TransientResourceAllocator::FindSlot(ResourceHandle resource) const
+{
+    for (size_t i = 0; i < c_MaxResources; i++)
+    {
+        if (m_resources[i].resource && reinterpret_cast<ResourceHandle>(m_resources[i].resource.Get()) == resource)
+            return i;
+    }
+
+    throw std::invalid_argument("Resource was not placed by this allocator");
+}
@@ -4,20 +4,137 @@
 
 #pragma once
 
+#include "DescriptorAllocator.h"
+#include "GpuProfiler.h"
+#include "ParallelCommandRecorder.h"
+#include "RenderGraph.h"
+#include "UploadRing.h"
+
 namespace DX
 {
-    // Provides an interface for an application that owns DeviceResources to be notified of the device being lost or created.
-    interface IDeviceNotify
+    // IFence on top of an ID3D12Fence signaled from the direct command queue.
+    class D3D12Fence final : public IFence
+    {
+    public:
+        void Create(ID3D12Device* device, ID3D12CommandQueue* commandQueue);
+        void Reset() noexcept;
+        bool IsValid() const noexcept { return m_fence && m_commandQueue && m_fenceEvent.IsValid(); }
+
+        uint64_t GetCompletedValue() const override { return m_fence->GetCompletedValue(); }
+        void Signal(uint64_t value) override;
+        void Wait(uint64_t value) override;
+
+    private:
+        Microsoft::WRL::ComPtr<ID3D12Fence>                 m_fence;
+        Microsoft::WRL::ComPtr<ID3D12CommandQueue>          m_commandQueue;
+        Microsoft::WRL::Wrappers::Event                     m_fenceEvent;
+    };
+
+    // ITimestampSource on top of a timestamp query heap and a readback buffer, mapped for its lifetime,
+    // that the queries are resolved into.
+    class D3D12TimestampQueries final : public ITimestampSource
+    {
+    public:
+        D3D12TimestampQueries() noexcept : m_frequency(0), m_timestamps(nullptr) {}
+
+        void Create(ID3D12Device* device, ID3D12CommandQueue* commandQueue, uint32_t queryCount);
+        void Reset() noexcept;
+        bool IsValid() const noexcept { return m_queryHeap && m_timestamps; }
+
+        void EndQuery(ID3D12GraphicsCommandList* commandList, uint32_t query) const noexcept;
+        void ResolveQueries(ID3D12GraphicsCommandList* commandList, uint32_t first, uint32_t count) const noexcept;
+
+        // ITimestampSource
+        uint64_t GetTimestampFrequency() override { return m_frequency; }
+        void ReadTimestamps(uint32_t first, uint32_t count, uint64_t* timestamps) override;
+
+    private:
+        Microsoft::WRL::ComPtr<ID3D12QueryHeap>             m_queryHeap;
+        Microsoft::WRL::ComPtr<ID3D12Resource>              m_readbackBuffer;
+        uint64_t                                            m_frequency;
+        const uint64_t*                                     m_timestamps;
+    };
+
+    class DeviceResources;
+
+    // A pooled direct command list with its own allocator, recorded on a worker thread.
+    class D3D12CommandContext final : public ICommandContext, public ICommandSink
+    {
+    public:
+        D3D12CommandContext(DeviceResources* deviceResources, unsigned int frameIndex, unsigned int slot);
+
+        // ICommandContext
+        void Begin() override;
+        void End() override;
+        ICommandSink* GetCommandSink() noexcept override { return this; }
+
+        // ICommandSink
+        void BeginEvent(const wchar_t* name) override;
+        void EndEvent() override;
+        void ResourceBarriers(uint32_t count, const ResourceBarrier* barriers) override;
+        void SetRenderTarget() override;
+        void ClearRenderTarget(const float color[4]) override;
+        void ClearDepthStencil(float depth) override;
+        void Draw(uint32_t vertexCount, uint32_t instanceCount) override;
+
+        ID3D12GraphicsCommandList* GetCommandList() const noexcept { return m_commandList.Get(); }
+
+    private:
+        DeviceResources*                                    m_deviceResources;
+        Microsoft::WRL::ComPtr<ID3D12CommandAllocator>      m_commandAllocator;
+        Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList>   m_commandList;
+        std::vector<uint32_t>                               m_gpuScopes;
+    };
+
+    // Places render graph transients in one default heap. Growing the heap waits for the GPU and
+    // recreates every placed resource. Render target views are created for render target transients.
+    class D3D12TransientResourceAllocator final : public ITransientResourceAllocator
     {
-        virtual void OnDeviceLost() = 0;
-        virtual void OnDeviceRestored() = 0;
+    public:
+        static const unsigned int c_MaxResources = 16;
+
+        explicit D3D12TransientResourceAllocator(DeviceResources* deviceResources) noexcept :
+            m_deviceResources(deviceResources), m_heapSize(0), m_heapFlags(D3D12_HEAP_FLAG_NONE), m_rtvDescriptorSize(0), m_generation(0) {}
+
+        // ITransientResourceAllocator
+        void GetAllocationInfo(const TransientResourceDesc& desc, uint64_t& size, uint64_t& alignment) override;
+        void Reserve(uint64_t heapSize) override;
+        ResourceHandle Acquire(const TransientResourceDesc& desc, uint64_t heapOffset, ResourceState& state) override;
+        void Release(ResourceHandle resource, ResourceState state) override;
 
-    protected:
-        ~IDeviceNotify() = default;
+        D3D12_CPU_DESCRIPTOR_HANDLE GetRenderTargetView(ResourceHandle resource) const;
+
+        // Drop the heap and everything placed in it, e.g. on device lost.
+        void ReleaseResources() noexcept;
+
+    private:
+        struct PlacedResource
+        {
+            TransientResourceDesc                           desc;
+            uint64_t                                        offset;
+            Microsoft::WRL::ComPtr<ID3D12Resource>          resource;
+            ResourceState                                   state;
+            uint64_t                                        generation;
+        };
+
+        void CreateDescriptorHeap();
+        D3D12_RESOURCE_DESC GetResourceDesc(const TransientResourceDesc& desc) const;
+        size_t FindSlot(ResourceHandle resource) const;
+
+        DeviceResources*                                    m_deviceResources;
+        Microsoft::WRL::ComPtr<ID3D12Heap>                  m_heap;
+        uint64_t                                            m_heapSize;
+        D3D12_HEAP_FLAGS                                    m_heapFlags;
+        Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>        m_rtvDescriptorHeap;
+        UINT                                                m_rtvDescriptorSize;
+        uint64_t                                            m_generation;
+
+        // Slot i owns descriptor i of m_rtvDescriptorHeap.
+        PlacedResource                                      m_resources[c_MaxResources];
     };
 
     // Controls all the DirectX device resources.
-    class DeviceResources
+    class DeviceResources final : public IRenderBackend, public ICommandSink, public ICommandContextFactory
     {
     public:
         static const unsigned int c_AllowTearing    = 0x1;
@@ -28,24 +145,61 @@ namespace DX
                         UINT backBufferCount = 2,
                         D3D_FEATURE_LEVEL minFeatureLevel = D3D_FEATURE_LEVEL_11_0,
                         unsigned int flags = 0) noexcept(false);
-        ~DeviceResources();
+        ~DeviceResources() override;
 
-        DeviceResources(DeviceResources&&) = default;
-        DeviceResources& operator= (DeviceResources&&) = default;
+        // The frame pacer points at m_fence, and the transient allocator and command contexts at this object.
+        DeviceResources(DeviceResources&&) = delete;
+        DeviceResources& operator= (DeviceResources&&) = delete;
 
         DeviceResources(DeviceResources const&) = delete;
         DeviceResources& operator= (DeviceResources const&) = delete;
 
-        void CreateDeviceResources();
-        void CreateWindowSizeDependentResources();
+        // IRenderBackend
+        void CreateDeviceResources() override;
+        void CreateWindowSizeDependentResources() override;
+        bool WindowSizeChanged(int width, int height) override;
+        void RegisterDeviceNotify(IDeviceNotify* deviceNotify) noexcept override { m_deviceNotify = deviceNotify; }
+        void Prepare(ResourceState beforeState = ResourceState::Present,
+                     ResourceState afterState = ResourceState::RenderTarget) override;
+        void Present(ResourceState beforeState = ResourceState::RenderTarget) override;
+        void WaitForGpu() noexcept override;
+        void SetFramesInFlight(unsigned int framesInFlight) override;
+        const FramePacer& GetFramePacer() const noexcept override { return m_framePacer; }
+
+        int             GetOutputWidth() const noexcept override        { return m_outputSize.right - m_outputSize.left; }
+        int             GetOutputHeight() const noexcept override       { return m_outputSize.bottom - m_outputSize.top; }
+        unsigned int    GetCurrentFrameIndex() const noexcept override  { return m_backBufferIndex; }
+        unsigned int    GetBackBufferCount() const noexcept override    { return m_backBufferCount; }
+        ResourceHandle  GetRenderTargetHandle() const noexcept override { return reinterpret_cast<ResourceHandle>(GetRenderTarget()); }
+        ResourceHandle  GetDepthStencilHandle() const noexcept override { return reinterpret_cast<ResourceHandle>(GetDepthStencil()); }
+        ICommandSink*   GetCommandSink() noexcept override              { return this; }
+        ICommandContextFactory* GetCommandContextFactory() noexcept override { return this; }
+        ITransientResourceAllocator* GetTransientResourceAllocator() noexcept override { return &m_transientAllocator; }
+        D3D12TransientResourceAllocator& GetD3D12TransientResourceAllocator() noexcept { return m_transientAllocator; }
+        UploadRing&     GetUploadRing() noexcept override               { return *m_uploadRing; }
+        DescriptorAllocator& GetDescriptorAllocator() noexcept override { return *m_descriptorAllocator; }
+        GpuProfiler&    GetGpuProfiler() noexcept override              { return *m_gpuProfiler; }
+
+        // ICommandContextFactory. The first Submit of a frame closes the main command list; anything
+        // recorded through GetCommandList() afterwards lands in a trailing list that executes after
+        // the submitted contexts, in the same ExecuteCommandLists call.
+        std::unique_ptr<ICommandContext> CreateContext(unsigned int frameIndex, unsigned int slot) override;
+        void Submit(unsigned int count, ICommandContext* const* contexts) override;
+
+        // ICommandSink (records into the frame command list)
+        void BeginEvent(const wchar_t* name) override;
+        void EndEvent() override;
+        void ResourceBarriers(uint32_t count, const ResourceBarrier* barriers) override;
+        void SetRenderTarget() override;
+        void ClearRenderTarget(const float color[4]) override;
+        void ClearDepthStencil(float depth) override;
+        void Draw(uint32_t vertexCount, uint32_t instanceCount) override;
+
         void SetWindow(HWND window, int width, int height) noexcept;
-        bool WindowSizeChanged(int width, int height);
         void HandleDeviceLost();
-        void RegisterDeviceNotify(IDeviceNotify* deviceNotify) noexcept { m_deviceNotify = deviceNotify; }
-        void Prepare(D3D12_RESOURCE_STATES beforeState = D3D12_RESOURCE_STATE_PRESENT,
-                     D3D12_RESOURCE_STATES afterState = D3D12_RESOURCE_STATE_RENDER_TARGET);
-        void Present(D3D12_RESOURCE_STATES beforeState = D3D12_RESOURCE_STATE_RENDER_TARGET);
-        void WaitForGpu() noexcept;
+
+        // Bind the current back buffer and depth buffer with a full-screen viewport on any command list.
+        void BindRenderTarget(ID3D12GraphicsCommandList* commandList) const noexcept;
 
         // Device Accessors.
         RECT GetOutputSize() const noexcept { return m_outputSize; }
@@ -59,14 +213,14 @@ namespace DX
         ID3D12Resource*             GetRenderTarget() const noexcept       { return m_renderTargets[m_backBufferIndex].Get(); }
         ID3D12Resource*             GetDepthStencil() const noexcept       { return m_depthStencil.Get(); }
         ID3D12CommandQueue*         GetCommandQueue() const noexcept       { return m_commandQueue.Get(); }
-        ID3D12CommandAllocator*     GetCommandAllocator() const noexcept   { return m_commandAllocators[m_backBufferIndex].Get(); }
-        auto                        GetCommandList() const noexcept        { return m_commandList.Get(); }
+        ID3D12CommandAllocator*     GetCommandAllocator() const noexcept   { return m_commandAllocators[m_framePacer.GetFrameIndex()].Get(); }
+        ID3D12GraphicsCommandList*  GetCommandList() const noexcept        { return m_currentCommandList; }
+        ID3D12Resource*             GetUploadBuffer() const noexcept       { return m_uploadBuffer.Get(); }
+        ID3D12DescriptorHeap*       GetShaderVisibleHeap() const noexcept  { return m_shaderVisibleHeap.Get(); }
         DXGI_FORMAT                 GetBackBufferFormat() const noexcept   { return m_backBufferFormat; }
         DXGI_FORMAT                 GetDepthBufferFormat() const noexcept  { return m_depthBufferFormat; }
         D3D12_VIEWPORT              GetScreenViewport() const noexcept     { return m_screenViewport; }
         D3D12_RECT                  GetScissorRect() const noexcept        { return m_scissorRect; }
-        UINT                        GetCurrentFrameIndex() const noexcept  { return m_backBufferIndex; }
-        UINT                        GetBackBufferCount() const noexcept    { return m_backBufferCount; }
         DXGI_COLOR_SPACE_TYPE       GetColorSpace() const noexcept         { return m_colorSpace; }
         unsigned int                GetDeviceOptions() const noexcept      { return m_options; }
 
@@ -81,20 +235,53 @@ namespace DX
             return CD3DX12_CPU_DESCRIPTOR_HANDLE(m_dsvDescriptorHeap->GetCPUDescriptorHandleForHeapStart());
         }
 
+        // Descriptors of the shader-visible heap, by DescriptorAllocator index. The heap is bound on every
+        // command list the device resources hand out, so passes never switch heaps.
+        CD3DX12_CPU_DESCRIPTOR_HANDLE GetCpuDescriptorHandle(uint32_t index) const noexcept
+        {
+            return CD3DX12_CPU_DESCRIPTOR_HANDLE(m_shaderVisibleHeap->GetCPUDescriptorHandleForHeapStart(),
+                static_cast<INT>(index), m_shaderVisibleDescriptorSize);
+        }
+        CD3DX12_GPU_DESCRIPTOR_HANDLE GetGpuDescriptorHandle(uint32_t index) const noexcept
+        {
+            return CD3DX12_GPU_DESCRIPTOR_HANDLE(m_shaderVisibleHeap->GetGPUDescriptorHandleForHeapStart(),
+                static_cast<INT>(index), m_shaderVisibleDescriptorSize);
+        }
+        void SetShaderVisibleHeap(ID3D12GraphicsCommandList* commandList) const noexcept;
+
+        // Write the timestamps of a GPU profiler scope on any command list recorded this frame. BeginGpuScope
+        // returns GpuProfiler::c_InvalidScope, which EndGpuScope ignores, once the frame's scopes are used up.
+        uint32_t BeginGpuScope(ID3D12GraphicsCommandList* commandList, const wchar_t* name) noexcept;
+        void EndGpuScope(ID3D12GraphicsCommandList* commandList, uint32_t scope) noexcept;
+
     private:
         void MoveToNextFrame();
+        void CreateCommandAllocators();
         void GetAdapter(IDXGIAdapter1** ppAdapter);
         void UpdateColorSpace();
 
         static const size_t MAX_BACK_BUFFER_COUNT = 3;
+        static const UINT64 c_UploadRingSize = 64 * 1024 * 1024;
+        static constexpr uint32_t c_PersistentDescriptorCount = 4096;
+        static constexpr uint32_t c_TransientDescriptorsPerFrame = 256;
+        static constexpr uint32_t c_MaxGpuScopesPerFrame = 128;
 
         UINT                                                m_backBufferIndex;
 
         // Direct3D objects.
         Microsoft::WRL::ComPtr<ID3D12Device>                m_d3dDevice;
         Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList>   m_commandList;
+        Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList>   m_trailingCommandList;
+        ID3D12GraphicsCommandList*                          m_currentCommandList;
+        std::vector<ID3D12CommandList*>                     m_submittedCommandLists;
         Microsoft::WRL::ComPtr<ID3D12CommandQueue>          m_commandQueue;
-        Microsoft::WRL::ComPtr<ID3D12CommandAllocator>      m_commandAllocators[MAX_BACK_BUFFER_COUNT];
+        Microsoft::WRL::ComPtr<ID3D12CommandAllocator>      m_commandAllocators[FramePacer::c_MaxFramesInFlight];
+        D3D12TransientResourceAllocator                     m_transientAllocator;
+
+        // One upload heap buffer, mapped for its lifetime, that the upload ring sub-allocates.
+        // The ring is heap allocated so it survives moves.
+        Microsoft::WRL::ComPtr<ID3D12Resource>              m_uploadBuffer;
+        std::unique_ptr<UploadRing>                         m_uploadRing;
 
         // Swap chain objects.
         Microsoft::WRL::ComPtr<IDXGIFactory4>               m_dxgiFactory;
@@ -102,15 +289,29 @@ namespace DX
         Microsoft::WRL::ComPtr<ID3D12Resource>              m_renderTargets[MAX_BACK_BUFFER_COUNT];
         Microsoft::WRL::ComPtr<ID3D12Resource>              m_depthStencil;
 
-        // Presentation fence objects.
-        Microsoft::WRL::ComPtr<ID3D12Fence>                 m_fence;
-        UINT64                                              m_fenceValues[MAX_BACK_BUFFER_COUNT];
-        Microsoft::WRL::Wrappers::Event                     m_fenceEvent;
+        // Presentation fence objects. Command allocators are indexed by the pacer's frame index,
+        // render targets by the swap chain's back buffer index.
+        D3D12Fence                                          m_fence;
+        FramePacer                                          m_framePacer;
 
         // Direct3D rendering objects.
         Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>        m_rtvDescriptorHeap;
         Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>        m_dsvDescriptorHeap;
         UINT                                                m_rtvDescriptorSize;
+
+        // The shared CBV/SRV/UAV heap. The allocator outlives device loss so persistent handles held
+        // across it stay valid; it is heap allocated so it survives moves.
+        Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>        m_shaderVisibleHeap;
+        UINT                                                m_shaderVisibleDescriptorSize;
+        std::unique_ptr<DescriptorAllocator>                m_descriptorAllocator;
+
+        // One block of timestamp queries per frame in flight, resolved at the end of the frame and read
+        // once its fence completes. The profiler keeps its history across device loss.
+        D3D12TimestampQueries                               m_timestampQueries;
+        std::unique_ptr<GpuProfiler>                        m_gpuProfiler;
+        uint32_t                                            m_frameGpuScope;
+        std::vector<uint32_t>                               m_gpuScopes;
+
         D3D12_VIEWPORT                                      m_screenViewport;
         D3D12_RECT                                          m_scissorRect;
 
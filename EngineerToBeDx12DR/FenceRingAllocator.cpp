@@ -0,0 +1,114 @@
+//
+// FenceRingAllocator.cpp - Ring buffer sub-allocator whose space is reclaimed as GPU fences complete
+//
+
+#include "FenceRingAllocator.h"
+
+#include <stdexcept>
+
+using namespace DX;
+
+// Constructor for FenceRingAllocator.
+FenceRingAllocator::FenceRingAllocator(uint64_t capacity) noexcept :
+    m_capacity(capacity),
+    m_head(0),
+    m_tail(0),
+    m_used(0),
+    m_pendingSize(0),
+    m_wrapCount(0)
+{
+}
+
+uint64_t FenceRingAllocator::Allocate(uint64_t size, uint64_t alignment)
+{
+    if (alignment == 0 || (alignment & (alignment - 1)) != 0)
+    {
+        throw std::invalid_argument("alignment must be a power of two");
+    }
+
+    if (size == 0 || size > m_capacity || m_used == m_capacity)
+    {
+        return c_InvalidOffset;
+    }
+
+    if (m_used == 0)
+    {
+        // Empty: restart at the beginning so a large allocation is not split by a stale head.
+        m_head = 0;
+        m_tail = 0;
+    }
+
+    const uint64_t aligned = (m_head + alignment - 1) & ~(alignment - 1);
+    uint64_t offset = c_InvalidOffset;
+    uint64_t consumed = 0;
+
+    if (m_head >= m_tail)
+    {
+        // Free space is [head, capacity) followed by [0, tail).
+        if (aligned + size <= m_capacity)
+        {
+            offset = aligned;
+            consumed = aligned + size - m_head;
+        }
+        else if (size <= m_tail)
+        {
+            offset = 0;
+            consumed = (m_capacity - m_head) + size;
+            m_wrapCount++;
+        }
+    }
+    else if (aligned + size <= m_tail)
+    {
+        // Wrapped: free space is [head, tail).
+        offset = aligned;
+        consumed = aligned + size - m_head;
+    }
+
+    if (offset == c_InvalidOffset)
+    {
+        return c_InvalidOffset;
+    }
+
+    m_head = offset + size;
+    if (m_head == m_capacity)
+    {
+        m_head = 0;
+    }
+
+    m_used += consumed;
+    m_pendingSize += consumed;
+    return offset;
+}
+
+void FenceRingAllocator::Finish(uint64_t fenceValue)
+{
+    if (m_pendingSize == 0)
+        return;
+
+    if (!m_groups.empty() && fenceValue < m_groups.back().fenceValue)
+    {
+        throw std::logic_error("Fence values must not decrease");
+    }
+
+    m_groups.push_back({ fenceValue, m_head, m_pendingSize });
+    m_pendingSize = 0;
+}
+
+void FenceRingAllocator::Retire(uint64_t completedFenceValue) noexcept
+{
+    while (!m_groups.empty() && m_groups.front().fenceValue <= completedFenceValue)
+    {
+        m_tail = m_groups.front().end;
+        m_used -= m_groups.front().size;
+        m_groups.pop_front();
+    }
+}
+
+void FenceRingAllocator::Reset() noexcept
+{
+    m_head = 0;
+    m_tail = 0;
+    m_used = 0;
+    m_pendingSize = 0;
+    m_groups.clear();
+}
@@ -0,0 +1,64 @@
+//
+// FenceRingAllocator.h - Ring buffer sub-allocator whose space is reclaimed as GPU fences complete
+//
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+
+
+namespace DX
+{
+    // Hands out offsets into a ring of `capacity` bytes; the memory itself belongs to the caller, e.g. a
+    // persistently mapped upload buffer. Allocations are grouped by the fence value passed to Finish and
+    // become free again once Retire sees that value complete. An allocation never wraps: if it does not
+    // fit before the end of the ring, the rest of the ring is skipped and it starts at offset 0.
+    class FenceRingAllocator
+    {
+    public:
+        static const uint64_t c_InvalidOffset = UINT64_MAX;
+
+        explicit FenceRingAllocator(uint64_t capacity = 0) noexcept;
+
+        FenceRingAllocator(FenceRingAllocator&&) = default;
+        FenceRingAllocator& operator= (FenceRingAllocator&&) = default;
+
+        FenceRingAllocator(FenceRingAllocator const&) = delete;
+        FenceRingAllocator& operator= (FenceRingAllocator const&) = delete;
+
+        // Returns c_InvalidOffset if there is not enough free space; retire completed fences and try again later.
+        // alignment must be a power of two.
+        uint64_t Allocate(uint64_t size, uint64_t alignment = 1);
+
+        // Everything allocated since the previous Finish is in use until fenceValue completes.
+        void Finish(uint64_t fenceValue);
+
+        // Reclaim the space of every group whose fence value is at most completedFenceValue.
+        void Retire(uint64_t completedFenceValue) noexcept;
+
+        // Forget all allocations, e.g. once the GPU is idle.
+        void Reset() noexcept;
+
+        uint64_t GetCapacity() const noexcept { return m_capacity; }
+        uint64_t GetUsedSize() const noexcept { return m_used; }
+        uint64_t GetFreeSize() const noexcept { return m_capacity - m_used; }
+        uint64_t GetWrapCount() const noexcept { return m_wrapCount; }
+
+    private:
+        struct Group
+        {
+            uint64_t    fenceValue;
+            uint64_t    end;    // head at the time of Finish
+            uint64_t    size;   // bytes including alignment padding and skipped tails
+        };
+
+        uint64_t            m_capacity;
+        uint64_t            m_head;
+        uint64_t            m_tail;
+        uint64_t            m_used;
+        uint64_t            m_pendingSize;
+        uint64_t            m_wrapCount;
+        std::deque<Group>   m_groups;
+    };
+}
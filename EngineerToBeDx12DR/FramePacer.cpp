@@ -0,0 +1,97 @@
+//
+// FramePacer.cpp - Tracks frames in flight with a ring of fence values
+//
+
+#include "FramePacer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+using namespace DX;
+
+// Constructor for FramePacer.
+FramePacer::FramePacer(unsigned int framesInFlight) noexcept(false) :
+    m_fence(nullptr),
+    m_framesInFlight(framesInFlight),
+    m_frameIndex(0),
+    m_frameCount(0),
+    m_lastSignaledValue(0),
+    m_fenceValues{},
+    m_lastStallSeconds(0),
+    m_totalStallSeconds(0),
+    m_stalledFrameCount(0)
+{
+    if (framesInFlight < 1 || framesInFlight > c_MaxFramesInFlight)
+    {
+        throw std::out_of_range("invalid framesInFlight");
+    }
+}
+
+void FramePacer::SetFramesInFlight(unsigned int framesInFlight)
+{
+    // The value comes from settings and the UI at runtime, so out-of-range requests are clamped rather than fatal.
+    framesInFlight = std::min(std::max(framesInFlight, 1u), c_MaxFramesInFlight);
+
+    if (framesInFlight == m_framesInFlight)
+    {
+        return;
+    }
+
+    // Every slot is free once the GPU is idle, so the ring can be resized without remapping.
+    WaitForIdle();
+
+    m_framesInFlight = framesInFlight;
+    m_frameIndex = 0;
+}
+
+void FramePacer::EndFrame()
+{
+    if (!m_fence)
+    {
+        throw std::logic_error("FramePacer has no fence");
+    }
+
+    // Schedule a Signal behind the frame that was just submitted.
+    const uint64_t fenceValue = ++m_lastSignaledValue;
+    m_fence->Signal(fenceValue);
+    m_fenceValues[m_frameIndex] = fenceValue;
+
+    m_frameIndex = (m_frameIndex + 1) % m_framesInFlight;
+    m_frameCount++;
+
+    // If the slot we are about to record into is still in use on the GPU, wait until it is ready.
+    m_lastStallSeconds = 0;
+    const uint64_t slotFenceValue = m_fenceValues[m_frameIndex];
+    if (m_fence->GetCompletedValue() < slotFenceValue)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        m_fence->Wait(slotFenceValue);
+        m_lastStallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        m_totalStallSeconds += m_lastStallSeconds;
+        m_stalledFrameCount++;
+    }
+}
+
+void FramePacer::WaitForIdle()
+{
+    if (!m_fence)
+    {
+        return;
+    }
+
+    // Every submission is followed by a signal in EndFrame, so waiting on the last one covers all of them.
+    // Signaling a new value here would complete the current frame's fence value before its work is submitted.
+    m_fence->Wait(m_lastSignaledValue);
+}
+
+void FramePacer::Reset() noexcept
+{
+    m_frameIndex = 0;
+    m_lastSignaledValue = 0;
+    for (auto& value : m_fenceValues)
+    {
+        value = 0;
+    }
+}
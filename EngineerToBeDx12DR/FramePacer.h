@@ -0,0 +1,90 @@
+//
+// FramePacer.h - Tracks frames in flight with a ring of fence values
+//
+
+#pragma once
+
+#include <cstdint>
+
+
+namespace DX
+{
+    // GPU progress as seen by the CPU. Implemented on top of ID3D12Fence, or simulated for tests.
+    class IFence
+    {
+    public:
+        virtual uint64_t GetCompletedValue() const = 0;
+
+        // Enqueue a signal behind all work submitted so far.
+        virtual void Signal(uint64_t value) = 0;
+
+        // Block the calling thread until GetCompletedValue() >= value.
+        virtual void Wait(uint64_t value) = 0;
+
+    protected:
+        ~IFence() = default;
+    };
+
+    // Lets the CPU record up to N frames ahead of the GPU. Each frame slot remembers the fence value
+    // signaled after its submission, and the CPU only waits when it is about to reuse a slot that
+    // the GPU has not finished with yet.
+    class FramePacer
+    {
+    public:
+        static constexpr unsigned int c_MaxFramesInFlight = 8;
+
+        explicit FramePacer(unsigned int framesInFlight = 2) noexcept(false);
+
+        FramePacer(FramePacer&&) = default;
+        FramePacer& operator= (FramePacer&&) = default;
+
+        FramePacer(FramePacer const&) = delete;
+        FramePacer& operator= (FramePacer const&) = delete;
+
+        // The fence must outlive the pacer, or be replaced before it is destroyed.
+        void SetFence(IFence* fence) noexcept { m_fence = fence; }
+
+        // Waits for the GPU to go idle, then changes the ring size, clamped to 1 to c_MaxFramesInFlight.
+        void SetFramesInFlight(unsigned int framesInFlight);
+        unsigned int GetFramesInFlight() const noexcept { return m_framesInFlight; }
+
+        // Ring slot of the frame currently being recorded; use it to index per-frame resources.
+        unsigned int GetFrameIndex() const noexcept { return m_frameIndex; }
+
+        // Number of frames submitted so far.
+        uint64_t GetFrameCount() const noexcept { return m_frameCount; }
+
+        // Fence value that will be signaled when the frame currently being recorded completes.
+        uint64_t GetCurrentFenceValue() const noexcept { return m_lastSignaledValue + 1; }
+
+        // Latest fence value the GPU has reached; without a fence every submitted frame counts as complete.
+        uint64_t GetCompletedFenceValue() const { return m_fence ? m_fence->GetCompletedValue() : m_lastSignaledValue; }
+
+        // Mark the current frame as submitted and advance to the next slot, waiting only
+        // if the GPU is still using that slot.
+        void EndFrame();
+
+        // Block until every frame submitted through EndFrame has completed.
+        void WaitForIdle();
+
+        // Forget all fence history, e.g. after the fence has been recreated.
+        void Reset() noexcept;
+
+        // CPU time spent blocked in EndFrame.
+        double GetLastStallSeconds() const noexcept { return m_lastStallSeconds; }
+        double GetTotalStallSeconds() const noexcept { return m_totalStallSeconds; }
+        uint64_t GetStalledFrameCount() const noexcept { return m_stalledFrameCount; }
+
+    private:
+        IFence*         m_fence;
+        unsigned int    m_framesInFlight;
+        unsigned int    m_frameIndex;
+        uint64_t        m_frameCount;
+        uint64_t        m_lastSignaledValue;
+        uint64_t        m_fenceValues[c_MaxFramesInFlight];
+
+        double          m_lastStallSeconds;
+        double          m_totalStallSeconds;
+        uint64_t        m_stalledFrameCount;
+    };
+}
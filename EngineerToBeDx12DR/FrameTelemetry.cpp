@@ -0,0 +1,280 @@
+//
+// FrameTelemetry.cpp - Frame time histogram, stutter detection and a binary log for soak runs
+//
+
+#include "FrameTelemetry.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <stdexcept>
+
+using namespace DX;
+
+// Constructor for FrameTimeHistogram.
+FrameTimeHistogram::FrameTimeHistogram() noexcept(false) :
+    m_buckets(c_BucketCount, 0),
+    m_count(0),
+    m_min(UINT64_MAX),
+    m_max(0),
+    m_sum(0)
+{
+}
+
+// Values below c_SubBucketCount have a bucket each. Above that, a value is shifted down until it fits
+// the upper half of the sub-buckets, and every shift starts a new row of c_SubBucketHalfCount buckets.
+size_t FrameTimeHistogram::GetBucketIndex(uint64_t value) noexcept
+{
+    if (value < c_SubBucketCount)
+        return static_cast<size_t>(value);
+
+    const unsigned int shift = static_cast<unsigned int>(std::bit_width(value)) - c_SubBucketBits;
+    return (shift + 1) * c_SubBucketHalfCount + static_cast<size_t>((value >> shift) - c_SubBucketHalfCount);
+}
+
+uint64_t FrameTimeHistogram::GetBucketLowerBound(size_t index) noexcept
+{
+    if (index < c_SubBucketCount)
+        return index;
+
+    const size_t shift = index / c_SubBucketHalfCount - 1;
+    return uint64_t(index % c_SubBucketHalfCount + c_SubBucketHalfCount) << shift;
+}
+
+uint64_t FrameTimeHistogram::GetBucketUpperBound(size_t index) noexcept
+{
+    if (index < c_SubBucketCount)
+        return index;
+
+    const size_t shift = index / c_SubBucketHalfCount - 1;
+    return GetBucketLowerBound(index) + ((uint64_t(1) << shift) - 1);
+}
+
+void FrameTimeHistogram::Record(uint64_t value) noexcept
+{
+    m_buckets[GetBucketIndex(value)]++;
+    m_count++;
+    m_min = std::min(m_min, value);
+    m_max = std::max(m_max, value);
+    m_sum += value;
+}
+
+void FrameTimeHistogram::Reset() noexcept
+{
+    std::fill(m_buckets.begin(), m_buckets.end(), 0);
+    m_count = 0;
+    m_min = UINT64_MAX;
+    m_max = 0;
+    m_sum = 0;
+}
+
+uint64_t FrameTimeHistogram::GetValueAtPercentile(double percentile) const noexcept
+{
+    if (m_count == 0)
+        return 0;
+
+    const double clamped = std::min(std::max(percentile, 0.0), 100.0);
+    // Multiplied before dividing, so e.g. 99.9% of 1000 frames is rank 999 and not 1000.
+    const uint64_t rank = std::max<uint64_t>(static_cast<uint64_t>(std::ceil(clamped * double(m_count) / 100.0)), 1);
+
+    uint64_t seen = 0;
+    for (size_t index = GetBucketIndex(GetMin()); index < c_BucketCount; index++)
+    {
+        seen += m_buckets[index];
+        if (seen >= rank)
+        {
+            return std::min(GetBucketUpperBound(index), m_max);
+        }
+    }
+
+    return m_max;
+}
+
+// Constructor for FrameTelemetry.
+FrameTelemetry::FrameTelemetry(uint32_t windowFrames, double stutterFactor, uint64_t stutterMinimumExcessTicks) noexcept(false) :
+    m_windowFrames(windowFrames),
+    m_stutterFactor(stutterFactor),
+    m_stutterMinimumExcessTicks(stutterMinimumExcessTicks),
+    m_frameCount(0),
+    m_stutterCount(0),
+    m_clampedCount(0),
+    m_baselineTicks(0.0),
+    m_lastFrameStutter(false),
+    m_windowFirstFrame(0),
+    m_windowStutterCount(0),
+    m_windowClampedCount(0),
+    m_lastWindow{}
+{
+    if (windowFrames == 0)
+    {
+        throw std::out_of_range("windowFrames must not be 0");
+    }
+
+    if (!(stutterFactor > 1.0))
+    {
+        throw std::out_of_range("stutterFactor must be greater than 1");
+    }
+}
+
+FrameTelemetry::~FrameTelemetry()
+{
+    try
+    {
+        CloseLog();
+    }
+    catch (const std::exception&)
+    {
+        // A log that cannot be finished keeps the windows already written.
+    }
+}
+
+bool FrameTelemetry::RecordFrame(uint64_t rawElapsedTicks, bool clamped)
+{
+    const double ticks = double(rawElapsedTicks);
+
+    // A clamped frame is always a stutter. Otherwise the first frame only seeds the baseline.
+    bool stutter = clamped;
+    if (m_frameCount == 0)
+    {
+        m_baselineTicks = ticks;
+    }
+    else
+    {
+        stutter = stutter
+            || (ticks > m_baselineTicks * m_stutterFactor && ticks - m_baselineTicks >= double(m_stutterMinimumExcessTicks));
+
+        // An exponential moving average over roughly the last 16 frames. A stutter only pulls it up by as much
+        // as a frame at the threshold would, so single hitches barely move it but a lasting slowdown becomes
+        // the new baseline within a few dozen frames.
+        m_baselineTicks += (std::min(ticks, m_baselineTicks * m_stutterFactor) - m_baselineTicks) / 16.0;
+    }
+
+    m_total.Record(rawElapsedTicks);
+    m_window.Record(rawElapsedTicks);
+    m_frameCount++;
+    m_lastFrameStutter = stutter;
+
+    if (stutter)
+    {
+        m_stutterCount++;
+        m_windowStutterCount++;
+    }
+
+    if (clamped)
+    {
+        m_clampedCount++;
+        m_windowClampedCount++;
+    }
+
+    if (m_window.GetCount() >= m_windowFrames)
+    {
+        CloseWindow();
+    }
+
+    return stutter;
+}
+
+void FrameTelemetry::OpenLog(const std::filesystem::path& path)
+{
+    CloseLog();
+
+    FrameTelemetryHeader header = {};
+    header.magic = c_FrameTelemetryMagic;
+    header.version = c_FrameTelemetryVersion;
+    header.ticksPerSecond = StepTimer::TicksPerSecond;
+    header.windowFrames = m_windowFrames;
+
+    m_log.open(path, std::ios::binary | std::ios::trunc);
+    m_log.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    m_log.flush();
+
+    if (!m_log)
+    {
+        m_log = std::ofstream();
+        throw std::runtime_error("Failed to open frame telemetry log");
+    }
+}
+
+void FrameTelemetry::CloseLog()
+{
+    if (!m_log.is_open())
+        return;
+
+    if (m_window.GetCount() != 0)
+    {
+        CloseWindow();
+    }
+
+    m_log.close();
+}
+
+FrameTimeStats FrameTelemetry::GetTotalStats() const noexcept
+{
+    return GetStats(m_total, 0, m_stutterCount, m_clampedCount);
+}
+
+void FrameTelemetry::CloseWindow()
+{
+    m_lastWindow = GetStats(m_window, m_windowFirstFrame, m_windowStutterCount, m_windowClampedCount);
+
+    m_window.Reset();
+    m_windowFirstFrame = m_frameCount;
+    m_windowStutterCount = 0;
+    m_windowClampedCount = 0;
+
+    // Flushed per window, so a run that crashes loses at most the window in progress.
+    if (m_log.is_open())
+    {
+        m_log.write(reinterpret_cast<const char*>(&m_lastWindow), sizeof(m_lastWindow));
+        m_log.flush();
+
+        if (!m_log)
+        {
+            m_log = std::ofstream();
+            throw std::runtime_error("Failed to write frame telemetry log");
+        }
+    }
+}
+
+FrameTimeStats FrameTelemetry::GetStats(const FrameTimeHistogram& histogram, uint64_t firstFrame,
+                                        uint64_t stutterCount, uint64_t clampedCount) noexcept
+{
+    FrameTimeStats stats = {};
+    stats.firstFrame = firstFrame;
+    stats.frameCount = histogram.GetCount();
+    stats.stutterCount = stutterCount;
+    stats.clampedCount = clampedCount;
+    stats.minTicks = histogram.GetMin();
+    stats.maxTicks = histogram.GetMax();
+    stats.meanTicks = histogram.GetMean();
+    stats.p50Ticks = histogram.GetValueAtPercentile(50.0);
+    stats.p95Ticks = histogram.GetValueAtPercentile(95.0);
+    stats.p99Ticks = histogram.GetValueAtPercentile(99.0);
+    stats.p999Ticks = histogram.GetValueAtPercentile(99.9);
+    return stats;
+}
+
+std::vector<FrameTimeStats> DX::ReadFrameTelemetryLog(const std::filesystem::path& path)
+{
+    std::ifstream file(path, std::ios::binary);
+
+    FrameTelemetryHeader header = {};
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+    {
+        throw std::runtime_error("Frame telemetry log is truncated");
+    }
+
+    if (header.magic != c_FrameTelemetryMagic || header.version != c_FrameTelemetryVersion)
+    {
+        throw std::runtime_error("Not a frame telemetry log");
+    }
+
+    std::vector<FrameTimeStats> windows;
+    FrameTimeStats stats = {};
+    while (file.read(reinterpret_cast<char*>(&stats), sizeof(stats)))
+    {
+        windows.push_back(stats);
+    }
+
+    return windows;
+}
@@ -0,0 +1,161 @@
+//
+// FrameTelemetry.h - Frame time histogram, stutter detection and a binary log for soak runs
+//
+
+#pragma once
+
+#include "StepTimer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+
+namespace DX
+{
+    // Counts values in log-linear buckets, like HdrHistogram: every power of two is split into
+    // c_SubBucketHalfCount linear buckets, so any uint64_t value is kept to within 1/c_SubBucketHalfCount
+    // of itself in a fixed amount of memory, and recording is a couple of shifts and an increment.
+    class FrameTimeHistogram
+    {
+    public:
+        static const unsigned int c_SubBucketBits = 10;
+        static const size_t c_SubBucketCount = size_t(1) << c_SubBucketBits;
+        static const size_t c_SubBucketHalfCount = c_SubBucketCount / 2;
+        static const size_t c_BucketCount = (64 - c_SubBucketBits + 2) * c_SubBucketHalfCount;
+
+        FrameTimeHistogram() noexcept(false);
+
+        void Record(uint64_t value) noexcept;
+        void Reset() noexcept;
+
+        uint64_t GetCount() const noexcept { return m_count; }
+        uint64_t GetMin() const noexcept { return m_count ? m_min : 0; }
+        uint64_t GetMax() const noexcept { return m_max; }
+        uint64_t GetMean() const noexcept { return m_count ? m_sum / m_count : 0; }
+
+        // The highest value in the bucket holding the given percentile (0 to 100), and never more than the
+        // largest value recorded. Returns 0 when empty.
+        uint64_t GetValueAtPercentile(double percentile) const noexcept;
+
+        static size_t GetBucketIndex(uint64_t value) noexcept;
+        static uint64_t GetBucketLowerBound(size_t index) noexcept;
+        static uint64_t GetBucketUpperBound(size_t index) noexcept;
+
+    private:
+        std::vector<uint64_t>   m_buckets;
+        uint64_t                m_count;
+        uint64_t                m_min;
+        uint64_t                m_max;
+        uint64_t                m_sum;
+    };
+
+    // Frame times of a run of frames, in StepTimer ticks.
+    struct FrameTimeStats
+    {
+        uint64_t    firstFrame;
+        uint64_t    frameCount;
+        uint64_t    stutterCount;
+        uint64_t    clampedCount;   // frames StepTimer clamped; their full time is still in the histogram
+        uint64_t    minTicks;
+        uint64_t    maxTicks;
+        uint64_t    meanTicks;
+        uint64_t    p50Ticks;
+        uint64_t    p95Ticks;
+        uint64_t    p99Ticks;
+        uint64_t    p999Ticks;
+    };
+
+    // Log layout, all little endian:
+    //   FrameTelemetryHeader
+    //   FrameTimeStats[]            one per window of frames, appended as each window closes
+    struct FrameTelemetryHeader
+    {
+        uint32_t    magic;
+        uint32_t    version;
+        uint64_t    ticksPerSecond;
+        uint32_t    windowFrames;
+        uint32_t    reserved;
+    };
+
+    const uint32_t c_FrameTelemetryMagic = 0x4C455446; // "FTEL"
+    const uint32_t c_FrameTelemetryVersion = 1;
+
+    // Records the real time of every Tick, including the hitches StepTimer clamps, into a histogram for
+    // the whole run and one per window of frames. A frame is a stutter when it takes stutterFactor times
+    // the recent baseline, and at least stutterMinimumExcessTicks more, so a steady low frame rate is not
+    // flagged; a frame StepTimer clamped always is. Each closed window is appended to the log, if one is
+    // open, for offline analysis of long runs.
+    //
+    // Not thread-safe: record and read from one thread, or hand the stats over between frames.
+    class FrameTelemetry
+    {
+    public:
+        static const uint32_t c_DefaultWindowFrames = 600;
+
+        explicit FrameTelemetry(uint32_t windowFrames = c_DefaultWindowFrames, double stutterFactor = 2.0,
+                                uint64_t stutterMinimumExcessTicks = StepTimer::TicksPerSecond / 1000) noexcept(false);
+        ~FrameTelemetry();
+
+        FrameTelemetry(FrameTelemetry&&) = default;
+        FrameTelemetry& operator= (FrameTelemetry&&) = default;
+
+        FrameTelemetry(FrameTelemetry const&) = delete;
+        FrameTelemetry& operator= (FrameTelemetry const&) = delete;
+
+        // Record one Tick from StepTimer::GetRawElapsedTicks and WasLastDeltaClamped. Returns true if the
+        // frame is a stutter.
+        bool RecordFrame(uint64_t rawElapsedTicks, bool clamped);
+
+        // Start appending windows to a new file; throws std::runtime_error if it cannot be written.
+        void OpenLog(const std::filesystem::path& path);
+
+        // Close the current window early, so the log ends with every recorded frame, and close the log.
+        void CloseLog();
+        bool IsLogOpen() const noexcept { return m_log.is_open(); }
+
+        const FrameTimeHistogram& GetHistogram() const noexcept { return m_total; }
+        FrameTimeStats GetTotalStats() const noexcept;
+
+        // The last closed window; frameCount is 0 before the first one closes.
+        const FrameTimeStats& GetWindowStats() const noexcept { return m_lastWindow; }
+
+        uint64_t GetFrameCount() const noexcept { return m_frameCount; }
+        uint64_t GetStutterCount() const noexcept { return m_stutterCount; }
+        uint64_t GetClampedCount() const noexcept { return m_clampedCount; }
+        bool WasLastFrameStutter() const noexcept { return m_lastFrameStutter; }
+
+        // The recent frame time stutters are measured against.
+        double GetBaselineTicks() const noexcept { return m_baselineTicks; }
+
+    private:
+        void CloseWindow();
+        static FrameTimeStats GetStats(const FrameTimeHistogram& histogram, uint64_t firstFrame,
+                                       uint64_t stutterCount, uint64_t clampedCount) noexcept;
+
+        uint32_t                m_windowFrames;
+        double                  m_stutterFactor;
+        uint64_t                m_stutterMinimumExcessTicks;
+
+        FrameTimeHistogram      m_total;
+        uint64_t                m_frameCount;
+        uint64_t                m_stutterCount;
+        uint64_t                m_clampedCount;
+        double                  m_baselineTicks;
+        bool                    m_lastFrameStutter;
+
+        FrameTimeHistogram      m_window;
+        uint64_t                m_windowFirstFrame;
+        uint64_t                m_windowStutterCount;
+        uint64_t                m_windowClampedCount;
+        FrameTimeStats          m_lastWindow;
+
+        std::ofstream           m_log;
+    };
+
+    // Read every window of a log. Throws std::runtime_error if it is not a frame telemetry log; a partly
+    // written last window, e.g. after a crash, is ignored.
+    std::vector<FrameTimeStats> ReadFrameTelemetryLog(const std::filesystem::path& path);
+}
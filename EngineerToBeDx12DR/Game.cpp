@@ -18,192 +18,184 @@ namespace dxmath = DirectX::SimpleMath;
 using Microsoft::WRL::ComPtr;
 
 Game::Game() noexcept(false)
-	: m_imguiLayer(true, true, ImVec4(0.45f, 0.55f, 0.60f, 1.00f))
+	: Game(std::make_unique<DX::DeviceResources>())
 {
-	m_deviceResources = std::make_unique<DX::DeviceResources>();
-	m_deviceResources->RegisterDeviceNotify(this);
+}
+
+Game::Game(std::unique_ptr<DX::IRenderBackend> backend) noexcept(false)
+	: GameLoop(std::move(backend))
+{
+	m_deviceResources = dynamic_cast<DX::DeviceResources *>(m_backend.get());
 }
 
 Game::~Game()
 {
-	if (m_deviceResources)
-	{
-		m_deviceResources->WaitForGpu();
-	}
+	// The textures, renderers and ImGui buffers below may still be used by frames in flight.
+	WaitForIdle();
 }
 
 // Initialize the Direct3D resources required to run.
 void Game::Initialize(HWND window, int width, int height)
 {
+	if (!m_deviceResources)
+	{
+		throw std::logic_error("Initialize requires DX::DeviceResources, call InitializeHeadless instead");
+	}
+
 	m_deviceResources->SetWindow(window, width, height);
 
 	m_deviceResources->CreateDeviceResources();
+	m_sceneColorFormat = m_deviceResources->GetBackBufferFormat();
 	CreateDeviceDependentResources();
 
-	auto device = m_deviceResources->GetD3DDevice();
-	m_imguiLayer.OnDeviceCreated(
-		window, device, m_deviceResources->GetBackBufferCount(), m_deviceResources->GetBackBufferFormat()
-	);
+	CreateImguiDeviceObjects();
+	m_imguiLayer.SetGpuProfiler(&m_backend->GetGpuProfiler());
+	m_imguiLayer.SetJobSystem(m_jobSystem.get());
 
 	m_deviceResources->CreateWindowSizeDependentResources();
 	CreateWindowSizeDependentResources();
 
 	// TODO: Change the timer settings if you want something other than the default variable timestep mode.
-	// e.g. for 60 FPS fixed timestep update logic, call:
+	// e.g. for 60 FPS fixed timestep update logic that catches up at most 4 steps per frame and drops to
+	// as low as 30 updates per second under sustained overload, call:
 	/*
 	m_timer.SetFixedTimeStep(true);
 	m_timer.SetTargetElapsedSeconds(1.0 / 60);
+	m_timer.SetMaxUpdatesPerTick(4);
+	m_timer.SetAdaptiveTimeStep(true, DX::StepTimer::SecondsToTicks(1.0 / 30));
 	*/
 }
 
-#pragma region Frame Update
-// Executes the basic game loop.
-void Game::Tick()
+#pragma region Frame Render
+// Texture uploads go into the main command list, ahead of every pass. A texture published here is drawn this frame.
+void Game::OnFrameStarted()
 {
-	m_timer.Tick(
-		[&]()
-		{
-			Update(m_timer);
-		}
-	);
+	if (!m_textureStreamer)
+		return;
 
-	Render();
+	DX::ProfileScope streamerScope("TextureStreamer::Update");
+	const auto & framePacer = m_backend->GetFramePacer();
+	m_textureStreamer->Update(framePacer.GetCompletedFenceValue(), framePacer.GetCurrentFenceValue());
 }
 
-// Updates the world.
-void Game::Update(DX::StepTimer const & timer)
+// The graph may place the scene color target differently every frame, so its view is written into this
+// frame's transient region instead of a slot that frames in flight may still read.
+void Game::OnRenderGraphCompiled()
 {
-	PIXBeginEvent(PIX_COLOR_DEFAULT, L"Update");
-
-	float elapsedTime = float(timer.GetElapsedSeconds());
+	if (!m_deviceResources)
+		return;
 
-	// TODO: Add your game logic here.
-	elapsedTime;
+	auto sceneColor = reinterpret_cast<ID3D12Resource *>(m_renderGraph.GetResource(m_sceneColor));
+	const uint32_t sceneColorSrv = m_deviceResources->GetDescriptorAllocator().AllocateTransient();
+	if (sceneColorSrv == DX::DescriptorHandle::c_InvalidIndex)
+	{
+		throw std::length_error("Transient descriptor region is full");
+	}
 
-	PIXEndEvent();
+	CreateShaderResourceView(
+		m_deviceResources->GetD3DDevice(), sceneColor, m_deviceResources->GetCpuDescriptorHandle(sceneColorSrv)
+	);
+	m_postProcess->SetSourceTexture(m_deviceResources->GetGpuDescriptorHandle(sceneColorSrv), sceneColor);
 }
-#pragma endregion
 
-#pragma region Frame Render
-// Draws the scene.
-void Game::Render()
+void Game::OnPresenting()
 {
-	// Don't try to render anything before the first Update.
-	if (m_timer.GetFrameCount() == 0)
+	PIXBeginEvent(PIX_COLOR_DEFAULT, L"Present");
+
+	if (m_deviceResources)
 	{
-		return;
+		m_imguiLayer.OnPresent(m_deviceResources->GetCommandList());
 	}
+}
 
-	// Prepare the command list to render a new frame.
-	m_deviceResources->Prepare();
-	Clear();
-
-	auto commandList = m_deviceResources->GetCommandList();
-	PIXBeginEvent(commandList, PIX_COLOR_DEFAULT, L"Render");
-
-	// TODO: Add your rendering code here.
-
-	ID3D12DescriptorHeap * heaps[] = {m_resourceDescHeap->Heap(), m_states->Heap()};
-	commandList->SetDescriptorHeaps(static_cast<UINT>(std::size(heaps)), heaps);
-
-	m_effect->Apply(commandList);
-	m_primitiveBatch->Begin(commandList);
-
-	Vertex v1(dxmath::Vector3(400.f, 150.f, 0.f), dxmath::Vector2(0.5f, 0));
-	Vertex v2(dxmath::Vector3(600.f, 450.f, 0.f), dxmath::Vector2(1, 1));
-	Vertex v3(dxmath::Vector3(200.f, 450.f, 0.f), dxmath::Vector2(0, 1));
-
-	m_primitiveBatch->DrawTriangle(v1, v2, v3);
-	m_primitiveBatch->End();
-
-	m_imguiLayer.OnRender(commandList);
-
-	PIXEndEvent(commandList);
-
-	// Show the new frame.
-	PIXBeginEvent(PIX_COLOR_DEFAULT, L"Present");
-
-	m_imguiLayer.OnPresent(commandList);
-	
-	m_deviceResources->Present();
-	m_graphicsMemory->Commit(m_deviceResources->GetCommandQueue());
+void Game::OnPresented()
+{
+	if (m_deviceResources)
+	{
+		m_graphicsMemory->Commit(m_deviceResources->GetCommandQueue());
+	}
 
 	PIXEndEvent();
 }
 
-// Helper method to clear the back buffers.
-void Game::Clear()
+// Binds the scene color target with the depth buffer.
+void Game::SetSceneRenderTarget(ID3D12GraphicsCommandList * commandList, DX::ResourceHandle sceneColor) const
 {
-	auto commandList = m_deviceResources->GetCommandList();
-	PIXBeginEvent(commandList, PIX_COLOR_DEFAULT, L"Clear");
-
-	// Clear the views.
-	auto rtvDescriptor = m_deviceResources->GetRenderTargetView();
-	auto dsvDescriptor = m_deviceResources->GetDepthStencilView();
-
+	const auto rtvDescriptor = m_deviceResources->GetD3D12TransientResourceAllocator().GetRenderTargetView(sceneColor);
+	const auto dsvDescriptor = m_deviceResources->GetDepthStencilView();
 	commandList->OMSetRenderTargets(1, &rtvDescriptor, FALSE, &dsvDescriptor);
-	commandList->ClearRenderTargetView(rtvDescriptor, Colors::CornflowerBlue, 0, nullptr);
-	commandList->ClearDepthStencilView(dsvDescriptor, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
 
-	// Set the viewport and scissor rect.
-	auto viewport = m_deviceResources->GetScreenViewport();
-	auto scissorRect = m_deviceResources->GetScissorRect();
+	const auto viewport = m_deviceResources->GetScreenViewport();
+	const auto scissorRect = m_deviceResources->GetScissorRect();
 	commandList->RSSetViewports(1, &viewport);
 	commandList->RSSetScissorRects(1, &scissorRect);
-
-	PIXEndEvent(commandList);
 }
-#pragma endregion
 
-#pragma region Message Handlers
-// Message handlers
-void Game::OnActivated()
+// Clears the scene color target and the depth buffer. The scene color memory may be aliased, so it must be fully cleared.
+void Game::Clear(DX::ICommandContext & context, DX::ResourceHandle sceneColor)
 {
-	// TODO: Game is becoming active window.
-}
+	if (!m_deviceResources)
+	{
+		GameLoop::Clear(context, sceneColor);
+		return;
+	}
 
-void Game::OnDeactivated()
-{
-	// TODO: Game is becoming background window.
+	auto commandList = static_cast<DX::D3D12CommandContext &>(context).GetCommandList();
+	const auto rtvDescriptor = m_deviceResources->GetD3D12TransientResourceAllocator().GetRenderTargetView(sceneColor);
+	commandList->ClearRenderTargetView(rtvDescriptor, c_ClearColor, 0, nullptr);
+	commandList->ClearDepthStencilView(m_deviceResources->GetDepthStencilView(), D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
 }
 
-void Game::OnSuspending()
+// Records the scene into the scene color target.
+void Game::RenderScene(DX::ICommandContext & context, DX::ResourceHandle sceneColor)
 {
-	// TODO: Game is being power-suspended (or minimized).
-}
+	if (!m_deviceResources)
+	{
+		GameLoop::RenderScene(context, sceneColor);
+		return;
+	}
 
-void Game::OnResuming()
-{
-	m_timer.ResetElapsedTime();
+	// TODO: Add your rendering code here. With a fixed timestep, draw animated state blended between its
+	// previous and latest update by m_interpolationAlpha.
+	auto commandList = static_cast<DX::D3D12CommandContext &>(context).GetCommandList();
+	SetSceneRenderTarget(commandList, sceneColor);
 
-	// TODO: Game is being power-resumed (or returning from minimize).
+	BuildSceneBatches();
+	m_primitiveRenderer->Render(commandList, m_sceneBatcher);
 }
 
-void Game::OnWindowMoved()
+uint32_t Game::GetTextureDescriptor(DX::TextureStreamer::TextureId texture) const
 {
-	auto r = m_deviceResources->GetOutputSize();
-	m_deviceResources->WindowSizeChanged(r.right, r.bottom);
+	if (!m_textureStreamer)
+		return 0;
+
+	return m_textureBackend->GetDescriptorIndex(m_textureStreamer->GetDescriptorSlot(texture));
 }
 
-void Game::OnWindowSizeChanged(int width, int height)
+// Copies the scene color target to the back buffer.
+void Game::PostProcess(DX::ICommandContext & context)
 {
-	// spdlog::debug("Window resized: {} x {}", height, width);
-	std::cout << "Window resized\n";
-
-	if (!m_deviceResources->WindowSizeChanged(width, height))
+	if (!m_deviceResources)
+	{
+		GameLoop::PostProcess(context);
 		return;
+	}
 
-	CreateWindowSizeDependentResources();
-
-	// TODO: Game window is being resized.
+	context.GetCommandSink()->SetRenderTarget();
+	m_postProcess->Process(static_cast<DX::D3D12CommandContext &>(context).GetCommandList());
 }
 
-// Properties
-void Game::GetDefaultSize(int & width, int & height) const noexcept
+// Records the ImGui draw data built by ImguiLayerBase::OnNewFrame into a command context.
+void Game::RenderUI(DX::ICommandContext & context)
 {
-	// TODO: Change to desired default window size (note minimum size is 320x200).
-	width = 800;
-	height = 600;
+	if (!m_deviceResources)
+	{
+		GameLoop::RenderUI(context);
+		return;
+	}
+
+	context.GetCommandSink()->SetRenderTarget();
+	m_imguiLayer.OnRecord(static_cast<DX::D3D12CommandContext &>(context).GetCommandList());
 }
 #pragma endregion
 
@@ -211,31 +203,39 @@ void Game::GetDefaultSize(int & width, int & height) const noexcept
 // These are the resources that depend on the device.
 void Game::CreateDeviceDependentResources()
 {
+	if (!m_deviceResources)
+		return;
+
 	auto device = m_deviceResources->GetD3DDevice();
 
 	m_graphicsMemory = std::make_unique<GraphicsMemory>(device);
 
-	m_primitiveBatch = std::make_unique<PrimitiveBatch<Vertex>>(device);
-
 	RenderTargetState renderTargetState(
 		m_deviceResources->GetBackBufferFormat(),
 		m_deviceResources->GetDepthBufferFormat()
 	);
 
-	EffectPipelineStateDescription pipelineDesc(
-		&Vertex::InputLayout, CommonStates::Opaque, CommonStates::DepthDefault,
-		CommonStates::CullCounterClockwise, renderTargetState
+	// Nothing is loaded here: the streamer maps or decodes on the job system and uploads over the next frames.
+	// JPEGs are cooked to BC1 with mips next to the source on first use and mapped on later launches.
+	DX::TextureCookOptions cookOptions;
+	cookOptions.compress = true;
+	m_textureBackend = std::make_unique<DX::D3D12TextureStreamingBackend>(
+		m_deviceResources, c_MaxStreamedTextures, cookOptions
 	);
-
-	LoadTexture(device);
+	m_textureStreamer = std::make_unique<DX::TextureStreamer>(
+		m_textureBackend.get(), m_jobSystem.get(), &m_deviceResources->GetUploadRing(), c_MaxStreamedTextures
+	);
+	RequestTextures();
 
 	// according to the tutorial this line is not here,
 	// but the tutorial is obviously wrong
 	m_states = std::make_unique<CommonStates>(device);
 
-	m_effect = std::make_unique<BasicEffect>(device, EffectFlags::Texture, pipelineDesc);
-	auto gpuHandle = m_resourceDescHeap->GetGpuHandle(ResourceDescriptors::Rocks);
-	m_effect->SetTexture(gpuHandle, m_states->LinearClamp());
+	m_primitiveRenderer = std::make_unique<DX::D3D12PrimitiveRenderer>(
+		m_deviceResources, m_deviceResources->GetBackBufferFormat(), m_deviceResources->GetDepthBufferFormat()
+	);
+
+	m_postProcess = std::make_unique<BasicPostProcess>(device, renderTargetState, BasicPostProcess::Copy);
 
 	// Check Shader Model 6 support
 	D3D12_FEATURE_DATA_SHADER_MODEL shaderModel = {D3D_SHADER_MODEL_6_0};
@@ -255,36 +255,33 @@ void Game::CreateDeviceDependentResources()
 void Game::CreateWindowSizeDependentResources()
 {
 	// TODO: Initialize windows-size dependent objects here.		
-	auto size = m_deviceResources->GetOutputSize();
-
-	dxmath::Matrix proj = dxmath::Matrix::CreateScale(
-			2.f / float(size.right),
-			-2.f / float(size.bottom), 1.f
-		)
-		* dxmath::Matrix::CreateTranslation(-1.f, 1.f, 0.f);
-	m_effect->SetProjection(proj);
+	if (!m_primitiveRenderer)
+		return;
+
+	m_primitiveRenderer->SetViewportSize(m_backend->GetOutputWidth(), m_backend->GetOutputHeight());
 }
 
-void Game::LoadTexture(ID3D12Device * device)
+// Queues the scene's textures. The triangle's texture is streamed first, the posters as bandwidth allows.
+void Game::RequestTextures()
 {
-	m_resourceDescHeap = std::make_unique<DescriptorHeap>(device, ResourceDescriptors::Count);
-
-	ResourceUploadBatch resourceUpload(device);
-	resourceUpload.Begin();
-
-	DX::ThrowIfFailed(
-		CreateWICTextureFromFile(
-			device, resourceUpload, L"kiti.jpg", m_texture.ReleaseAndGetAddressOf()
-		)
-	);
+	m_sceneTexture = m_textureStreamer->Request(L"kiti.jpg", 1);
+	m_posterTextures[0] = m_textureStreamer->Request(L"lotr1.jpg");
+	m_posterTextures[1] = m_textureStreamer->Request(L"axtlkthadml31.jpg");
+}
 
-	CreateShaderResourceView(
-		device, m_texture.Get(), m_resourceDescHeap->GetCpuHandle(ResourceDescriptors::Rocks)
+// ImGui keeps a vertex/index buffer per frame in flight; size it for the pacer's maximum
+// so SetFramesInFlight can be changed at runtime.
+void Game::CreateImguiDeviceObjects()
+{
+	m_imguiFontDescriptor = m_deviceResources->GetDescriptorAllocator().Allocate();
+	m_imguiLayer.OnDeviceCreated(
+		m_deviceResources->GetWindow(), m_deviceResources->GetD3DDevice(), DX::FramePacer::c_MaxFramesInFlight,
+		m_deviceResources->GetBackBufferFormat(),
+		m_deviceResources->GetShaderVisibleHeap(),
+		m_deviceResources->GetCpuDescriptorHandle(m_imguiFontDescriptor.index),
+		m_deviceResources->GetGpuDescriptorHandle(m_imguiFontDescriptor.index)
 	);
-
-	auto commandQueue = m_deviceResources->GetCommandQueue();
-	auto uploadResourceTask = resourceUpload.End(commandQueue);
-	uploadResourceTask.wait();
+	m_imguiLayer.SetUploadRing(&m_deviceResources->GetUploadRing());
 }
 
 void Game::OnDeviceLost()
@@ -292,19 +289,30 @@ void Game::OnDeviceLost()
 	// TODO: Add Direct3D resource cleanup here.
 	m_graphicsMemory.reset();
 
-	m_effect.reset();
-	m_primitiveBatch.reset();
+	m_primitiveRenderer.reset();
+	m_postProcess.reset();
 
-	m_texture.Reset();
-	m_resourceDescHeap.reset();
+	m_textureStreamer.reset();
+	m_textureBackend.reset();
 
+	// The font descriptor is given back with the heap it was written to; the restored device gets a new one.
 	m_imguiLayer.OnDeviceLost();
+	if (m_deviceResources && m_imguiFontDescriptor.IsValid())
+	{
+		m_deviceResources->GetDescriptorAllocator().Free(m_imguiFontDescriptor);
+		m_imguiFontDescriptor = {};
+	}
+
+	GameLoop::OnDeviceLost();
 }
 
 void Game::OnDeviceRestored()
 {
-	CreateDeviceDependentResources();
+	GameLoop::OnDeviceRestored();
 
-	CreateWindowSizeDependentResources();
+	if (m_deviceResources)
+	{
+		CreateImguiDeviceObjects();
+	}
 }
 #pragma endregion
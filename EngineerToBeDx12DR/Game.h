@@ -4,87 +4,79 @@
 
 #pragma once
 
-#include "DemoImguiLayer.h"
+#include "GameLoop.h"
 
+#include "D3D12PrimitiveRenderer.h"
+#include "D3D12TextureStreamingBackend.h"
 #include "DeviceResources.h"
-#include "StepTimer.h"
 
 
 // A basic game implementation that creates a D3D12 device and
-// provides a game loop.
-class Game final : public DX::IDeviceNotify
+// draws the platform-neutral game loop with it.
+class Game final : public GameLoop
 {
 public:
 	Game() noexcept(false);
-	~Game();
-
-	Game(Game &&) = default;
-	Game & operator=(Game &&) = default;
-
-	Game(Game const &) = delete;
-	Game & operator=(Game const &) = delete;
+	// Runs the frame loop on the given backend; D3D12 scene and UI rendering is skipped
+	// unless the backend is a DX::DeviceResources.
+	explicit Game(std::unique_ptr<DX::IRenderBackend> backend) noexcept(false);
+	~Game() override;
 
 	// Initialization and management
 	void Initialize(HWND window, int width, int height);
 
-	// Basic game loop
-	void Tick();
-
 	// IDeviceNotify
 	void OnDeviceLost() override;
 	void OnDeviceRestored() override;
 
-	// Messages
-	void OnActivated();
-	void OnDeactivated();
-	void OnSuspending();
-	void OnResuming();
-	void OnWindowMoved();
-	void OnWindowSizeChanged(int width, int height);
+private:
+	void CreateDeviceDependentResources() override;
+	void CreateWindowSizeDependentResources() override;
 
-	// Properties
-	void GetDefaultSize(int & width, int & height) const noexcept;
+	void OnFrameStarted() override;
+	void OnRenderGraphCompiled() override;
+	void OnPresenting() override;
+	void OnPresented() override;
 
-private:
-	void Update(DX::StepTimer const & timer);
-	void Render();
+	// Render graph passes.
+	void Clear(DX::ICommandContext & context, DX::ResourceHandle sceneColor) override;
+	void RenderScene(DX::ICommandContext & context, DX::ResourceHandle sceneColor) override;
+	void PostProcess(DX::ICommandContext & context) override;
+	void RenderUI(DX::ICommandContext & context) override;
 
-	void Clear();
+	void SetSceneRenderTarget(ID3D12GraphicsCommandList * commandList, DX::ResourceHandle sceneColor) const;
+	uint32_t GetTextureDescriptor(DX::TextureStreamer::TextureId texture) const override;
 
-	void CreateDeviceDependentResources();
-	void CreateWindowSizeDependentResources();
+	void RequestTextures();
 
-	void LoadTexture(ID3D12Device* device);
+	// Gives ImGui's renderer the current device and a font descriptor in the shared heap.
+	void CreateImguiDeviceObjects();
 
 	// IMGUI
 	// -----------------------------------------------
 	// void PrepareImguiFrame();
 	// -----------------------------------------------
 
-	// Device resources.
-	std::unique_ptr<DX::DeviceResources> m_deviceResources;
-
-	// Rendering loop timer.
-	DX::StepTimer m_timer;
+	// The backend as Direct3D 12 device resources; null when running on a headless backend.
+	DX::DeviceResources * m_deviceResources;
 
 	// DX TK
 	std::unique_ptr<DirectX::GraphicsMemory> m_graphicsMemory;
 
-	using Vertex = DirectX::VertexPositionTexture;
-
-	std::unique_ptr<DirectX::BasicEffect> m_effect;
-	std::unique_ptr<DirectX::PrimitiveBatch<Vertex>> m_primitiveBatch;
+	// Draws the scene batcher's batches, one instanced draw per texture.
+	std::unique_ptr<DX::D3D12PrimitiveRenderer> m_primitiveRenderer;
 
 	std::unique_ptr<DirectX::CommonStates> m_states;
 
-	std::unique_ptr<DirectX::DescriptorHeap> m_resourceDescHeap;
-	Microsoft::WRL::ComPtr<ID3D12Resource> m_texture;
+	// Reads the scene color target through a transient descriptor written every frame.
+	std::unique_ptr<DirectX::BasicPostProcess> m_postProcess;
+
+	// Textures load in the background; the scene draws with the placeholder until each one is resident.
+	static const uint32_t c_MaxStreamedTextures = 16;
 
-	enum ResourceDescriptors
-	{
-		Rocks,
-		Count
-	};
+	std::unique_ptr<DX::D3D12TextureStreamingBackend> m_textureBackend;
+	std::unique_ptr<DX::TextureStreamer> m_textureStreamer;
 
-	DemoImguiLayer m_imguiLayer;
+	// ImGui's font texture lives in the shared heap for the lifetime of the device.
+	DX::DescriptorHandle m_imguiFontDescriptor;
 };
@@ -0,0 +1,365 @@
+//
+// GameLoop.cpp
+//
+
+#include "GameLoop.h"
+
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+
+GameLoop::GameLoop(std::unique_ptr<DX::IRenderBackend> backend) noexcept(false)
+	: m_backend(std::move(backend)), m_imguiLayer(true, true, ImVec4(0.45f, 0.55f, 0.60f, 1.00f))
+{
+	m_backend->RegisterDeviceNotify(this);
+
+	DX::CpuProfiler::GetInstance().SetThreadName("Main");
+
+	m_jobSystem = std::make_unique<DX::JobSystem>();
+	m_commandRecorder = std::make_unique<DX::ParallelCommandRecorder>(
+		m_backend->GetCommandContextFactory(), m_jobSystem.get()
+	);
+}
+
+GameLoop::~GameLoop()
+{
+	WaitForIdle();
+}
+
+void GameLoop::WaitForIdle() noexcept
+{
+	if (m_jobSystem)
+	{
+		try
+		{
+			WaitForUpdate();
+		}
+		catch (const std::exception &)
+		{
+		}
+	}
+
+	if (m_backend)
+	{
+		m_backend->WaitForGpu();
+	}
+}
+
+void GameLoop::InitializeHeadless()
+{
+	m_backend->CreateDeviceResources();
+	CreateDeviceDependentResources();
+
+	m_backend->CreateWindowSizeDependentResources();
+	CreateWindowSizeDependentResources();
+
+	// The UI is built and counted, so its CPU cost shows in the profiler like in a windowed run.
+	m_imguiLayer.OnHeadlessCreated(m_backend->GetOutputWidth(), m_backend->GetOutputHeight());
+	m_imguiLayer.SetJobSystem(m_jobSystem.get());
+}
+
+void GameLoop::SetClock(DX::IClock * clock)
+{
+	// The timer is ticked by the update job.
+	WaitForUpdate();
+	m_timer.SetClock(clock);
+}
+
+void GameLoop::OpenTelemetryLog(const std::filesystem::path & path)
+{
+	// The telemetry is recorded by the update job.
+	WaitForUpdate();
+	m_frameTelemetry.OpenLog(path);
+}
+
+// Executes the basic game loop.
+void GameLoop::Tick()
+{
+	// Finish the update that ran alongside the previous frame's render.
+	WaitForUpdate();
+
+	// Don't try to render anything before the first Update.
+	const bool hasUpdated = m_timer.GetFrameCount() != 0;
+
+	// The update job is done with the telemetry until the next one is scheduled.
+	m_imguiLayer.SetFrameTimeStats(m_frameTelemetry.GetTotalStats(), m_frameTelemetry.GetWindowStats());
+
+	// Render blends the last two updated states by how far the simulation is into its next step.
+	m_interpolationAlpha = float(m_timer.GetInterpolationAlpha());
+
+	// Start the next update on the job system so it overlaps with recording this frame.
+	// Update must not write state that Render reads; hand such state over here, between the wait and the schedule.
+	m_updateJob = m_jobSystem->Schedule(
+		[this, hasUpdated]()
+		{
+			m_timer.Tick(
+				[&]()
+				{
+					Update(m_timer);
+				}
+			);
+
+			// The first tick measures initialization, not a frame.
+			if (hasUpdated)
+			{
+				m_frameTelemetry.RecordFrame(m_timer.GetRawElapsedTicks(), m_timer.WasLastDeltaClamped());
+			}
+		}
+	);
+
+	if (hasUpdated)
+	{
+		Render();
+	}
+
+	// The update scheduled above is collected with the next frame.
+	DX::CpuProfiler::GetInstance().EndFrame();
+}
+
+// Blocks until the update scheduled by the last Tick has finished, rethrowing its failure.
+void GameLoop::WaitForUpdate()
+{
+	auto updateJob = std::move(m_updateJob);
+	m_jobSystem->Wait(updateJob);
+}
+
+// Updates the world.
+void GameLoop::Update(DX::StepTimer const & timer)
+{
+	DX::ProfileScope profileScope("Update");
+
+	float elapsedTime = float(timer.GetElapsedSeconds());
+
+	// TODO: Add your game logic here.
+	// Runs on a job system worker; split independent work with m_jobSystem->ParallelFor to use every core.
+	(void)elapsedTime;
+}
+
+// Draws the scene.
+void GameLoop::Render()
+{
+	DX::ProfileScope profileScope("Render");
+
+	// Prepare the command list to render a new frame. The render graph does the back buffer transitions.
+	m_backend->Prepare(DX::ResourceState::Present, DX::ResourceState::Present);
+
+	OnFrameStarted();
+
+	// ImGui builds its frame on this thread; only the resulting draw data is recorded in parallel.
+	m_imguiLayer.OnNewFrame();
+
+	{
+		DX::ProfileScope graphScope("RenderGraph::Compile");
+		BuildRenderGraph();
+		m_renderGraph.Compile(m_backend->GetTransientResourceAllocator());
+	}
+
+	OnRenderGraphCompiled();
+
+	// Every pass is recorded on a worker thread into its own command list, with its barriers batched in front.
+	DX::ProfileScope executeScope("RenderGraph::Execute");
+	m_renderGraph.Execute(*m_commandRecorder, m_backend->GetFramePacer().GetFrameIndex(), *m_backend->GetCommandSink());
+
+	// Show the new frame.
+	DX::ProfileScope presentScope("Present");
+
+	OnPresenting();
+	m_backend->Present(DX::ResourceState::Present);
+	OnPresented();
+}
+
+// Declares this frame's passes: the scene is drawn into a transient target and copied to the back buffer
+// by the post-process pass, with the UI drawn on top.
+void GameLoop::BuildRenderGraph()
+{
+	m_renderGraph.Reset();
+
+	const auto backBuffer = m_renderGraph.ImportResource(
+		L"BackBuffer", m_backend->GetRenderTargetHandle(), DX::ResourceState::Present, DX::ResourceState::Present
+	);
+	const auto depthBuffer = m_renderGraph.ImportResource(
+		L"DepthBuffer", m_backend->GetDepthStencilHandle(), DX::ResourceState::DepthWrite, DX::ResourceState::DepthWrite
+	);
+
+	DX::TransientResourceDesc sceneColorDesc = {};
+	sceneColorDesc.type = DX::TransientResourceType::Texture2D;
+	sceneColorDesc.width = static_cast<uint32_t>(m_backend->GetOutputWidth());
+	sceneColorDesc.height = static_cast<uint32_t>(m_backend->GetOutputHeight());
+	sceneColorDesc.format = m_sceneColorFormat;
+	sceneColorDesc.flags = DX::TransientResourceFlags_RenderTarget;
+	m_sceneColor = m_renderGraph.CreateTransient(L"SceneColor", sceneColorDesc);
+
+	const auto sceneColor = m_sceneColor;
+
+	m_renderGraph.AddPass(
+		L"Clear",
+		[&](DX::RenderGraphBuilder & builder)
+		{
+			builder.Write(sceneColor, DX::ResourceState::RenderTarget);
+			builder.Write(depthBuffer, DX::ResourceState::DepthWrite);
+		},
+		[this, sceneColor](DX::ICommandContext & context, const DX::RenderGraph & graph) { Clear(context, graph.GetResource(sceneColor)); }
+	);
+
+	m_renderGraph.AddPass(
+		L"Scene",
+		[&](DX::RenderGraphBuilder & builder)
+		{
+			builder.Write(sceneColor, DX::ResourceState::RenderTarget);
+			builder.Write(depthBuffer, DX::ResourceState::DepthWrite);
+		},
+		[this, sceneColor](DX::ICommandContext & context, const DX::RenderGraph & graph) { RenderScene(context, graph.GetResource(sceneColor)); }
+	);
+
+	m_renderGraph.AddPass(
+		L"PostProcess",
+		[&](DX::RenderGraphBuilder & builder)
+		{
+			builder.Read(sceneColor, DX::ResourceState::PixelShaderResource);
+			builder.Write(backBuffer, DX::ResourceState::RenderTarget);
+		},
+		[this](DX::ICommandContext & context, const DX::RenderGraph &) { PostProcess(context); }
+	);
+
+	m_renderGraph.AddPass(
+		L"UI",
+		[&](DX::RenderGraphBuilder & builder)
+		{
+			builder.Write(backBuffer, DX::ResourceState::RenderTarget);
+		},
+		[this](DX::ICommandContext & context, const DX::RenderGraph &) { RenderUI(context); }
+	);
+}
+
+// Clears the scene color target and the depth buffer. The scene color memory may be aliased, so it must be fully cleared.
+void GameLoop::Clear(DX::ICommandContext & context, DX::ResourceHandle)
+{
+	auto sink = context.GetCommandSink();
+	sink->ClearRenderTarget(c_ClearColor);
+	sink->ClearDepthStencil(1.0f);
+}
+
+// Records the scene into the scene color target.
+void GameLoop::RenderScene(DX::ICommandContext & context, DX::ResourceHandle)
+{
+	// TODO: Add your rendering code here. With a fixed timestep, draw animated state blended between its
+	// previous and latest update by m_interpolationAlpha.
+
+	// Headless: record one draw per batch so the command stream matches what the GPU path submits.
+	BuildSceneBatches();
+
+	auto sink = context.GetCommandSink();
+	sink->SetRenderTarget();
+	for (const auto & batch : m_sceneBatcher.GetBatches())
+	{
+		sink->Draw(batch.GetVertexCountPerInstance(), batch.instanceCount);
+	}
+}
+
+// Fills the scene batcher with this frame's primitives and sorts them into batches.
+void GameLoop::BuildSceneBatches()
+{
+	m_sceneBatcher.Clear();
+
+	// Textures that are still streaming in sample the placeholder. Material 0 is opaque: depth tested and written.
+	DX::BatchState state = {};
+	state.material = 0;
+	state.texture = GetTextureDescriptor(m_sceneTexture);
+	m_sceneBatcher.AddTriangle({400.f, 150.f, 0.5f, 0.f}, {600.f, 450.f, 1.f, 1.f}, {200.f, 450.f, 0.f, 1.f}, state);
+
+	for (size_t i = 0; i < std::size(m_posterTextures); i++)
+	{
+		state.texture = GetTextureDescriptor(m_posterTextures[i]);
+
+		const float left = 20.f + 600.f * float(i);
+		m_sceneBatcher.AddSprite(left, 20.f, left + 160.f, 140.f, state);
+	}
+
+	m_sceneBatcher.Build();
+}
+
+uint32_t GameLoop::GetTextureDescriptor(DX::TextureStreamer::TextureId) const
+{
+	return 0;
+}
+
+// Copies the scene color target to the back buffer.
+void GameLoop::PostProcess(DX::ICommandContext & context)
+{
+	auto sink = context.GetCommandSink();
+	sink->SetRenderTarget();
+
+	// Full-screen triangle.
+	sink->Draw(3, 1);
+}
+
+// Records the ImGui draw data built by ImguiLayerBase::OnNewFrame into a command context.
+void GameLoop::RenderUI(DX::ICommandContext & context)
+{
+	auto sink = context.GetCommandSink();
+	sink->SetRenderTarget();
+
+	m_imguiLayer.OnRecord(nullptr);
+}
+
+// Message handlers
+void GameLoop::OnActivated()
+{
+	// TODO: Game is becoming active window.
+}
+
+void GameLoop::OnDeactivated()
+{
+	// TODO: Game is becoming background window.
+}
+
+void GameLoop::OnSuspending()
+{
+	// TODO: Game is being power-suspended (or minimized).
+}
+
+void GameLoop::OnResuming()
+{
+	WaitForUpdate();
+	m_timer.ResetElapsedTime();
+
+	// TODO: Game is being power-resumed (or returning from minimize).
+}
+
+void GameLoop::OnWindowMoved()
+{
+	m_backend->WindowSizeChanged(m_backend->GetOutputWidth(), m_backend->GetOutputHeight());
+}
+
+void GameLoop::OnWindowSizeChanged(int width, int height)
+{
+	// spdlog::debug("Window resized: {} x {}", height, width);
+	std::cout << "Window resized\n";
+
+	if (!m_backend->WindowSizeChanged(width, height))
+		return;
+
+	CreateWindowSizeDependentResources();
+
+	// TODO: Game window is being resized.
+}
+
+// Properties
+void GameLoop::GetDefaultSize(int & width, int & height) const noexcept
+{
+	// TODO: Change to desired default window size (note minimum size is 320x200).
+	width = 800;
+	height = 600;
+}
+
+void GameLoop::OnDeviceLost()
+{
+	m_commandRecorder->ReleaseContexts();
+}
+
+void GameLoop::OnDeviceRestored()
+{
+	CreateDeviceDependentResources();
+
+	CreateWindowSizeDependentResources();
+}
@@ -0,0 +1,144 @@
+//
+// GameLoop.h - The platform-neutral part of the game
+//
+
+#pragma once
+
+#include "DemoImguiLayer.h"
+
+#include "CpuProfiler.h"
+#include "FrameTelemetry.h"
+#include "JobSystem.h"
+#include "ParallelCommandRecorder.h"
+#include "PrimitiveBatcher.h"
+#include "RenderBackend.h"
+#include "RenderGraph.h"
+#include "StepTimer.h"
+#include "TextureStreamer.h"
+
+#include <filesystem>
+#include <memory>
+
+
+// Runs the frame loop on any render backend: ticks the timer on the job system alongside rendering, builds the
+// frame's render graph and records its passes through the backend's command sinks. Builds without the Windows SDK,
+// so the whole loop runs on DX::NullRenderBackend on any platform; Game overrides the passes to draw with Direct3D 12.
+class GameLoop : public DX::IDeviceNotify
+{
+public:
+	explicit GameLoop(std::unique_ptr<DX::IRenderBackend> backend) noexcept(false);
+	virtual ~GameLoop();
+
+	// The update job and the backend's device notification point at this object.
+	GameLoop(GameLoop &&) = delete;
+	GameLoop & operator=(GameLoop &&) = delete;
+
+	GameLoop(GameLoop const &) = delete;
+	GameLoop & operator=(GameLoop const &) = delete;
+
+	// Initialize a backend that has no window, e.g. DX::NullRenderBackend for CI runs and CPU benchmarks.
+	void InitializeHeadless();
+
+	// Drive the timer from another clock, e.g. a DX::ReplayClock for deterministic headless runs.
+	// nullptr restores the steady clock. Call between ticks; the clock must outlive the game.
+	void SetClock(DX::IClock * clock);
+
+	// Append the frame time statistics of every window of frames to a binary log, e.g. for soak runs.
+	// The log is finished when the game is destroyed.
+	void OpenTelemetryLog(const std::filesystem::path & path);
+
+	// Basic game loop
+	void Tick();
+
+	// IDeviceNotify
+	void OnDeviceLost() override;
+	void OnDeviceRestored() override;
+
+	// Messages
+	void OnActivated();
+	void OnDeactivated();
+	void OnSuspending();
+	void OnResuming();
+	void OnWindowMoved();
+	void OnWindowSizeChanged(int width, int height);
+
+	// Properties
+	void GetDefaultSize(int & width, int & height) const noexcept;
+	DX::IRenderBackend & GetBackend() const noexcept { return *m_backend; }
+	const DemoImguiLayer & GetImguiLayer() const noexcept { return m_imguiLayer; }
+
+protected:
+	// Format of the scene color target: DXGI_FORMAT_B8G8R8A8_UNORM, the null backend's back buffer format.
+	static const uint32_t c_DefaultSceneColorFormat = 87;
+
+	// Cornflower blue, the scene's background.
+	static constexpr float c_ClearColor[4] = { 0.392156899f, 0.584313750f, 0.929411829f, 1.f };
+
+	// Waits for the update scheduled by the last Tick and for the GPU to finish every frame in flight.
+	// A derived class calls it first thing in its destructor, before releasing anything a frame may use.
+	void WaitForIdle() noexcept;
+
+	// Device and window size dependent resources of a derived class; nothing by default.
+	virtual void CreateDeviceDependentResources() {}
+	virtual void CreateWindowSizeDependentResources() {}
+
+	// Called by Render right after the backend's Prepare, before the UI and the render graph are built.
+	virtual void OnFrameStarted() {}
+	// Called once the render graph is compiled, before its passes are recorded.
+	virtual void OnRenderGraphCompiled() {}
+	// Called after the passes are recorded, before and after the backend's Present.
+	virtual void OnPresenting() {}
+	virtual void OnPresented() {}
+
+	// Render graph passes. The defaults record through the context's command sink, the way a headless
+	// backend counts them: one draw per scene batch and a full-screen triangle for the post-process.
+	virtual void Clear(DX::ICommandContext & context, DX::ResourceHandle sceneColor);
+	virtual void RenderScene(DX::ICommandContext & context, DX::ResourceHandle sceneColor);
+	virtual void PostProcess(DX::ICommandContext & context);
+	virtual void RenderUI(DX::ICommandContext & context);
+
+	// Index of a streamed texture's current descriptor in the shared heap; 0 when textures are not streamed.
+	virtual uint32_t GetTextureDescriptor(DX::TextureStreamer::TextureId texture) const;
+
+	// Fills the scene batcher with this frame's primitives and sorts them into batches.
+	void BuildSceneBatches();
+
+	// Device resources.
+	std::unique_ptr<DX::IRenderBackend> m_backend;
+
+	// Runs the update and render passes across all cores.
+	std::unique_ptr<DX::JobSystem> m_jobSystem;
+	std::unique_ptr<DX::ParallelCommandRecorder> m_commandRecorder;
+
+	// Rebuilt every frame; the scene is drawn into the transient m_sceneColor target.
+	DX::RenderGraph m_renderGraph;
+	DX::RenderGraphResource m_sceneColor = DX::RenderGraph::c_InvalidResource;
+	uint32_t m_sceneColorFormat = c_DefaultSceneColorFormat;
+
+	// Rendering loop timer. Only the update job touches it while an update is pending.
+	DX::StepTimer m_timer;
+
+	// The timer's interpolation alpha, handed to Render between updates.
+	float m_interpolationAlpha = 1.f;
+
+	// The scene's triangles and quads, filled and sorted by the Scene pass and drawn one instanced draw per texture.
+	DX::PrimitiveBatcher m_sceneBatcher;
+
+	// The textures the scene samples, as requested from the derived class's texture streamer.
+	DX::TextureStreamer::TextureId m_sceneTexture = 0;
+	DX::TextureStreamer::TextureId m_posterTextures[2] = {};
+
+	DemoImguiLayer m_imguiLayer;
+
+private:
+	void Update(DX::StepTimer const & timer);
+	void WaitForUpdate();
+	void Render();
+
+	void BuildRenderGraph();
+
+	DX::JobHandle m_updateJob;
+
+	// The real time of every tick, recorded by the update job right after the timer ticks.
+	DX::FrameTelemetry m_frameTelemetry;
+};
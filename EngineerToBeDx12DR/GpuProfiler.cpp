@@ -0,0 +1,232 @@
+//
+// GpuProfiler.cpp - Per-pass GPU timings from a ring of timestamp queries, one block per frame in flight
+//
+
+#include "GpuProfiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace DX;
+
+namespace
+{
+    // Pass names are ASCII; anything else is shown as '?'.
+    std::string ToDisplayName(std::wstring_view name)
+    {
+        std::string result;
+        result.reserve(name.size());
+        for (const wchar_t c : name)
+        {
+            result.push_back(c > 0 && c < 0x80 ? static_cast<char>(c) : '?');
+        }
+
+        return result;
+    }
+
+    // Nearest-rank percentile of sorted values.
+    double Percentile(const std::vector<float>& sorted, double percentile)
+    {
+        const auto rank = static_cast<size_t>(std::ceil(percentile / 100.0 * double(sorted.size())));
+        return sorted[std::min(std::max<size_t>(rank, 1), sorted.size()) - 1];
+    }
+}
+
+// Constructor for GpuProfiler.
+GpuProfiler::GpuProfiler(uint32_t maxScopesPerFrame, unsigned int framesInFlight, size_t historyLength) noexcept(false) :
+    m_maxScopesPerFrame(maxScopesPerFrame),
+    m_framesInFlight(framesInFlight),
+    m_historyLength(historyLength),
+    m_frameIndex(0),
+    m_scopeCount(0),
+    m_overflowCount(0),
+    m_resolvedFrameCount(0)
+{
+    if (maxScopesPerFrame == 0 || framesInFlight == 0 || historyLength == 0)
+    {
+        throw std::out_of_range("GpuProfiler sizes must not be 0");
+    }
+
+    if (uint64_t(maxScopesPerFrame) * 2 * framesInFlight > UINT32_MAX)
+    {
+        throw std::out_of_range("Too many GPU profiler queries");
+    }
+
+    m_frames.resize(framesInFlight);
+    for (auto& frame : m_frames)
+    {
+        frame = { 0, 0, false, std::vector<const wchar_t*>(maxScopesPerFrame, nullptr), std::vector<uint8_t>(maxScopesPerFrame, 0) };
+    }
+}
+
+void GpuProfiler::BeginFrame(unsigned int frameIndex, uint64_t completedFenceValue, ITimestampSource& source)
+{
+    if (frameIndex >= m_framesInFlight)
+    {
+        throw std::out_of_range("frameIndex has no GPU profiler queries");
+    }
+
+    // Oldest first, so every history stays in frame order.
+    for (;;)
+    {
+        unsigned int oldest = m_framesInFlight;
+        for (unsigned int i = 0; i < m_framesInFlight; i++)
+        {
+            const auto& frame = m_frames[i];
+            if (frame.pending && frame.fenceValue <= completedFenceValue
+                && (oldest == m_framesInFlight || frame.fenceValue < m_frames[oldest].fenceValue))
+            {
+                oldest = i;
+            }
+        }
+
+        if (oldest == m_framesInFlight)
+            break;
+
+        Resolve(oldest, source);
+    }
+
+    if (m_frames[frameIndex].pending)
+    {
+        throw std::logic_error("GPU profiler queries reused before their frame completed");
+    }
+
+    m_frameIndex = frameIndex;
+    m_scopeCount.store(0, std::memory_order_relaxed);
+}
+
+void GpuProfiler::GetFrameQueries(uint32_t& first, uint32_t& count) const noexcept
+{
+    first = GetBeginQuery(0);
+    count = std::min(m_scopeCount.load(std::memory_order_relaxed), m_maxScopesPerFrame) * 2;
+}
+
+void GpuProfiler::EndFrame(uint64_t fenceValue)
+{
+    auto& frame = m_frames[m_frameIndex];
+    frame.fenceValue = fenceValue;
+    frame.scopeCount = std::min(m_scopeCount.load(std::memory_order_relaxed), m_maxScopesPerFrame);
+    frame.pending = frame.scopeCount > 0;
+}
+
+void GpuProfiler::RetireAll() noexcept
+{
+    for (auto& frame : m_frames)
+    {
+        frame.pending = false;
+    }
+
+    m_scopeCount.store(0, std::memory_order_relaxed);
+}
+
+uint32_t GpuProfiler::BeginScope(const wchar_t* name) noexcept
+{
+    const uint32_t scope = m_scopeCount.fetch_add(1, std::memory_order_relaxed);
+    if (scope >= m_maxScopesPerFrame)
+    {
+        m_overflowCount.fetch_add(1, std::memory_order_relaxed);
+        return c_InvalidScope;
+    }
+
+    auto& frame = m_frames[m_frameIndex];
+    frame.names[scope] = name;
+    frame.ended[scope] = 0;
+    return scope;
+}
+
+void GpuProfiler::EndScope(uint32_t scope) noexcept
+{
+    if (scope < m_maxScopesPerFrame)
+    {
+        m_frames[m_frameIndex].ended[scope] = 1;
+    }
+}
+
+void GpuProfiler::Resolve(unsigned int frameIndex, ITimestampSource& source)
+{
+    auto& frame = m_frames[frameIndex];
+    frame.pending = false;
+    m_resolvedFrameCount++;
+
+    const uint64_t frequency = source.GetTimestampFrequency();
+    if (frequency == 0)
+        return;
+
+    const uint32_t queryCount = frame.scopeCount * 2;
+    m_timestamps.resize(queryCount);
+    source.ReadTimestamps(frameIndex * m_maxScopesPerFrame * 2, queryCount, m_timestamps.data());
+
+    const double ticksToMilliseconds = 1000.0 / double(frequency);
+    m_frameTotals.assign(m_histories.size(), -1.0);
+    for (uint32_t scope = 0; scope < frame.scopeCount; scope++)
+    {
+        // The end query of a scope that was never ended holds whatever an earlier frame wrote to it.
+        const wchar_t* name = frame.names[scope];
+        if (!name || !frame.ended[scope])
+            continue;
+
+        const uint64_t begin = m_timestamps[scope * 2];
+        const uint64_t end = m_timestamps[scope * 2 + 1];
+        if (end < begin)
+            continue;
+
+        auto entry = m_historyIndices.find(name);
+        if (entry == m_historyIndices.end())
+        {
+            entry = m_historyIndices.emplace(name, m_histories.size()).first;
+            m_histories.push_back({ ToDisplayName(name), std::vector<float>(m_historyLength, 0.f), 0, 0 });
+            m_frameTotals.push_back(-1.0);
+        }
+
+        double& total = m_frameTotals[entry->second];
+        total = std::max(total, 0.0) + double(end - begin) * ticksToMilliseconds;
+    }
+
+    for (size_t i = 0; i < m_histories.size(); i++)
+    {
+        if (m_frameTotals[i] < 0.0)
+            continue;
+
+        auto& history = m_histories[i];
+        history.milliseconds[history.next] = static_cast<float>(m_frameTotals[i]);
+        history.next = (history.next + 1) % m_historyLength;
+        history.count = std::min(history.count + 1, m_historyLength);
+    }
+}
+
+std::vector<GpuTiming> GpuProfiler::GetTimings() const
+{
+    std::vector<GpuTiming> timings;
+    timings.reserve(m_histories.size());
+
+    std::vector<float> sorted;
+    for (const auto& history : m_histories)
+    {
+        if (history.count == 0)
+            continue;
+
+        // The ring fills from the front, so its first count entries are the samples.
+        sorted.assign(history.milliseconds.begin(), history.milliseconds.begin() + history.count);
+        std::sort(sorted.begin(), sorted.end());
+
+        double sum = 0.0;
+        for (const float milliseconds : sorted)
+        {
+            sum += milliseconds;
+        }
+
+        GpuTiming timing = {};
+        timing.name = history.name;
+        timing.lastMs = history.milliseconds[(history.next + m_historyLength - 1) % m_historyLength];
+        timing.averageMs = sum / double(sorted.size());
+        timing.p50Ms = Percentile(sorted, 50.0);
+        timing.p95Ms = Percentile(sorted, 95.0);
+        timing.p99Ms = Percentile(sorted, 99.0);
+        timing.maxMs = sorted.back();
+        timing.sampleCount = static_cast<uint32_t>(sorted.size());
+        timings.push_back(std::move(timing));
+    }
+
+    return timings;
+}
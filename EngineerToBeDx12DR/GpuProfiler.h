@@ -0,0 +1,135 @@
+//
+// GpuProfiler.h - Per-pass GPU timings from a ring of timestamp queries, one block per frame in flight
+//
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+
+namespace DX
+{
+    // Where GpuProfiler reads resolved timestamps from, e.g. a readback buffer. Tests supply a fake.
+    class ITimestampSource
+    {
+    public:
+        virtual ~ITimestampSource() = default;
+
+        // Timestamp ticks per second.
+        virtual uint64_t GetTimestampFrequency() = 0;
+
+        // Copy the resolved values of queries [first, first + count). Only called once the frame that wrote
+        // them has completed on the GPU.
+        virtual void ReadTimestamps(uint32_t first, uint32_t count, uint64_t* timestamps) = 0;
+    };
+
+    // Rolling GPU time of every scope with one name, in milliseconds. Scopes with the same name in a frame add up.
+    struct GpuTiming
+    {
+        std::string     name;
+        double          lastMs;
+        double          averageMs;
+        double          p50Ms;
+        double          p95Ms;
+        double          p99Ms;
+        double          maxMs;
+        uint32_t        sampleCount;
+    };
+
+    // Hands out pairs of timestamp queries to named scopes and turns their resolved values into rolling
+    // per-scope statistics. The query heap holds one block of queries per frame in flight. A frame's block
+    // is read once its fence value has completed, in BeginFrame, so reading never waits on the GPU.
+    //
+    // Scopes may be begun from any thread while a frame is recorded: the caller writes a timestamp to
+    // GetBeginQuery at the start and to GetEndQuery at the end, calls EndScope, and resolves GetFrameQueries
+    // before submitting the frame's last command list. Scopes that were never ended are not timed.
+    // BeginFrame and EndFrame are called by the owner of the frame loop, like UploadRing's Retire and Finish.
+    class GpuProfiler
+    {
+    public:
+        static const uint32_t c_InvalidScope = UINT32_MAX;
+        static const size_t c_DefaultHistoryLength = 256;
+
+        GpuProfiler(uint32_t maxScopesPerFrame, unsigned int framesInFlight,
+                    size_t historyLength = c_DefaultHistoryLength) noexcept(false);
+
+        GpuProfiler(GpuProfiler&&) = delete;
+        GpuProfiler& operator= (GpuProfiler&&) = delete;
+
+        GpuProfiler(GpuProfiler const&) = delete;
+        GpuProfiler& operator= (GpuProfiler const&) = delete;
+
+        // The size of the query heap: two queries per scope per frame in flight.
+        uint32_t GetQueryCount() const noexcept { return m_maxScopesPerFrame * 2 * m_framesInFlight; }
+
+        // Read every ended frame up to completedFenceValue, then start recording frameIndex (the frame pacer's).
+        void BeginFrame(unsigned int frameIndex, uint64_t completedFenceValue, ITimestampSource& source);
+
+        // The queries the current frame has handed out so far.
+        void GetFrameQueries(uint32_t& first, uint32_t& count) const noexcept;
+
+        // The frame's timestamps are valid once fenceValue completes.
+        void EndFrame(uint64_t fenceValue);
+
+        // Drop the frames in flight without reading them, e.g. after device loss.
+        void RetireAll() noexcept;
+
+        // Returns c_InvalidScope, and counts an overflow, once the frame's scopes are used up. name must outlive
+        // the profiler, e.g. be a string literal.
+        uint32_t BeginScope(const wchar_t* name) noexcept;
+        // Mark the scope's end timestamp as written this frame. Ignores c_InvalidScope.
+        void EndScope(uint32_t scope) noexcept;
+        uint32_t GetBeginQuery(uint32_t scope) const noexcept { return (m_frameIndex * m_maxScopesPerFrame + scope) * 2; }
+        uint32_t GetEndQuery(uint32_t scope) const noexcept { return GetBeginQuery(scope) + 1; }
+
+        // In order of first appearance. Call from the thread that calls BeginFrame.
+        std::vector<GpuTiming> GetTimings() const;
+
+        uint64_t GetResolvedFrameCount() const noexcept { return m_resolvedFrameCount; }
+        uint64_t GetOverflowCount() const noexcept { return m_overflowCount.load(std::memory_order_relaxed); }
+
+    private:
+        struct FrameQueries
+        {
+            uint64_t                        fenceValue;
+            uint32_t                        scopeCount;
+            bool                            pending;
+            std::vector<const wchar_t*>     names;
+            std::vector<uint8_t>            ended;      // per scope; a byte each, as scopes end on different threads
+        };
+
+        // A ring of the last historyLength per-frame totals.
+        struct History
+        {
+            std::string                     name;
+            std::vector<float>              milliseconds;
+            size_t                          next;
+            size_t                          count;
+        };
+
+        void Resolve(unsigned int frameIndex, ITimestampSource& source);
+
+        uint32_t                                        m_maxScopesPerFrame;
+        unsigned int                                    m_framesInFlight;
+        size_t                                          m_historyLength;
+
+        std::vector<FrameQueries>                       m_frames;
+        unsigned int                                    m_frameIndex;
+        std::atomic<uint32_t>                           m_scopeCount;
+        std::atomic<uint64_t>                           m_overflowCount;
+
+        std::vector<History>                            m_histories;
+        std::unordered_map<std::wstring_view, size_t>   m_historyIndices;
+        uint64_t                                        m_resolvedFrameCount;
+
+        // Reused by Resolve.
+        std::vector<uint64_t>                           m_timestamps;
+        std::vector<double>                             m_frameTotals;
+    };
+}
@@ -1,9 +1,53 @@
-﻿#include "pch.h"
-#include "ImguiLayerBase.h"
+﻿#include "ImguiLayerBase.h"
+#include "CpuProfiler.h"
+#include "JobSystem.h"
+#include "UploadRing.h"
 
 #include "imgui.h"
+#include "backends/imgui_impl_headless.h"
+
+#include <algorithm>
+#include <iterator>
+
+// The Direct3D 12 and Win32 backends; without them only the headless backend is available.
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <Windows.h>
+#include <d3d12.h>
+
 #include "backends/imgui_impl_dx12.h"
 #include "backends/imgui_impl_win32.h"
+#endif
+
+namespace
+{
+	template <typename T>
+	void Append(std::vector<char> & buffer, const T * data, size_t count)
+	{
+		const auto bytes = reinterpret_cast<const char *>(data);
+		buffer.insert(buffer.end(), bytes, bytes + sizeof(T) * count);
+	}
+
+	// ImGui's job callback (io.RunDrawListJobsFn, ImFontAtlas::BuildJobsFn) on a DX::JobSystem. One index per job: ImGui
+	// already hands out work big enough to be worth one, a whole lane or plot, or a batch of glyphs.
+	void RunImguiJobs(void * userData, int count, void (*job)(void * jobData, int index), void * jobData)
+	{
+		static_cast<DX::JobSystem *>(userData)->ParallelFor(size_t(count), 1,
+			[job, jobData](size_t begin, size_t end)
+			{
+				for (size_t index = begin; index < end; index++)
+				{
+					job(jobData, int(index));
+				}
+			}
+		);
+	}
+}
 
 
 ImguiLayerBase::ImguiLayerBase()
@@ -16,6 +60,7 @@ ImguiLayerBase::ImguiLayerBase()
 	//m_io->ConfigFlags |= ImGuiConfigFlags_NavEnableGamepad; // Enable Gamepad Controls
 	m_io->ConfigFlags |= ImGuiConfigFlags_DockingEnable; // Enable Docking
 	m_io->ConfigFlags |= ImGuiConfigFlags_ViewportsEnable; // Enable Multi-Viewport / Platform Windows
+	m_io->Fonts->BuildCacheFilename = "imgui_fonts.cache"; // Next to imgui.ini; skips rasterizing the fonts when they did not change
 	//io.ConfigViewportsNoAutoMerge = true;
 	//io.ConfigViewportsNoTaskBarIcon = true;
 
@@ -34,58 +79,260 @@ ImguiLayerBase::ImguiLayerBase()
 
 ImguiLayerBase::~ImguiLayerBase()
 {
-	ImGui_ImplDX12_Shutdown();
-	ImGui_ImplWin32_Shutdown();
+#ifdef _WIN32
+	if (m_backendsInitialized)
+	{
+		ImGui_ImplDX12_Shutdown();
+	}
+	if (m_windowBackendInitialized)
+	{
+		ImGui_ImplWin32_Shutdown();
+	}
+#endif
+	if (m_headless)
+	{
+		ImGui_ImplHeadless_Shutdown();
+	}
 	ImGui::DestroyContext();
 }
 
-void ImguiLayerBase::OnRender(const Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> & commandList)
+#ifdef _WIN32
+void ImguiLayerBase::OnRender(ID3D12GraphicsCommandList * commandList)
+{
+	OnNewFrame();
+	OnRecord(commandList);
+}
+#endif
+
+void ImguiLayerBase::OnNewFrame()
 {
 	// Start the Dear ImGui frame
-	ImGui_ImplDX12_NewFrame();
-	ImGui_ImplWin32_NewFrame();
-	ImGui::NewFrame();
+	{
+		DX::ProfileScope profileScope("ImGui::NewFrame");
+		if (m_headless)
+		{
+			ImGui_ImplHeadless_NewFrame();
+		}
+#ifdef _WIN32
+		else
+		{
+			ImGui_ImplDX12_NewFrame();
+			ImGui_ImplWin32_NewFrame();
+		}
+#endif
+
+		// The backends still run every frame, so their input and timing stay current.
+		const bool inputChanged = CaptureInput();
+		if (m_retainedMode && CanReuseFrame(inputChanged))
+		{
+			m_skippedDeltaTime += m_io->DeltaTime;
+			m_recordMode = m_recordMode == RecordMode::Upload ? RecordMode::RetainedUpload : RecordMode::RetainedReuse;
+			m_reusedFrames++;
+			return;
+		}
 
-	CreateGUI();
+		// The skipped frames' time passes in one step, so animations and timers do not fall behind.
+		m_io->DeltaTime += m_skippedDeltaTime;
+		m_skippedDeltaTime = 0.f;
+		ImGui::NewFrame();
+	}
+
+	{
+		DX::ProfileScope profileScope("CreateGUI");
+		CreateGUI();
+	}
 
 	// Rendering
+	DX::ProfileScope profileScope("ImGui::Render");
 	ImGui::Render();
 
-	// Render Dear ImGui graphics
-	commandList->SetDescriptorHeaps(1, m_srvDescriptorHeap.GetAddressOf());
-	ImGui_ImplDX12_RenderDrawData(ImGui::GetDrawData(), commandList.Get());
+	m_recordMode = RecordMode::Upload;
+	m_dirty = false;
+	m_drawDataStable = m_retainedMode && CaptureDrawData(ImGui::GetDrawData());
+	m_rebuiltFrames++;
 }
 
-void ImguiLayerBase::OnDeviceLost()
+void ImguiLayerBase::OnRecord(ID3D12GraphicsCommandList * commandList) const
 {
-	m_srvDescriptorHeap.Reset();
+	// Render Dear ImGui graphics
+	DX::ProfileScope profileScope("ImGui_ImplDX12_RenderDrawData");
+	if (m_headless)
+	{
+		ImGui_ImplHeadless_RenderDrawData(ImGui::GetDrawData());
+	}
+#ifdef _WIN32
+	else if (m_recordMode == RecordMode::Upload)
+	{
+		ImGui_ImplDX12_RenderDrawData(ImGui::GetDrawData(), commandList);
+	}
+	else
+	{
+		ImGui_ImplDX12_RenderDrawDataRetained(ImGui::GetDrawData(), commandList, m_recordMode == RecordMode::RetainedUpload);
+	}
+#else
+	(void)commandList;
+#endif
 }
 
-void ImguiLayerBase::OnPresent(const Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> & commandList) const
+#ifdef _WIN32
+void ImguiLayerBase::OnPresent(ID3D12GraphicsCommandList * commandList) const
 {
-	// Update and Render additional Platform Windows
-	if (m_io->ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
+	// Update and Render additional Platform Windows; a reused frame has none, as CanReuseFrame requires.
+	if ((m_io->ConfigFlags & ImGuiConfigFlags_ViewportsEnable) && m_recordMode == RecordMode::Upload && !m_headless)
 	{
 		ImGui::UpdatePlatformWindows();
-		ImGui::RenderPlatformWindowsDefault(nullptr, (void*)commandList.Get());
+		ImGui::RenderPlatformWindowsDefault(nullptr, (void*)commandList);
 	}
 }
 
-void ImguiLayerBase::OnDeviceCreated(HWND window, ID3D12Device * device, int backBufferCount, DXGI_FORMAT rtvFormat)
+void ImguiLayerBase::OnDeviceCreated(void * window, ID3D12Device * device, int backBufferCount, DXGI_FORMAT rtvFormat,
+	ID3D12DescriptorHeap * srvHeap, D3D12_CPU_DESCRIPTOR_HANDLE fontSrvCpuHandle, D3D12_GPU_DESCRIPTOR_HANDLE fontSrvGpuHandle)
 {
-	D3D12_DESCRIPTOR_HEAP_DESC desc = {};
-	desc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-	desc.NumDescriptors = 1;
-	desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-	DX::ThrowIfFailed(
-		device->CreateDescriptorHeap(&desc, IID_PPV_ARGS(m_srvDescriptorHeap.ReleaseAndGetAddressOf()))
-	);
-
 	// Setup Platform/Renderer backends
-	ImGui_ImplWin32_Init(window);
-	ImGui_ImplDX12_Init(
-		device, backBufferCount, rtvFormat, m_srvDescriptorHeap.Get(),
-		m_srvDescriptorHeap->GetCPUDescriptorHandleForHeapStart(),
-		m_srvDescriptorHeap->GetGPUDescriptorHandleForHeapStart()
+	if (!m_windowBackendInitialized)
+	{
+		ImGui_ImplWin32_Init(window);
+		m_windowBackendInitialized = true;
+	}
+	ImGui_ImplDX12_Init(device, backBufferCount, rtvFormat, srvHeap, fontSrvCpuHandle, fontSrvGpuHandle);
+	m_backendsInitialized = true;
+	Invalidate();
+}
+
+void ImguiLayerBase::OnDeviceLost()
+{
+	if (!m_backendsInitialized)
+		return;
+
+	// The pipeline and font texture are recreated by the first ImGui_ImplDX12_NewFrame on the new device.
+	// The backend also holds the old device, heap and per-frame buffers, which only Shutdown lets go of.
+	ImGui_ImplDX12_InvalidateDeviceObjects();
+	ImGui_ImplDX12_Shutdown();
+	m_backendsInitialized = false;
+
+	// A retained frame would draw from the released buffers.
+	m_drawDataStable = false;
+	m_drawDataSnapshot.clear();
+	Invalidate();
+}
+#endif
+
+void ImguiLayerBase::OnHeadlessCreated(int width, int height)
+{
+	ImGui_ImplHeadless_Init(ImVec2(static_cast<float>(width), static_cast<float>(height)));
+	m_headless = true;
+	Invalidate();
+}
+
+#ifdef _WIN32
+void ImguiLayerBase::SetUploadRing(DX::UploadRing * uploadRing)
+{
+	Invalidate();
+
+	if (!uploadRing)
+	{
+		ImGui_ImplDX12_SetUploadAllocator(nullptr, nullptr);
+		return;
+	}
+
+	ImGui_ImplDX12_SetUploadAllocator(
+		[](void * userData, size_t size, size_t alignment, void ** cpuAddress, ImU64 * gpuAddress)
+		{
+			auto allocation = static_cast<DX::UploadRing *>(userData)->TryAllocate(size, alignment);
+			*cpuAddress = allocation.cpuAddress;
+			*gpuAddress = allocation.gpuAddress;
+			return static_cast<bool>(allocation);
+		},
+		uploadRing
 	);
 }
+#endif
+
+void ImguiLayerBase::SetJobSystem(DX::JobSystem * jobSystem)
+{
+	m_io->RunDrawListJobsFn = jobSystem ? RunImguiJobs : nullptr;
+	m_io->RunDrawListJobsUserData = jobSystem;
+	m_io->Fonts->BuildJobsFn = jobSystem ? RunImguiJobs : nullptr;
+	m_io->Fonts->BuildJobsUserData = jobSystem;
+}
+
+void ImguiLayerBase::SetRetainedMode(bool enabled, float refreshSeconds)
+{
+	m_retainedMode = enabled;
+	m_refreshSeconds = refreshSeconds;
+	m_drawDataStable = false;
+	m_drawDataSnapshot.clear();
+	Invalidate();
+}
+
+bool ImguiLayerBase::CaptureInput()
+{
+	InputState input = {};
+	input.mousePos = m_io->MousePos;
+	input.mouseWheel = m_io->MouseWheel;
+	input.mouseWheelH = m_io->MouseWheelH;
+	std::copy(std::begin(m_io->MouseDown), std::end(m_io->MouseDown), input.mouseDown);
+	std::copy(std::begin(m_io->KeysDown), std::end(m_io->KeysDown), input.keysDown);
+	input.keyCtrl = m_io->KeyCtrl;
+	input.keyShift = m_io->KeyShift;
+	input.keyAlt = m_io->KeyAlt;
+	input.keySuper = m_io->KeySuper;
+	input.inputCharacterCount = m_io->InputQueueCharacters.Size;
+	input.displaySize = m_io->DisplaySize;
+
+	// Wheel and characters are only cleared by ImGui::NewFrame, so any pending at all counts as a change.
+	const bool changed = input.mousePos.x != m_input.mousePos.x || input.mousePos.y != m_input.mousePos.y
+		|| input.mouseWheel != 0.f || input.mouseWheelH != 0.f || input.inputCharacterCount != 0
+		|| !std::equal(std::begin(input.mouseDown), std::end(input.mouseDown), std::begin(m_input.mouseDown))
+		|| !std::equal(std::begin(input.keysDown), std::end(input.keysDown), std::begin(m_input.keysDown))
+		|| input.keyCtrl != m_input.keyCtrl || input.keyShift != m_input.keyShift
+		|| input.keyAlt != m_input.keyAlt || input.keySuper != m_input.keySuper
+		|| input.displaySize.x != m_input.displaySize.x || input.displaySize.y != m_input.displaySize.y;
+
+	m_input = input;
+	return changed;
+}
+
+// Flattening and comparing the bytes is cheaper than hashing them, and exact. ImDrawCmd clears its
+// padding on construction, so equal commands compare equal.
+bool ImguiLayerBase::CaptureDrawData(const ImDrawData * drawData)
+{
+	m_drawDataScratch.clear();
+	if (!drawData || !drawData->Valid)
+	{
+		m_drawDataSnapshot.clear();
+		return false;
+	}
+
+	const float header[] = {
+		drawData->DisplayPos.x, drawData->DisplayPos.y,
+		drawData->DisplaySize.x, drawData->DisplaySize.y,
+		drawData->FramebufferScale.x, drawData->FramebufferScale.y,
+	};
+	Append(m_drawDataScratch, header, std::size(header));
+	Append(m_drawDataScratch, &drawData->CmdListsCount, 1);
+
+	for (int i = 0; i < drawData->CmdListsCount; i++)
+	{
+		const ImDrawList * list = drawData->CmdLists[i];
+		const int sizes[] = { list->VtxBuffer.Size, list->IdxBuffer.Size, list->CmdBuffer.Size };
+		Append(m_drawDataScratch, sizes, std::size(sizes));
+		Append(m_drawDataScratch, list->VtxBuffer.Data, list->VtxBuffer.Size);
+		Append(m_drawDataScratch, list->IdxBuffer.Data, list->IdxBuffer.Size);
+		Append(m_drawDataScratch, list->CmdBuffer.Data, list->CmdBuffer.Size);
+	}
+
+	const bool equal = m_drawDataScratch == m_drawDataSnapshot;
+	std::swap(m_drawDataScratch, m_drawDataSnapshot);
+	return equal;
+}
+
+bool ImguiLayerBase::CanReuseFrame(bool inputChanged) const
+{
+	// Text fields blink their cursor, and platform windows are rendered by ImGui itself, so neither is reused.
+	return !m_dirty && !inputChanged && m_drawDataStable && (m_backendsInitialized || m_headless)
+		&& m_skippedDeltaTime + m_io->DeltaTime < m_refreshSeconds
+		&& !m_io->WantTextInput
+		&& ImGui::GetPlatformIO().Viewports.Size <= 1
+		&& ImGui::GetDrawData() != nullptr;
+}
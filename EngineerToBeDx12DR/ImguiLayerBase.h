@@ -1,18 +1,80 @@
 ﻿#pragma once
 #include "imgui.h"
 
+#ifdef _WIN32
+#include "backends/imgui_impl_dx12.h"
+#endif
+
+#include <cstdint>
+#include <vector>
+
+struct ID3D12GraphicsCommandList;
+
+namespace DX
+{
+	class JobSystem;
+	class UploadRing;
+}
+
 class ImguiLayerBase
 {
 public:
 	ImguiLayerBase();
 
-	void OnDeviceCreated(HWND window, ID3D12Device * device, int backBufferCount, DXGI_FORMAT rtvFormat);
-
-	void OnRender(const Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> & commandList);
+#ifdef _WIN32
+	// The font texture's SRV is written to the given descriptor of srvHeap, a shader-visible heap that
+	// the caller binds on the command lists passed to OnRecord and keeps alive. window is the HWND.
+	// Call again with the new device after OnDeviceLost; the window backend is only initialized once.
+	void OnDeviceCreated(void * window, ID3D12Device * device, int backBufferCount, DXGI_FORMAT rtvFormat,
+		ID3D12DescriptorHeap * srvHeap, D3D12_CPU_DESCRIPTOR_HANDLE fontSrvCpuHandle, D3D12_GPU_DESCRIPTOR_HANDLE fontSrvGpuHandle);
 
+	// Release everything the renderer backend created on the device, including its per-frame buffers and
+	// the heap and font descriptor it was given. Nothing is drawn until OnDeviceCreated and SetUploadRing.
 	void OnDeviceLost();
+#endif
+
+	// Build the UI without a window or GPU, e.g. to measure CreateGUI on a headless backend. Draw data is
+	// counted instead of drawn: see ImGui_ImplHeadless_GetLastFrameStats. Use instead of OnDeviceCreated.
+	// The only backend there is off Windows.
+	void OnHeadlessCreated(int width, int height);
+
+#ifdef _WIN32
+	// Source the main viewport's vertex and index data from the frame's upload ring instead of
+	// ImGui's own per-frame buffers. Call after OnDeviceCreated.
+	void SetUploadRing(DX::UploadRing * uploadRing);
+#endif
+
+	// Build the draw lists queued with ImGui::AddDeferredDrawList across the job system's workers when
+	// ImGui::Render runs in OnNewFrame, instead of one after the other, and rasterize the font atlas there
+	// when the first frame builds it. Null does both serially again.
+	void SetJobSystem(DX::JobSystem * jobSystem);
 
-	void OnPresent(const Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> & commandList) const;
+#ifdef _WIN32
+	void OnRender(ID3D12GraphicsCommandList * commandList);
+#endif
+
+	// OnRender split in two: OnNewFrame builds the UI and must run on the window thread,
+	// OnRecord only records the resulting draw data and may run on a worker thread.
+	// commandList is ignored by the headless backend.
+	void OnNewFrame();
+	void OnRecord(ID3D12GraphicsCommandList * commandList) const;
+
+#ifdef _WIN32
+	void OnPresent(ID3D12GraphicsCommandList * commandList) const;
+#endif
+
+	// Retained mode for UI that is mostly idle: while the input is unchanged and the last two builds produced
+	// the same draw data, OnNewFrame skips building the UI and OnRecord draws the previous draw data again
+	// from the backend's buffers, without uploading it. The UI is still rebuilt at least every refreshSeconds,
+	// so time-driven widgets catch up, and on every frame while platform windows are open.
+	void SetRetainedMode(bool enabled, float refreshSeconds = 0.25f);
+	bool IsRetainedMode() const { return m_retainedMode; }
+
+	// Rebuild the UI on the next frame, e.g. after state it shows changed without any input.
+	void Invalidate() { m_dirty = true; }
+
+	uint64_t GetRebuiltFrameCount() const { return m_rebuiltFrames; }
+	uint64_t GetReusedFrameCount() const { return m_reusedFrames; }
 
 protected:
 	// override this method to create UI
@@ -21,6 +83,52 @@ protected:
 	virtual ~ImguiLayerBase();
 
 private:
-	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_srvDescriptorHeap;
+	enum class RecordMode
+	{
+		Upload,			// the UI was built this frame
+		RetainedUpload,	// first reused frame: upload once into the backend's own buffers
+		RetainedReuse,	// draw from those buffers again
+	};
+
+	struct InputState
+	{
+		ImVec2 mousePos;
+		float mouseWheel;
+		float mouseWheelH;
+		decltype(ImGuiIO::MouseDown) mouseDown;
+		decltype(ImGuiIO::KeysDown) keysDown;
+		bool keyCtrl;
+		bool keyShift;
+		bool keyAlt;
+		bool keySuper;
+		int inputCharacterCount;
+		ImVec2 displaySize;
+	};
+
+	// Returns true if the input differs from the previous frame's.
+	bool CaptureInput();
+	// Returns true if the draw data is identical to the previous build's.
+	bool CaptureDrawData(const ImDrawData * drawData);
+	bool CanReuseFrame(bool inputChanged) const;
+
 	ImGuiIO * m_io;
+	// false until OnDeviceCreated, e.g. when the game runs on a headless backend, and after OnDeviceLost
+	bool m_backendsInitialized = false;
+	// the window backend outlives the device
+	bool m_windowBackendInitialized = false;
+	// true after OnHeadlessCreated
+	bool m_headless = false;
+
+	bool m_retainedMode = false;
+	float m_refreshSeconds = 0.25f;
+	bool m_dirty = true;
+	bool m_drawDataStable = false;
+	float m_skippedDeltaTime = 0.f;
+	RecordMode m_recordMode = RecordMode::Upload;
+	InputState m_input = {};
+	// The last build's draw data, flattened, and the buffer the next build is flattened into.
+	std::vector<char> m_drawDataSnapshot;
+	std::vector<char> m_drawDataScratch;
+	uint64_t m_rebuiltFrames = 0;
+	uint64_t m_reusedFrames = 0;
 };
@@ -0,0 +1,301 @@
+//
+// JobSystem.cpp - Work-stealing job scheduler with per-worker deques and job dependencies
+//
+
+#include "JobSystem.h"
+
+#include "CpuProfiler.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace DX;
+
+namespace
+{
+    // Identifies the pool and worker slot of the calling thread.
+    thread_local const JobSystem* t_jobSystem = nullptr;
+    thread_local int t_workerIndex = -1;
+}
+
+unsigned int JobSystem::GetDefaultWorkerCount() noexcept
+{
+    const unsigned int hardwareThreads = std::thread::hardware_concurrency();
+    return hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+}
+
+// Constructor for JobSystem. With no workers, jobs only run on threads that call Wait.
+JobSystem::JobSystem(unsigned int workerCount) noexcept(false) :
+    m_queuedJobs(0),
+    m_waitingThreads(0),
+    m_exiting(false),
+    m_executedJobs(0),
+    m_stolenJobs(0)
+{
+    m_queues.reserve(workerCount + 1);
+    for (unsigned int i = 0; i < workerCount + 1; i++)
+    {
+        m_queues.push_back(std::make_unique<WorkQueue>());
+    }
+
+    m_workers.reserve(workerCount);
+    for (unsigned int i = 0; i < workerCount; i++)
+    {
+        m_workers.emplace_back(&JobSystem::WorkerThread, this, i);
+    }
+}
+
+// Destructor for JobSystem. Jobs that have not started yet are dropped.
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_exiting = true;
+    }
+    m_wakeup.notify_all();
+
+    for (auto& worker : m_workers)
+    {
+        worker.join();
+    }
+}
+
+JobHandle JobSystem::Schedule(JobFunction function, size_t dependencyCount, const JobHandle* dependencies)
+{
+    if (!function)
+    {
+        throw std::invalid_argument("Scheduled job has no function");
+    }
+
+    auto job = std::make_shared<Job>();
+    job->m_function = std::move(function);
+
+    // The extra count keeps the job from being queued by a dependency that completes while we are still registering.
+    job->m_pendingDependencies.store(1, std::memory_order_relaxed);
+
+    for (size_t i = 0; i < dependencyCount; i++)
+    {
+        auto& dependency = dependencies[i];
+        if (!dependency)
+            continue;
+
+        std::lock_guard<std::mutex> lock(dependency->m_mutex);
+        if (!dependency->m_completed)
+        {
+            job->m_pendingDependencies.fetch_add(1, std::memory_order_relaxed);
+            dependency->m_dependents.push_back(job);
+        }
+    }
+
+    if (job->m_pendingDependencies.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        Enqueue(job);
+    }
+
+    return job;
+}
+
+void JobSystem::Wait(const JobHandle& job)
+{
+    if (!job)
+        return;
+
+    const int workerIndex = GetCurrentWorkerIndex();
+    while (!job->IsComplete())
+    {
+        if (TryRunJob(workerIndex))
+            continue;
+
+        // Nothing to run: the job is executing on another thread or waiting on dependencies that are.
+        m_waitingThreads.fetch_add(1);
+        {
+            std::unique_lock<std::mutex> lock(m_sleepMutex);
+            m_wakeup.wait(lock, [&] { return job->IsComplete() || m_queuedJobs.load() > 0 || m_exiting; });
+        }
+        m_waitingThreads.fetch_sub(1);
+    }
+
+    if (job->m_error)
+    {
+        std::rethrow_exception(job->m_error);
+    }
+}
+
+void JobSystem::ParallelFor(size_t count, size_t grainSize, const RangeFunction& function)
+{
+    if (count == 0)
+        return;
+
+    grainSize = std::max<size_t>(grainSize, 1);
+
+    std::vector<JobHandle> jobs;
+    jobs.reserve((count + grainSize - 1) / grainSize);
+    for (size_t begin = 0; begin < count; begin += grainSize)
+    {
+        const size_t end = std::min(begin + grainSize, count);
+        jobs.push_back(Schedule([&function, begin, end] { function(begin, end); }));
+    }
+
+    // Wait for every chunk before rethrowing, since they reference the caller's function.
+    std::exception_ptr error;
+    for (auto& job : jobs)
+    {
+        try
+        {
+            Wait(job);
+        }
+        catch (...)
+        {
+            if (!error)
+            {
+                error = std::current_exception();
+            }
+        }
+    }
+
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+}
+
+int JobSystem::GetCurrentWorkerIndex() const noexcept
+{
+    return t_jobSystem == this ? t_workerIndex : -1;
+}
+
+void JobSystem::WorkerThread(unsigned int index)
+{
+    t_jobSystem = this;
+    t_workerIndex = static_cast<int>(index);
+
+    CpuProfiler::GetInstance().SetThreadName("Job worker " + std::to_string(index));
+
+    for (;;)
+    {
+        if (TryRunJob(t_workerIndex))
+            continue;
+
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_wakeup.wait(lock, [this] { return m_exiting || m_queuedJobs.load() > 0; });
+        if (m_exiting)
+            return;
+    }
+}
+
+void JobSystem::Enqueue(JobHandle job)
+{
+    const int workerIndex = GetCurrentWorkerIndex();
+    auto& queue = workerIndex >= 0 ? *m_queues[workerIndex] : *m_queues.back();
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.push_back(std::move(job));
+    }
+    m_queuedJobs.fetch_add(1);
+
+    // Taking the lock orders the notification after any sleeper's predicate check.
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+    }
+    m_wakeup.notify_one();
+}
+
+// Run one job: the newest from our own deque, otherwise the oldest from someone else's.
+bool JobSystem::TryRunJob(int workerIndex)
+{
+    if (m_queuedJobs.load() == 0)
+        return false;
+
+    JobHandle job;
+    if (workerIndex >= 0)
+    {
+        job = TryPop(*m_queues[workerIndex], true);
+    }
+
+    if (!job)
+    {
+        // Start at a different victim per thread so thieves do not all contend on the same deque.
+        const size_t queueCount = m_queues.size();
+        const size_t start = workerIndex >= 0 ? static_cast<size_t>(workerIndex) + 1 : queueCount - 1;
+        for (size_t i = 0; i < queueCount && !job; i++)
+        {
+            const size_t victim = (start + i) % queueCount;
+            if (static_cast<int>(victim) == workerIndex)
+                continue;
+
+            job = TryPop(*m_queues[victim], false);
+            if (job && victim != queueCount - 1)
+            {
+                m_stolenJobs.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    if (!job)
+        return false;
+
+    Execute(job);
+    return true;
+}
+
+JobHandle JobSystem::TryPop(WorkQueue& queue, bool fromBack)
+{
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.jobs.empty())
+        return nullptr;
+
+    JobHandle job;
+    if (fromBack)
+    {
+        job = std::move(queue.jobs.back());
+        queue.jobs.pop_back();
+    }
+    else
+    {
+        job = std::move(queue.jobs.front());
+        queue.jobs.pop_front();
+    }
+
+    m_queuedJobs.fetch_sub(1);
+    return job;
+}
+
+void JobSystem::Execute(const JobHandle& job)
+{
+    try
+    {
+        job->m_function();
+    }
+    catch (...)
+    {
+        job->m_error = std::current_exception();
+    }
+
+    // Release captured state now rather than when the last handle goes away.
+    job->m_function = nullptr;
+
+    std::vector<JobHandle> dependents;
+    {
+        std::lock_guard<std::mutex> lock(job->m_mutex);
+        job->m_completed = true;
+        dependents.swap(job->m_dependents);
+    }
+    job->m_done.store(true);
+    m_executedJobs.fetch_add(1, std::memory_order_relaxed);
+
+    for (auto& dependent : dependents)
+    {
+        if (dependent->m_pendingDependencies.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            Enqueue(std::move(dependent));
+        }
+    }
+
+    if (m_waitingThreads.load() > 0)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_sleepMutex);
+        }
+        m_wakeup.notify_all();
+    }
+}
@@ -0,0 +1,111 @@
+//
+// JobSystem.h - Work-stealing job scheduler with per-worker deques and job dependencies
+//
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace DX
+{
+    class JobSystem;
+
+    // A scheduled unit of work. Only the scheduler touches its internals; callers hold it through JobHandle.
+    class Job
+    {
+    public:
+        bool IsComplete() const noexcept { return m_done.load(std::memory_order_acquire); }
+
+    private:
+        friend class JobSystem;
+
+        std::function<void()>               m_function;
+        std::atomic<uint32_t>               m_pendingDependencies{ 0 };
+        std::atomic<bool>                   m_done{ false };
+        std::exception_ptr                  m_error;
+
+        // Jobs waiting on this one; m_completed is guarded by m_mutex so no dependent is added after it is released.
+        std::mutex                          m_mutex;
+        bool                                m_completed = false;
+        std::vector<std::shared_ptr<Job>>   m_dependents;
+    };
+
+    using JobHandle = std::shared_ptr<Job>;
+
+    // Each worker owns a deque: it pushes and pops its own jobs at the back (LIFO, cache friendly) while
+    // idle workers steal from the front of the others. Jobs scheduled from outside the pool go to a shared
+    // queue that everybody steals from. Threads blocked in Wait run jobs instead of sleeping.
+    class JobSystem
+    {
+    public:
+        using JobFunction = std::function<void()>;
+        using RangeFunction = std::function<void(size_t begin, size_t end)>;
+
+        // Number of workers that leaves one hardware thread to the thread that owns the job system.
+        static unsigned int GetDefaultWorkerCount() noexcept;
+
+        explicit JobSystem(unsigned int workerCount = GetDefaultWorkerCount()) noexcept(false);
+        ~JobSystem();
+
+        JobSystem(JobSystem&&) = delete;
+        JobSystem& operator= (JobSystem&&) = delete;
+
+        JobSystem(JobSystem const&) = delete;
+        JobSystem& operator= (JobSystem const&) = delete;
+
+        // Queue a job that runs once every dependency has completed. Null dependencies are ignored.
+        JobHandle Schedule(JobFunction function, size_t dependencyCount = 0, const JobHandle* dependencies = nullptr);
+
+        // Run jobs until the given one completes, then rethrow the exception it raised, if any.
+        // A failed job still releases its dependents. Waiting on a null handle returns immediately.
+        void Wait(const JobHandle& job);
+
+        // Split [0, count) into chunks of at most grainSize items, run them across the pool and wait for all of them.
+        void ParallelFor(size_t count, size_t grainSize, const RangeFunction& function);
+
+        unsigned int GetWorkerCount() const noexcept { return static_cast<unsigned int>(m_workers.size()); }
+
+        // Index of the calling worker, or -1 when called from a thread outside the pool.
+        int GetCurrentWorkerIndex() const noexcept;
+
+        uint64_t GetExecutedJobCount() const noexcept { return m_executedJobs.load(std::memory_order_relaxed); }
+        uint64_t GetStolenJobCount() const noexcept { return m_stolenJobs.load(std::memory_order_relaxed); }
+
+    private:
+        struct WorkQueue
+        {
+            std::mutex                      mutex;
+            std::deque<JobHandle>           jobs;
+        };
+
+        void WorkerThread(unsigned int index);
+        void Enqueue(JobHandle job);
+        bool TryRunJob(int workerIndex);
+        JobHandle TryPop(WorkQueue& queue, bool fromBack);
+        void Execute(const JobHandle& job);
+
+        // One queue per worker plus the shared queue for external threads, which is always last.
+        std::vector<std::unique_ptr<WorkQueue>>     m_queues;
+        std::vector<std::thread>                    m_workers;
+
+        // Idle workers and waiting threads sleep here until a job is queued or one completes.
+        std::mutex                                  m_sleepMutex;
+        std::condition_variable                     m_wakeup;
+        std::atomic<uint64_t>                       m_queuedJobs;
+        std::atomic<uint32_t>                       m_waitingThreads;
+        bool                                        m_exiting;
+
+        std::atomic<uint64_t>                       m_executedJobs;
+        std::atomic<uint64_t>                       m_stolenJobs;
+    };
+}
@@ -6,6 +6,8 @@
 #include "Game.h"
 #include "backends/imgui_impl_win32.h"
 
+#include <shellapi.h>
+
 using namespace DirectX;
 
 #ifdef __clang__
@@ -46,7 +48,6 @@ int WINAPI wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance,
     freopen_s(&pCerr, "CONOUT$", "w+", stderr);
 	
     UNREFERENCED_PARAMETER(hPrevInstance);
-    UNREFERENCED_PARAMETER(lpCmdLine);
 
     if (!XMVerifyCPUSupport())
         return 1;
@@ -101,6 +102,27 @@ int WINAPI wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance,
         g_game->Initialize(hwnd, rc.right - rc.left, rc.bottom - rc.top);
     }
 
+    // -telemetry <path> logs the frame time statistics of every window of frames, e.g. for soak runs.
+    {
+        int argc = 0;
+        LPWSTR* argv = CommandLineToArgvW(lpCmdLine, &argc);
+        for (int i = 0; argv && lpCmdLine[0] && i + 1 < argc; i++)
+        {
+            if (_wcsicmp(argv[i], L"-telemetry") == 0)
+            {
+                try
+                {
+                    g_game->OpenTelemetryLog(argv[i + 1]);
+                }
+                catch (const std::exception& e)
+                {
+                    std::cerr << e.what() << '\n';
+                }
+            }
+        }
+        LocalFree(argv);
+    }
+
     // Main message loop
     MSG msg = {};
     while (WM_QUIT != msg.message)
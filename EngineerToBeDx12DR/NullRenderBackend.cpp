@@ -0,0 +1,455 @@
+//
+// NullRenderBackend.cpp - A headless backend that records command streams to memory
+//
+
+#include "NullRenderBackend.h"
+
+#include "CookedTexture.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace DX;
+
+namespace
+{
+    // The null backend writes no timestamps, so there is never anything to read.
+    class NoTimestamps final : public ITimestampSource
+    {
+    public:
+        uint64_t GetTimestampFrequency() override { return 0; }
+        void ReadTimestamps(uint32_t, uint32_t count, uint64_t* timestamps) override { std::fill_n(timestamps, count, 0); }
+    };
+}
+
+void SimulatedFence::Signal(uint64_t value)
+{
+    if (value <= m_signaledValue)
+    {
+        throw std::logic_error("Fence values must increase monotonically");
+    }
+
+    m_signaledValue = value;
+    if (value > m_latency)
+    {
+        Complete(value - m_latency);
+    }
+}
+
+void SimulatedFence::Wait(uint64_t value)
+{
+    if (value > m_signaledValue)
+    {
+        // On a real device this would never return.
+        throw std::logic_error("Waiting on a fence value that was never signaled");
+    }
+
+    m_waitCount++;
+    Complete(value);
+}
+
+void SimulatedFence::Complete(uint64_t value)
+{
+    if (value > m_completedValue)
+    {
+        m_completedValue = std::min(value, m_signaledValue);
+    }
+}
+
+void RecordingCommandSink::BeginEvent(const wchar_t* name)
+{
+    Record(CommandType::BeginEvent).name = name;
+}
+
+void RecordingCommandSink::EndEvent()
+{
+    Record(CommandType::EndEvent);
+}
+
+void RecordingCommandSink::ResourceBarriers(uint32_t count, const ResourceBarrier* barriers)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        Record(CommandType::ResourceBarrier).barrier = barriers[i];
+    }
+}
+
+void RecordingCommandSink::SetRenderTarget()
+{
+    Record(CommandType::SetRenderTarget);
+}
+
+void RecordingCommandSink::ClearRenderTarget(const float color[4])
+{
+    auto& command = Record(CommandType::ClearRenderTarget);
+    for (size_t i = 0; i < 4; i++)
+    {
+        command.values[i] = color[i];
+    }
+}
+
+void RecordingCommandSink::ClearDepthStencil(float depth)
+{
+    Record(CommandType::ClearDepthStencil).values[0] = depth;
+}
+
+void RecordingCommandSink::Draw(uint32_t vertexCount, uint32_t instanceCount)
+{
+    auto& command = Record(CommandType::Draw);
+    command.counts[0] = vertexCount;
+    command.counts[1] = instanceCount;
+}
+
+void RecordingCommandSink::Append(const RecordingCommandSink& other)
+{
+    m_commandCount += other.m_commandsSinceOpen;
+
+    if (!m_recordingEnabled)
+        return;
+
+    for (auto command : other.m_commands)
+    {
+        command.frame = m_frame;
+        m_commands.push_back(command);
+    }
+}
+
+RecordedCommand& RecordingCommandSink::Record(CommandType type)
+{
+    if (!m_isOpen)
+    {
+        throw std::logic_error("Command recorded into a closed command list");
+    }
+
+    m_commandCount++;
+    m_commandsSinceOpen++;
+
+    if (!m_recordingEnabled)
+    {
+        return m_scratch;
+    }
+
+    RecordedCommand command = {};
+    command.type = type;
+    command.frame = m_frame;
+    m_commands.push_back(command);
+    return m_commands.back();
+}
+
+void NullCommandContext::Begin()
+{
+    if (m_sink.IsOpen())
+    {
+        throw std::logic_error("Command context reset while still recording");
+    }
+
+    // Like resetting an allocator, this throws away what was recorded the last time the slot was used.
+    m_sink.ClearCommands();
+    m_sink.Open(m_beginCount++);
+}
+
+void NullTransientResourceAllocator::GetAllocationInfo(const TransientResourceDesc& desc, uint64_t& size, uint64_t& alignment)
+{
+    size = desc.type == TransientResourceType::Buffer ? desc.width : uint64_t(desc.width) * desc.height * 4;
+    size = (size + c_placementAlignment - 1) / c_placementAlignment * c_placementAlignment;
+    alignment = c_placementAlignment;
+}
+
+void NullTransientResourceAllocator::Reserve(uint64_t heapSize)
+{
+    if (heapSize <= m_heapSize)
+        return;
+
+    // Resources placed in the old heap go away with it.
+    m_resources.clear();
+    m_heapSize = heapSize;
+    m_heapCreateCount++;
+}
+
+ResourceHandle NullTransientResourceAllocator::Acquire(const TransientResourceDesc& desc, uint64_t heapOffset, ResourceState& state)
+{
+    uint64_t size, alignment;
+    GetAllocationInfo(desc, size, alignment);
+    if (heapOffset % alignment != 0 || heapOffset + size > m_heapSize)
+    {
+        throw std::out_of_range("Transient resource placed outside of the heap");
+    }
+
+    for (const auto& resource : m_resources)
+    {
+        if (resource.offset == heapOffset && resource.desc == desc)
+        {
+            state = resource.state;
+            return resource.handle;
+        }
+    }
+
+    m_resources.push_back({ desc, heapOffset, m_nextHandle++, ResourceState::Common });
+    state = ResourceState::Common;
+    return m_resources.back().handle;
+}
+
+void NullTransientResourceAllocator::Release(ResourceHandle resource, ResourceState state)
+{
+    for (auto& placed : m_resources)
+    {
+        if (placed.handle == resource)
+        {
+            placed.state = state;
+            return;
+        }
+    }
+
+    throw std::invalid_argument("Released a resource this allocator does not own");
+}
+
+// Constructor for NullTextureStreamingBackend.
+NullTextureStreamingBackend::NullTextureStreamingBackend(const UploadRing* uploadRing) noexcept(false) :
+    m_uploadRing(uploadRing),
+    m_nextHandle(c_textureHandleBase),
+    m_decodeCount(0),
+    m_copyCount(0)
+{
+    if (!uploadRing)
+    {
+        throw std::invalid_argument("NullTextureStreamingBackend requires an upload ring");
+    }
+}
+
+void NullTextureStreamingBackend::SetImageSize(const std::wstring& path, uint32_t width, uint32_t height)
+{
+    if (width == 0 || height == 0)
+    {
+        throw std::invalid_argument("Image size must not be zero");
+    }
+
+    m_imageSizes[path] = { width, height };
+}
+
+void NullTextureStreamingBackend::Decode(const std::wstring& path, StreamedImage& image)
+{
+    m_decodeCount.fetch_add(1);
+
+    if (std::filesystem::path(path).extension() == c_CookedTextureExtension)
+    {
+        LoadCookedTexture(path, image);
+        return;
+    }
+
+    auto size = m_imageSizes.find(path);
+    image.width = size != m_imageSizes.end() ? size->second.first : c_defaultImageSize;
+    image.height = size != m_imageSizes.end() ? size->second.second : c_defaultImageSize;
+    image.mipLevels = 1;
+    image.format = c_FormatR8G8B8A8Unorm;
+    image.blockSize = 1;
+    image.bytesPerBlock = 4;
+
+    std::fill_n(AllocateTexels(image), image.GetMipSize(0), static_cast<uint8_t>(0xFF));
+}
+
+uint64_t NullTextureStreamingBackend::GetTextureSize(const StreamedImage& image)
+{
+    const uint64_t size = image.GetMipOffset(image.mipLevels);
+    return (size + c_placementAlignment - 1) / c_placementAlignment * c_placementAlignment;
+}
+
+ResourceHandle NullTextureStreamingBackend::CreateTexture(const StreamedImage& image)
+{
+    const ResourceHandle handle = m_nextHandle++;
+    m_textures[handle] = { image.mipLevels, 0, 0, false };
+    return handle;
+}
+
+void NullTextureStreamingBackend::ReleaseTexture(ResourceHandle texture)
+{
+    FindTexture(texture);
+    m_textures.erase(texture);
+}
+
+void NullTextureStreamingBackend::CopyRows(ResourceHandle texture, const StreamedImage& image, uint32_t mip, uint32_t firstRow,
+                                           uint32_t rowCount, uint64_t stagingOffset, uint32_t stagingPitch)
+{
+    auto& entry = FindTexture(texture);
+    if (stagingOffset % TextureStreamer::c_StagingPlacementAlignment != 0 || stagingPitch % TextureStreamer::c_StagingPitchAlignment != 0
+        || stagingPitch < image.GetRowSize(mip))
+    {
+        throw std::invalid_argument("Copy footprint is not aligned");
+    }
+
+    if (stagingOffset + uint64_t(rowCount) * stagingPitch > m_uploadRing->GetCapacity() || mip != entry.nextMip
+        || firstRow != entry.copiedRows || firstRow + rowCount > image.GetRowCount(mip))
+    {
+        throw std::out_of_range("Copied rows are outside of the staging buffer or the texture");
+    }
+
+    entry.copiedRows += rowCount;
+    if (entry.copiedRows == image.GetRowCount(mip))
+    {
+        entry.nextMip++;
+        entry.copiedRows = 0;
+    }
+
+    m_copyCount++;
+}
+
+void NullTextureStreamingBackend::FinishUpload(ResourceHandle texture)
+{
+    auto& entry = FindTexture(texture);
+    if (entry.nextMip != entry.mipLevels)
+    {
+        throw std::logic_error("Texture upload finished before all rows were copied");
+    }
+
+    entry.readable = true;
+}
+
+void NullTextureStreamingBackend::Publish(uint32_t slot, ResourceHandle texture)
+{
+    if (slot == TextureStreamer::c_PlaceholderSlot || !FindTexture(texture).readable)
+    {
+        throw std::logic_error("Published the placeholder slot or a texture that is still uploading");
+    }
+
+    m_published[slot] = texture;
+}
+
+ResourceHandle NullTextureStreamingBackend::GetPublishedTexture(uint32_t slot) const
+{
+    auto published = m_published.find(slot);
+    return published != m_published.end() ? published->second : 0;
+}
+
+NullTextureStreamingBackend::Texture& NullTextureStreamingBackend::FindTexture(ResourceHandle texture)
+{
+    auto entry = m_textures.find(texture);
+    if (entry == m_textures.end())
+    {
+        throw std::invalid_argument("Texture is not owned by this backend");
+    }
+
+    return entry->second;
+}
+
+// Constructor for NullRenderBackend.
+NullRenderBackend::NullRenderBackend(int width, int height, unsigned int backBufferCount, uint64_t uploadRingSize) noexcept(false) :
+    m_backBufferIndex(0),
+    m_backBufferCount(backBufferCount),
+    m_width(width),
+    m_height(height),
+    m_frameCount(0),
+    m_submittedContextCount(0),
+    m_uploadMemory(uploadRingSize),
+    m_uploadRing(std::make_unique<UploadRing>()),
+    m_descriptorAllocator(std::make_unique<DescriptorAllocator>(
+        c_persistentDescriptorCount, c_transientDescriptorsPerFrame, FramePacer::c_MaxFramesInFlight)),
+    m_gpuProfiler(std::make_unique<GpuProfiler>(c_maxGpuScopesPerFrame, FramePacer::c_MaxFramesInFlight)),
+    m_fence(std::make_unique<SimulatedFence>()),
+    m_deviceNotify(nullptr)
+{
+    if (backBufferCount < 2)
+    {
+        throw std::out_of_range("invalid backBufferCount");
+    }
+
+    m_framePacer.SetFence(m_fence.get());
+    m_uploadRing->Initialize(m_uploadMemory.data(), c_uploadRingGpuBase, uploadRingSize);
+}
+
+// There is no device to create; kept so the frame loop drives both backends identically.
+void NullRenderBackend::CreateDeviceResources()
+{
+    m_backBufferIndex = 0;
+    m_commandSink.Close();
+}
+
+void NullRenderBackend::CreateWindowSizeDependentResources()
+{
+    m_backBufferIndex = 0;
+}
+
+bool NullRenderBackend::WindowSizeChanged(int width, int height)
+{
+    if (width == m_width && height == m_height)
+    {
+        return false;
+    }
+
+    m_width = width;
+    m_height = height;
+    CreateWindowSizeDependentResources();
+    return true;
+}
+
+// Begin recording a new frame.
+void NullRenderBackend::Prepare(ResourceState beforeState, ResourceState afterState)
+{
+    if (m_commandSink.IsOpen())
+    {
+        throw std::logic_error("Prepare called twice without Present");
+    }
+
+    m_commandSink.Open(m_frameCount);
+    m_uploadRing->Retire(m_framePacer.GetCompletedFenceValue());
+    m_descriptorAllocator->BeginFrame(m_framePacer.GetFrameIndex(), m_framePacer.GetCompletedFenceValue());
+    NoTimestamps noTimestamps;
+    m_gpuProfiler->BeginFrame(m_framePacer.GetFrameIndex(), m_framePacer.GetCompletedFenceValue(), noTimestamps);
+
+    if (beforeState != afterState)
+    {
+        const ResourceBarrier barrier = { GetRenderTargetHandle(), beforeState, afterState };
+        m_commandSink.ResourceBarriers(1, &barrier);
+    }
+}
+
+// "Submit" the frame and advance to the next back buffer.
+void NullRenderBackend::Present(ResourceState beforeState)
+{
+    if (beforeState != ResourceState::Present)
+    {
+        const ResourceBarrier barrier = { GetRenderTargetHandle(), beforeState, ResourceState::Present };
+        m_commandSink.ResourceBarriers(1, &barrier);
+    }
+
+    m_commandSink.RecordQueueCommand(CommandType::ExecuteCommandList);
+    m_commandSink.RecordQueueCommand(CommandType::Present);
+    m_commandSink.Close();
+
+    m_frameCount++;
+    m_backBufferIndex = (m_backBufferIndex + 1) % m_backBufferCount;
+
+    m_uploadRing->Finish(m_framePacer.GetCurrentFenceValue());
+    m_descriptorAllocator->EndFrame(m_framePacer.GetCurrentFenceValue());
+    m_gpuProfiler->EndFrame(m_framePacer.GetCurrentFenceValue());
+    m_framePacer.EndFrame();
+}
+
+void NullRenderBackend::WaitForGpu() noexcept
+{
+    m_fence->Complete(m_fence->GetSignaledValue());
+}
+
+std::unique_ptr<ICommandContext> NullRenderBackend::CreateContext(unsigned int frameIndex, unsigned int slot)
+{
+    return std::make_unique<NullCommandContext>(frameIndex, slot);
+}
+
+void NullRenderBackend::Submit(unsigned int count, ICommandContext* const* contexts)
+{
+    if (!m_commandSink.IsOpen())
+    {
+        throw std::logic_error("Command contexts submitted outside of Prepare/Present");
+    }
+
+    for (unsigned int i = 0; i < count; i++)
+    {
+        auto context = static_cast<const NullCommandContext*>(contexts[i]);
+        if (context->GetRecordingSink().IsOpen())
+        {
+            throw std::logic_error("Submitted command context was not closed");
+        }
+
+        m_commandSink.Append(context->GetRecordingSink());
+    }
+
+    m_submittedContextCount += count;
+}
@@ -0,0 +1,322 @@
+//
+// NullRenderBackend.h - A headless backend that records command streams to memory
+//
+
+#pragma once
+
+#include "DescriptorAllocator.h"
+#include "GpuProfiler.h"
+#include "ParallelCommandRecorder.h"
+#include "RenderGraph.h"
+#include "TextureStreamer.h"
+#include "UploadRing.h"
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+namespace DX
+{
+    // A CPU-side fence. Signaled values complete on their own once `latency` newer values have been
+    // signaled, which models a GPU running that many frames behind; Wait completes them immediately.
+    class SimulatedFence final : public IFence
+    {
+    public:
+        explicit SimulatedFence(uint64_t latency = 1) noexcept :
+            m_latency(latency), m_signaledValue(0), m_completedValue(0), m_waitCount(0) {}
+
+        uint64_t GetCompletedValue() const override { return m_completedValue; }
+        void Signal(uint64_t value) override;
+        void Wait(uint64_t value) override;
+
+        // Simulate the GPU catching up to the given value.
+        void Complete(uint64_t value);
+
+        void SetLatency(uint64_t latency) noexcept { m_latency = latency; }
+        uint64_t GetSignaledValue() const noexcept { return m_signaledValue; }
+        uint64_t GetWaitCount() const noexcept { return m_waitCount; }
+
+    private:
+        uint64_t m_latency;
+        uint64_t m_signaledValue;
+        uint64_t m_completedValue;
+        uint64_t m_waitCount;
+    };
+
+    enum class CommandType : uint32_t
+    {
+        BeginEvent,
+        EndEvent,
+        ResourceBarrier,
+        SetRenderTarget,
+        ClearRenderTarget,
+        ClearDepthStencil,
+        Draw,
+        ExecuteCommandList,
+        Present,
+    };
+
+    // A single command as it would have been submitted to the GPU.
+    struct RecordedCommand
+    {
+        CommandType         type;
+        uint64_t            frame;
+        const wchar_t*      name;       // BeginEvent (names are expected to be string literals)
+        ResourceBarrier     barrier;    // ResourceBarrier
+        float               values[4];  // ClearRenderTarget color, ClearDepthStencil depth
+        uint32_t            counts[2];  // Draw vertex/instance counts
+    };
+
+    // Appends every ICommandSink call to an in-memory command stream.
+    class RecordingCommandSink final : public ICommandSink
+    {
+    public:
+        RecordingCommandSink() noexcept :
+            m_frame(0), m_commandCount(0), m_commandsSinceOpen(0), m_isOpen(false), m_recordingEnabled(true), m_scratch{} {}
+
+        void BeginEvent(const wchar_t* name) override;
+        void EndEvent() override;
+        void ResourceBarriers(uint32_t count, const ResourceBarrier* barriers) override;
+        void SetRenderTarget() override;
+        void ClearRenderTarget(const float color[4]) override;
+        void ClearDepthStencil(float depth) override;
+        void Draw(uint32_t vertexCount, uint32_t instanceCount) override;
+
+        // Recording outside of Open/Close throws, like recording into a closed command list.
+        void Open(uint64_t frame) noexcept { m_frame = frame; m_commandsSinceOpen = 0; m_isOpen = true; }
+        void Close() noexcept { m_isOpen = false; }
+        bool IsOpen() const noexcept { return m_isOpen; }
+
+        // Append the commands of another stream, e.g. a command context submitted this frame.
+        void Append(const RecordingCommandSink& other);
+
+        // Queue-level commands (ExecuteCommandList, Present) that have no ICommandSink equivalent.
+        void RecordQueueCommand(CommandType type) { Record(type); }
+
+        void SetRecordingEnabled(bool enabled) noexcept { m_recordingEnabled = enabled; }
+        const std::vector<RecordedCommand>& GetCommands() const noexcept { return m_commands; }
+        void ClearCommands() noexcept { m_commands.clear(); }
+        uint64_t GetCommandCount() const noexcept { return m_commandCount; }
+
+    private:
+        RecordedCommand& Record(CommandType type);
+
+        uint64_t                        m_frame;
+        uint64_t                        m_commandCount;
+        uint64_t                        m_commandsSinceOpen;
+        bool                            m_isOpen;
+        bool                            m_recordingEnabled;
+        std::vector<RecordedCommand>    m_commands;
+        RecordedCommand                 m_scratch;
+    };
+
+    // CPU mock of a pooled command list and allocator.
+    class NullCommandContext final : public ICommandContext
+    {
+    public:
+        NullCommandContext(unsigned int frameIndex, unsigned int slot) noexcept :
+            m_frameIndex(frameIndex), m_slot(slot), m_beginCount(0) {}
+
+        void Begin() override;
+        void End() override { m_sink.Close(); }
+        ICommandSink* GetCommandSink() noexcept override { return &m_sink; }
+
+        const RecordingCommandSink& GetRecordingSink() const noexcept { return m_sink; }
+        unsigned int GetFrameIndex() const noexcept { return m_frameIndex; }
+        unsigned int GetSlot() const noexcept { return m_slot; }
+        uint64_t GetBeginCount() const noexcept { return m_beginCount; }
+
+    private:
+        RecordingCommandSink    m_sink;
+        unsigned int            m_frameIndex;
+        unsigned int            m_slot;
+        uint64_t                m_beginCount;
+    };
+
+    // CPU mock of a placed resource heap. Textures take 4 bytes per texel and every allocation is rounded
+    // up to the 64KB default placement alignment, so aliasing results resemble the Direct3D 12 ones.
+    class NullTransientResourceAllocator final : public ITransientResourceAllocator
+    {
+    public:
+        NullTransientResourceAllocator() noexcept :
+            m_heapSize(0), m_heapCreateCount(0), m_nextHandle(c_transientHandleBase) {}
+
+        void GetAllocationInfo(const TransientResourceDesc& desc, uint64_t& size, uint64_t& alignment) override;
+        void Reserve(uint64_t heapSize) override;
+        ResourceHandle Acquire(const TransientResourceDesc& desc, uint64_t heapOffset, ResourceState& state) override;
+        void Release(ResourceHandle resource, ResourceState state) override;
+
+        uint64_t GetHeapSize() const noexcept { return m_heapSize; }
+        uint64_t GetHeapCreateCount() const noexcept { return m_heapCreateCount; }
+        size_t GetResourceCount() const noexcept { return m_resources.size(); }
+
+        static const uint64_t c_placementAlignment = 64 * 1024;
+
+        // Handles of placed resources start at this value.
+        static const ResourceHandle c_transientHandleBase = 0x100000;
+
+    private:
+        struct PlacedResource
+        {
+            TransientResourceDesc   desc;
+            uint64_t                offset;
+            ResourceHandle          handle;
+            ResourceState           state;
+        };
+
+        uint64_t                        m_heapSize;
+        uint64_t                        m_heapCreateCount;
+        ResourceHandle                  m_nextHandle;
+        std::vector<PlacedResource>     m_resources;
+    };
+
+    // Streams synthetic images: every path decodes to a solid RGBA8 image of its registered size, or of the
+    // default size, except cooked textures, which are loaded from disk. Copies are validated against the
+    // D3D12 footprint rules and counted instead of executed.
+    class NullTextureStreamingBackend final : public ITextureStreamingBackend
+    {
+    public:
+        // Copies are checked against the bounds of uploadRing, which must outlive the backend.
+        explicit NullTextureStreamingBackend(const UploadRing* uploadRing) noexcept(false);
+
+        // Register the size path decodes to. Not thread-safe; call before requesting the path.
+        void SetImageSize(const std::wstring& path, uint32_t width, uint32_t height);
+
+        void Decode(const std::wstring& path, StreamedImage& image) override;
+        uint64_t GetTextureSize(const StreamedImage& image) override;
+        ResourceHandle CreateTexture(const StreamedImage& image) override;
+        void ReleaseTexture(ResourceHandle texture) override;
+        void CopyRows(ResourceHandle texture, const StreamedImage& image, uint32_t mip, uint32_t firstRow,
+                      uint32_t rowCount, uint64_t stagingOffset, uint32_t stagingPitch) override;
+        void FinishUpload(ResourceHandle texture) override;
+        void Publish(uint32_t slot, ResourceHandle texture) override;
+
+        uint64_t GetDecodeCount() const noexcept { return m_decodeCount.load(); }
+        uint64_t GetCopyCount() const noexcept { return m_copyCount; }
+        size_t GetTextureCount() const noexcept { return m_textures.size(); }
+
+        // The texture last published to slot, or 0.
+        ResourceHandle GetPublishedTexture(uint32_t slot) const;
+
+        static const uint32_t c_defaultImageSize = 64;
+        static const uint64_t c_placementAlignment = 64 * 1024;
+
+        // Texture handles start at this value.
+        static const ResourceHandle c_textureHandleBase = 0x200000;
+
+    private:
+        // Mips must be copied in order, each from its first row to its last.
+        struct Texture
+        {
+            uint32_t                    mipLevels;
+            uint32_t                    nextMip;
+            uint32_t                    copiedRows;
+            bool                        readable;
+        };
+
+        Texture& FindTexture(ResourceHandle texture);
+
+        const UploadRing*                               m_uploadRing;
+        std::map<std::wstring, std::pair<uint32_t, uint32_t>> m_imageSizes;
+        std::map<ResourceHandle, Texture>               m_textures;
+        std::map<uint32_t, ResourceHandle>              m_published;
+        ResourceHandle                                  m_nextHandle;
+        std::atomic<uint64_t>                           m_decodeCount;
+        uint64_t                                        m_copyCount;
+    };
+
+    // Runs the frame loop without a GPU. Every command is appended to an in-memory stream so tests
+    // can verify what would have been submitted, and CPU frame cost can be measured in isolation.
+    // Contexts submitted through the factory are appended in submission order.
+    class NullRenderBackend final : public IRenderBackend, public ICommandContextFactory
+    {
+    public:
+        NullRenderBackend(int width = 800, int height = 600, unsigned int backBufferCount = 2,
+                          uint64_t uploadRingSize = c_defaultUploadRingSize) noexcept(false);
+
+        NullRenderBackend(NullRenderBackend&&) = default;
+        NullRenderBackend& operator= (NullRenderBackend&&) = default;
+
+        NullRenderBackend(NullRenderBackend const&) = delete;
+        NullRenderBackend& operator= (NullRenderBackend const&) = delete;
+
+        // IRenderBackend
+        void CreateDeviceResources() override;
+        void CreateWindowSizeDependentResources() override;
+        bool WindowSizeChanged(int width, int height) override;
+        void RegisterDeviceNotify(IDeviceNotify* deviceNotify) noexcept override { m_deviceNotify = deviceNotify; }
+        void Prepare(ResourceState beforeState = ResourceState::Present,
+                     ResourceState afterState = ResourceState::RenderTarget) override;
+        void Present(ResourceState beforeState = ResourceState::RenderTarget) override;
+        void WaitForGpu() noexcept override;
+        void SetFramesInFlight(unsigned int framesInFlight) override { m_framePacer.SetFramesInFlight(framesInFlight); }
+        const FramePacer& GetFramePacer() const noexcept override { return m_framePacer; }
+
+        int                     GetOutputWidth() const noexcept override            { return m_width; }
+        int                     GetOutputHeight() const noexcept override           { return m_height; }
+        unsigned int            GetCurrentFrameIndex() const noexcept override      { return m_backBufferIndex; }
+        unsigned int            GetBackBufferCount() const noexcept override        { return m_backBufferCount; }
+        ResourceHandle          GetRenderTargetHandle() const noexcept override     { return c_backBufferHandleBase + m_backBufferIndex; }
+        ResourceHandle          GetDepthStencilHandle() const noexcept override     { return c_depthStencilHandle; }
+        ICommandSink*           GetCommandSink() noexcept override                  { return &m_commandSink; }
+        ICommandContextFactory* GetCommandContextFactory() noexcept override        { return this; }
+        ITransientResourceAllocator* GetTransientResourceAllocator() noexcept override { return &m_transientAllocator; }
+        UploadRing&             GetUploadRing() noexcept override                   { return *m_uploadRing; }
+        DescriptorAllocator&    GetDescriptorAllocator() noexcept override          { return *m_descriptorAllocator; }
+        GpuProfiler&            GetGpuProfiler() noexcept override                  { return *m_gpuProfiler; }
+
+        // ICommandContextFactory
+        std::unique_ptr<ICommandContext> CreateContext(unsigned int frameIndex, unsigned int slot) override;
+        void Submit(unsigned int count, ICommandContext* const* contexts) override;
+
+        // Recorded command stream access. Disable recording to benchmark the frame loop without the stream growing.
+        void SetRecordingEnabled(bool enabled) noexcept { m_commandSink.SetRecordingEnabled(enabled); }
+        const std::vector<RecordedCommand>& GetRecordedCommands() const noexcept { return m_commandSink.GetCommands(); }
+        void ClearRecordedCommands() noexcept { m_commandSink.ClearCommands(); }
+
+        SimulatedFence& GetFence() noexcept { return *m_fence; }
+        const NullTransientResourceAllocator& GetTransientAllocator() const noexcept { return m_transientAllocator; }
+
+        uint64_t GetPresentedFrameCount() const noexcept { return m_frameCount; }
+        uint64_t GetCommandCount() const noexcept { return m_commandSink.GetCommandCount(); }
+        uint64_t GetSubmittedContextCount() const noexcept { return m_submittedContextCount; }
+
+        // Handles of the simulated back buffers start at this value.
+        static const ResourceHandle c_backBufferHandleBase = 0x1000;
+        static const ResourceHandle c_depthStencilHandle = 0x2000;
+
+        // GPU virtual address reported for the start of the upload ring.
+        static const uint64_t c_uploadRingGpuBase = 0x10000000;
+        static const uint64_t c_defaultUploadRingSize = 4 * 1024 * 1024;
+
+        // Layout of the simulated shader-visible heap.
+        static constexpr uint32_t c_persistentDescriptorCount = 1024;
+        static constexpr uint32_t c_transientDescriptorsPerFrame = 64;
+
+        // Scopes per frame of the GPU profiler. No timestamps are written, so it never reports timings.
+        static constexpr uint32_t c_maxGpuScopesPerFrame = 64;
+
+    private:
+        unsigned int                    m_backBufferIndex;
+        unsigned int                    m_backBufferCount;
+        int                             m_width;
+        int                             m_height;
+        uint64_t                        m_frameCount;
+        uint64_t                        m_submittedContextCount;
+        RecordingCommandSink            m_commandSink;
+        NullTransientResourceAllocator  m_transientAllocator;
+        std::vector<uint8_t>            m_uploadMemory;
+        std::unique_ptr<UploadRing>     m_uploadRing;
+        std::unique_ptr<DescriptorAllocator> m_descriptorAllocator;
+        std::unique_ptr<GpuProfiler>    m_gpuProfiler;
+
+        // Heap allocated so the pacer's fence pointer survives moves.
+        std::unique_ptr<SimulatedFence> m_fence;
+        FramePacer                      m_framePacer;
+
+        IDeviceNotify*                  m_deviceNotify;
+    };
+}
@@ -0,0 +1,102 @@
+//
+// ParallelCommandRecorder.cpp - Records render passes on worker threads into pooled command lists
+//
+
+#include "ParallelCommandRecorder.h"
+
+#include <stdexcept>
+
+using namespace DX;
+
+// Constructor for ParallelCommandRecorder.
+ParallelCommandRecorder::ParallelCommandRecorder(ICommandContextFactory* factory, JobSystem* jobSystem) noexcept(false) :
+    m_factory(factory),
+    m_jobSystem(jobSystem)
+{
+    if (!factory || !jobSystem)
+    {
+        throw std::invalid_argument("ParallelCommandRecorder requires a context factory and a job system");
+    }
+}
+
+void ParallelCommandRecorder::Record(unsigned int frameIndex, size_t passCount, const RecordFunction* passes)
+{
+    if (frameIndex >= FramePacer::c_MaxFramesInFlight)
+    {
+        throw std::out_of_range("invalid frameIndex");
+    }
+
+    // Grow the pool for this frame slot; contexts are only created the first time a slot is used.
+    auto& pool = m_pool[frameIndex];
+    while (pool.size() < passCount)
+    {
+        pool.push_back(m_factory->CreateContext(frameIndex, static_cast<unsigned int>(pool.size())));
+    }
+
+    m_recorded.clear();
+    m_jobs.clear();
+    for (size_t i = 0; i < passCount; i++)
+    {
+        // Each pass owns its context, so recording needs no locking.
+        auto context = pool[i].get();
+        auto& pass = passes[i];
+        m_recorded.push_back(context);
+        m_jobs.push_back(m_jobSystem->Schedule([context, &pass]
+            {
+                context->Begin();
+                try
+                {
+                    pass(*context);
+                }
+                catch (...)
+                {
+                    // Leave the context closed so the slot can be reset next time it is used.
+                    try { context->End(); } catch (...) {}
+                    throw;
+                }
+                context->End();
+            }));
+    }
+
+    // Wait for every pass before rethrowing, since the jobs reference the caller's passes.
+    std::exception_ptr error;
+    for (auto& job : m_jobs)
+    {
+        try
+        {
+            m_jobSystem->Wait(job);
+        }
+        catch (...)
+        {
+            if (!error)
+            {
+                error = std::current_exception();
+            }
+        }
+    }
+    m_jobs.clear();
+
+    if (error)
+    {
+        m_recorded.clear();
+        std::rethrow_exception(error);
+    }
+}
+
+void ParallelCommandRecorder::Submit()
+{
+    if (!m_recorded.empty())
+    {
+        m_factory->Submit(static_cast<unsigned int>(m_recorded.size()), m_recorded.data());
+        m_recorded.clear();
+    }
+}
+
+void ParallelCommandRecorder::ReleaseContexts() noexcept
+{
+    m_recorded.clear();
+    for (auto& pool : m_pool)
+    {
+        pool.clear();
+    }
+}
@@ -0,0 +1,78 @@
+//
+// ParallelCommandRecorder.h - Records render passes on worker threads into pooled command lists
+//
+
+#pragma once
+
+#include "JobSystem.h"
+#include "RenderBackend.h"
+
+#include <exception>
+#include <functional>
+#include <memory>
+#include <vector>
+
+
+namespace DX
+{
+    // A command list together with the allocator it records into.
+    class ICommandContext
+    {
+    public:
+        virtual ~ICommandContext() = default;
+
+        // Reset the allocator and open the list. The GPU must be done with the previous recording.
+        virtual void Begin() = 0;
+        virtual void End() = 0;
+
+        virtual ICommandSink* GetCommandSink() noexcept = 0;
+    };
+
+    // Creates command contexts and hands recorded ones to the backend.
+    class ICommandContextFactory
+    {
+    public:
+        virtual std::unique_ptr<ICommandContext> CreateContext(unsigned int frameIndex, unsigned int slot) = 0;
+
+        // Queue closed contexts for execution, in order, after the work already recorded this frame.
+        // All of them are submitted with a single ExecuteCommandLists call at Present.
+        virtual void Submit(unsigned int count, ICommandContext* const* contexts) = 0;
+
+    protected:
+        ~ICommandContextFactory() = default;
+    };
+
+    // Records a set of passes in parallel on a job system, each into its own context taken from a pool
+    // indexed by frame slot, and submits them in the order they were given regardless of which finished first.
+    class ParallelCommandRecorder
+    {
+    public:
+        using RecordFunction = std::function<void(ICommandContext&)>;
+
+        ParallelCommandRecorder(ICommandContextFactory* factory, JobSystem* jobSystem) noexcept(false);
+
+        ParallelCommandRecorder(ParallelCommandRecorder&&) = delete;
+        ParallelCommandRecorder& operator= (ParallelCommandRecorder&&) = delete;
+
+        ParallelCommandRecorder(ParallelCommandRecorder const&) = delete;
+        ParallelCommandRecorder& operator= (ParallelCommandRecorder const&) = delete;
+
+        // Record every pass as a job and wait for all of them; the calling thread runs jobs meanwhile. frameIndex
+        // must come from the frame pacer so a context is never reset while the GPU still executes it.
+        // Rethrows the first pass failure.
+        void Record(unsigned int frameIndex, size_t passCount, const RecordFunction* passes);
+
+        // Hand the contexts filled by the last Record call to the factory, in pass order.
+        void Submit();
+
+        // Drop all pooled contexts, e.g. on device lost.
+        void ReleaseContexts() noexcept;
+
+    private:
+        ICommandContextFactory*                                     m_factory;
+        JobSystem*                                                  m_jobSystem;
+        std::vector<std::unique_ptr<ICommandContext>>               m_pool[FramePacer::c_MaxFramesInFlight];
+        std::vector<ICommandContext*>                               m_recorded;
+        std::vector<JobHandle>                                      m_jobs;
+    };
+}
@@ -0,0 +1,191 @@
+//
+// PrimitiveBatcher.cpp - Accumulates textured triangles and quads as instances and groups them into instanced draws
+//
+
+#include "PrimitiveBatcher.h"
+
+#include <numeric>
+#include <stdexcept>
+
+using namespace DX;
+
+namespace
+{
+    const unsigned int c_RadixBits = 8;
+    const unsigned int c_RadixBuckets = 1u << c_RadixBits;
+    const unsigned int c_RadixPasses = 64 / c_RadixBits;
+}
+
+// Constructor for PrimitiveBatcher.
+PrimitiveBatcher::PrimitiveBatcher(size_t initialCapacity) :
+    m_built(false),
+    m_skippedSortPasses(0)
+{
+    m_keys.reserve(initialCapacity);
+    m_positions.reserve(initialCapacity);
+    m_texcoords.reserve(initialCapacity);
+    m_attributes.reserve(initialCapacity);
+}
+
+void PrimitiveBatcher::Clear() noexcept
+{
+    m_keys.clear();
+    m_positions.clear();
+    m_texcoords.clear();
+    m_attributes.clear();
+    m_batches.clear();
+    m_built = false;
+}
+
+void PrimitiveBatcher::AddTriangle(const BatchVertex& v0, const BatchVertex& v1, const BatchVertex& v2, const BatchState& state)
+{
+    Add(BatchPrimitive::Triangle, v0, v1, v2, state);
+}
+
+void PrimitiveBatcher::AddQuad(const BatchVertex& topLeft, const BatchVertex& topRight, const BatchVertex& bottomLeft, const BatchState& state)
+{
+    Add(BatchPrimitive::Quad, topLeft, topRight, bottomLeft, state);
+}
+
+void PrimitiveBatcher::AddSprite(float left, float top, float right, float bottom, const BatchState& state,
+                                 float u0, float v0, float u1, float v1)
+{
+    Add(BatchPrimitive::Quad, { left, top, u0, v0 }, { right, top, u1, v0 }, { left, bottom, u0, v1 }, state);
+}
+
+void PrimitiveBatcher::Add(BatchPrimitive primitive, const BatchVertex& v0, const BatchVertex& v1, const BatchVertex& v2, const BatchState& state)
+{
+    if (m_built)
+    {
+        throw std::logic_error("Instances added after Build; call Clear first");
+    }
+
+    if (state.material >= 0x8000)
+    {
+        throw std::out_of_range("Batch material index out of range");
+    }
+
+    if (m_keys.size() >= UINT32_MAX)
+    {
+        throw std::length_error("Too many batch instances");
+    }
+
+    m_keys.push_back(MakeKey(primitive, state));
+    m_positions.push_back({ { v0.x, v0.y, v1.x, v1.y, v2.x, v2.y } });
+    m_texcoords.push_back({ { v0.u, v0.v, v1.u, v1.v, v2.u, v2.v } });
+    m_attributes.push_back({ state.color, state.depth });
+}
+
+void PrimitiveBatcher::Build()
+{
+    if (m_built)
+        return;
+
+    SortKeys();
+
+    const auto count = static_cast<uint32_t>(m_sortedKeys.size());
+    for (uint32_t first = 0; first < count;)
+    {
+        const uint64_t key = m_sortedKeys[first];
+        uint32_t last = first + 1;
+        while (last < count && m_sortedKeys[last] == key)
+        {
+            last++;
+        }
+
+        Batch batch = {};
+        batch.primitive = static_cast<BatchPrimitive>((key >> 32) & 1);
+        batch.texture = static_cast<uint32_t>(key);
+        batch.material = static_cast<uint16_t>((key >> 33) & 0x7FFF);
+        batch.layer = static_cast<uint16_t>(key >> 48);
+        batch.firstInstance = first;
+        batch.instanceCount = last - first;
+        m_batches.push_back(batch);
+
+        first = last;
+    }
+
+    m_built = true;
+}
+
+// Stable LSD radix sort of the keys, carrying the instance indices along. All digit histograms are built in
+// one pass, and a pass whose digit is the same for every key is skipped: with few layers and materials,
+// most of the high digits are.
+void PrimitiveBatcher::SortKeys()
+{
+    const size_t count = m_keys.size();
+    m_sortedKeys.assign(m_keys.begin(), m_keys.end());
+    m_order.resize(count);
+    std::iota(m_order.begin(), m_order.end(), 0u);
+    m_skippedSortPasses = 0;
+
+    if (count < 2)
+        return;
+
+    m_keyScratch.resize(count);
+    m_orderScratch.resize(count);
+
+    std::vector<uint32_t> histograms(c_RadixPasses * c_RadixBuckets, 0);
+    for (const uint64_t key : m_sortedKeys)
+    {
+        for (unsigned int pass = 0; pass < c_RadixPasses; pass++)
+        {
+            histograms[pass * c_RadixBuckets + ((key >> (pass * c_RadixBits)) & (c_RadixBuckets - 1))]++;
+        }
+    }
+
+    for (unsigned int pass = 0; pass < c_RadixPasses; pass++)
+    {
+        uint32_t* histogram = histograms.data() + pass * c_RadixBuckets;
+        const unsigned int shift = pass * c_RadixBits;
+
+        if (histogram[(m_sortedKeys[0] >> shift) & (c_RadixBuckets - 1)] == count)
+        {
+            m_skippedSortPasses++;
+            continue;
+        }
+
+        uint32_t offset = 0;
+        for (unsigned int bucket = 0; bucket < c_RadixBuckets; bucket++)
+        {
+            const uint32_t bucketCount = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += bucketCount;
+        }
+
+        for (size_t i = 0; i < count; i++)
+        {
+            const uint64_t key = m_sortedKeys[i];
+            const uint32_t destination = histogram[(key >> shift) & (c_RadixBuckets - 1)]++;
+            m_keyScratch[destination] = key;
+            m_orderScratch[destination] = m_order[i];
+        }
+
+        m_sortedKeys.swap(m_keyScratch);
+        m_order.swap(m_orderScratch);
+    }
+}
+
+void PrimitiveBatcher::Pack(const BatchStreams& dest) const
+{
+    if (!m_built)
+    {
+        throw std::logic_error("PrimitiveBatcher::Pack called before Build");
+    }
+
+    const size_t count = m_order.size();
+    for (size_t i = 0; i < count; i++)
+    {
+        dest.positions[i] = m_positions[m_order[i]];
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        dest.texcoords[i] = m_texcoords[m_order[i]];
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        dest.attributes[i] = m_attributes[m_order[i]];
+    }
+}
@@ -0,0 +1,143 @@
+//
+// PrimitiveBatcher.h - Accumulates textured triangles and quads as instances and groups them into instanced draws
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+namespace DX
+{
+    enum class BatchPrimitive : uint32_t
+    {
+        Triangle,
+        Quad,           // a parallelogram: the fourth corner is implied by the other three
+    };
+
+    struct BatchVertex
+    {
+        float       x, y;       // pixels
+        float       u, v;
+    };
+
+    // What an instance is drawn with. Instances are ordered by layer first, so a higher layer always draws
+    // over a lower one; within a layer they are grouped by material, then by texture.
+    struct BatchState
+    {
+        uint32_t    texture;        // descriptor index, resolved by the renderer
+        uint16_t    material;       // pipeline state index below 32768, resolved by the renderer
+        uint16_t    layer;
+        uint32_t    color = 0xFFFFFFFF; // RGBA8 with red in the low byte, multiplied with the texture
+        float       depth = 0.f;
+    };
+
+    // Per-instance vertex streams, one array each. Every instance is three corners; a quad's fourth corner
+    // is corner1 + corner2 - corner0, and so is its texture coordinate.
+    struct BatchInstancePositions
+    {
+        float       corners[6];
+    };
+
+    struct BatchInstanceTexcoords
+    {
+        float       corners[6];
+    };
+
+    struct BatchInstanceAttributes
+    {
+        uint32_t    color;
+        float       depth;
+    };
+
+    // Destination of Pack, typically upload memory bound as per-instance vertex buffers.
+    struct BatchStreams
+    {
+        BatchInstancePositions*     positions;
+        BatchInstanceTexcoords*     texcoords;
+        BatchInstanceAttributes*    attributes;
+    };
+
+    // One instanced draw: instanceCount instances starting at firstInstance of the packed streams.
+    struct Batch
+    {
+        BatchPrimitive  primitive;
+        uint32_t        texture;
+        uint16_t        material;
+        uint16_t        layer;
+        uint32_t        firstInstance;
+        uint32_t        instanceCount;
+
+        uint32_t GetVertexCountPerInstance() const noexcept { return primitive == BatchPrimitive::Quad ? 6u : 3u; }
+    };
+
+    // Instances are appended into structure-of-arrays storage that keeps its capacity from frame to frame.
+    // Build sorts them by (layer, material, primitive, texture) with a stable radix sort, so submission order is
+    // kept among equal keys, and splits them into batches. Pack then gathers each stream in sorted order.
+    // Not thread-safe; use one batcher per recording thread.
+    class PrimitiveBatcher
+    {
+    public:
+        explicit PrimitiveBatcher(size_t initialCapacity = 0);
+
+        PrimitiveBatcher(PrimitiveBatcher&&) = default;
+        PrimitiveBatcher& operator= (PrimitiveBatcher&&) = default;
+
+        PrimitiveBatcher(PrimitiveBatcher const&) = delete;
+        PrimitiveBatcher& operator= (PrimitiveBatcher const&) = delete;
+
+        // Drop all instances and batches, keeping the allocated storage.
+        void Clear() noexcept;
+
+        void AddTriangle(const BatchVertex& v0, const BatchVertex& v1, const BatchVertex& v2, const BatchState& state);
+
+        // topLeft, topRight and bottomLeft span the quad; bottom right is implied.
+        void AddQuad(const BatchVertex& topLeft, const BatchVertex& topRight, const BatchVertex& bottomLeft, const BatchState& state);
+
+        // Axis-aligned rectangle in pixels, textured with the uv rectangle (u0, v0) - (u1, v1).
+        void AddSprite(float left, float top, float right, float bottom, const BatchState& state,
+                       float u0 = 0.f, float v0 = 0.f, float u1 = 1.f, float v1 = 1.f);
+
+        // Sort the instances and compute the batches. Instances must not be added until Clear.
+        void Build();
+
+        // Gather the streams into dest in sorted order; each array must hold GetInstanceCount() elements.
+        // Throws std::logic_error if called before Build.
+        void Pack(const BatchStreams& dest) const;
+
+        size_t GetInstanceCount() const noexcept { return m_keys.size(); }
+        const std::vector<Batch>& GetBatches() const noexcept { return m_batches; }
+        bool IsBuilt() const noexcept { return m_built; }
+
+        // Radix sort passes skipped because every key had the same digit, from the last Build.
+        uint32_t GetSkippedSortPasses() const noexcept { return m_skippedSortPasses; }
+
+    private:
+        void Add(BatchPrimitive primitive, const BatchVertex& v0, const BatchVertex& v1, const BatchVertex& v2, const BatchState& state);
+        void SortKeys();
+
+        static uint64_t MakeKey(BatchPrimitive primitive, const BatchState& state) noexcept
+        {
+            return (uint64_t(state.layer) << 48) | (uint64_t(state.material) << 33)
+                | (uint64_t(primitive) << 32) | uint64_t(state.texture);
+        }
+
+        // Instance streams in submission order.
+        std::vector<uint64_t>                   m_keys;
+        std::vector<BatchInstancePositions>     m_positions;
+        std::vector<BatchInstanceTexcoords>     m_texcoords;
+        std::vector<BatchInstanceAttributes>    m_attributes;
+
+        // Sorted order and radix sort scratch.
+        std::vector<uint32_t>                   m_order;
+        std::vector<uint32_t>                   m_orderScratch;
+        std::vector<uint64_t>                   m_sortedKeys;
+        std::vector<uint64_t>                   m_keyScratch;
+
+        std::vector<Batch>                      m_batches;
+        bool                                    m_built;
+        uint32_t                                m_skippedSortPasses;
+    };
+}
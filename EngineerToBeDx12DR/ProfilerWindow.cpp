@@ -0,0 +1,247 @@
+#include "ProfilerWindow.h"
+
+#include <algorithm>
+#include <fstream>
+
+namespace
+{
+	// The same scope gets the same color in every frame.
+	ImU32 GetScopeColor(const char * name)
+	{
+		uint32_t hash = 2166136261u;
+		for (; *name; name++)
+		{
+			hash = (hash ^ static_cast<unsigned char>(*name)) * 16777619u;
+		}
+
+		return ImColor::HSV(float(hash & 0xFFFF) / 65535.f, 0.45f, 0.9f);
+	}
+
+	// Scopes that began in an earlier frame are cut off at the frame's start.
+	void GetSampleRect(const DX::ProfileFrame & frame, const DX::ProfileSample & sample, ImVec2 origin, double scale, float rowHeight,
+		ImVec2 & min, ImVec2 & max)
+	{
+		const double begin = sample.begin > frame.begin ? double(sample.begin - frame.begin) : 0.0;
+		const double end = double(sample.end - frame.begin);
+
+		min = ImVec2(origin.x + float(begin * scale), origin.y + rowHeight * float(sample.depth));
+		max = ImVec2(std::max(origin.x + float(end * scale), min.x + 1.f), min.y + rowHeight - 1.f);
+	}
+}
+
+void ProfilerWindow::Show(DX::CpuProfiler & profiler, bool * open)
+{
+	if (!ImGui::Begin("Profiler", open))
+	{
+		ImGui::End();
+		return;
+	}
+
+	const DX::ProfileFrame * lastFrame = profiler.GetLastFrame();
+	if (ImGui::Checkbox("Pause", &m_paused) && m_paused && lastFrame)
+	{
+		m_pausedFrame = *lastFrame;
+	}
+
+	ImGui::SameLine();
+	if (ImGui::Button("Save trace"))
+	{
+		std::ofstream stream("profile.json");
+		profiler.WriteChromeTrace(stream);
+		m_status = stream ? "Saved profile.json" : "Could not write profile.json";
+	}
+
+	ImGui::SameLine();
+	ImGui::SetNextItemWidth(120.f);
+	ImGui::SliderFloat("Zoom", &m_zoom, 1.f, 50.f, "%.1fx", ImGuiSliderFlags_Logarithmic);
+
+	if (!m_status.empty())
+	{
+		ImGui::SameLine();
+		ImGui::TextUnformatted(m_status.c_str());
+	}
+
+	const DX::ProfileFrame * frame = m_paused ? &m_pausedFrame : lastFrame;
+	if (frame)
+	{
+		const double milliseconds = double(frame->end - frame->begin) * 1000.0 / double(DX::CpuProfiler::GetFrequency());
+		ImGui::Text("Frame %llu: %.3f ms, %zu scopes, %llu dropped",
+			static_cast<unsigned long long>(frame->number), milliseconds, frame->samples.size(),
+			static_cast<unsigned long long>(profiler.GetDroppedScopeCount()));
+
+		DrawFlameGraph(*frame, profiler.GetThreadNames());
+	}
+
+	ImGui::End();
+}
+
+void ProfilerWindow::ShowGpuTimings(const DX::GpuProfiler & profiler, bool * open)
+{
+	if (!ImGui::Begin("GPU timings", open))
+	{
+		ImGui::End();
+		return;
+	}
+
+	ImGui::Text("%llu frames read back, %llu scopes over budget",
+		static_cast<unsigned long long>(profiler.GetResolvedFrameCount()),
+		static_cast<unsigned long long>(profiler.GetOverflowCount()));
+
+	const ImGuiTableFlags flags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingStretchProp;
+	if (ImGui::BeginTable("GpuTimings", 7, flags))
+	{
+		ImGui::TableSetupColumn("Pass");
+		ImGui::TableSetupColumn("Last ms");
+		ImGui::TableSetupColumn("Avg ms");
+		ImGui::TableSetupColumn("p50");
+		ImGui::TableSetupColumn("p95");
+		ImGui::TableSetupColumn("p99");
+		ImGui::TableSetupColumn("Max");
+		ImGui::TableHeadersRow();
+
+		for (const auto & timing : profiler.GetTimings())
+		{
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn();
+			ImGui::TextUnformatted(timing.name.c_str());
+			for (const double milliseconds : { timing.lastMs, timing.averageMs, timing.p50Ms, timing.p95Ms, timing.p99Ms, timing.maxMs })
+			{
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", milliseconds);
+			}
+		}
+
+		ImGui::EndTable();
+	}
+
+	ImGui::End();
+}
+
+void ProfilerWindow::ShowFrameTimes(const DX::FrameTimeStats & total, const DX::FrameTimeStats & window, bool * open)
+{
+	if (!ImGui::Begin("Frame times", open))
+	{
+		ImGui::End();
+		return;
+	}
+
+	ImGui::Text("%llu frames, %llu stutters, %llu clamped",
+		static_cast<unsigned long long>(total.frameCount),
+		static_cast<unsigned long long>(total.stutterCount),
+		static_cast<unsigned long long>(total.clampedCount));
+
+	const ImGuiTableFlags flags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingStretchProp;
+	if (ImGui::BeginTable("FrameTimes", 8, flags))
+	{
+		ImGui::TableSetupColumn("Frames");
+		ImGui::TableSetupColumn("Stutters");
+		ImGui::TableSetupColumn("Avg ms");
+		ImGui::TableSetupColumn("p50");
+		ImGui::TableSetupColumn("p95");
+		ImGui::TableSetupColumn("p99");
+		ImGui::TableSetupColumn("p99.9");
+		ImGui::TableSetupColumn("Max");
+		ImGui::TableHeadersRow();
+
+		const double ticksToMilliseconds = 1000.0 / double(DX::StepTimer::TicksPerSecond);
+		for (const DX::FrameTimeStats * stats : { &total, &window })
+		{
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn();
+			ImGui::Text(stats == &total ? "All %llu" : "Last %llu", static_cast<unsigned long long>(stats->frameCount));
+			ImGui::TableNextColumn();
+			ImGui::Text("%llu", static_cast<unsigned long long>(stats->stutterCount));
+			for (const uint64_t ticks : { stats->meanTicks, stats->p50Ticks, stats->p95Ticks, stats->p99Ticks, stats->p999Ticks, stats->maxTicks })
+			{
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", double(ticks) * ticksToMilliseconds);
+			}
+		}
+
+		ImGui::EndTable();
+	}
+
+	ImGui::End();
+}
+
+// Samples of a thread are contiguous and ordered by begin time, so each lane is drawn in one pass. Lanes are
+// drawn as deferred draw lists, one per thread, which ImGui::Render may build in parallel; only the tooltip of
+// the hovered lane is looked up here.
+void ProfilerWindow::DrawFlameGraph(const DX::ProfileFrame & frame, const std::vector<std::string> & threadNames)
+{
+	const double ticksToMilliseconds = 1000.0 / double(DX::CpuProfiler::GetFrequency());
+	const float rowHeight = ImGui::GetTextLineHeightWithSpacing();
+
+	ImGui::BeginChild("FlameGraph", ImVec2(0.f, 0.f), false, ImGuiWindowFlags_HorizontalScrollbar);
+
+	const float width = ImGui::GetContentRegionAvail().x * m_zoom;
+	const double scale = width / double(std::max<uint64_t>(frame.end - frame.begin, 1));
+
+	m_lanes.clear();
+	for (size_t first = 0; first < frame.samples.size();)
+	{
+		const uint32_t thread = frame.samples[first].thread;
+		uint32_t maxDepth = 0;
+		size_t last = first;
+		for (; last < frame.samples.size() && frame.samples[last].thread == thread; last++)
+		{
+			maxDepth = std::max(maxDepth, frame.samples[last].depth);
+		}
+
+		ImGui::TextUnformatted(thread < threadNames.size() ? threadNames[thread].c_str() : "Unknown thread");
+		const ImVec2 origin = ImGui::GetCursorScreenPos();
+		const ImVec2 size(width, rowHeight * float(maxDepth + 1));
+		ImGui::Dummy(size);
+
+		if (ImGui::IsItemVisible())
+		{
+			m_lanes.push_back({ &frame, first, last, origin, scale, rowHeight });
+		}
+
+		if (ImGui::IsItemHovered())
+		{
+			for (size_t i = first; i < last; i++)
+			{
+				const auto & sample = frame.samples[i];
+				ImVec2 min, max;
+				GetSampleRect(frame, sample, origin, scale, rowHeight, min, max);
+				if (ImGui::IsMouseHoveringRect(min, max))
+				{
+					ImGui::SetTooltip("%s\n%.3f ms", sample.name, double(sample.end - sample.begin) * ticksToMilliseconds);
+				}
+			}
+		}
+
+		first = last;
+	}
+
+	// Queued once m_lanes stops growing, as ImGui keeps the pointers until Render.
+	for (auto & lane : m_lanes)
+	{
+		ImGui::AddDeferredDrawList(&ProfilerWindow::DrawFlameGraphLane, &lane);
+	}
+
+	ImGui::EndChild();
+}
+
+// Runs in ImGui::Render, possibly on a worker thread, so it only uses the draw list.
+void ProfilerWindow::DrawFlameGraphLane(ImDrawList * drawList, void * userData)
+{
+	const auto & lane = *static_cast<const FlameGraphLane *>(userData);
+	const ImVec2 clipMin = drawList->GetClipRectMin();
+	const ImVec2 clipMax = drawList->GetClipRectMax();
+
+	for (size_t i = lane.first; i < lane.last; i++)
+	{
+		const auto & sample = lane.frame->samples[i];
+		ImVec2 min, max;
+		GetSampleRect(*lane.frame, sample, lane.origin, lane.scale, lane.rowHeight, min, max);
+		if (max.x < clipMin.x || min.x > clipMax.x || max.y < clipMin.y || min.y > clipMax.y)
+			continue;
+
+		drawList->AddRectFilled(min, max, GetScopeColor(sample.name));
+		drawList->PushClipRect(min, max, true);
+		drawList->AddText(ImVec2(min.x + 2.f, min.y), IM_COL32_BLACK, sample.name);
+		drawList->PopClipRect();
+	}
+}
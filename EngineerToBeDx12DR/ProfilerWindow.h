@@ -0,0 +1,47 @@
+#pragma once
+
+#include "CpuProfiler.h"
+#include "FrameTelemetry.h"
+#include "GpuProfiler.h"
+
+#include "imgui.h"
+
+// An ImGui window showing a CpuProfiler frame as a flame graph, one lane per thread,
+// with buttons to pause on the current frame and to save the history as a Chrome trace,
+// a window with the rolling GPU time of every pass, and one with the frame time percentiles and stutters.
+class ProfilerWindow
+{
+public:
+	ProfilerWindow() = default;
+
+	// Call between ImGui::NewFrame and ImGui::Render, on the thread that calls profiler.EndFrame. The flame graph
+	// lanes are drawn by ImGui::Render, possibly on worker threads, so the profiler must not end a frame in between.
+	void Show(DX::CpuProfiler & profiler, bool * open);
+
+	// Call on the thread that renders, where the backend reads the timings back.
+	void ShowGpuTimings(const DX::GpuProfiler & profiler, bool * open);
+
+	// Frame times of the whole run and of the last window of frames, as handed over by the update job.
+	void ShowFrameTimes(const DX::FrameTimeStats & total, const DX::FrameTimeStats & window, bool * open);
+
+private:
+	// The samples of one thread and where they go; read by ImGui::Render.
+	struct FlameGraphLane
+	{
+		const DX::ProfileFrame * frame;
+		size_t first;
+		size_t last;
+		ImVec2 origin;
+		double scale;
+		float rowHeight;
+	};
+
+	void DrawFlameGraph(const DX::ProfileFrame & frame, const std::vector<std::string> & threadNames);
+	static void DrawFlameGraphLane(ImDrawList * drawList, void * lane);
+
+	bool m_paused = false;
+	float m_zoom = 1.f;
+	DX::ProfileFrame m_pausedFrame = {};
+	std::string m_status;
+	std::vector<FlameGraphLane> m_lanes;
+};
@@ -0,0 +1,133 @@
+//
+// RenderBackend.h - Platform-neutral interface for the device and frame loop
+//
+
+#pragma once
+
+#include "FramePacer.h"
+
+#include <cstdint>
+
+
+namespace DX
+{
+    class ICommandContextFactory;
+    class DescriptorAllocator;
+    class GpuProfiler;
+    class ITransientResourceAllocator;
+    class UploadRing;
+
+    // Resource states understood by every backend. The values mirror D3D12_RESOURCE_STATES
+    // so the Direct3D 12 backend can convert them with a plain cast.
+    enum class ResourceState : uint32_t
+    {
+        Common                  = 0,
+        Present                 = 0,
+        VertexAndConstantBuffer = 0x1,
+        IndexBuffer             = 0x2,
+        RenderTarget            = 0x4,
+        UnorderedAccess         = 0x8,
+        DepthWrite              = 0x10,
+        DepthRead               = 0x20,
+        NonPixelShaderResource  = 0x40,
+        PixelShaderResource     = 0x80,
+        CopyDest                = 0x400,
+        CopySource              = 0x800,
+        GenericRead             = 0xAC3,
+    };
+
+    // Opaque resource identifier. The Direct3D 12 backend stores the ID3D12Resource pointer.
+    using ResourceHandle = uint64_t;
+
+    enum class BarrierType : uint32_t
+    {
+        Transition,
+        Aliasing,       // resource starts using memory shared with other placed resources; states are ignored
+        UnorderedAccess,
+    };
+
+    struct ResourceBarrier
+    {
+        ResourceHandle  resource;
+        ResourceState   before;
+        ResourceState   after;
+        BarrierType     type = BarrierType::Transition;
+    };
+
+    // Provides an interface for an application that owns a render backend to be notified of the device being lost or created.
+    class IDeviceNotify
+    {
+    public:
+        virtual void OnDeviceLost() = 0;
+        virtual void OnDeviceRestored() = 0;
+
+    protected:
+        ~IDeviceNotify() = default;
+    };
+
+    // The subset of command list functionality the frame loop records through.
+    class ICommandSink
+    {
+    public:
+        virtual void BeginEvent(const wchar_t* name) = 0;
+        virtual void EndEvent() = 0;
+        virtual void ResourceBarriers(uint32_t count, const ResourceBarrier* barriers) = 0;
+
+        // Binds the current back buffer and depth buffer, along with a full-screen viewport and scissor rect.
+        virtual void SetRenderTarget() = 0;
+        virtual void ClearRenderTarget(const float color[4]) = 0;
+        virtual void ClearDepthStencil(float depth) = 0;
+        virtual void Draw(uint32_t vertexCount, uint32_t instanceCount) = 0;
+
+    protected:
+        ~ICommandSink() = default;
+    };
+
+    // Owns the device, swap chain and per-frame command recording state.
+    class IRenderBackend
+    {
+    public:
+        virtual ~IRenderBackend() = default;
+
+        virtual void CreateDeviceResources() = 0;
+        virtual void CreateWindowSizeDependentResources() = 0;
+        virtual bool WindowSizeChanged(int width, int height) = 0;
+        virtual void RegisterDeviceNotify(IDeviceNotify* deviceNotify) noexcept = 0;
+        virtual void Prepare(ResourceState beforeState = ResourceState::Present,
+                             ResourceState afterState = ResourceState::RenderTarget) = 0;
+        virtual void Present(ResourceState beforeState = ResourceState::RenderTarget) = 0;
+        virtual void WaitForGpu() noexcept = 0;
+
+        // Number of frames the CPU may record ahead of the GPU (clamped to 1 to FramePacer::c_MaxFramesInFlight).
+        virtual void SetFramesInFlight(unsigned int framesInFlight) = 0;
+        virtual const FramePacer& GetFramePacer() const noexcept = 0;
+
+        virtual int             GetOutputWidth() const noexcept = 0;
+        virtual int             GetOutputHeight() const noexcept = 0;
+        virtual unsigned int    GetCurrentFrameIndex() const noexcept = 0;
+        virtual unsigned int    GetBackBufferCount() const noexcept = 0;
+        virtual ResourceHandle  GetRenderTargetHandle() const noexcept = 0;
+        virtual ResourceHandle  GetDepthStencilHandle() const noexcept = 0;
+
+        // Valid between Prepare and Present.
+        virtual ICommandSink*   GetCommandSink() noexcept = 0;
+
+        // Source of additional command lists for recording passes on worker threads.
+        virtual ICommandContextFactory* GetCommandContextFactory() noexcept = 0;
+
+        // Places render graph transient resources in a shared heap.
+        virtual ITransientResourceAllocator* GetTransientResourceAllocator() noexcept = 0;
+
+        // Persistently mapped upload memory for the frame's transient data. Retired in Prepare and
+        // tagged with the frame's fence value in Present.
+        virtual UploadRing& GetUploadRing() noexcept = 0;
+
+        // Slots of the one shader-visible descriptor heap shared by everything that renders. Transient
+        // descriptors are reset in Prepare; freed slots are recycled once their frame completes.
+        virtual DescriptorAllocator& GetDescriptorAllocator() noexcept = 0;
+
+        // GPU time of the frame and of every BeginEvent/EndEvent pair recorded through a command sink.
+        // Timings are read back in Prepare, from frames the GPU has finished.
+        virtual GpuProfiler& GetGpuProfiler() noexcept = 0;
+    };
+}
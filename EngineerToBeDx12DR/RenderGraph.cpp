@@ -0,0 +1,435 @@
+//
+// RenderGraph.cpp - Declarative frame graph with barrier batching, pass culling and transient aliasing
+//
+
+#include "RenderGraph.h"
+
+#include "CpuProfiler.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace DX;
+
+namespace
+{
+    const uint32_t c_writeStates = static_cast<uint32_t>(ResourceState::RenderTarget)
+        | static_cast<uint32_t>(ResourceState::UnorderedAccess)
+        | static_cast<uint32_t>(ResourceState::DepthWrite)
+        | static_cast<uint32_t>(ResourceState::CopyDest);
+
+    inline bool IsReadOnly(ResourceState state) noexcept
+    {
+        return state != ResourceState::Common && (static_cast<uint32_t>(state) & c_writeStates) == 0;
+    }
+
+    // True if a resource in `current` can already be accessed as `requested` without a transition.
+    inline bool Includes(ResourceState current, ResourceState requested) noexcept
+    {
+        if (current == requested)
+            return true;
+
+        return IsReadOnly(current) && IsReadOnly(requested)
+            && (static_cast<uint32_t>(current) & static_cast<uint32_t>(requested)) == static_cast<uint32_t>(requested);
+    }
+
+    inline uint64_t AlignUp(uint64_t value, uint64_t alignment) noexcept
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+}
+
+void RenderGraphBuilder::Read(RenderGraphResource resource, ResourceState state)
+{
+    m_graph.AddAccess(m_pass, resource, state, false);
+}
+
+void RenderGraphBuilder::Write(RenderGraphResource resource, ResourceState state)
+{
+    m_graph.AddAccess(m_pass, resource, state, true);
+}
+
+void RenderGraphBuilder::SetSideEffect() noexcept
+{
+    m_graph.m_passes[m_pass].sideEffect = true;
+}
+
+void RenderGraph::Reset() noexcept
+{
+    m_resources.clear();
+    m_passes.clear();
+    m_barriers.clear();
+    m_firstFinalBarrier = 0;
+    m_heapSize = 0;
+    m_allocator = nullptr;
+}
+
+RenderGraphResource RenderGraph::ImportResource(const wchar_t* name, ResourceHandle resource,
+                                                ResourceState initialState, ResourceState finalState)
+{
+    ResourceNode node = {};
+    node.name = name;
+    node.imported = true;
+    node.handle = resource;
+    node.initialState = initialState;
+    node.finalState = finalState;
+    m_resources.push_back(node);
+    return static_cast<RenderGraphResource>(m_resources.size() - 1);
+}
+
+RenderGraphResource RenderGraph::CreateTransient(const wchar_t* name, const TransientResourceDesc& desc)
+{
+    if (desc.width == 0 || (desc.type == TransientResourceType::Texture2D && desc.height == 0))
+    {
+        throw std::invalid_argument("Transient resource has no size");
+    }
+
+    ResourceNode node = {};
+    node.name = name;
+    node.imported = false;
+    node.desc = desc;
+    m_resources.push_back(node);
+    return static_cast<RenderGraphResource>(m_resources.size() - 1);
+}
+
+size_t RenderGraph::AddPass(const wchar_t* name, const SetupFunction& setup, ExecuteFunction execute)
+{
+    PassNode pass = {};
+    pass.name = name;
+    pass.execute = std::move(execute);
+    m_passes.push_back(std::move(pass));
+
+    const size_t index = m_passes.size() - 1;
+    RenderGraphBuilder builder(*this, index);
+    setup(builder);
+    return index;
+}
+
+// A pass may touch a resource several times; reads are merged, but it can only be in one writable state.
+void RenderGraph::AddAccess(size_t pass, RenderGraphResource resource, ResourceState state, bool write)
+{
+    if (resource >= m_resources.size())
+    {
+        throw std::out_of_range("invalid RenderGraphResource");
+    }
+
+    if (write == IsReadOnly(state))
+    {
+        throw std::invalid_argument(write ? "Write access with a read-only state" : "Read access with a writable state");
+    }
+
+    auto& accesses = m_passes[pass].accesses;
+    for (auto& access : accesses)
+    {
+        if (access.resource != resource)
+            continue;
+
+        if (access.write || write)
+        {
+            if (access.state != state)
+            {
+                throw std::logic_error("Pass uses a resource in conflicting states");
+            }
+        }
+        else
+        {
+            access.state = static_cast<ResourceState>(static_cast<uint32_t>(access.state) | static_cast<uint32_t>(state));
+        }
+
+        access.write = access.write || write;
+        return;
+    }
+
+    accesses.push_back({ resource, state, write });
+}
+
+void RenderGraph::Compile(ITransientResourceAllocator* allocator)
+{
+    CullPasses();
+    PlaceTransients(allocator);
+    ComputeBarriers();
+}
+
+// Walk backwards from the passes with visible results, keeping every pass that writes a resource
+// a kept pass depends on. Writes count as dependencies too, since most passes draw over what is there.
+void RenderGraph::CullPasses()
+{
+    std::vector<bool> needed(m_resources.size(), false);
+
+    for (size_t i = m_passes.size(); i-- > 0;)
+    {
+        auto& pass = m_passes[i];
+
+        bool keep = pass.sideEffect;
+        for (const auto& access : pass.accesses)
+        {
+            if (access.write && (m_resources[access.resource].imported || needed[access.resource]))
+            {
+                keep = true;
+            }
+        }
+
+        pass.culled = !keep;
+        if (!keep)
+            continue;
+
+        for (const auto& access : pass.accesses)
+        {
+            needed[access.resource] = true;
+        }
+    }
+}
+
+// Greedy first fit, largest first: each transient goes at the lowest offset that does not overlap the
+// memory of an already placed transient whose lifetime overlaps its own.
+void RenderGraph::PlaceTransients(ITransientResourceAllocator* allocator)
+{
+    m_allocator = allocator;
+    m_heapSize = 0;
+
+    for (auto& resource : m_resources)
+    {
+        resource.firstPass = c_NoPass;
+        resource.lastPass = c_NoPass;
+        resource.aliased = false;
+        resource.offset = 0;
+    }
+
+    for (RenderGraphResource i = 0; i < m_resources.size(); i++)
+    {
+        m_resources[i].stateOwner = i;
+    }
+
+    for (uint32_t i = 0; i < m_passes.size(); i++)
+    {
+        if (m_passes[i].culled)
+            continue;
+
+        for (const auto& access : m_passes[i].accesses)
+        {
+            auto& resource = m_resources[access.resource];
+            if (resource.firstPass == c_NoPass)
+            {
+                resource.firstPass = i;
+            }
+            resource.lastPass = i;
+        }
+    }
+
+    std::vector<RenderGraphResource> transients;
+    for (RenderGraphResource i = 0; i < m_resources.size(); i++)
+    {
+        if (!m_resources[i].imported && m_resources[i].firstPass != c_NoPass)
+        {
+            transients.push_back(i);
+        }
+    }
+
+    if (transients.empty())
+        return;
+
+    if (!allocator)
+    {
+        throw std::logic_error("Transient resources need an allocator");
+    }
+
+    for (auto index : transients)
+    {
+        auto& resource = m_resources[index];
+        allocator->GetAllocationInfo(resource.desc, resource.size, resource.alignment);
+        resource.alignment = std::max<uint64_t>(resource.alignment, 1);
+    }
+
+    std::stable_sort(transients.begin(), transients.end(), [this](RenderGraphResource a, RenderGraphResource b)
+        {
+            return m_resources[a].size > m_resources[b].size;
+        });
+
+    std::vector<RenderGraphResource> placed;
+    placed.reserve(transients.size());
+    for (auto index : transients)
+    {
+        auto& resource = m_resources[index];
+
+        auto overlapsInTime = [&](const ResourceNode& other)
+        {
+            return resource.firstPass <= other.lastPass && other.firstPass <= resource.lastPass;
+        };
+
+        // Candidate offsets are the start of the heap and the end of every live neighbour.
+        uint64_t best = UINT64_MAX;
+        auto tryOffset = [&](uint64_t offset)
+        {
+            offset = AlignUp(offset, resource.alignment);
+            if (offset >= best)
+                return;
+
+            for (auto other : placed)
+            {
+                const auto& node = m_resources[other];
+                if (overlapsInTime(node) && offset < node.offset + node.size && node.offset < offset + resource.size)
+                    return;
+            }
+            best = offset;
+        };
+
+        tryOffset(0);
+        for (auto other : placed)
+        {
+            if (overlapsInTime(m_resources[other]))
+            {
+                tryOffset(m_resources[other].offset + m_resources[other].size);
+            }
+        }
+
+        resource.offset = best;
+        m_heapSize = std::max(m_heapSize, best + resource.size);
+        placed.push_back(index);
+    }
+
+    allocator->Reserve(m_heapSize);
+    for (auto index : transients)
+    {
+        auto& resource = m_resources[index];
+        resource.handle = allocator->Acquire(resource.desc, resource.offset, resource.initialState);
+    }
+
+    // Transients with the same description at the same offset share one placed resource, and so its state.
+    // Anything sharing memory with a different resource needs an aliasing barrier before its first use.
+    for (size_t i = 0; i < placed.size(); i++)
+    {
+        for (size_t j = 0; j < i; j++)
+        {
+            auto& a = m_resources[placed[j]];
+            auto& b = m_resources[placed[i]];
+            if (a.handle == b.handle)
+            {
+                b.stateOwner = std::min(b.stateOwner, a.stateOwner);
+            }
+            else if (a.offset < b.offset + b.size && b.offset < a.offset + a.size)
+            {
+                a.aliased = true;
+                b.aliased = true;
+            }
+        }
+    }
+}
+
+// Each kept pass gets one contiguous batch with everything it needs before it starts.
+void RenderGraph::ComputeBarriers()
+{
+    m_barriers.clear();
+
+    for (auto& resource : m_resources)
+    {
+        resource.state = resource.initialState;
+        resource.lastAccessWrote = false;
+    }
+
+    for (uint32_t i = 0; i < m_passes.size(); i++)
+    {
+        auto& pass = m_passes[i];
+        pass.firstBarrier = m_barriers.size();
+        pass.barrierCount = 0;
+        if (pass.culled)
+            continue;
+
+        for (const auto& access : pass.accesses)
+        {
+            const auto& node = m_resources[access.resource];
+            auto& resource = m_resources[node.stateOwner];
+
+            if (!node.imported && node.aliased && node.firstPass == i)
+            {
+                ResourceBarrier barrier = { resource.handle, resource.state, resource.state, BarrierType::Aliasing };
+                m_barriers.push_back(barrier);
+            }
+
+            if (!Includes(resource.state, access.state))
+            {
+                m_barriers.push_back({ resource.handle, resource.state, access.state });
+                resource.state = access.state;
+            }
+            else if (access.state == ResourceState::UnorderedAccess && (resource.lastAccessWrote || access.write))
+            {
+                // Back to back unordered access still has to wait for the previous writes.
+                ResourceBarrier barrier = { resource.handle, resource.state, resource.state, BarrierType::UnorderedAccess };
+                m_barriers.push_back(barrier);
+            }
+
+            resource.lastAccessWrote = access.write;
+        }
+
+        pass.barrierCount = m_barriers.size() - pass.firstBarrier;
+    }
+
+    m_firstFinalBarrier = m_barriers.size();
+    for (auto& resource : m_resources)
+    {
+        if (resource.imported && resource.state != resource.finalState)
+        {
+            m_barriers.push_back({ resource.handle, resource.state, resource.finalState });
+            resource.state = resource.finalState;
+        }
+    }
+}
+
+void RenderGraph::Execute(ParallelCommandRecorder& recorder, unsigned int frameIndex, ICommandSink& sink)
+{
+    m_recordFunctions.clear();
+    for (const auto& pass : m_passes)
+    {
+        if (pass.culled)
+            continue;
+
+        const PassNode* node = &pass;
+        const ResourceBarrier* barriers = m_barriers.data() + pass.firstBarrier;
+        m_recordFunctions.push_back([this, node, barriers](ICommandContext& context)
+            {
+                ProfileScope profileScope("RenderGraph pass");
+
+                auto passSink = context.GetCommandSink();
+                if (node->barrierCount > 0)
+                {
+                    passSink->ResourceBarriers(static_cast<uint32_t>(node->barrierCount), barriers);
+                }
+
+                passSink->BeginEvent(node->name);
+                node->execute(context, *this);
+                passSink->EndEvent();
+            });
+    }
+
+    recorder.Record(frameIndex, m_recordFunctions.size(), m_recordFunctions.data());
+    recorder.Submit();
+
+    if (m_barriers.size() > m_firstFinalBarrier)
+    {
+        sink.ResourceBarriers(static_cast<uint32_t>(m_barriers.size() - m_firstFinalBarrier), m_barriers.data() + m_firstFinalBarrier);
+    }
+
+    for (RenderGraphResource i = 0; i < m_resources.size(); i++)
+    {
+        const auto& resource = m_resources[i];
+        if (!resource.imported && resource.firstPass != c_NoPass && resource.stateOwner == i)
+        {
+            m_allocator->Release(resource.handle, resource.state);
+        }
+    }
+}
+
+ResourceHandle RenderGraph::GetResource(RenderGraphResource resource) const
+{
+    const auto& node = m_resources.at(resource);
+    if (!node.imported && node.firstPass == c_NoPass)
+    {
+        throw std::logic_error("Transient resource is not used by any pass");
+    }
+
+    return node.handle;
+}
+
+size_t RenderGraph::GetCulledPassCount() const noexcept
+{
+    return static_cast<size_t>(std::count_if(m_passes.begin(), m_passes.end(), [](const PassNode& pass) { return pass.culled; }));
+}
@@ -0,0 +1,196 @@
+//
+// RenderGraph.h - Declarative frame graph with barrier batching, pass culling and transient aliasing
+//
+
+#pragma once
+
+#include "ParallelCommandRecorder.h"
+
+#include <functional>
+#include <vector>
+
+
+namespace DX
+{
+    enum class TransientResourceType : uint32_t
+    {
+        Buffer,
+        Texture2D,
+    };
+
+    enum TransientResourceFlags : uint32_t
+    {
+        TransientResourceFlags_None                 = 0,
+        TransientResourceFlags_RenderTarget         = 0x1,
+        TransientResourceFlags_DepthStencil         = 0x2,
+        TransientResourceFlags_UnorderedAccess      = 0x4,
+    };
+
+    struct TransientResourceDesc
+    {
+        TransientResourceType   type;
+        uint32_t                width;      // bytes for buffers
+        uint32_t                height;
+        uint32_t                format;     // DXGI_FORMAT for textures
+        uint32_t                flags;      // TransientResourceFlags
+
+        bool operator== (const TransientResourceDesc& other) const noexcept
+        {
+            return type == other.type && width == other.width && height == other.height
+                && format == other.format && flags == other.flags;
+        }
+    };
+
+    // Backs the render graph's transient resources with placed resources in one shared heap.
+    class ITransientResourceAllocator
+    {
+    public:
+        virtual void GetAllocationInfo(const TransientResourceDesc& desc, uint64_t& size, uint64_t& alignment) = 0;
+
+        // Make sure the heap is at least heapSize bytes. Growing it may wait for the GPU.
+        virtual void Reserve(uint64_t heapSize) = 0;
+
+        // Returns the resource placed at heapOffset, creating it if needed, and the state it was last left in.
+        virtual ResourceHandle Acquire(const TransientResourceDesc& desc, uint64_t heapOffset, ResourceState& state) = 0;
+
+        // Record the state the resource is left in at the end of the frame.
+        virtual void Release(ResourceHandle resource, ResourceState state) = 0;
+
+    protected:
+        ~ITransientResourceAllocator() = default;
+    };
+
+    using RenderGraphResource = uint32_t;
+
+    class RenderGraph;
+
+    // Declares what a pass reads and writes while it is being added to the graph.
+    class RenderGraphBuilder
+    {
+    public:
+        void Read(RenderGraphResource resource, ResourceState state);
+        void Write(RenderGraphResource resource, ResourceState state);
+
+        // Keep the pass even if nothing reads its outputs.
+        void SetSideEffect() noexcept;
+
+    private:
+        friend class RenderGraph;
+
+        RenderGraphBuilder(RenderGraph& graph, size_t pass) noexcept : m_graph(graph), m_pass(pass) {}
+
+        RenderGraph&    m_graph;
+        size_t          m_pass;
+    };
+
+    // Passes are added in execution order each frame, then Compile culls the ones whose outputs are never
+    // used, places transient resources with disjoint lifetimes at overlapping heap offsets and computes the
+    // barriers each pass needs as a single batch. Execute records every pass into its own command context.
+    class RenderGraph
+    {
+    public:
+        using SetupFunction = std::function<void(RenderGraphBuilder& builder)>;
+        using ExecuteFunction = std::function<void(ICommandContext& context, const RenderGraph& graph)>;
+
+        static const RenderGraphResource c_InvalidResource = UINT32_MAX;
+
+        RenderGraph() = default;
+
+        RenderGraph(RenderGraph&&) = default;
+        RenderGraph& operator= (RenderGraph&&) = default;
+
+        RenderGraph(RenderGraph const&) = delete;
+        RenderGraph& operator= (RenderGraph const&) = delete;
+
+        // Clear all passes and resources, keeping allocations for the next frame.
+        void Reset() noexcept;
+
+        // An externally owned resource, e.g. the back buffer. Passes writing it are never culled, and
+        // it is transitioned to finalState once all passes have run.
+        RenderGraphResource ImportResource(const wchar_t* name, ResourceHandle resource,
+                                           ResourceState initialState, ResourceState finalState);
+
+        // A resource that only lives for part of the frame. The first pass writing it must fully
+        // overwrite it (clear, discard or copy), since its memory may have been used by another resource.
+        RenderGraphResource CreateTransient(const wchar_t* name, const TransientResourceDesc& desc);
+
+        // Names are expected to be string literals. Returns the pass index.
+        size_t AddPass(const wchar_t* name, const SetupFunction& setup, ExecuteFunction execute);
+
+        // The allocator may be null when no transient resources were created.
+        void Compile(ITransientResourceAllocator* allocator);
+
+        // Record the surviving passes in parallel and submit them in order, then record the final
+        // transitions of imported resources into sink.
+        void Execute(ParallelCommandRecorder& recorder, unsigned int frameIndex, ICommandSink& sink);
+
+        // Valid after Compile for resources used by at least one surviving pass.
+        ResourceHandle GetResource(RenderGraphResource resource) const;
+
+        // Inspection, valid after Compile.
+        size_t GetPassCount() const noexcept { return m_passes.size(); }
+        bool IsPassCulled(size_t pass) const { return m_passes.at(pass).culled; }
+        size_t GetCulledPassCount() const noexcept;
+        size_t GetBarrierCount() const noexcept { return m_barriers.size(); }
+        uint64_t GetTransientHeapSize() const noexcept { return m_heapSize; }
+        uint64_t GetTransientOffset(RenderGraphResource resource) const { return m_resources.at(resource).offset; }
+        bool IsTransientAliased(RenderGraphResource resource) const { return m_resources.at(resource).aliased; }
+
+    private:
+        friend class RenderGraphBuilder;
+
+        static const uint32_t c_NoPass = UINT32_MAX;
+
+        struct ResourceNode
+        {
+            const wchar_t*          name;
+            bool                    imported;
+            TransientResourceDesc   desc;
+            ResourceHandle          handle;
+            ResourceState           initialState;
+            ResourceState           finalState;
+
+            // Compile results. State is tracked on the node that owns the underlying resource.
+            RenderGraphResource     stateOwner;
+            ResourceState           state;
+            bool                    lastAccessWrote;
+            bool                    aliased;
+            uint32_t                firstPass;
+            uint32_t                lastPass;
+            uint64_t                size;
+            uint64_t                alignment;
+            uint64_t                offset;
+        };
+
+        struct ResourceAccess
+        {
+            RenderGraphResource     resource;
+            ResourceState           state;
+            bool                    write;
+        };
+
+        struct PassNode
+        {
+            const wchar_t*              name;
+            ExecuteFunction             execute;
+            std::vector<ResourceAccess> accesses;
+            bool                        sideEffect;
+            bool                        culled;
+            size_t                      firstBarrier;
+            size_t                      barrierCount;
+        };
+
+        void AddAccess(size_t pass, RenderGraphResource resource, ResourceState state, bool write);
+        void CullPasses();
+        void PlaceTransients(ITransientResourceAllocator* allocator);
+        void ComputeBarriers();
+
+        std::vector<ResourceNode>                           m_resources;
+        std::vector<PassNode>                               m_passes;
+        std::vector<ResourceBarrier>                        m_barriers;
+        size_t                                              m_firstFinalBarrier = 0;
+        uint64_t                                            m_heapSize = 0;
+        ITransientResourceAllocator*                        m_allocator = nullptr;
+        std::vector<ParallelCommandRecorder::RecordFunction> m_recordFunctions;
+    };
+}
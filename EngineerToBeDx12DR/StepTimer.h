@@ -4,42 +4,74 @@
 
 #pragma once
 
+#include "Clock.h"
+
+#include <algorithm>
 #include <cmath>
 #include <cstdint>
-#include <exception>
+#include <stdexcept>
 
 
 namespace DX
 {
     // Helper class for animation and simulation timing.
+    // Time is read from an IClock: the steady clock by default, or e.g. a ReplayClock for deterministic replays.
     class StepTimer
     {
     public:
-        StepTimer() noexcept(false) :
+        // The clock must outlive the timer; nullptr selects SteadyClock.
+        explicit StepTimer(IClock* clock = nullptr) noexcept(false) :
+            m_clock(nullptr),
+            m_clockFrequency(0),
+            m_clockLastTime(0),
+            m_clockMaxDelta(0),
+            m_rawElapsedTicks(0),
+            m_clampedDeltaCount(0),
+            m_lastDeltaClamped(false),
             m_elapsedTicks(0),
             m_totalTicks(0),
             m_leftOverTicks(0),
             m_frameCount(0),
             m_framesPerSecond(0),
             m_framesThisSecond(0),
-            m_qpcSecondCounter(0),
+            m_clockSecondCounter(0),
             m_isFixedTimeStep(false),
-            m_targetElapsedTicks(TicksPerSecond / 60)
+            m_targetElapsedTicks(TicksPerSecond / 60),
+            m_maxUpdatesPerTick(0),
+            m_droppedTicks(0),
+            m_isAdaptiveTimeStep(false),
+            m_maxTargetElapsedTicks(TicksPerSecond / 60),
+            m_currentTargetElapsedTicks(TicksPerSecond / 60),
+            m_averageTickDelta(0.0),
+            m_overloadedTicks(0),
+            m_recoveredTicks(0)
         {
-            if (!QueryPerformanceFrequency(&m_qpcFrequency))
-            {
-                throw std::exception();
-            }
+            SetClock(clock);
+        }
+
+        // Switch to another clock, nullptr for SteadyClock, and restart timing from its current time.
+        // The clock is read once here, so queue a ReplayClock's deltas afterwards to line them up with Tick.
+        void SetClock(IClock* clock)
+        {
+            IClock* newClock = clock ? clock : &SteadyClock::GetInstance();
 
-            if (!QueryPerformanceCounter(&m_qpcLastTime))
+            const uint64_t frequency = newClock->GetFrequency();
+            if (frequency == 0)
             {
-                throw std::exception();
+                throw std::out_of_range("Clock frequency must not be 0");
             }
 
+            m_clock = newClock;
+            m_clockFrequency = frequency;
+
             // Initialize max delta to 1/10 of a second.
-            m_qpcMaxDelta = static_cast<uint64_t>(m_qpcFrequency.QuadPart / 10);
+            m_clockMaxDelta = frequency / 10;
+
+            ResetElapsedTime();
         }
 
+        IClock* GetClock() const noexcept { return m_clock; }
+
         // Get elapsed time since the previous Update call.
         uint64_t GetElapsedTicks() const noexcept { return m_elapsedTicks; }
         double GetElapsedSeconds() const noexcept { return TicksToSeconds(m_elapsedTicks); }
@@ -48,6 +80,12 @@ namespace DX
         uint64_t GetTotalTicks() const noexcept { return m_totalTicks; }
         double GetTotalSeconds() const noexcept { return TicksToSeconds(m_totalTicks); }
 
+        // Get the unclamped time between the last two Tick calls, and whether it was clamped for the updates
+        // (by more than 1/10 of a second, e.g. a hitch or a debugger break). For frame time telemetry.
+        uint64_t GetRawElapsedTicks() const noexcept { return m_rawElapsedTicks; }
+        bool WasLastDeltaClamped() const noexcept { return m_lastDeltaClamped; }
+        uint64_t GetClampedDeltaCount() const noexcept { return m_clampedDeltaCount; }
+
         // Get total number of updates since start of the program.
         uint32_t GetFrameCount() const noexcept { return m_frameCount; }
 
@@ -57,9 +95,49 @@ namespace DX
         // Set whether to use fixed or variable timestep mode.
         void SetFixedTimeStep(bool isFixedTimestep) noexcept { m_isFixedTimeStep = isFixedTimestep; }
 
-        // Set how often to call Update when in fixed timestep mode.
-        void SetTargetElapsedTicks(uint64_t targetElapsed) noexcept { m_targetElapsedTicks = targetElapsed; }
-        void SetTargetElapsedSeconds(double targetElapsed) noexcept { m_targetElapsedTicks = SecondsToTicks(targetElapsed); }
+        // Set how often to call Update when in fixed timestep mode. Undoes any adaptive slowdown.
+        void SetTargetElapsedTicks(uint64_t targetElapsed) noexcept
+        {
+            m_targetElapsedTicks = targetElapsed;
+            m_currentTargetElapsedTicks = targetElapsed;
+            m_maxTargetElapsedTicks = std::max(m_maxTargetElapsedTicks, targetElapsed);
+            m_overloadedTicks = 0;
+            m_recoveredTicks = 0;
+        }
+        void SetTargetElapsedSeconds(double targetElapsed) noexcept { SetTargetElapsedTicks(SecondsToTicks(targetElapsed)); }
+
+        // Cap the updates a fixed timestep Tick may run to catch up, 0 for no cap. Time beyond the cap is
+        // dropped, so an Update slower than its timestep cannot snowball into ever longer frames.
+        void SetMaxUpdatesPerTick(uint32_t maxUpdates) noexcept { m_maxUpdatesPerTick = maxUpdates; }
+        uint32_t GetMaxUpdatesPerTick() const noexcept { return m_maxUpdatesPerTick; }
+
+        // Simulated time dropped by the cap.
+        uint64_t GetDroppedTicks() const noexcept { return m_droppedTicks; }
+
+        // With a cap set, lengthen the timestep by a quarter, up to maxTargetElapsed, whenever the average
+        // time between Ticks has needed more updates than the cap for c_OverloadedTicksBeforeSlowdown Ticks in
+        // a row, and shorten it back towards the target once it would have needed at most three quarters of the
+        // cap at the shorter step for c_CalmTicksBeforeSpeedup Ticks in a row. Update sees the current step through GetElapsedTicks.
+        void SetAdaptiveTimeStep(bool isAdaptive, uint64_t maxTargetElapsed) noexcept
+        {
+            m_isAdaptiveTimeStep = isAdaptive;
+            m_maxTargetElapsedTicks = std::max(maxTargetElapsed, m_targetElapsedTicks);
+            m_currentTargetElapsedTicks = m_targetElapsedTicks;
+            m_averageTickDelta = 0.0;
+            m_overloadedTicks = 0;
+            m_recoveredTicks = 0;
+        }
+        uint64_t GetCurrentTargetElapsedTicks() const noexcept { return m_currentTargetElapsedTicks; }
+
+        static const uint32_t c_OverloadedTicksBeforeSlowdown = 8;
+        static const uint32_t c_CalmTicksBeforeSpeedup = 240;
+
+        // How far the fixed timestep simulation is into its next step, from 0 up to 1, to render a blend of the
+        // last two updated states instead of updating again. Always 1 in variable timestep mode.
+        double GetInterpolationAlpha() const noexcept
+        {
+            return m_isFixedTimeStep ? double(m_leftOverTicks) / double(m_currentTargetElapsedTicks) : 1.0;
+        }
 
         // Integer format represents time using 10,000,000 ticks per second.
         static const uint64_t TicksPerSecond = 10000000;
@@ -73,15 +151,12 @@ namespace DX
 
         void ResetElapsedTime()
         {
-            if (!QueryPerformanceCounter(&m_qpcLastTime))
-            {
-                throw std::exception();
-            }
+            m_clockLastTime = m_clock->GetTime();
 
             m_leftOverTicks = 0;
             m_framesPerSecond = 0;
             m_framesThisSecond = 0;
-            m_qpcSecondCounter = 0;
+            m_clockSecondCounter = 0;
         }
 
         // Update timer state, calling the specified Update function the appropriate number of times.
@@ -89,27 +164,28 @@ namespace DX
         void Tick(const TUpdate& update)
         {
             // Query the current time.
-            LARGE_INTEGER currentTime;
+            const uint64_t currentTime = m_clock->GetTime();
 
-            if (!QueryPerformanceCounter(&currentTime))
-            {
-                throw std::exception();
-            }
+            uint64_t timeDelta = currentTime - m_clockLastTime;
 
-            uint64_t timeDelta = static_cast<uint64_t>(currentTime.QuadPart - m_qpcLastTime.QuadPart);
+            m_clockLastTime = currentTime;
+            m_clockSecondCounter += timeDelta;
 
-            m_qpcLastTime = currentTime;
-            m_qpcSecondCounter += timeDelta;
+            // Keep the real delta, split so the conversion cannot overflow.
+            m_rawElapsedTicks = (timeDelta / m_clockFrequency) * TicksPerSecond
+                + (timeDelta % m_clockFrequency) * TicksPerSecond / m_clockFrequency;
 
             // Clamp excessively large time deltas (e.g. after paused in the debugger).
-            if (timeDelta > m_qpcMaxDelta)
+            m_lastDeltaClamped = timeDelta > m_clockMaxDelta;
+            if (m_lastDeltaClamped)
             {
-                timeDelta = m_qpcMaxDelta;
+                timeDelta = m_clockMaxDelta;
+                m_clampedDeltaCount++;
             }
 
-            // Convert QPC units into a canonical tick format. This cannot overflow due to the previous clamp.
+            // Convert clock units into a canonical tick format. This cannot overflow due to the previous clamp.
             timeDelta *= TicksPerSecond;
-            timeDelta /= static_cast<uint64_t>(m_qpcFrequency.QuadPart);
+            timeDelta /= m_clockFrequency;
 
             uint32_t lastFrameCount = m_frameCount;
 
@@ -124,22 +200,39 @@ namespace DX
                 // accumulate enough tiny errors that it would drop a frame. It is better to just round
                 // small deviations down to zero to leave things running smoothly.
 
-                if (static_cast<uint64_t>(std::abs(static_cast<int64_t>(timeDelta - m_targetElapsedTicks))) < TicksPerSecond / 4000)
+                const uint64_t targetElapsedTicks = m_currentTargetElapsedTicks;
+                if (static_cast<uint64_t>(std::abs(static_cast<int64_t>(timeDelta - targetElapsedTicks))) < TicksPerSecond / 4000)
                 {
-                    timeDelta = m_targetElapsedTicks;
+                    timeDelta = targetElapsedTicks;
                 }
 
                 m_leftOverTicks += timeDelta;
 
-                while (m_leftOverTicks >= m_targetElapsedTicks)
+                uint32_t updateCount = 0;
+                while (m_leftOverTicks >= targetElapsedTicks)
                 {
-                    m_elapsedTicks = m_targetElapsedTicks;
-                    m_totalTicks += m_targetElapsedTicks;
-                    m_leftOverTicks -= m_targetElapsedTicks;
+                    if (m_maxUpdatesPerTick != 0 && updateCount == m_maxUpdatesPerTick)
+                    {
+                        // Drop whole steps of the backlog, keeping the phase of the next step.
+                        const uint64_t remainder = m_leftOverTicks % targetElapsedTicks;
+                        m_droppedTicks += m_leftOverTicks - remainder;
+                        m_leftOverTicks = remainder;
+                        break;
+                    }
+
+                    m_elapsedTicks = targetElapsedTicks;
+                    m_totalTicks += targetElapsedTicks;
+                    m_leftOverTicks -= targetElapsedTicks;
                     m_frameCount++;
+                    updateCount++;
 
                     update();
                 }
+
+                if (m_isAdaptiveTimeStep && m_maxUpdatesPerTick != 0)
+                {
+                    AdaptTimeStep(timeDelta);
+                }
             }
             else
             {
@@ -158,19 +251,50 @@ namespace DX
                 m_framesThisSecond++;
             }
 
-            if (m_qpcSecondCounter >= static_cast<uint64_t>(m_qpcFrequency.QuadPart))
+            if (m_clockSecondCounter >= m_clockFrequency)
             {
                 m_framesPerSecond = m_framesThisSecond;
                 m_framesThisSecond = 0;
-                m_qpcSecondCounter %= static_cast<uint64_t>(m_qpcFrequency.QuadPart);
+                m_clockSecondCounter %= m_clockFrequency;
             }
         }
 
     private:
-        // Source timing data uses QPC units.
-        LARGE_INTEGER m_qpcFrequency;
-        LARGE_INTEGER m_qpcLastTime;
-        uint64_t m_qpcMaxDelta;
+        void AdaptTimeStep(uint64_t timeDelta) noexcept
+        {
+            // Averaged over about 8 Ticks, so single hitches are left to the cap.
+            m_averageTickDelta = m_averageTickDelta == 0.0
+                ? double(timeDelta) : m_averageTickDelta + (double(timeDelta) - m_averageTickDelta) / 8.0;
+
+            const uint64_t shorterElapsedTicks = std::max(m_currentTargetElapsedTicks * 4 / 5, m_targetElapsedTicks);
+
+            m_overloadedTicks = m_averageTickDelta > double(m_currentTargetElapsedTicks * m_maxUpdatesPerTick)
+                ? m_overloadedTicks + 1 : 0;
+            m_recoveredTicks = shorterElapsedTicks < m_currentTargetElapsedTicks
+                && m_averageTickDelta <= double(shorterElapsedTicks * m_maxUpdatesPerTick) * 0.75 ? m_recoveredTicks + 1 : 0;
+
+            if (m_overloadedTicks >= c_OverloadedTicksBeforeSlowdown)
+            {
+                m_currentTargetElapsedTicks = std::min(m_currentTargetElapsedTicks * 5 / 4, m_maxTargetElapsedTicks);
+                m_overloadedTicks = 0;
+            }
+            else if (m_recoveredTicks >= c_CalmTicksBeforeSpeedup)
+            {
+                m_currentTargetElapsedTicks = shorterElapsedTicks;
+                m_recoveredTicks = 0;
+            }
+        }
+
+        // Source timing data uses clock units.
+        IClock* m_clock;
+        uint64_t m_clockFrequency;
+        uint64_t m_clockLastTime;
+        uint64_t m_clockMaxDelta;
+
+        // The last delta before clamping, in the canonical tick format.
+        uint64_t m_rawElapsedTicks;
+        uint64_t m_clampedDeltaCount;
+        bool m_lastDeltaClamped;
 
         // Derived timing data uses a canonical tick format.
         uint64_t m_elapsedTicks;
@@ -181,10 +305,20 @@ namespace DX
         uint32_t m_frameCount;
         uint32_t m_framesPerSecond;
         uint32_t m_framesThisSecond;
-        uint64_t m_qpcSecondCounter;
+        uint64_t m_clockSecondCounter;
 
         // Members for configuring fixed timestep mode.
         bool m_isFixedTimeStep;
         uint64_t m_targetElapsedTicks;
+        uint32_t m_maxUpdatesPerTick;
+        uint64_t m_droppedTicks;
+
+        // Members for the adaptive timestep, which runs at m_currentTargetElapsedTicks.
+        bool m_isAdaptiveTimeStep;
+        uint64_t m_maxTargetElapsedTicks;
+        uint64_t m_currentTargetElapsedTicks;
+        double m_averageTickDelta;
+        uint32_t m_overloadedTicks;
+        uint32_t m_recoveredTicks;
     };
 }
@@ -0,0 +1,64 @@
+//
+// StreamedImage.h - CPU-side texel data of a texture, from a decoder or a mapped cooked file
+//
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+
+
+namespace DX
+{
+    // DXGI_FORMAT values of the formats images are decoded or cooked to, for code that cannot include dxgiformat.h.
+    const uint32_t c_FormatR8G8B8A8Unorm = 28;
+    const uint32_t c_FormatBC1Unorm = 71;
+
+    // A full mip chain. Rows are rows of blocks: one texel high for uncompressed formats, four for BC.
+    struct StreamedImage
+    {
+        uint32_t                        width;
+        uint32_t                        height;
+        uint32_t                        mipLevels;
+        uint32_t                        format;         // DXGI_FORMAT
+        uint32_t                        blockSize;      // texels along a block edge, 1 for uncompressed formats
+        uint32_t                        bytesPerBlock;
+
+        // Every mip level in order, each as tightly packed rows. Keeps whatever it points into alive:
+        // a decoded buffer, or the mapping of a cooked file.
+        std::shared_ptr<const uint8_t>  texels;
+
+        uint32_t GetMipWidth(uint32_t mip) const noexcept { return std::max(width >> mip, 1u); }
+        uint32_t GetMipHeight(uint32_t mip) const noexcept { return std::max(height >> mip, 1u); }
+
+        uint32_t GetRowCount(uint32_t mip) const noexcept { return (GetMipHeight(mip) + blockSize - 1) / blockSize; }
+        uint64_t GetRowSize(uint32_t mip) const noexcept
+        {
+            return uint64_t((GetMipWidth(mip) + blockSize - 1) / blockSize) * bytesPerBlock;
+        }
+
+        uint64_t GetMipSize(uint32_t mip) const noexcept { return GetRowSize(mip) * GetRowCount(mip); }
+
+        // Offset of a mip level from texels; GetMipOffset(mipLevels) is the size of the whole chain.
+        uint64_t GetMipOffset(uint32_t mip) const noexcept
+        {
+            uint64_t offset = 0;
+            for (uint32_t level = 0; level < mip; level++)
+            {
+                offset += GetMipSize(level);
+            }
+            return offset;
+        }
+
+        const uint8_t* GetMipData(uint32_t mip) const noexcept { return texels.get() + GetMipOffset(mip); }
+    };
+
+    // Allocate texels for the whole chain described by the image's other fields and return them for writing.
+    inline uint8_t* AllocateTexels(StreamedImage& image)
+    {
+        std::shared_ptr<uint8_t> buffer(new uint8_t[image.GetMipOffset(image.mipLevels)], std::default_delete<uint8_t[]>());
+        image.texels = buffer;
+        return buffer.get();
+    }
+}
@@ -0,0 +1,220 @@
+//
+// TextureCooker.cpp - Builds mip chains and block-compressed texel data for cooked textures
+//
+
+#include "TextureCooker.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+using namespace DX;
+
+namespace
+{
+    inline uint16_t ToRGB565(const uint8_t* color) noexcept
+    {
+        return static_cast<uint16_t>(((color[0] >> 3) << 11) | ((color[1] >> 2) << 5) | (color[2] >> 3));
+    }
+
+    inline void FromRGB565(uint16_t packed, int* color) noexcept
+    {
+        const int r = (packed >> 11) & 0x1F;
+        const int g = (packed >> 5) & 0x3F;
+        const int b = packed & 0x1F;
+        color[0] = (r << 3) | (r >> 2);
+        color[1] = (g << 2) | (g >> 4);
+        color[2] = (b << 3) | (b >> 2);
+    }
+
+    bool IsOpaque(const StreamedImage& image) noexcept
+    {
+        const uint8_t* texels = image.texels.get();
+        const uint64_t count = uint64_t(image.width) * image.height;
+        for (uint64_t i = 0; i < count; i++)
+        {
+            if (texels[i * 4 + 3] != 0xFF)
+                return false;
+        }
+        return true;
+    }
+
+    // Each destination texel averages the 2x2 source texels it covers, clamped at odd edges.
+    void DownsampleRGBA8(const uint8_t* source, uint32_t sourceWidth, uint32_t sourceHeight,
+                         uint8_t* destination, uint32_t width, uint32_t height) noexcept
+    {
+        for (uint32_t y = 0; y < height; y++)
+        {
+            const uint32_t y0 = std::min(y * 2, sourceHeight - 1);
+            const uint32_t y1 = std::min(y * 2 + 1, sourceHeight - 1);
+            for (uint32_t x = 0; x < width; x++)
+            {
+                const uint32_t x0 = std::min(x * 2, sourceWidth - 1);
+                const uint32_t x1 = std::min(x * 2 + 1, sourceWidth - 1);
+                for (uint32_t channel = 0; channel < 4; channel++)
+                {
+                    const uint32_t sum = source[(size_t(y0) * sourceWidth + x0) * 4 + channel]
+                        + source[(size_t(y0) * sourceWidth + x1) * 4 + channel]
+                        + source[(size_t(y1) * sourceWidth + x0) * 4 + channel]
+                        + source[(size_t(y1) * sourceWidth + x1) * 4 + channel];
+                    destination[(size_t(y) * width + x) * 4 + channel] = static_cast<uint8_t>((sum + 2) / 4);
+                }
+            }
+        }
+    }
+
+    void CompressMipBC1(const uint8_t* source, uint32_t width, uint32_t height, uint8_t* destination) noexcept
+    {
+        uint8_t texels[16 * 4];
+        for (uint32_t blockY = 0; blockY < height; blockY += 4)
+        {
+            for (uint32_t blockX = 0; blockX < width; blockX += 4)
+            {
+                // Mips smaller than a block repeat their edge texels.
+                for (uint32_t y = 0; y < 4; y++)
+                {
+                    const uint32_t sourceY = std::min(blockY + y, height - 1);
+                    for (uint32_t x = 0; x < 4; x++)
+                    {
+                        const uint32_t sourceX = std::min(blockX + x, width - 1);
+                        std::memcpy(&texels[(y * 4 + x) * 4], &source[(size_t(sourceY) * width + sourceX) * 4], 4);
+                    }
+                }
+
+                CompressBlockBC1(texels, destination);
+                destination += 8;
+            }
+        }
+    }
+}
+
+StreamedImage DX::CookTexture(const StreamedImage& source, const TextureCookOptions& options)
+{
+    if (source.format != c_FormatR8G8B8A8Unorm || source.mipLevels != 1 || !source.texels)
+    {
+        throw std::invalid_argument("Only single-mip RGBA8 images can be cooked");
+    }
+
+    uint32_t mipLevels = 1;
+    if (options.generateMips)
+    {
+        while ((std::max(source.width, source.height) >> mipLevels) != 0)
+        {
+            mipLevels++;
+        }
+    }
+
+    StreamedImage chain = {};
+    chain.width = source.width;
+    chain.height = source.height;
+    chain.mipLevels = mipLevels;
+    chain.format = c_FormatR8G8B8A8Unorm;
+    chain.blockSize = 1;
+    chain.bytesPerBlock = 4;
+
+    uint8_t* texels = AllocateTexels(chain);
+    std::memcpy(texels, source.texels.get(), source.GetMipSize(0));
+    for (uint32_t mip = 1; mip < mipLevels; mip++)
+    {
+        DownsampleRGBA8(
+            texels + chain.GetMipOffset(mip - 1), chain.GetMipWidth(mip - 1), chain.GetMipHeight(mip - 1),
+            texels + chain.GetMipOffset(mip), chain.GetMipWidth(mip), chain.GetMipHeight(mip)
+        );
+    }
+
+    if (!options.compress || source.width % 4 != 0 || source.height % 4 != 0 || !IsOpaque(source))
+        return chain;
+
+    StreamedImage compressed = {};
+    compressed.width = source.width;
+    compressed.height = source.height;
+    compressed.mipLevels = mipLevels;
+    compressed.format = c_FormatBC1Unorm;
+    compressed.blockSize = 4;
+    compressed.bytesPerBlock = 8;
+
+    uint8_t* blocks = AllocateTexels(compressed);
+    for (uint32_t mip = 0; mip < mipLevels; mip++)
+    {
+        CompressMipBC1(chain.GetMipData(mip), chain.GetMipWidth(mip), chain.GetMipHeight(mip), blocks + compressed.GetMipOffset(mip));
+    }
+
+    return compressed;
+}
+
+// Endpoints span the bounding box of the block's colors, inset by 1/16 to reduce the error at the ends,
+// and every texel takes the nearest of the four palette entries.
+void DX::CompressBlockBC1(const uint8_t* texels, uint8_t* block) noexcept
+{
+    uint8_t minColor[3] = { 255, 255, 255 };
+    uint8_t maxColor[3] = { 0, 0, 0 };
+    for (uint32_t i = 0; i < 16; i++)
+    {
+        for (uint32_t channel = 0; channel < 3; channel++)
+        {
+            minColor[channel] = std::min(minColor[channel], texels[i * 4 + channel]);
+            maxColor[channel] = std::max(maxColor[channel], texels[i * 4 + channel]);
+        }
+    }
+
+    for (uint32_t channel = 0; channel < 3; channel++)
+    {
+        const uint8_t inset = static_cast<uint8_t>((maxColor[channel] - minColor[channel]) >> 4);
+        minColor[channel] = static_cast<uint8_t>(minColor[channel] + inset);
+        maxColor[channel] = static_cast<uint8_t>(maxColor[channel] - inset);
+    }
+
+    uint16_t color0 = ToRGB565(maxColor);
+    uint16_t color1 = ToRGB565(minColor);
+    uint32_t indices = 0;
+
+    // color0 > color1 selects the four-color mode; equal endpoints leave every index at 0.
+    if (color0 < color1)
+    {
+        std::swap(color0, color1);
+    }
+
+    if (color0 != color1)
+    {
+        int palette[4][3];
+        FromRGB565(color0, palette[0]);
+        FromRGB565(color1, palette[1]);
+        for (uint32_t channel = 0; channel < 3; channel++)
+        {
+            palette[2][channel] = (2 * palette[0][channel] + palette[1][channel]) / 3;
+            palette[3][channel] = (palette[0][channel] + 2 * palette[1][channel]) / 3;
+        }
+
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            uint32_t best = 0;
+            int bestDistance = INT32_MAX;
+            for (uint32_t entry = 0; entry < 4; entry++)
+            {
+                int distance = 0;
+                for (uint32_t channel = 0; channel < 3; channel++)
+                {
+                    const int delta = int(texels[i * 4 + channel]) - palette[entry][channel];
+                    distance += delta * delta;
+                }
+
+                if (distance < bestDistance)
+                {
+                    best = entry;
+                    bestDistance = distance;
+                }
+            }
+
+            indices |= best << (i * 2);
+        }
+    }
+
+    block[0] = static_cast<uint8_t>(color0);
+    block[1] = static_cast<uint8_t>(color0 >> 8);
+    block[2] = static_cast<uint8_t>(color1);
+    block[3] = static_cast<uint8_t>(color1 >> 8);
+    block[4] = static_cast<uint8_t>(indices);
+    block[5] = static_cast<uint8_t>(indices >> 8);
+    block[6] = static_cast<uint8_t>(indices >> 16);
+    block[7] = static_cast<uint8_t>(indices >> 24);
+}
@@ -0,0 +1,26 @@
+//
+// TextureCooker.h - Builds mip chains and block-compressed texel data for cooked textures
+//
+
+#pragma once
+
+#include "StreamedImage.h"
+
+
+namespace DX
+{
+    struct TextureCookOptions
+    {
+        bool    generateMips = true;
+
+        // BC1 at 4 bits per texel. Only applied to opaque images whose size is a multiple of 4,
+        // which D3D12 requires of block-compressed textures; anything else stays RGBA8.
+        bool    compress = false;
+    };
+
+    // Cook a single-mip RGBA8 image, e.g. one decoded from a JPEG. Mips are box filtered.
+    StreamedImage CookTexture(const StreamedImage& source, const TextureCookOptions& options);
+
+    // Encode one 4x4 block of RGBA8 texels, row by row, into 8 bytes of opaque BC1.
+    void CompressBlockBC1(const uint8_t* texels, uint8_t* block) noexcept;
+}
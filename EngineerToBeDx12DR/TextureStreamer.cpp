@@ -0,0 +1,446 @@
+//
+// TextureStreamer.cpp - Asynchronous texture loading with worker decode, upload ring staging and a memory budget
+//
+
+#include "TextureStreamer.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <stdexcept>
+
+using namespace DX;
+
+namespace
+{
+    const uint64_t c_DefaultMemoryBudget = 256ull * 1024 * 1024;
+    const uint64_t c_DefaultUploadBytesPerFrame = 4ull * 1024 * 1024;
+    const uint32_t c_DefaultMaxPendingDecodes = 4;
+
+    inline uint64_t AlignUp(uint64_t value, uint64_t alignment) noexcept
+    {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+}
+
+// Constructor for TextureStreamer.
+TextureStreamer::TextureStreamer(ITextureStreamingBackend* backend, JobSystem* jobSystem, UploadRing* uploadRing,
+                                 uint32_t maxTextures) noexcept(false) :
+    m_backend(backend),
+    m_jobSystem(jobSystem),
+    m_uploadRing(uploadRing),
+    m_maxTextures(maxTextures),
+    m_nextSequence(0),
+    m_pendingDecodes(0),
+    m_memoryBudget(c_DefaultMemoryBudget),
+    m_uploadBytesPerFrame(c_DefaultUploadBytesPerFrame),
+    m_maxPendingDecodes(c_DefaultMaxPendingDecodes),
+    m_residentBytes(0),
+    m_uploadedBytes(0),
+    m_evictionCount(0),
+    m_requeueCount(0)
+{
+    if (!backend || !jobSystem || !uploadRing)
+    {
+        throw std::invalid_argument("TextureStreamer requires a backend, a job system and an upload ring");
+    }
+
+    m_textures.reserve(maxTextures);
+}
+
+// Destructor for TextureStreamer. The GPU must have finished with every texture.
+TextureStreamer::~TextureStreamer()
+{
+    for (auto& texture : m_textures)
+    {
+        try
+        {
+            m_jobSystem->Wait(texture.decodeJob);
+        }
+        catch (...)
+        {
+        }
+
+        if (texture.resource)
+        {
+            m_backend->ReleaseTexture(texture.resource);
+        }
+    }
+
+    for (auto& release : m_pendingReleases)
+    {
+        m_backend->ReleaseTexture(release.resource);
+    }
+}
+
+TextureStreamer::TextureId TextureStreamer::Request(const std::wstring& path, int priority)
+{
+    for (TextureId id = 0; id < m_textures.size(); id++)
+    {
+        auto& texture = m_textures[id];
+        if (texture.path != path)
+            continue;
+
+        if (priority > texture.priority)
+        {
+            SetPriority(id, priority);
+        }
+
+        if (texture.state == StreamedTextureState::Evicted || texture.state == StreamedTextureState::Failed)
+        {
+            texture.state = StreamedTextureState::Queued;
+            Enqueue(id);
+        }
+
+        return id;
+    }
+
+    if (m_textures.size() >= m_maxTextures)
+    {
+        throw std::out_of_range("Too many streamed textures");
+    }
+
+    Texture texture = {};
+    texture.path = path;
+    texture.priority = priority;
+    texture.sequence = m_nextSequence++;
+    texture.state = StreamedTextureState::Queued;
+    m_textures.push_back(std::move(texture));
+
+    const auto id = static_cast<TextureId>(m_textures.size() - 1);
+    Enqueue(id);
+    return id;
+}
+
+void TextureStreamer::SetPriority(TextureId texture, int priority)
+{
+    auto& entry = m_textures.at(texture);
+    if (entry.priority == priority)
+        return;
+
+    entry.priority = priority;
+
+    // The old queue entry no longer matches and will be skipped.
+    if (entry.state == StreamedTextureState::Queued)
+    {
+        Enqueue(texture);
+    }
+}
+
+uint32_t TextureStreamer::GetDescriptorSlot(TextureId texture) const
+{
+    return IsResident(texture) ? texture + 1 : c_PlaceholderSlot;
+}
+
+void TextureStreamer::Update(uint64_t completedFenceValue, uint64_t currentFenceValue)
+{
+    auto retired = std::remove_if(m_pendingReleases.begin(), m_pendingReleases.end(),
+        [&](const PendingRelease& release)
+        {
+            if (release.fenceValue > completedFenceValue)
+                return false;
+
+            m_backend->ReleaseTexture(release.resource);
+            return true;
+        });
+    m_pendingReleases.erase(retired, m_pendingReleases.end());
+
+    // Honor a lowered budget before anything new is made resident.
+    MakeRoom(0, INT_MAX, currentFenceValue);
+
+    CollectDecodes();
+    StartDecodes(completedFenceValue);
+    StartUploads(currentFenceValue);
+}
+
+void TextureStreamer::Enqueue(TextureId texture)
+{
+    const auto& entry = m_textures[texture];
+    m_decodeQueue.push({ entry.priority, entry.sequence, texture });
+}
+
+void TextureStreamer::CollectDecodes()
+{
+    for (auto& texture : m_textures)
+    {
+        if (texture.state != StreamedTextureState::Decoding || !texture.decodeJob->IsComplete())
+            continue;
+
+        auto job = std::move(texture.decodeJob);
+        try
+        {
+            m_jobSystem->Wait(job);
+            texture.state = StreamedTextureState::Decoded;
+        }
+        catch (const std::exception&)
+        {
+            Fail(texture);
+        }
+    }
+}
+
+void TextureStreamer::StartDecodes(uint64_t completedFenceValue)
+{
+    std::vector<QueueEntry> deferred;
+
+    while (!m_decodeQueue.empty())
+    {
+        const auto entry = m_decodeQueue.top();
+        auto& texture = m_textures[entry.texture];
+        if (texture.state != StreamedTextureState::Queued || texture.priority != entry.priority)
+        {
+            m_decodeQueue.pop();
+            continue;
+        }
+
+        // A reloaded texture publishes to the same slot, which frames in flight may still read.
+        if (texture.releaseFence > completedFenceValue)
+        {
+            m_decodeQueue.pop();
+            deferred.push_back(entry);
+            continue;
+        }
+
+        // Images parked for lack of memory would otherwise hold every slot against higher priorities.
+        if (m_pendingDecodes >= m_maxPendingDecodes && !RequeueDecoded(entry.priority))
+            break;
+
+        m_decodeQueue.pop();
+        texture.state = StreamedTextureState::Decoding;
+        m_pendingDecodes++;
+
+        auto backend = m_backend;
+        auto image = &texture.image;
+        texture.decodeJob = m_jobSystem->Schedule(
+            [backend, image, path = texture.path]()
+            {
+                backend->Decode(path, *image);
+            });
+    }
+
+    for (auto& entry : deferred)
+    {
+        m_decodeQueue.push(entry);
+    }
+}
+
+void TextureStreamer::StartUploads(uint64_t currentFenceValue)
+{
+    m_uploadOrder.clear();
+    for (TextureId id = 0; id < m_textures.size(); id++)
+    {
+        const auto state = m_textures[id].state;
+        if (state == StreamedTextureState::Decoded || state == StreamedTextureState::Uploading)
+        {
+            m_uploadOrder.push_back(id);
+        }
+    }
+
+    std::sort(m_uploadOrder.begin(), m_uploadOrder.end(),
+        [this](TextureId a, TextureId b)
+        {
+            const auto& ta = m_textures[a];
+            const auto& tb = m_textures[b];
+            return ta.priority != tb.priority ? ta.priority > tb.priority : ta.sequence < tb.sequence;
+        });
+
+    uint64_t uploadBudget = m_uploadBytesPerFrame;
+    for (const auto id : m_uploadOrder)
+    {
+        auto& texture = m_textures[id];
+        if (texture.state == StreamedTextureState::Decoded)
+        {
+            const uint64_t pitch = AlignUp(texture.image.GetRowSize(0), c_StagingPitchAlignment);
+            texture.size = m_backend->GetTextureSize(texture.image);
+            if (texture.size > m_memoryBudget || pitch > m_uploadRing->GetCapacity())
+            {
+                // Could never become resident.
+                Fail(texture);
+                continue;
+            }
+
+            // Lower priority textures may still fit in what is left.
+            if (!MakeRoom(texture.size, texture.priority, currentFenceValue))
+                continue;
+
+            texture.resource = m_backend->CreateTexture(texture.image);
+            texture.nextMip = 0;
+            texture.nextRow = 0;
+            texture.state = StreamedTextureState::Uploading;
+            m_residentBytes += texture.size;
+        }
+
+        if (!UploadRows(texture, uploadBudget))
+            break;
+
+        if (texture.nextMip == texture.image.mipLevels)
+        {
+            m_backend->FinishUpload(texture.resource);
+            m_backend->Publish(id + 1, texture.resource);
+            texture.state = StreamedTextureState::Resident;
+            texture.image.texels.reset();
+            m_pendingDecodes--;
+        }
+    }
+}
+
+// Drop the decoded image of the lowest priority texture below priority that has not started uploading,
+// most recently requested among equals, and queue it again. Returns false if there is none.
+bool TextureStreamer::RequeueDecoded(int priority)
+{
+    Texture* victim = nullptr;
+    TextureId victimId = 0;
+    for (TextureId id = 0; id < m_textures.size(); id++)
+    {
+        auto& texture = m_textures[id];
+        if (texture.state != StreamedTextureState::Decoded || texture.priority >= priority)
+            continue;
+
+        if (!victim || texture.priority < victim->priority
+            || (texture.priority == victim->priority && texture.sequence > victim->sequence))
+        {
+            victim = &texture;
+            victimId = id;
+        }
+    }
+
+    if (!victim)
+        return false;
+
+    victim->image.texels.reset();
+    victim->state = StreamedTextureState::Queued;
+    m_pendingDecodes--;
+    m_requeueCount++;
+    Enqueue(victimId);
+    return true;
+}
+
+// Evict resident textures of lower priority, lowest first, until size more bytes fit in the budget.
+// Evicts nothing if that would not be enough.
+bool TextureStreamer::MakeRoom(uint64_t size, int priority, uint64_t currentFenceValue)
+{
+    if (m_residentBytes + size <= m_memoryBudget)
+        return true;
+
+    uint64_t evictable = 0;
+    for (const auto& texture : m_textures)
+    {
+        if (texture.state == StreamedTextureState::Resident && texture.priority < priority)
+        {
+            evictable += texture.size;
+        }
+    }
+
+    if (m_residentBytes - evictable + size > m_memoryBudget)
+        return false;
+
+    while (m_residentBytes + size > m_memoryBudget)
+    {
+        // Lowest priority first, most recently requested among equals.
+        TextureId victim = 0;
+        bool found = false;
+        for (TextureId id = 0; id < m_textures.size(); id++)
+        {
+            const auto& texture = m_textures[id];
+            if (texture.state != StreamedTextureState::Resident || texture.priority >= priority)
+                continue;
+
+            if (!found || texture.priority < m_textures[victim].priority
+                || (texture.priority == m_textures[victim].priority && texture.sequence > m_textures[victim].sequence))
+            {
+                victim = id;
+                found = true;
+            }
+        }
+
+        Evict(victim, currentFenceValue);
+    }
+
+    return true;
+}
+
+// The descriptor slot stays untouched: the frame being recorded already uses the placeholder, and the
+// resource is kept until the frames recorded before it have completed.
+void TextureStreamer::Evict(TextureId texture, uint64_t currentFenceValue)
+{
+    auto& entry = m_textures[texture];
+    m_pendingReleases.push_back({ entry.resource, currentFenceValue });
+    m_residentBytes -= entry.size;
+
+    entry.resource = 0;
+    entry.releaseFence = currentFenceValue;
+    entry.state = StreamedTextureState::Evicted;
+    m_evictionCount++;
+}
+
+void TextureStreamer::Fail(Texture& texture) noexcept
+{
+    texture.image.texels.reset();
+    texture.state = StreamedTextureState::Failed;
+    m_pendingDecodes--;
+}
+
+// Copy as many rows as the frame's upload budget and the upload ring allow, mip by mip. Returns false once
+// either is exhausted, so lower priority textures do not take bandwidth from a partially uploaded one.
+bool TextureStreamer::UploadRows(Texture& texture, uint64_t& uploadBudget)
+{
+    const auto& image = texture.image;
+    const uint64_t ringCapacity = m_uploadRing->GetCapacity();
+
+    for (; texture.nextMip < image.mipLevels; texture.nextMip++, texture.nextRow = 0)
+    {
+        const uint32_t mip = texture.nextMip;
+        const uint32_t rowCount = image.GetRowCount(mip);
+        const uint64_t rowSize = image.GetRowSize(mip);
+        const uint64_t pitch = AlignUp(rowSize, c_StagingPitchAlignment);
+        const uint8_t* mipData = image.GetMipData(mip);
+
+        while (texture.nextRow < rowCount)
+        {
+            // Always make some progress, even if a single row is larger than the per-frame budget.
+            uint64_t rows = uploadBudget / pitch;
+            if (rows == 0 && uploadBudget == m_uploadBytesPerFrame)
+            {
+                rows = 1;
+            }
+
+            rows = std::min<uint64_t>({ rows, rowCount - texture.nextRow, ringCapacity / pitch });
+            if (rows == 0)
+                return false;
+
+            // Other uploads share the ring, so take what is left rather than waiting for the whole range.
+            auto staging = m_uploadRing->TryAllocate(rows * pitch, c_StagingPlacementAlignment);
+            while (!staging && rows > 1)
+            {
+                rows /= 2;
+                staging = m_uploadRing->TryAllocate(rows * pitch, c_StagingPlacementAlignment);
+            }
+
+            if (!staging)
+                return false;
+
+            // A single copy when the rows are already pitch aligned, e.g. wide mips of a cooked texture.
+            const uint8_t* source = mipData + texture.nextRow * rowSize;
+            if (rowSize == pitch)
+            {
+                std::memcpy(staging.cpuAddress, source, rows * pitch);
+            }
+            else
+            {
+                for (uint64_t row = 0; row < rows; row++)
+                {
+                    std::memcpy(staging.cpuAddress + row * pitch, source + row * rowSize, rowSize);
+                }
+            }
+
+            m_backend->CopyRows(texture.resource, image, mip, texture.nextRow, static_cast<uint32_t>(rows), staging.offset,
+                                static_cast<uint32_t>(pitch));
+
+            texture.nextRow += static_cast<uint32_t>(rows);
+            uploadBudget -= std::min(uploadBudget, rows * pitch);
+            m_uploadedBytes += rows * pitch;
+        }
+    }
+
+    return true;
+}
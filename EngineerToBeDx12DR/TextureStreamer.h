@@ -0,0 +1,190 @@
+//
+// TextureStreamer.h - Asynchronous texture loading with worker decode, upload ring staging and a memory budget
+//
+
+#pragma once
+
+#include "JobSystem.h"
+#include "RenderBackend.h"
+#include "StreamedImage.h"
+#include "UploadRing.h"
+
+#include <queue>
+#include <string>
+#include <vector>
+
+
+namespace DX
+{
+    // Graphics side of the streamer. Decode runs on job system workers; everything else is called from the
+    // thread that records the frame, between Prepare and Present.
+    class ITextureStreamingBackend
+    {
+    public:
+        // Load the file, decoding or mapping it, and throw on failure.
+        virtual void Decode(const std::wstring& path, StreamedImage& image) = 0;
+
+        // Memory a texture for the image would occupy, used to enforce the budget before creating it.
+        virtual uint64_t GetTextureSize(const StreamedImage& image) = 0;
+
+        // Create a texture with all of the image's mip levels in the CopyDest state.
+        virtual ResourceHandle CreateTexture(const StreamedImage& image) = 0;
+
+        // Destroy a texture created by CreateTexture. The GPU has finished with it.
+        virtual void ReleaseTexture(ResourceHandle texture) = 0;
+
+        // Record a copy of rowCount block rows of a mip level, starting at firstRow, from the upload ring's buffer at stagingOffset.
+        virtual void CopyRows(ResourceHandle texture, const StreamedImage& image, uint32_t mip, uint32_t firstRow,
+                              uint32_t rowCount, uint64_t stagingOffset, uint32_t stagingPitch) = 0;
+
+        // Record the transition that makes a fully copied texture readable by shaders.
+        virtual void FinishUpload(ResourceHandle texture) = 0;
+
+        // Point the descriptor at slot to the texture. Slot 0 is the placeholder and is never published.
+        virtual void Publish(uint32_t slot, ResourceHandle texture) = 0;
+
+    protected:
+        ~ITextureStreamingBackend() = default;
+    };
+
+    enum class StreamedTextureState : uint32_t
+    {
+        Queued,         // waiting for a decode slot
+        Decoding,
+        Decoded,        // waiting for memory budget or upload bandwidth; queued again for a higher priority decode
+        Uploading,
+        Resident,
+        Evicted,        // dropped for a higher priority texture; request it again to reload
+        Failed,
+    };
+
+    // Textures are requested by path and decoded on the job system, highest priority first. Update then
+    // copies the decoded mip chain through the frame's upload ring, a bounded number of bytes per frame, and
+    // publishes a texture's descriptor once its upload has been recorded. Until then GetDescriptorSlot
+    // returns the placeholder slot, so rendering never waits on a load.
+    class TextureStreamer
+    {
+    public:
+        using TextureId = uint32_t;
+
+        static const uint32_t c_PlaceholderSlot = 0;
+
+        // D3D12 copy footprint requirements, which the null backend follows as well.
+        static const uint32_t c_StagingPitchAlignment = 256;
+        static const uint32_t c_StagingPlacementAlignment = 512;
+
+        // The backend and upload ring must outlive the streamer. Descriptor slots 1 to maxTextures are used for textures.
+        TextureStreamer(ITextureStreamingBackend* backend, JobSystem* jobSystem, UploadRing* uploadRing,
+                        uint32_t maxTextures) noexcept(false);
+        ~TextureStreamer();
+
+        TextureStreamer(TextureStreamer&&) = delete;
+        TextureStreamer& operator= (TextureStreamer&&) = delete;
+
+        TextureStreamer(TextureStreamer const&) = delete;
+        TextureStreamer& operator= (TextureStreamer const&) = delete;
+
+        // Returns the texture already registered for path, if any, raising its priority if needed.
+        // Higher priorities decode, upload and stay resident first. Evicted and failed textures are queued again.
+        TextureId Request(const std::wstring& path, int priority = 0);
+
+        void SetPriority(TextureId texture, int priority);
+
+        // Call once per frame while the frame's command list is open. Evicted textures are released once
+        // completedFenceValue reaches the currentFenceValue they were evicted in; staging memory is retired
+        // by the upload ring's owner.
+        void Update(uint64_t completedFenceValue, uint64_t currentFenceValue);
+
+        StreamedTextureState GetState(TextureId texture) const { return m_textures.at(texture).state; }
+        bool IsResident(TextureId texture) const { return GetState(texture) == StreamedTextureState::Resident; }
+
+        // The texture's descriptor slot once resident, otherwise c_PlaceholderSlot.
+        uint32_t GetDescriptorSlot(TextureId texture) const;
+
+        // Bytes of texture memory that may be resident at once. Lowering it evicts on the next Update.
+        void SetMemoryBudget(uint64_t bytes) noexcept { m_memoryBudget = bytes; }
+        uint64_t GetMemoryBudget() const noexcept { return m_memoryBudget; }
+
+        // Staging bytes copied per frame, to bound the cost of streaming on the frame time.
+        void SetUploadBytesPerFrame(uint64_t bytes) noexcept { m_uploadBytesPerFrame = bytes; }
+
+        // Decoded images held in CPU memory at once, including decodes in progress.
+        void SetMaxPendingDecodes(uint32_t count) noexcept { m_maxPendingDecodes = count; }
+
+        uint32_t GetTextureCount() const noexcept { return static_cast<uint32_t>(m_textures.size()); }
+        uint64_t GetResidentBytes() const noexcept { return m_residentBytes; }
+        uint64_t GetUploadedBytes() const noexcept { return m_uploadedBytes; }
+        uint32_t GetEvictionCount() const noexcept { return m_evictionCount; }
+
+        // Decoded images dropped to free a decode slot for a higher priority texture.
+        uint32_t GetRequeueCount() const noexcept { return m_requeueCount; }
+
+    private:
+        struct Texture
+        {
+            std::wstring            path;
+            int                     priority;
+            uint64_t                sequence;       // request order, breaks priority ties
+            StreamedTextureState    state;
+            JobHandle               decodeJob;
+            StreamedImage           image;
+            ResourceHandle          resource;
+            uint64_t                size;
+            uint32_t                nextMip;
+            uint32_t                nextRow;
+
+            // Fence value of the last frame that may still sample the texture after it was evicted.
+            uint64_t                releaseFence;
+        };
+
+        struct QueueEntry
+        {
+            int                     priority;
+            uint64_t                sequence;
+            TextureId               texture;
+
+            bool operator< (const QueueEntry& other) const noexcept
+            {
+                return priority != other.priority ? priority < other.priority : sequence > other.sequence;
+            }
+        };
+
+        struct PendingRelease
+        {
+            ResourceHandle          resource;
+            uint64_t                fenceValue;
+        };
+
+        void Enqueue(TextureId texture);
+        void CollectDecodes();
+        void StartDecodes(uint64_t completedFenceValue);
+        void StartUploads(uint64_t currentFenceValue);
+        bool RequeueDecoded(int priority);
+        bool MakeRoom(uint64_t size, int priority, uint64_t currentFenceValue);
+        void Evict(TextureId texture, uint64_t currentFenceValue);
+        void Fail(Texture& texture) noexcept;
+        bool UploadRows(Texture& texture, uint64_t& uploadBudget);
+
+        ITextureStreamingBackend*       m_backend;
+        JobSystem*                      m_jobSystem;
+        UploadRing*                     m_uploadRing;
+        uint32_t                        m_maxTextures;
+
+        // Reserved up front so decode jobs can hold pointers to their texture's image.
+        std::vector<Texture>            m_textures;
+        std::priority_queue<QueueEntry> m_decodeQueue;  // may hold stale entries, skipped when popped
+        std::vector<TextureId>          m_uploadOrder;  // scratch
+        std::vector<PendingRelease>     m_pendingReleases;
+        uint64_t                        m_nextSequence;
+        uint32_t                        m_pendingDecodes;
+
+        uint64_t                        m_memoryBudget;
+        uint64_t                        m_uploadBytesPerFrame;
+        uint32_t                        m_maxPendingDecodes;
+
+        uint64_t                        m_residentBytes;
+        uint64_t                        m_uploadedBytes;
+        uint32_t                        m_evictionCount;
+        uint32_t                        m_requeueCount;
+    };
+}
@@ -0,0 +1,94 @@
+//
+// UploadRing.cpp - Shared CPU-to-GPU upload memory, sub-allocated per frame and retired by fence
+//
+
+#include "UploadRing.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace DX;
+
+void UploadRing::Initialize(uint8_t* cpuBase, uint64_t gpuBase, uint64_t capacity)
+{
+    if (!cpuBase || capacity == 0)
+    {
+        throw std::invalid_argument("UploadRing requires mapped memory");
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_allocator = FenceRingAllocator(capacity);
+    m_cpuBase = cpuBase;
+    m_gpuBase = gpuBase;
+    m_peakUsedSize = 0;
+}
+
+void UploadRing::Reset() noexcept
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_allocator = FenceRingAllocator();
+    m_cpuBase = nullptr;
+    m_gpuBase = 0;
+}
+
+UploadAllocation UploadRing::TryAllocate(uint64_t size, uint64_t alignment)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    const uint64_t offset = m_allocator.Allocate(size, alignment);
+    if (offset == FenceRingAllocator::c_InvalidOffset)
+    {
+        m_failedAllocations++;
+        return { nullptr, 0, 0 };
+    }
+
+    m_peakUsedSize = std::max(m_peakUsedSize, m_allocator.GetUsedSize());
+    return { m_cpuBase + offset, m_gpuBase + offset, offset };
+}
+
+UploadAllocation UploadRing::Allocate(uint64_t size, uint64_t alignment)
+{
+    auto allocation = TryAllocate(size, alignment);
+    if (!allocation)
+    {
+        throw std::length_error("Upload ring is out of memory");
+    }
+
+    return allocation;
+}
+
+void UploadRing::Retire(uint64_t completedFenceValue)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_allocator.Retire(completedFenceValue);
+}
+
+void UploadRing::Finish(uint64_t fenceValue)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_allocator.Finish(fenceValue);
+}
+
+uint64_t UploadRing::GetCapacity() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_allocator.GetCapacity();
+}
+
+uint64_t UploadRing::GetUsedSize() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_allocator.GetUsedSize();
+}
+
+uint64_t UploadRing::GetPeakUsedSize() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_peakUsedSize;
+}
+
+uint64_t UploadRing::GetFailedAllocationCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_failedAllocations;
+}
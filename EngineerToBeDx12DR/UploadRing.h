@@ -0,0 +1,68 @@
+//
+// UploadRing.h - Shared CPU-to-GPU upload memory, sub-allocated per frame and retired by fence
+//
+
+#pragma once
+
+#include "FenceRingAllocator.h"
+
+#include <mutex>
+
+
+namespace DX
+{
+    struct UploadAllocation
+    {
+        uint8_t*    cpuAddress;     // null if the allocation failed
+        uint64_t    gpuAddress;
+        uint64_t    offset;         // from the start of the ring's buffer
+
+        explicit operator bool() const noexcept { return cpuAddress != nullptr; }
+    };
+
+    // One persistently mapped upload buffer that every transient upload of a frame is carved from: texture
+    // staging, UI geometry and the like. The owner of the frame loop retires completed frames before
+    // recording and tags the frame's allocations with its fence value once it is submitted, so memory is
+    // reused as soon as the GPU is done with it, with no per-upload buffers or maps. Allocation is
+    // thread-safe, since command contexts are recorded in parallel.
+    class UploadRing
+    {
+    public:
+        UploadRing() noexcept : m_cpuBase(nullptr), m_gpuBase(0), m_failedAllocations(0), m_peakUsedSize(0) {}
+
+        UploadRing(UploadRing&&) = delete;
+        UploadRing& operator= (UploadRing&&) = delete;
+
+        UploadRing(UploadRing const&) = delete;
+        UploadRing& operator= (UploadRing const&) = delete;
+
+        // The memory must stay mapped until Reset. Any previous allocations are forgotten.
+        void Initialize(uint8_t* cpuBase, uint64_t gpuBase, uint64_t capacity);
+
+        // Forget the memory and all allocations, e.g. when the device is lost.
+        void Reset() noexcept;
+
+        // Returns a null allocation if the ring is full until more frames complete.
+        UploadAllocation TryAllocate(uint64_t size, uint64_t alignment);
+
+        // Throws std::length_error if the ring is full.
+        UploadAllocation Allocate(uint64_t size, uint64_t alignment);
+
+        // Called by the frame loop: before recording with the GPU's progress, after submitting with the frame's fence value.
+        void Retire(uint64_t completedFenceValue);
+        void Finish(uint64_t fenceValue);
+
+        uint64_t GetCapacity() const;
+        uint64_t GetUsedSize() const;
+        uint64_t GetPeakUsedSize() const;
+        uint64_t GetFailedAllocationCount() const;
+
+    private:
+        mutable std::mutex      m_mutex;
+        FenceRingAllocator      m_allocator;
+        uint8_t*                m_cpuBase;
+        uint64_t                m_gpuBase;
+        uint64_t                m_failedAllocations;
+        uint64_t                m_peakUsedSize;
+    };
+}
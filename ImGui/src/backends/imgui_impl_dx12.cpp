@@ -6,6 +6,8 @@
 //  [X] Renderer: Multi-viewport support. Enable with 'io.ConfigFlags |= ImGuiConfigFlags_ViewportsEnable'.
 //      FIXME: The transition from removing a viewport and moving the window in an existing hosted viewport tends to flicker.
 //  [X] Renderer: Support for large meshes (64k+ vertices) with 16-bit indices.
+//  [X] Renderer: Support for 32-bit indices ('#define ImDrawIdx unsigned int' in imconfig.h), which avoids splitting large meshes into 64k vertex draw calls.
+//  [X] Renderer: Uploads font atlas regions changed by glyphs rasterized on demand (ImFontConfig::DynamicGlyphs).
 
 // Important: to compile on 32-bit systems, this backend requires code to be compiled with '#define ImTextureID ImU64'.
 // This is because we need ImTextureID to carry a 64-bit value and by default ImTextureID is defined as void*.
@@ -23,6 +25,11 @@
 // CHANGELOG
 // (minor and older changes stripped away, please see git history for details)
 //  2021-XX-XX: Platform: Added support for multiple windows via the ImGuiPlatformIO interface.
+//  2021-XX-XX: DirectX12: Upload the regions of the font texture listed in ImFontAtlas::TexDirtyRects, for glyphs rasterized on demand.
+//  2021-XX-XX: DirectX12: Moved the stream placement to imgui_impl_dx12_stream.cpp, which builds without Direct3D and takes its chunks from a callback.
+//  2021-XX-XX: DirectX12: Stream vertex/index data into persistently mapped buffers that grow by adding chunks, instead of recreating and mapping them.
+//  2021-XX-XX: DirectX12: Added ImGui_ImplDX12_RenderDrawDataRetained() to draw unchanged draw data again without uploading it.
+//  2021-XX-XX: DirectX12: Added ImGui_ImplDX12_SetUploadAllocator() to source main viewport vertex/index data from application upload memory.
 //  2021-06-29: Reorganized backend to pull data from a single structure to facilitate usage with multiple-contexts (all g_XXXX access changed to bd->XXXX).
 //  2021-05-19: DirectX12: Replaced direct access to ImDrawCmd::TextureId with a call to ImDrawCmd::GetTexID(). (will become a requirement)
 //  2021-02-18: DirectX12: Change blending equation to preserve alpha in output buffer.
@@ -42,6 +49,7 @@
 
 #include "imgui.h"
 #include "imgui_impl_dx12.h"
+#include "imgui_impl_dx12_stream.h"
 
 // DirectX
 #include <d3d12.h>
@@ -63,6 +71,8 @@ struct ImGui_ImplDX12_Data
     D3D12_GPU_DESCRIPTOR_HANDLE hFontSrvGpuDescHandle;
     ID3D12DescriptorHeap*       pd3dSrvDescHeap;
     UINT                        numFramesInFlight;
+    ImGui_ImplDX12_UploadAllocator UploadAllocator;
+    void*                       UploadAllocatorUserData;
 
     ImGui_ImplDX12_Data()       { memset(this, 0, sizeof(*this)); }
 };
@@ -77,10 +87,12 @@ static ImGui_ImplDX12_Data* ImGui_ImplDX12_GetBackendData()
 // Buffers used during the rendering of a frame
 struct ImGui_ImplDX12_RenderBuffers
 {
-    ID3D12Resource*     IndexBuffer;
-    ID3D12Resource*     VertexBuffer;
-    int                 IndexBufferSize;
-    int                 VertexBufferSize;
+    ImGui_ImplDX12_BufferStream Vertices;
+    ImGui_ImplDX12_BufferStream Indices;
+    ImGui_ImplDX12_BufferStream Texels;     // Font texture regions, see ImGui_ImplDX12_UploadFontsTextureRects()
+
+    // Segments bound for the current frame, into the streams above or into memory from the upload allocator
+    ImVector<ImGui_ImplDX12_RenderSegment> Segments;
 };
 
 // Buffers used for secondary viewports created by the multi-viewports systems
@@ -129,12 +141,6 @@ struct ImGui_ImplDX12_ViewportData
         {
             FrameCtx[i].CommandAllocator = NULL;
             FrameCtx[i].RenderTarget = NULL;
-
-            // Create buffers with a default size (they will later be grown as needed)
-            FrameRenderBuffers[i].IndexBuffer = NULL;
-            FrameRenderBuffers[i].VertexBuffer = NULL;
-            FrameRenderBuffers[i].VertexBufferSize = 5000;
-            FrameRenderBuffers[i].IndexBufferSize = 10000;
         }
     }
     ~ImGui_ImplDX12_ViewportData()
@@ -148,7 +154,7 @@ struct ImGui_ImplDX12_ViewportData
         for (UINT i = 0; i < NumFramesInFlight; ++i)
         {
             IM_ASSERT(FrameCtx[i].CommandAllocator == NULL && FrameCtx[i].RenderTarget == NULL);
-            IM_ASSERT(FrameRenderBuffers[i].IndexBuffer == NULL && FrameRenderBuffers[i].VertexBuffer == NULL);
+            IM_ASSERT(FrameRenderBuffers[i].Indices.Chunks.Size == 0 && FrameRenderBuffers[i].Vertices.Chunks.Size == 0);
         }
 
         delete[] FrameCtx; FrameCtx = NULL;
@@ -166,7 +172,7 @@ static void ImGui_ImplDX12_InitPlatformInterface();
 static void ImGui_ImplDX12_ShutdownPlatformInterface();
 
 // Functions
-static void ImGui_ImplDX12_SetupRenderState(ImDrawData* draw_data, ID3D12GraphicsCommandList* ctx, ImGui_ImplDX12_RenderBuffers* fr)
+static void ImGui_ImplDX12_SetupRenderState(ImDrawData* draw_data, ID3D12GraphicsCommandList* ctx, const ImGui_ImplDX12_RenderSegment* segment)
 {
     ImGui_ImplDX12_Data* bd = ImGui_ImplDX12_GetBackendData();
 
@@ -203,14 +209,14 @@ static void ImGui_ImplDX12_SetupRenderState(ImDrawData* draw_data, ID3D12Graphic
     unsigned int offset = 0;
     D3D12_VERTEX_BUFFER_VIEW vbv;
     memset(&vbv, 0, sizeof(D3D12_VERTEX_BUFFER_VIEW));
-    vbv.BufferLocation = fr->VertexBuffer->GetGPUVirtualAddress() + offset;
-    vbv.SizeInBytes = fr->VertexBufferSize * stride;
+    vbv.BufferLocation = segment->VertexBufferLocation + offset;
+    vbv.SizeInBytes = segment->VertexBufferViewSize;
     vbv.StrideInBytes = stride;
     ctx->IASetVertexBuffers(0, 1, &vbv);
     D3D12_INDEX_BUFFER_VIEW ibv;
     memset(&ibv, 0, sizeof(D3D12_INDEX_BUFFER_VIEW));
-    ibv.BufferLocation = fr->IndexBuffer->GetGPUVirtualAddress();
-    ibv.SizeInBytes = fr->IndexBufferSize * sizeof(ImDrawIdx);
+    ibv.BufferLocation = segment->IndexBufferLocation;
+    ibv.SizeInBytes = segment->IndexBufferViewSize;
     ibv.Format = sizeof(ImDrawIdx) == 2 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
     ctx->IASetIndexBuffer(&ibv);
     ctx->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
@@ -231,8 +237,110 @@ static inline void SafeRelease(T*& res)
     res = NULL;
 }
 
-// Render function
-void ImGui_ImplDX12_RenderDrawData(ImDrawData* draw_data, ID3D12GraphicsCommandList* ctx)
+static void ImGui_ImplDX12_RenderCommandLists(ImDrawData* draw_data, ID3D12GraphicsCommandList* ctx, ImGui_ImplDX12_RenderBuffers* fr);
+
+// Chunk factory of the streams: an upload heap buffer, mapped until it is released by ImGui_ImplDX12_DestroyStream()
+static bool ImGui_ImplDX12_CreateChunk(size_t size, ImGui_ImplDX12_BufferChunk* out_chunk)
+{
+    ImGui_ImplDX12_Data* bd = ImGui_ImplDX12_GetBackendData();
+    D3D12_HEAP_PROPERTIES props;
+    memset(&props, 0, sizeof(D3D12_HEAP_PROPERTIES));
+    props.Type = D3D12_HEAP_TYPE_UPLOAD;
+    props.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+    props.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+    D3D12_RESOURCE_DESC desc;
+    memset(&desc, 0, sizeof(D3D12_RESOURCE_DESC));
+    desc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+    desc.Width = size;
+    desc.Height = 1;
+    desc.DepthOrArraySize = 1;
+    desc.MipLevels = 1;
+    desc.Format = DXGI_FORMAT_UNKNOWN;
+    desc.SampleDesc.Count = 1;
+    desc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+    desc.Flags = D3D12_RESOURCE_FLAG_NONE;
+    ID3D12Resource* resource = NULL;
+    if (bd->pd3dDevice->CreateCommittedResource(&props, D3D12_HEAP_FLAG_NONE, &desc, D3D12_RESOURCE_STATE_GENERIC_READ, NULL, IID_PPV_ARGS(&resource)) < 0)
+        return false;
+
+    // Upload heaps may stay mapped for the lifetime of the resource
+    D3D12_RANGE range;
+    memset(&range, 0, sizeof(D3D12_RANGE));
+    void* cpu_address = NULL;
+    if (resource->Map(0, &range, &cpu_address) != S_OK)
+    {
+        resource->Release();
+        return false;
+    }
+    out_chunk->Resource = resource;
+    out_chunk->CpuAddress = cpu_address;
+    out_chunk->GpuAddress = resource->GetGPUVirtualAddress();
+    out_chunk->Size = size;
+    return true;
+}
+
+// Copy the regions of the font texture changed since the last frame, by glyphs rasterized on demand, from the atlas RGBA32 data.
+// The copies are recorded on ctx ahead of the draw calls, so frames still in flight sample the texture before it changes: those
+// regions belong to glyph cache pages that the current frame does not use. Secondary viewports are drawn after the main one and
+// see the changes from the same frame, as long as their queue does not run ahead of ctx.
+static void ImGui_ImplDX12_UploadFontsTextureRects(ID3D12GraphicsCommandList* ctx, ImGui_ImplDX12_RenderBuffers* fr)
+{
+    ImGui_ImplDX12_Data* bd = ImGui_ImplDX12_GetBackendData();
+    ImFontAtlas* atlas = ImGui::GetIO().Fonts;
+    ImGui_ImplDX12_BeginStream(&fr->Texels);
+    if (atlas->TexDirtyRects.Size == 0 || atlas->TexPixelsRGBA32 == NULL || bd->pFontTextureResource == NULL)
+        return;
+
+    D3D12_RESOURCE_BARRIER barrier = {};
+    barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+    barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+    barrier.Transition.pResource   = bd->pFontTextureResource;
+    barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+    barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+    barrier.Transition.StateAfter  = D3D12_RESOURCE_STATE_COPY_DEST;
+    ctx->ResourceBarrier(1, &barrier);
+
+    int uploaded_count = 0;
+    for (; uploaded_count < atlas->TexDirtyRects.Size; uploaded_count++)
+    {
+        const ImFontAtlasRect& r = atlas->TexDirtyRects[uploaded_count];
+        const UINT upload_pitch = (r.Width * 4 + D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1u) & ~(D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1u);
+        const size_t upload_size = ((size_t)r.Height * upload_pitch + D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1u) & ~(size_t)(D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1u);
+        size_t offset;
+        const int chunk = ImGui_ImplDX12_ReserveStream(&fr->Texels, upload_size, IMGUI_IMPL_DX12_MIN_TEXEL_CHUNK_SIZE, ImGui_ImplDX12_CreateChunk, &offset);
+        if (chunk < 0)
+            break;
+        const ImGui_ImplDX12_BufferChunk& dst = fr->Texels.Chunks[chunk];
+        for (int y = 0; y < r.Height; y++)
+            memcpy((char*)dst.CpuAddress + offset + y * upload_pitch, atlas->TexPixelsRGBA32 + r.X + (r.Y + y) * atlas->TexWidth, r.Width * 4);
+
+        D3D12_TEXTURE_COPY_LOCATION srcLocation = {};
+        srcLocation.pResource = dst.Resource;
+        srcLocation.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+        srcLocation.PlacedFootprint.Offset = offset;
+        srcLocation.PlacedFootprint.Footprint.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+        srcLocation.PlacedFootprint.Footprint.Width = r.Width;
+        srcLocation.PlacedFootprint.Footprint.Height = r.Height;
+        srcLocation.PlacedFootprint.Footprint.Depth = 1;
+        srcLocation.PlacedFootprint.Footprint.RowPitch = upload_pitch;
+
+        D3D12_TEXTURE_COPY_LOCATION dstLocation = {};
+        dstLocation.pResource = bd->pFontTextureResource;
+        dstLocation.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+        dstLocation.SubresourceIndex = 0;
+        ctx->CopyTextureRegion(&dstLocation, r.X, r.Y, 0, &srcLocation, NULL);
+    }
+
+    barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_COPY_DEST;
+    barrier.Transition.StateAfter  = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+    ctx->ResourceBarrier(1, &barrier);
+
+    // Whatever could not be uploaded is tried again next frame
+    atlas->TexDirtyRects.erase(atlas->TexDirtyRects.Data, atlas->TexDirtyRects.Data + uploaded_count);
+}
+
+// Upload and render. The upload allocator is skipped for retained draw data, which must stay in the backend's own buffers.
+static void ImGui_ImplDX12_UploadAndRenderDrawData(ImDrawData* draw_data, ID3D12GraphicsCommandList* ctx, bool allow_upload_allocator)
 {
     // Avoid rendering when minimized
     if (draw_data->DisplaySize.x <= 0.0f || draw_data->DisplaySize.y <= 0.0f)
@@ -242,86 +350,93 @@ void ImGui_ImplDX12_RenderDrawData(ImDrawData* draw_data, ID3D12GraphicsCommandL
     ImGui_ImplDX12_ViewportData* vd = (ImGui_ImplDX12_ViewportData*)draw_data->OwnerViewport->RendererUserData;
     vd->FrameIndex++;
     ImGui_ImplDX12_RenderBuffers* fr = &vd->FrameRenderBuffers[vd->FrameIndex % bd->numFramesInFlight];
+    fr->Segments.resize(0);
+
+    if (draw_data->OwnerViewport == ImGui::GetMainViewport())
+        ImGui_ImplDX12_UploadFontsTextureRects(ctx, fr);
 
-    // Create and grow vertex/index buffers if needed
-    if (fr->VertexBuffer == NULL || fr->VertexBufferSize < draw_data->TotalVtxCount)
+    // Sub-allocate from the application's upload memory when possible, as a single segment
+    void* vtx_resource, *idx_resource;
+    ImU64 vtx_gpu_address, idx_gpu_address;
+    const size_t vtx_size = (size_t)draw_data->TotalVtxCount * sizeof(ImDrawVert);
+    const size_t idx_size = (size_t)draw_data->TotalIdxCount * sizeof(ImDrawIdx);
+    bool use_upload_allocator = allow_upload_allocator && bd->UploadAllocator != NULL && draw_data->OwnerViewport == ImGui::GetMainViewport() && vtx_size > 0 && idx_size > 0;
+    if (use_upload_allocator)
+        use_upload_allocator = bd->UploadAllocator(bd->UploadAllocatorUserData, vtx_size, sizeof(float), &vtx_resource, &vtx_gpu_address)
+                            && bd->UploadAllocator(bd->UploadAllocatorUserData, idx_size, sizeof(ImDrawIdx), &idx_resource, &idx_gpu_address);
+    if (use_upload_allocator)
     {
-        SafeRelease(fr->VertexBuffer);
-        fr->VertexBufferSize = draw_data->TotalVtxCount + 5000;
-        D3D12_HEAP_PROPERTIES props;
-        memset(&props, 0, sizeof(D3D12_HEAP_PROPERTIES));
-        props.Type = D3D12_HEAP_TYPE_UPLOAD;
-        props.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
-        props.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
-        D3D12_RESOURCE_DESC desc;
-        memset(&desc, 0, sizeof(D3D12_RESOURCE_DESC));
-        desc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
-        desc.Width = fr->VertexBufferSize * sizeof(ImDrawVert);
-        desc.Height = 1;
-        desc.DepthOrArraySize = 1;
-        desc.MipLevels = 1;
-        desc.Format = DXGI_FORMAT_UNKNOWN;
-        desc.SampleDesc.Count = 1;
-        desc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
-        desc.Flags = D3D12_RESOURCE_FLAG_NONE;
-        if (bd->pd3dDevice->CreateCommittedResource(&props, D3D12_HEAP_FLAG_NONE, &desc, D3D12_RESOURCE_STATE_GENERIC_READ, NULL, IID_PPV_ARGS(&fr->VertexBuffer)) < 0)
-            return;
+        ImGui_ImplDX12_RenderSegment segment = { draw_data->CmdListsCount, vtx_gpu_address, idx_gpu_address, (UINT)vtx_size, (UINT)idx_size };
+        fr->Segments.push_back(segment);
+        ImDrawVert* vtx_dst = (ImDrawVert*)vtx_resource;
+        ImDrawIdx* idx_dst = (ImDrawIdx*)idx_resource;
+        for (int n = 0; n < draw_data->CmdListsCount; n++)
+        {
+            const ImDrawList* cmd_list = draw_data->CmdLists[n];
+            memcpy(vtx_dst, cmd_list->VtxBuffer.Data, cmd_list->VtxBuffer.Size * sizeof(ImDrawVert));
+            memcpy(idx_dst, cmd_list->IdxBuffer.Data, cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx));
+            vtx_dst += cmd_list->VtxBuffer.Size;
+            idx_dst += cmd_list->IdxBuffer.Size;
+        }
     }
-    if (fr->IndexBuffer == NULL || fr->IndexBufferSize < draw_data->TotalIdxCount)
+    else
     {
-        SafeRelease(fr->IndexBuffer);
-        fr->IndexBufferSize = draw_data->TotalIdxCount + 10000;
-        D3D12_HEAP_PROPERTIES props;
-        memset(&props, 0, sizeof(D3D12_HEAP_PROPERTIES));
-        props.Type = D3D12_HEAP_TYPE_UPLOAD;
-        props.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
-        props.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
-        D3D12_RESOURCE_DESC desc;
-        memset(&desc, 0, sizeof(D3D12_RESOURCE_DESC));
-        desc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
-        desc.Width = fr->IndexBufferSize * sizeof(ImDrawIdx);
-        desc.Height = 1;
-        desc.DepthOrArraySize = 1;
-        desc.MipLevels = 1;
-        desc.Format = DXGI_FORMAT_UNKNOWN;
-        desc.SampleDesc.Count = 1;
-        desc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
-        desc.Flags = D3D12_RESOURCE_FLAG_NONE;
-        if (bd->pd3dDevice->CreateCommittedResource(&props, D3D12_HEAP_FLAG_NONE, &desc, D3D12_RESOURCE_STATE_GENERIC_READ, NULL, IID_PPV_ARGS(&fr->IndexBuffer)) < 0)
+        // Otherwise stream each command list into the persistently mapped chunks, starting a segment whenever either stream moves to another chunk
+        if (!ImGui_ImplDX12_StreamDrawData(draw_data, &fr->Vertices, &fr->Indices, ImGui_ImplDX12_CreateChunk, &fr->Segments))
             return;
     }
 
-    // Upload vertex/index data into a single contiguous GPU buffer
-    void* vtx_resource, *idx_resource;
-    D3D12_RANGE range;
-    memset(&range, 0, sizeof(D3D12_RANGE));
-    if (fr->VertexBuffer->Map(0, &range, &vtx_resource) != S_OK)
-        return;
-    if (fr->IndexBuffer->Map(0, &range, &idx_resource) != S_OK)
-        return;
-    ImDrawVert* vtx_dst = (ImDrawVert*)vtx_resource;
-    ImDrawIdx* idx_dst = (ImDrawIdx*)idx_resource;
-    for (int n = 0; n < draw_data->CmdListsCount; n++)
+    ImGui_ImplDX12_RenderCommandLists(draw_data, ctx, fr);
+}
+
+// Render function
+void ImGui_ImplDX12_RenderDrawData(ImDrawData* draw_data, ID3D12GraphicsCommandList* ctx)
+{
+    ImGui_ImplDX12_UploadAndRenderDrawData(draw_data, ctx, true);
+}
+
+void ImGui_ImplDX12_RenderDrawDataRetained(ImDrawData* draw_data, ID3D12GraphicsCommandList* ctx, bool upload)
+{
+    if (upload)
     {
-        const ImDrawList* cmd_list = draw_data->CmdLists[n];
-        memcpy(vtx_dst, cmd_list->VtxBuffer.Data, cmd_list->VtxBuffer.Size * sizeof(ImDrawVert));
-        memcpy(idx_dst, cmd_list->IdxBuffer.Data, cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx));
-        vtx_dst += cmd_list->VtxBuffer.Size;
-        idx_dst += cmd_list->IdxBuffer.Size;
+        ImGui_ImplDX12_UploadAndRenderDrawData(draw_data, ctx, false);
+        return;
     }
-    fr->VertexBuffer->Unmap(0, &range);
-    fr->IndexBuffer->Unmap(0, &range);
 
-    // Setup desired DX state
-    ImGui_ImplDX12_SetupRenderState(draw_data, ctx, fr);
+    // Avoid rendering when minimized
+    if (draw_data->DisplaySize.x <= 0.0f || draw_data->DisplaySize.y <= 0.0f)
+        return;
+
+    // Bind the buffers of the last upload again, without advancing to the next frame's buffers
+    ImGui_ImplDX12_Data* bd = ImGui_ImplDX12_GetBackendData();
+    ImGui_ImplDX12_ViewportData* vd = (ImGui_ImplDX12_ViewportData*)draw_data->OwnerViewport->RendererUserData;
+    IM_ASSERT(vd->FrameIndex != UINT_MAX && "Upload the retained draw data first!");
+    ImGui_ImplDX12_RenderBuffers* fr = &vd->FrameRenderBuffers[vd->FrameIndex % bd->numFramesInFlight];
+    ImGui_ImplDX12_RenderCommandLists(draw_data, ctx, fr);
+}
 
-    // Render command lists
-    // (Because we merged all buffers into a single one, we maintain our own offset into them)
+static void ImGui_ImplDX12_RenderCommandLists(ImDrawData* draw_data, ID3D12GraphicsCommandList* ctx, ImGui_ImplDX12_RenderBuffers* fr)
+{
+    // Render command lists, binding the buffers of each segment in turn
+    // (Because we merged the buffers of a segment into a single one, we maintain our own offset into them)
     int global_vtx_offset = 0;
     int global_idx_offset = 0;
     ImVec2 clip_off = draw_data->DisplayPos;
+    const ImGui_ImplDX12_RenderSegment* segment = NULL;
+    int segment_end = 0;
     for (int n = 0; n < draw_data->CmdListsCount; n++)
     {
+        // Bind the next segment's buffers (there are none if the upload failed)
+        if (n == segment_end)
+        {
+            segment = (segment == NULL) ? fr->Segments.begin() : segment + 1;
+            if (segment >= fr->Segments.end())
+                return;
+            segment_end += segment->CmdListsCount;
+            global_vtx_offset = global_idx_offset = 0;
+            ImGui_ImplDX12_SetupRenderState(draw_data, ctx, segment);
+        }
+
         const ImDrawList* cmd_list = draw_data->CmdLists[n];
         for (int cmd_i = 0; cmd_i < cmd_list->CmdBuffer.Size; cmd_i++)
         {
@@ -331,7 +446,7 @@ void ImGui_ImplDX12_RenderDrawData(ImDrawData* draw_data, ID3D12GraphicsCommandL
                 // User callback, registered via ImDrawList::AddCallback()
                 // (ImDrawCallback_ResetRenderState is a special callback value used by the user to request the renderer to reset render state.)
                 if (pcmd->UserCallback == ImDrawCallback_ResetRenderState)
-                    ImGui_ImplDX12_SetupRenderState(draw_data, ctx, fr);
+                    ImGui_ImplDX12_SetupRenderState(draw_data, ctx, segment);
                 else
                     pcmd->UserCallback(cmd_list, pcmd);
             }
@@ -362,6 +477,7 @@ static void ImGui_ImplDX12_CreateFontsTexture()
     unsigned char* pixels;
     int width, height;
     io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+    io.Fonts->TexDirtyRects.clear();
 
     // Upload texture to graphics system
     {
@@ -744,11 +860,23 @@ bool    ImGui_ImplDX12_CreateDeviceObjects()
     return true;
 }
 
+static void ImGui_ImplDX12_DestroyStream(ImGui_ImplDX12_BufferStream* stream)
+{
+    for (int i = 0; i < stream->Chunks.Size; i++)
+    {
+        stream->Chunks[i].Resource->Unmap(0, NULL);
+        SafeRelease(stream->Chunks[i].Resource);
+    }
+    stream->Chunks.clear();
+    ImGui_ImplDX12_BeginStream(stream);
+}
+
 static void ImGui_ImplDX12_DestroyRenderBuffers(ImGui_ImplDX12_RenderBuffers* render_buffers)
 {
-    SafeRelease(render_buffers->IndexBuffer);
-    SafeRelease(render_buffers->VertexBuffer);
-    render_buffers->IndexBufferSize = render_buffers->VertexBufferSize = 0;
+    ImGui_ImplDX12_DestroyStream(&render_buffers->Indices);
+    ImGui_ImplDX12_DestroyStream(&render_buffers->Vertices);
+    ImGui_ImplDX12_DestroyStream(&render_buffers->Texels);
+    render_buffers->Segments.clear();
 }
 
 void    ImGui_ImplDX12_InvalidateDeviceObjects()
@@ -819,6 +947,14 @@ void ImGui_ImplDX12_Shutdown()
     IM_DELETE(bd);
 }
 
+void ImGui_ImplDX12_SetUploadAllocator(ImGui_ImplDX12_UploadAllocator allocator, void* user_data)
+{
+    ImGui_ImplDX12_Data* bd = ImGui_ImplDX12_GetBackendData();
+    IM_ASSERT(bd != NULL && "Did you call ImGui_ImplDX12_Init()?");
+    bd->UploadAllocator = allocator;
+    bd->UploadAllocatorUserData = user_data;
+}
+
 void ImGui_ImplDX12_NewFrame()
 {
     ImGui_ImplDX12_Data* bd = ImGui_ImplDX12_GetBackendData();
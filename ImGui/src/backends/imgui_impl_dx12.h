@@ -40,6 +40,18 @@ IMGUI_IMPL_API void     ImGui_ImplDX12_Shutdown();
 IMGUI_IMPL_API void     ImGui_ImplDX12_NewFrame();
 IMGUI_IMPL_API void     ImGui_ImplDX12_RenderDrawData(ImDrawData* draw_data, ID3D12GraphicsCommandList* graphics_command_list);
 
+// Optional: sub-allocate the main viewport's vertex/index data from application-owned upload memory (e.g. a fence-retired ring)
+// instead of the backend's own per-frame upload buffers. The memory must stay mapped and untouched until the GPU has finished
+// the frame it was allocated for. Return false when out of memory: the backend then falls back to its own buffers for that frame.
+// Secondary viewports always use the backend's buffers, since they are submitted on their own queue.
+typedef bool (*ImGui_ImplDX12_UploadAllocator)(void* user_data, size_t size, size_t alignment, void** out_cpu_address, ImU64* out_gpu_address);
+IMGUI_IMPL_API void     ImGui_ImplDX12_SetUploadAllocator(ImGui_ImplDX12_UploadAllocator allocator, void* user_data);
+
+// Optional: for UI that rarely changes. With upload == true, renders like ImGui_ImplDX12_RenderDrawData() but always uploads into
+// the backend's own buffers. With upload == false, renders the same draw data again from those buffers without uploading it,
+// which is only valid while the draw data is unchanged and no other ImGui_ImplDX12_RenderDrawData*() call was made for its viewport.
+IMGUI_IMPL_API void     ImGui_ImplDX12_RenderDrawDataRetained(ImDrawData* draw_data, ID3D12GraphicsCommandList* graphics_command_list, bool upload);
+
 // Use if you want to reset your rendering device without losing Dear ImGui state.
 IMGUI_IMPL_API void     ImGui_ImplDX12_InvalidateDeviceObjects();
 IMGUI_IMPL_API bool     ImGui_ImplDX12_CreateDeviceObjects();
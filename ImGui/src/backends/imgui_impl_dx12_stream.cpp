@@ -0,0 +1,88 @@
+// dear imgui: vertex/index streams of the DirectX12 Renderer Backend
+// How imgui_impl_dx12.cpp places each frame's vertex, index and texel uploads into its persistently mapped chunks.
+// Nothing here depends on Direct3D: chunks come from a callback, so the placement can be tested with fake chunks on any OS.
+
+// You can use unmodified imgui_impl_* files in your project. See examples/ folder for examples of using this.
+// Prefer including the entire imgui/ repository into your project (either as a copy or as a submodule), and only build the backends you need.
+// If you are new to Dear ImGui, read documentation from the docs/ folder + read the top of imgui.cpp.
+// Read online: https://github.com/ocornut/imgui/tree/master/docs
+
+#include "imgui.h"
+#include "imgui_impl_dx12_stream.h"
+#include <limits.h>
+#include <string.h>
+
+void ImGui_ImplDX12_BeginStream(ImGui_ImplDX12_BufferStream* stream)
+{
+    stream->ChunkIndex = 0;
+    stream->ChunkUsed = 0;
+}
+
+int ImGui_ImplDX12_ReserveStream(ImGui_ImplDX12_BufferStream* stream, size_t size, size_t min_chunk_size, ImGui_ImplDX12_CreateChunkFunc create_chunk, size_t* out_offset)
+{
+    for (; stream->ChunkIndex < stream->Chunks.Size; stream->ChunkIndex++, stream->ChunkUsed = 0)
+    {
+        if (stream->ChunkUsed + size <= stream->Chunks[stream->ChunkIndex].Size)
+        {
+            *out_offset = stream->ChunkUsed;
+            stream->ChunkUsed += size;
+            return stream->ChunkIndex;
+        }
+    }
+
+    size_t chunk_size = stream->Chunks.Size > 0 ? stream->Chunks.back().Size * 2 : min_chunk_size;
+    while (chunk_size < size)
+        chunk_size *= 2;
+    IM_ASSERT(chunk_size <= UINT_MAX && "Vertex/index buffer views are limited to 4 GB!");
+
+    ImGui_ImplDX12_BufferChunk chunk;
+    if (!create_chunk(chunk_size, &chunk))
+        return -1;
+    stream->Chunks.push_back(chunk);
+    stream->ChunkIndex = stream->Chunks.Size - 1;
+    stream->ChunkUsed = size;
+    *out_offset = 0;
+    return stream->ChunkIndex;
+}
+
+// A segment starts whenever either stream moves to another chunk
+bool ImGui_ImplDX12_StreamDrawData(ImDrawData* draw_data, ImGui_ImplDX12_BufferStream* vertices, ImGui_ImplDX12_BufferStream* indices, ImGui_ImplDX12_CreateChunkFunc create_chunk, ImVector<ImGui_ImplDX12_RenderSegment>* out_segments)
+{
+    ImGui_ImplDX12_BeginStream(vertices);
+    ImGui_ImplDX12_BeginStream(indices);
+    out_segments->resize(0);
+
+    int segment_vtx_chunk = -1, segment_idx_chunk = -1;
+    for (int n = 0; n < draw_data->CmdListsCount; n++)
+    {
+        const ImDrawList* cmd_list = draw_data->CmdLists[n];
+        const size_t cmd_vtx_size = cmd_list->VtxBuffer.Size * sizeof(ImDrawVert);
+        const size_t cmd_idx_size = cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx);
+        size_t vtx_offset, idx_offset;
+        const int vtx_chunk = ImGui_ImplDX12_ReserveStream(vertices, cmd_vtx_size, IMGUI_IMPL_DX12_MIN_VERTEX_CHUNK_SIZE, create_chunk, &vtx_offset);
+        const int idx_chunk = ImGui_ImplDX12_ReserveStream(indices, cmd_idx_size, IMGUI_IMPL_DX12_MIN_INDEX_CHUNK_SIZE, create_chunk, &idx_offset);
+        if (vtx_chunk < 0 || idx_chunk < 0)
+        {
+            out_segments->resize(0);
+            return false;
+        }
+
+        const ImGui_ImplDX12_BufferChunk& vtx_dst = vertices->Chunks[vtx_chunk];
+        const ImGui_ImplDX12_BufferChunk& idx_dst = indices->Chunks[idx_chunk];
+        memcpy((char*)vtx_dst.CpuAddress + vtx_offset, cmd_list->VtxBuffer.Data, cmd_vtx_size);
+        memcpy((char*)idx_dst.CpuAddress + idx_offset, cmd_list->IdxBuffer.Data, cmd_idx_size);
+
+        if (vtx_chunk != segment_vtx_chunk || idx_chunk != segment_idx_chunk)
+        {
+            ImGui_ImplDX12_RenderSegment segment = { 0, vtx_dst.GpuAddress + vtx_offset, idx_dst.GpuAddress + idx_offset, 0, 0 };
+            out_segments->push_back(segment);
+            segment_vtx_chunk = vtx_chunk;
+            segment_idx_chunk = idx_chunk;
+        }
+        ImGui_ImplDX12_RenderSegment& segment = out_segments->back();
+        segment.CmdListsCount++;
+        segment.VertexBufferViewSize += (unsigned int)cmd_vtx_size;
+        segment.IndexBufferViewSize += (unsigned int)cmd_idx_size;
+    }
+    return true;
+}
@@ -0,0 +1,65 @@
+// dear imgui: vertex/index streams of the DirectX12 Renderer Backend
+// How imgui_impl_dx12.cpp places each frame's vertex, index and texel uploads into its persistently mapped chunks.
+// Nothing here depends on Direct3D: chunks come from a callback, so the placement can be tested with fake chunks on any OS.
+
+// You can use unmodified imgui_impl_* files in your project. See examples/ folder for examples of using this.
+// Prefer including the entire imgui/ repository into your project (either as a copy or as a submodule), and only build the backends you need.
+// If you are new to Dear ImGui, read documentation from the docs/ folder + read the top of imgui.cpp.
+// Read online: https://github.com/ocornut/imgui/tree/master/docs
+
+#pragma once
+#include "imgui.h"      // IMGUI_IMPL_API
+
+struct ID3D12Resource;
+
+// Upload heap buffer, mapped once when created and kept until the device objects are invalidated
+struct ImGui_ImplDX12_BufferChunk
+{
+    ID3D12Resource*             Resource;
+    void*                       CpuAddress;
+    ImU64                       GpuAddress;     // D3D12_GPU_VIRTUAL_ADDRESS
+    size_t                      Size;
+};
+
+// Vertex or index data of a frame, streamed into a list of chunks. A frame that does not fit moves on to the next chunk,
+// and only creates one when it runs out of them, twice the size of the last: the chunks of the previous frames are reused
+// as they are, so opening a large window costs one buffer creation instead of recreating the whole buffer, and the number
+// of chunks stays logarithmic in the largest frame.
+struct ImGui_ImplDX12_BufferStream
+{
+    ImVector<ImGui_ImplDX12_BufferChunk> Chunks;
+    int                         ChunkIndex;     // Chunk being filled
+    size_t                      ChunkUsed;      // Bytes used in it
+
+    ImGui_ImplDX12_BufferStream() { ChunkIndex = 0; ChunkUsed = 0; }
+};
+
+// Consecutive command lists whose vertices and indices were uploaded to the same two buffers, drawn with one vertex/index buffer binding
+struct ImGui_ImplDX12_RenderSegment
+{
+    int                         CmdListsCount;
+    ImU64                       VertexBufferLocation;
+    ImU64                       IndexBufferLocation;
+    unsigned int                VertexBufferViewSize;
+    unsigned int                IndexBufferViewSize;
+};
+
+// Smallest chunks, for frames with few vertices; the chunks of larger frames grow geometrically from there
+static const size_t IMGUI_IMPL_DX12_MIN_VERTEX_CHUNK_SIZE = 5000 * sizeof(ImDrawVert);
+static const size_t IMGUI_IMPL_DX12_MIN_INDEX_CHUNK_SIZE = 10000 * sizeof(ImDrawIdx);
+static const size_t IMGUI_IMPL_DX12_MIN_TEXEL_CHUNK_SIZE = 64 * 1024;
+
+// Create a mapped chunk of exactly size bytes, or return false. The backend's creates an upload heap buffer (ImGui_ImplDX12_CreateChunk).
+typedef bool (*ImGui_ImplDX12_CreateChunkFunc)(size_t size, ImGui_ImplDX12_BufferChunk* out_chunk);
+
+// Start filling the stream from its first chunk again, once the GPU is done with the frame that last used it.
+IMGUI_IMPL_API void     ImGui_ImplDX12_BeginStream(ImGui_ImplDX12_BufferStream* stream);
+
+// Reserve size bytes in the chunk being filled, or in the first later chunk they fit in, creating one if there is none.
+// Returns the index of the chunk and sets out_offset, or returns -1 if a chunk could not be created.
+// Sizes are multiples of the element size, so every offset stays aligned to it.
+IMGUI_IMPL_API int      ImGui_ImplDX12_ReserveStream(ImGui_ImplDX12_BufferStream* stream, size_t size, size_t min_chunk_size, ImGui_ImplDX12_CreateChunkFunc create_chunk, size_t* out_offset);
+
+// Copy every command list's vertices and indices into the two streams, from their start, and set out_segments to the segments
+// to bind, in command list order. Returns false, with no segments, if a chunk could not be created.
+IMGUI_IMPL_API bool     ImGui_ImplDX12_StreamDrawData(ImDrawData* draw_data, ImGui_ImplDX12_BufferStream* vertices, ImGui_ImplDX12_BufferStream* indices, ImGui_ImplDX12_CreateChunkFunc create_chunk, ImVector<ImGui_ImplDX12_RenderSegment>* out_segments);
@@ -0,0 +1,293 @@
+// dear imgui: Platform and Renderer Backend without a window or a GPU
+// This is both the Platform and the Renderer Backend: use it on its own, e.g. to measure the CPU cost of building UI on any OS.
+
+// Implemented features:
+//  [X] Platform: Fixed display size and time step, so runs are deterministic.
+//  [X] Platform: Synthetic mouse, keyboard and text input, played back on the frame it was queued for.
+//  [X] Platform: Keyboard arrays indexed using ImGuiKey_* values, e.g. ImGui::IsKeyPressed(ImGui::GetKeyIndex(ImGuiKey_Space)).
+//  [X] Renderer: Walks the draw data like a GPU renderer would, calling user callbacks, and counts what it would draw.
+//  [X] Renderer: Per-frame CPU time, vertex, index, draw call and allocation counts.
+//  [X] Renderer: Consumes ImFontAtlas::TexDirtyRects like a GPU renderer would, counting the font texture uploads.
+// Missing features:
+//  [ ] Platform: Multi-viewport support (multiple windows).
+//  [ ] Renderer: Nothing is rasterized. The font atlas is built, but its ImTextureID is a dummy non-null value.
+
+// You can use unmodified imgui_impl_* files in your project. See examples/ folder for examples of using this.
+// Prefer including the entire imgui/ repository into your project (either as a copy or as a submodule), and only build the backends you need.
+// If you are new to Dear ImGui, read documentation from the docs/ folder + read the top of imgui.cpp.
+// Read online: https://github.com/ocornut/imgui/tree/master/docs
+
+// CHANGELOG
+//  2021-XX-XX: Count the font texture regions listed in ImFontAtlas::TexDirtyRects.
+//  2021-XX-XX: Initial version.
+
+#include "imgui.h"
+#include "imgui_impl_headless.h"
+#include <atomic>
+#include <chrono>
+#include <string.h>
+
+struct ImGui_ImplHeadless_Data
+{
+    ImVec2                                  DisplaySize;
+    float                                   DeltaTime;
+    int                                     FrameCount;
+    std::chrono::steady_clock::time_point   FrameStart;
+    std::chrono::steady_clock::time_point   LastFrameStart;
+    int                                     FrameAllocationsStart;
+    ImVector<ImGui_ImplHeadless_InputEvent> InputEvents;
+    ImGui_ImplHeadless_FrameStats           LastFrameStats;
+    ImGui_ImplHeadless_FrameStats           TotalStats;
+
+    // Allocations are counted by wrapping the allocator functions that were set when the backend was initialized.
+    // Atomic, as deferred draw lists may be built on several threads (see io.RunDrawListJobsFn).
+    std::atomic<int>                        Allocations;
+    ImGuiMemAllocFunc                       PrevAllocFunc;
+    ImGuiMemFreeFunc                        PrevFreeFunc;
+    void*                                   PrevAllocatorUserData;
+
+    ImGui_ImplHeadless_Data()   { DisplaySize = ImVec2(0.0f, 0.0f); DeltaTime = 0.0f; FrameCount = 0; FrameAllocationsStart = 0; Allocations = 0; PrevAllocFunc = NULL; PrevFreeFunc = NULL; PrevAllocatorUserData = NULL; memset(&LastFrameStats, 0, sizeof(LastFrameStats)); memset(&TotalStats, 0, sizeof(TotalStats)); }
+};
+
+// Backend data stored in io.BackendPlatformUserData to allow support for multiple Dear ImGui contexts
+// FIXME: allocator functions are global, so with multiple contexts every backend instance counts the allocations of all of them.
+static ImGui_ImplHeadless_Data* ImGui_ImplHeadless_GetBackendData()
+{
+    return ImGui::GetCurrentContext() ? (ImGui_ImplHeadless_Data*)ImGui::GetIO().BackendPlatformUserData : NULL;
+}
+
+static void* ImGui_ImplHeadless_CountingAlloc(size_t size, void* user_data)
+{
+    ImGui_ImplHeadless_Data* bd = (ImGui_ImplHeadless_Data*)user_data;
+    bd->Allocations.fetch_add(1, std::memory_order_relaxed);
+    return bd->PrevAllocFunc(size, bd->PrevAllocatorUserData);
+}
+
+static void ImGui_ImplHeadless_CountingFree(void* ptr, void* user_data)
+{
+    ImGui_ImplHeadless_Data* bd = (ImGui_ImplHeadless_Data*)user_data;
+    bd->PrevFreeFunc(ptr, bd->PrevAllocatorUserData);
+}
+
+// Functions
+bool    ImGui_ImplHeadless_Init(ImVec2 display_size, float delta_time)
+{
+    ImGuiIO& io = ImGui::GetIO();
+    IM_ASSERT(io.BackendPlatformUserData == NULL && "Already initialized a platform backend!");
+    IM_ASSERT(io.BackendRendererUserData == NULL && "Already initialized a renderer backend!");
+    IM_ASSERT(delta_time >= 0.0f);
+
+    // Setup backend capabilities flags
+    ImGui_ImplHeadless_Data* bd = IM_NEW(ImGui_ImplHeadless_Data)();
+    io.BackendPlatformUserData = (void*)bd;
+    io.BackendRendererUserData = (void*)bd;
+    io.BackendPlatformName = "imgui_impl_headless";
+    io.BackendRendererName = "imgui_impl_headless";
+    io.BackendFlags |= ImGuiBackendFlags_RendererHasVtxOffset;  // We count ImDrawCmd::VtxOffset like any other field, so large meshes are fine.
+
+    bd->DisplaySize = display_size;
+    bd->DeltaTime = delta_time;
+
+    // Keyboard mapping. The keyboard array is indexed by ImGuiKey_* values, so queued key events need no translation.
+    for (int key = 0; key < ImGuiKey_COUNT; key++)
+        io.KeyMap[key] = key;
+
+    // bd itself was allocated before the wrapper is installed, which is fine: both end up in the same allocator.
+    ImGui::GetAllocatorFunctions(&bd->PrevAllocFunc, &bd->PrevFreeFunc, &bd->PrevAllocatorUserData);
+    ImGui::SetAllocatorFunctions(ImGui_ImplHeadless_CountingAlloc, ImGui_ImplHeadless_CountingFree, bd);
+
+    return true;
+}
+
+void    ImGui_ImplHeadless_Shutdown()
+{
+    ImGui_ImplHeadless_Data* bd = ImGui_ImplHeadless_GetBackendData();
+    IM_ASSERT(bd != NULL && "No platform backend to shutdown, or already shutdown?");
+    ImGuiIO& io = ImGui::GetIO();
+
+    ImGui::SetAllocatorFunctions(bd->PrevAllocFunc, bd->PrevFreeFunc, bd->PrevAllocatorUserData);
+
+    io.BackendPlatformName = NULL;
+    io.BackendRendererName = NULL;
+    io.BackendPlatformUserData = NULL;
+    io.BackendRendererUserData = NULL;
+    io.Fonts->SetTexID(NULL);
+    IM_DELETE(bd);
+}
+
+static void ImGui_ImplHeadless_ApplyInputEvents()
+{
+    ImGui_ImplHeadless_Data* bd = ImGui_ImplHeadless_GetBackendData();
+    ImGuiIO& io = ImGui::GetIO();
+
+    // Events stay in order, so a later frame's event also holds back everything queued after it.
+    int applied = 0;
+    while (applied < bd->InputEvents.Size && bd->InputEvents[applied].Frame <= bd->FrameCount)
+    {
+        const ImGui_ImplHeadless_InputEvent& e = bd->InputEvents[applied++];
+        switch (e.Type)
+        {
+        case ImGui_ImplHeadless_InputType_MousePos:
+            io.MousePos = e.MousePos;
+            break;
+        case ImGui_ImplHeadless_InputType_MouseButton:
+            if (e.Index >= 0 && e.Index < IM_ARRAYSIZE(io.MouseDown))
+                io.MouseDown[e.Index] = e.Down;
+            break;
+        case ImGui_ImplHeadless_InputType_MouseWheel:
+            io.MouseWheel += e.Wheel;
+            break;
+        case ImGui_ImplHeadless_InputType_Key:
+            if (e.Index >= 0 && e.Index < IM_ARRAYSIZE(io.KeysDown))
+                io.KeysDown[e.Index] = e.Down;
+            break;
+        case ImGui_ImplHeadless_InputType_Char:
+            io.AddInputCharacter(e.Char);
+            break;
+        }
+    }
+
+    if (applied > 0)
+        bd->InputEvents.erase(bd->InputEvents.Data, bd->InputEvents.Data + applied);
+}
+
+void    ImGui_ImplHeadless_NewFrame()
+{
+    ImGui_ImplHeadless_Data* bd = ImGui_ImplHeadless_GetBackendData();
+    IM_ASSERT(bd != NULL && "Did you call ImGui_ImplHeadless_Init()?");
+    ImGuiIO& io = ImGui::GetIO();
+
+    bd->FrameStart = std::chrono::steady_clock::now();
+    bd->FrameAllocationsStart = bd->Allocations.load(std::memory_order_relaxed);
+
+    // Nothing is uploaded, but the atlas is built like a renderer would, as ImGui::NewFrame() requires it.
+    if (!io.Fonts->IsBuilt())
+    {
+        unsigned char* pixels;
+        int width, height;
+        io.Fonts->GetTexDataAsAlpha8(&pixels, &width, &height);
+        io.Fonts->SetTexID((ImTextureID)(intptr_t)1);
+    }
+
+    // Setup display size and time step
+    io.DisplaySize = bd->DisplaySize;
+    io.DisplayFramebufferScale = ImVec2(1.0f, 1.0f);
+    if (bd->DeltaTime > 0.0f || bd->FrameCount == 0)
+        io.DeltaTime = bd->DeltaTime > 0.0f ? bd->DeltaTime : 1.0f / 60.0f;
+    else
+    {
+        float delta_time = std::chrono::duration<float>(bd->FrameStart - bd->LastFrameStart).count();
+        io.DeltaTime = delta_time > 0.0f ? delta_time : 1e-6f;
+    }
+    bd->LastFrameStart = bd->FrameStart;
+
+    ImGui_ImplHeadless_ApplyInputEvents();
+    bd->FrameCount++;
+}
+
+void    ImGui_ImplHeadless_RenderDrawData(ImDrawData* draw_data)
+{
+    ImGui_ImplHeadless_Data* bd = ImGui_ImplHeadless_GetBackendData();
+    IM_ASSERT(bd != NULL && "Did you call ImGui_ImplHeadless_Init()?");
+
+    ImGui_ImplHeadless_FrameStats stats;
+    memset(&stats, 0, sizeof(stats));
+    stats.Frames = 1;
+
+    // Avoid rendering when minimized
+    if (draw_data->DisplaySize.x > 0.0f && draw_data->DisplaySize.y > 0.0f)
+    {
+        stats.CmdLists = draw_data->CmdListsCount;
+        stats.Vertices = draw_data->TotalVtxCount;
+        stats.Indices = draw_data->TotalIdxCount;
+
+        // Regions of the font texture a GPU renderer would upload before drawing
+        ImFontAtlas* atlas = ImGui::GetIO().Fonts;
+        for (int n = 0; n < atlas->TexDirtyRects.Size; n++)
+            stats.FontUploadPixels += atlas->TexDirtyRects[n].Width * atlas->TexDirtyRects[n].Height;
+        stats.FontUploads = atlas->TexDirtyRects.Size;
+        atlas->TexDirtyRects.clear();
+
+        // Same clipping as the GPU renderers, so the counts match what they would draw
+        ImVec2 clip_off = draw_data->DisplayPos;
+        for (int n = 0; n < draw_data->CmdListsCount; n++)
+        {
+            const ImDrawList* cmd_list = draw_data->CmdLists[n];
+            for (int cmd_i = 0; cmd_i < cmd_list->CmdBuffer.Size; cmd_i++)
+            {
+                const ImDrawCmd* pcmd = &cmd_list->CmdBuffer[cmd_i];
+                if (pcmd->UserCallback != NULL)
+                {
+                    // There is no render state to reset, so ImDrawCallback_ResetRenderState is a no-op.
+                    if (pcmd->UserCallback != ImDrawCallback_ResetRenderState)
+                        pcmd->UserCallback(cmd_list, pcmd);
+                }
+                else
+                {
+                    ImVec2 clip_min(pcmd->ClipRect.x - clip_off.x, pcmd->ClipRect.y - clip_off.y);
+                    ImVec2 clip_max(pcmd->ClipRect.z - clip_off.x, pcmd->ClipRect.w - clip_off.y);
+                    if (pcmd->ElemCount > 0 && clip_max.x > clip_min.x && clip_max.y > clip_min.y)
+                        stats.DrawCalls++;
+                }
+            }
+        }
+    }
+
+    stats.CpuTimeNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - bd->FrameStart).count();
+    stats.Allocations = bd->Allocations.load(std::memory_order_relaxed) - bd->FrameAllocationsStart;
+    bd->LastFrameStats = stats;
+
+    ImGui_ImplHeadless_FrameStats& total = bd->TotalStats;
+    total.Frames += stats.Frames;
+    total.CpuTimeNs += stats.CpuTimeNs;
+    total.CmdLists += stats.CmdLists;
+    total.Vertices += stats.Vertices;
+    total.Indices += stats.Indices;
+    total.DrawCalls += stats.DrawCalls;
+    total.Allocations += stats.Allocations;
+    total.FontUploads += stats.FontUploads;
+    total.FontUploadPixels += stats.FontUploadPixels;
+}
+
+void    ImGui_ImplHeadless_QueueInputEvent(const ImGui_ImplHeadless_InputEvent& input_event)
+{
+    ImGui_ImplHeadless_Data* bd = ImGui_ImplHeadless_GetBackendData();
+    IM_ASSERT(bd != NULL && "Did you call ImGui_ImplHeadless_Init()?");
+    bd->InputEvents.push_back(input_event);
+}
+
+void    ImGui_ImplHeadless_ClearInputEvents()
+{
+    ImGui_ImplHeadless_Data* bd = ImGui_ImplHeadless_GetBackendData();
+    IM_ASSERT(bd != NULL && "Did you call ImGui_ImplHeadless_Init()?");
+    bd->InputEvents.clear();
+}
+
+int     ImGui_ImplHeadless_GetFrameCount()
+{
+    ImGui_ImplHeadless_Data* bd = ImGui_ImplHeadless_GetBackendData();
+    IM_ASSERT(bd != NULL && "Did you call ImGui_ImplHeadless_Init()?");
+    return bd->FrameCount;
+}
+
+const ImGui_ImplHeadless_FrameStats& ImGui_ImplHeadless_GetLastFrameStats()
+{
+    ImGui_ImplHeadless_Data* bd = ImGui_ImplHeadless_GetBackendData();
+    IM_ASSERT(bd != NULL && "Did you call ImGui_ImplHeadless_Init()?");
+    return bd->LastFrameStats;
+}
+
+const ImGui_ImplHeadless_FrameStats& ImGui_ImplHeadless_GetTotalStats()
+{
+    ImGui_ImplHeadless_Data* bd = ImGui_ImplHeadless_GetBackendData();
+    IM_ASSERT(bd != NULL && "Did you call ImGui_ImplHeadless_Init()?");
+    return bd->TotalStats;
+}
+
+void    ImGui_ImplHeadless_ResetStats()
+{
+    ImGui_ImplHeadless_Data* bd = ImGui_ImplHeadless_GetBackendData();
+    IM_ASSERT(bd != NULL && "Did you call ImGui_ImplHeadless_Init()?");
+    memset(&bd->LastFrameStats, 0, sizeof(bd->LastFrameStats));
+    memset(&bd->TotalStats, 0, sizeof(bd->TotalStats));
+}
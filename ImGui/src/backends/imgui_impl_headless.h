@@ -0,0 +1,70 @@
+// dear imgui: Platform and Renderer Backend without a window or a GPU
+// This is both the Platform and the Renderer Backend: use it on its own, e.g. to measure the CPU cost of building UI on any OS.
+
+// Implemented features:
+//  [X] Platform: Fixed display size and time step, so runs are deterministic.
+//  [X] Platform: Synthetic mouse, keyboard and text input, played back on the frame it was queued for.
+//  [X] Platform: Keyboard arrays indexed using ImGuiKey_* values, e.g. ImGui::IsKeyPressed(ImGui::GetKeyIndex(ImGuiKey_Space)).
+//  [X] Renderer: Walks the draw data like a GPU renderer would, calling user callbacks, and counts what it would draw.
+//  [X] Renderer: Per-frame CPU time, vertex, index, draw call and allocation counts.
+//  [X] Renderer: Consumes ImFontAtlas::TexDirtyRects like a GPU renderer would, counting the font texture uploads.
+// Missing features:
+//  [ ] Platform: Multi-viewport support (multiple windows).
+//  [ ] Renderer: Nothing is rasterized. The font atlas is built, but its ImTextureID is a dummy non-null value.
+
+// You can use unmodified imgui_impl_* files in your project. See examples/ folder for examples of using this.
+// Prefer including the entire imgui/ repository into your project (either as a copy or as a submodule), and only build the backends you need.
+// If you are new to Dear ImGui, read documentation from the docs/ folder + read the top of imgui.cpp.
+// Read online: https://github.com/ocornut/imgui/tree/master/docs
+
+#pragma once
+#include "imgui.h"      // IMGUI_IMPL_API
+
+enum ImGui_ImplHeadless_InputType
+{
+    ImGui_ImplHeadless_InputType_MousePos,
+    ImGui_ImplHeadless_InputType_MouseButton,
+    ImGui_ImplHeadless_InputType_MouseWheel,
+    ImGui_ImplHeadless_InputType_Key,
+    ImGui_ImplHeadless_InputType_Char
+};
+
+struct ImGui_ImplHeadless_InputEvent
+{
+    int                             Frame;      // Applied by the NewFrame() of this frame, counted from 0 since Init
+    ImGui_ImplHeadless_InputType    Type;
+    ImVec2                          MousePos;   // MousePos
+    int                             Index;      // MouseButton: 0 to 4. Key: ImGuiKey_* value, or any other index into io.KeysDown[]
+    bool                            Down;       // MouseButton, Key
+    float                           Wheel;      // MouseWheel: vertical steps
+    ImWchar                         Char;       // Char
+};
+
+struct ImGui_ImplHeadless_FrameStats
+{
+    int                             Frames;     // 1 for a single frame, the number of frames summed for totals
+    double                          CpuTimeNs;  // From the start of NewFrame() to the end of RenderDrawData()
+    int                             CmdLists;
+    int                             Vertices;
+    int                             Indices;
+    int                             DrawCalls;  // Commands with elements and a visible clip rectangle; callbacks are not counted
+    int                             Allocations;// ImGui::MemAlloc() calls, from any context
+    int                             FontUploads;// Font texture regions changed by glyphs rasterized on demand
+    int                             FontUploadPixels;
+};
+
+// The time step is fixed, as a real clock would make runs differ; 0.0f measures real time instead.
+IMGUI_IMPL_API bool     ImGui_ImplHeadless_Init(ImVec2 display_size, float delta_time = 1.0f / 60.0f);
+IMGUI_IMPL_API void     ImGui_ImplHeadless_Shutdown();
+IMGUI_IMPL_API void     ImGui_ImplHeadless_NewFrame();
+IMGUI_IMPL_API void     ImGui_ImplHeadless_RenderDrawData(ImDrawData* draw_data);
+
+// Input playback. Events are applied in the order they were queued; events queued for a frame that already started are applied on the next one.
+IMGUI_IMPL_API void     ImGui_ImplHeadless_QueueInputEvent(const ImGui_ImplHeadless_InputEvent& input_event);
+IMGUI_IMPL_API void     ImGui_ImplHeadless_ClearInputEvents();
+IMGUI_IMPL_API int      ImGui_ImplHeadless_GetFrameCount();
+
+// Statistics. Divide the totals by their Frames for per-frame averages; reset them e.g. after warm-up frames.
+IMGUI_IMPL_API const ImGui_ImplHeadless_FrameStats& ImGui_ImplHeadless_GetLastFrameStats();
+IMGUI_IMPL_API const ImGui_ImplHeadless_FrameStats& ImGui_ImplHeadless_GetTotalStats();
+IMGUI_IMPL_API void     ImGui_ImplHeadless_ResetStats();
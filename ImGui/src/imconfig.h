@@ -57,6 +57,10 @@
 //---- Use 32-bit for ImWchar (default is 16-bit) to support unicode planes 1-16. (e.g. point beyond 0xFFFF like emoticons, dingbats, symbols, shapes, ancient languages, etc...)
 //#define IMGUI_USE_WCHAR32
 
+//---- Use an open addressing hash map for ImGuiStorage instead of a sorted vector: O(1) insertion and lookup instead of O(N) insertion and O(log N) lookup,
+// at the cost of iterating ImGuiStorage::Data in no particular order and over empty slots (key 0, value 0).
+//#define IMGUI_USE_OPEN_ADDRESSING_STORAGE
+
 //---- Avoid multiple STB libraries implementations, or redefine path/filenames to prioritize another version
 // By default the embedded implementations are declared static and not available outside of Dear ImGui sources files.
 //#define IMGUI_STB_TRUETYPE_FILENAME   "my_folder/stb_truetype.h"
@@ -93,7 +97,8 @@
 // Your renderer backend will need to support it (most example renderer backends support both 16/32-bit indices).
 // Another way to allow large meshes while keeping 16-bit indices is to handle ImDrawCmd::VtxOffset in your renderer.
 // Read about ImGuiBackendFlags_RendererHasVtxOffset for details.
-//#define ImDrawIdx unsigned int
+// Enabled here: large plots would otherwise be split into a draw call per 64K vertices. Both our backends (imgui_impl_dx12, imgui_impl_headless) support it.
+#define ImDrawIdx unsigned int
 
 //---- Override ImDrawCallback signature (will need to modify renderer backends accordingly)
 //struct ImDrawList;
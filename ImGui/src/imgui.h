@@ -216,6 +216,7 @@ typedef int (*ImGuiInputTextCallback)(ImGuiInputTextCallbackData* data);    // C
 typedef void (*ImGuiSizeCallback)(ImGuiSizeCallbackData* data);             // Callback function for ImGui::SetNextWindowSizeConstraints()
 typedef void* (*ImGuiMemAllocFunc)(size_t sz, void* user_data);             // Function signature for ImGui::SetAllocatorFunctions()
 typedef void (*ImGuiMemFreeFunc)(void* ptr, void* user_data);               // Function signature for ImGui::SetAllocatorFunctions()
+typedef void (*ImDrawListBuildCallback)(ImDrawList* draw_list, void* user_data); // Callback function for ImGui::AddDeferredDrawList()
 
 // Character types
 // (we generally use UTF-8 encoded string in the API. This is storage specifically for a decoded character used for keyboard input and display)
@@ -355,6 +356,14 @@ namespace ImGui
     IMGUI_API float         GetWindowHeight();                          // get current window height (shortcut for GetWindowSize().y)
     IMGUI_API ImGuiViewport*GetWindowViewport();                        // get viewport currently associated to the current window.
 
+    // Deferred draw lists
+    // - For drawing that needs no ImGui state once its inputs are known, e.g. large plots. Render() calls build_func(draw_list, user_data)
+    //   for every call made this frame, through io.RunDrawListJobsFn if set, so builds may run on other threads and concurrently.
+    // - Each build fills its own ImDrawList, starting with the clip rectangle, texture and font current at the time of the call.
+    //   It is drawn right after the window's own draw list, in call order, no matter which build finished first.
+    // - A build must only touch the given draw list and its own data: ImGui:: functions are not thread-safe. user_data must stay valid until Render().
+    IMGUI_API void          AddDeferredDrawList(ImDrawListBuildCallback build_func, void* user_data); // queue drawing for the current window
+
     // Window manipulation
     // - Prefer using SetNextXXX functions (before Begin) rather that SetXXX functions (after Begin).
     IMGUI_API void          SetNextWindowPos(const ImVec2& pos, ImGuiCond cond = 0, const ImVec2& pivot = ImVec2(0, 0)); // set next window position. call before Begin(). use pivot=(0.5f,0.5f) to center on given point, etc.
@@ -1941,6 +1950,12 @@ struct ImGuiIO
     void        (*SetClipboardTextFn)(void* user_data, const char* text);
     void*       ClipboardUserData;
 
+    // Optional: Run the draw list builds queued with AddDeferredDrawList(), e.g. on a job system. Call job(job_data, index) once for every index
+    // in [0, count), in any order and on any threads, and return once all of them finished. (default to running them one after the other)
+    // Allocations made by concurrent builds may make io.MetricsActiveAllocations inaccurate.
+    void        (*RunDrawListJobsFn)(void* user_data, int count, void (*job)(void* job_data, int index), void* job_data);
+    void*       RunDrawListJobsUserData;
+
     //------------------------------------------------------------------
     // Input - Fill before calling NewFrame()
     //------------------------------------------------------------------
@@ -2223,12 +2238,27 @@ struct ImGuiStorage
         ImGuiStoragePair(ImGuiID _key, void* _val_p)    { key = _key; val_p = _val_p; }
     };
 
+#ifdef IMGUI_USE_OPEN_ADDRESSING_STORAGE
+    // Open addressing: Data holds Keys.Size slots in hash order, probed in groups of 4 keys, and a last slot for key 0.
+    // Unused slots have key 0 and value 0, so code iterating Data sees them as pairs with a zero value.
     ImVector<ImGuiStoragePair>      Data;
+    ImVector<ImGuiID>               Keys;           // Key of each slot but the last, 0 if unused. Kept apart from Data so a group is one SIMD load.
+    int                             Count;          // Used slots, not counting the one for key 0
+    bool                            ZeroKeyUsed;
 
-    // - Get***() functions find pair, never add/allocate. Pairs are sorted so a query is O(log N)
+    ImGuiStorage()                  { Count = 0; ZeroKeyUsed = false; }
+#else
+    ImVector<ImGuiStoragePair>      Data;
+#endif
+
+    // - Get***() functions find pair, never add/allocate. Pairs are sorted so a query is O(log N) (or hashed, see IMGUI_USE_OPEN_ADDRESSING_STORAGE)
     // - Set***() functions find pair, insertion on demand if missing.
     // - Sorted insertion is costly, paid once. A typical frame shouldn't need to insert any new pair.
+#ifdef IMGUI_USE_OPEN_ADDRESSING_STORAGE
+    void                Clear() { Data.clear(); Keys.clear(); Count = 0; ZeroKeyUsed = false; }
+#else
     void                Clear() { Data.clear(); }
+#endif
     IMGUI_API int       GetInt(ImGuiID key, int default_val = 0) const;
     IMGUI_API void      SetInt(ImGuiID key, int val);
     IMGUI_API bool      GetBool(ImGuiID key, bool default_val = false) const;
@@ -2250,6 +2280,9 @@ struct ImGuiStorage
     // Use on your own storage if you know only integer are being stored (open/close all tree nodes)
     IMGUI_API void      SetAllInt(int val);
 
+    // Remove a pair, if present. With IMGUI_USE_OPEN_ADDRESSING_STORAGE, the pairs probed after it are shifted back instead of leaving a tombstone.
+    IMGUI_API void      Remove(ImGuiID key);
+
     // For quicker full rebuild of a storage (instead of an incremental one), you may add all your contents and then sort once.
     IMGUI_API void      BuildSortByKey();
 };
@@ -2498,6 +2531,7 @@ struct ImDrawList
     ImVector<ImVec4>        _ClipRectStack;     // [Internal]
     ImVector<ImTextureID>   _TextureIdStack;    // [Internal]
     ImVector<ImVec2>        _Path;              // [Internal] current path building
+    ImVector<ImVec2>        _TempBuffer;        // [Internal] normals and edge points of AddPolyline() and AddConvexPolyFilled(), too large for the stack on long lines
     ImDrawCmdHeader         _CmdHeader;         // [Internal] template of active commands. Fields should match those of CmdBuffer.back().
     ImDrawListSplitter      _Splitter;          // [Internal] for channels api (note: prefer using your own persistent instance of ImDrawListSplitter!)
     float                   _FringeScale;       // [Internal] anti-alias fringe is scaled by this value, this helps to keep things sharp while zooming at vertex buffer content
@@ -2649,6 +2683,7 @@ struct ImFontConfig
     unsigned int    FontBuilderFlags;       // 0        // Settings for custom font builder. THIS IS BUILDER IMPLEMENTATION DEPENDENT. Leave as zero if unsure.
     float           RasterizerMultiply;     // 1.0f     // Brighten (>1.0f) or darken (<1.0f) font output. Brightening small fonts may be a good workaround to make them more readable.
     ImWchar         EllipsisChar;           // -1       // Explicitly specify unicode codepoint of ellipsis character. When fonts are being merged first specified ellipsis will be used.
+    bool            DynamicGlyphs;          // false    // Rasterize codepoints outside of GlyphRanges when they are first drawn or measured, into the atlas glyph cache (see ImFontAtlas::GlyphCachePageCount), instead of drawing FallbackChar. stb_truetype builder only.
 
     // [Internal]
     char            Name[40];               // Name (strictly to ease debugging)
@@ -2698,6 +2733,25 @@ struct ImFontAtlasCustomRect
     bool IsPacked() const           { return X != 0xFFFF; }
 };
 
+// A region of the font atlas texture, in pixels
+struct ImFontAtlasRect
+{
+    unsigned short  X, Y;
+    unsigned short  Width, Height;
+};
+
+// [Internal] A page of the glyph cache: a square of the atlas texture, reserved by Build(), that glyphs rasterized on demand are packed into
+// row by row. Pages are only ever emptied as a whole, the least recently used one first.
+struct ImFontGlyphCachePage
+{
+    int             PackId;         // Custom rectangle holding the page
+    unsigned short  CursorX;        // Where the next glyph goes in the current row, relative to the page
+    unsigned short  RowY;           // Top of the current row, relative to the page
+    unsigned short  RowHeight;      // Height of the tallest glyph in the current row
+    int             GlyphsCount;
+    int             LastUsedFrame;  // ImFontAtlas::GlyphCacheFrame when one of its glyphs was last looked up
+};
+
 // Flags for ImFontAtlas build
 enum ImFontAtlasFlags_
 {
@@ -2794,6 +2848,15 @@ struct ImFontAtlas
     int                         TexDesiredWidth;    // Texture width desired by user before Build(). Must be a power-of-two. If have many glyphs your graphics API have texture size restrictions you may want to increase texture width to decrease height.
     int                         TexGlyphPadding;    // Padding between glyphs within texture in pixels. Defaults to 1. If your rendering method doesn't rely on bilinear filtering you may set this to 0.
     bool                        Locked;             // Marked as Locked by ImGui::NewFrame() so attempt to modify the atlas will assert.
+    int                         GlyphCachePageCount;// = 0      // Number of pages reserved in the texture by Build() for the glyphs of ImFontConfig::DynamicGlyphs sources. Set before the first Build().
+    int                         GlyphCachePageSize; // = 256    // Width and height of a glyph cache page, in pixels. A glyph larger than a page draws as FallbackChar.
+    const char*                 BuildCacheFilename; // = NULL   // Path to a file where the stb_truetype builder saves the texture and glyphs, to load them back instead of rasterizing on the next Build() with the same fonts and settings. NULL to disable.
+
+    // Optional: Rasterize glyphs on a job system in Build(). Call job(job_data, index) once for every index in [0, count), in any order and on any threads,
+    // and return once all of them finished. (default to running them one after the other. Only used by the stb_truetype builder)
+    // Allocations made by concurrent jobs may make io.MetricsActiveAllocations inaccurate.
+    void                        (*BuildJobsFn)(void* user_data, int count, void (*job)(void* job_data, int index), void* job_data);
+    void*                       BuildJobsUserData;
 
     // [Internal]
     // NB: Access texture data via GetTexData*() calls! Which will setup a default font for you.
@@ -2809,6 +2872,7 @@ struct ImFontAtlas
     ImVector<ImFontAtlasCustomRect> CustomRects;    // Rectangles for packing custom texture data into the atlas.
     ImVector<ImFontConfig>      ConfigData;         // Configuration data
     ImVec4                      TexUvLines[IM_DRAWLIST_TEX_LINES_WIDTH_MAX + 1];  // UVs for baked anti-aliased lines
+    ImVector<ImFontAtlasRect>   TexDirtyRects;      // Regions of the texture data changed after Build(), by glyphs rasterized on demand. Renderer backends upload them to their texture, then clear the list.
 
     // [Internal] Font builder
     const ImFontBuilderIO*      FontBuilderIO;      // Opaque interface to a font builder (default to stb_truetype, can be changed to use FreeType by defining IMGUI_ENABLE_FREETYPE).
@@ -2818,6 +2882,11 @@ struct ImFontAtlas
     int                         PackIdMouseCursors; // Custom texture rectangle ID for white pixel and mouse cursors
     int                         PackIdLines;        // Custom texture rectangle ID for baked anti-aliased lines
 
+    // [Internal] Glyph cache
+    ImVector<ImFontGlyphCachePage> GlyphCachePages;
+    int                         GlyphCacheFrame;    // Advanced by ImGui::NewFrame(). Pages looked up during the current frame are never emptied, as draw lists already point into them.
+    bool                        GlyphCacheLocked;   // Set by ImGui::Render() while deferred draw lists build, possibly on other threads: their lookups are recorded, and rasterized or marked as used once the builds are done.
+
 #ifndef IMGUI_DISABLE_OBSOLETE_FUNCTIONS
     typedef ImFontAtlasCustomRect    CustomRect;         // OBSOLETED in 1.72+
     //typedef ImFontGlyphRangesBuilder GlyphRangesBuilder; // OBSOLETED in 1.67+
@@ -2850,13 +2919,16 @@ struct ImFont
     float                       Ascent, Descent;    // 4+4   // out //            // Ascent: distance from top to bottom of e.g. 'A' [0..FontSize]
     int                         MetricsTotalSurface;// 4     // out //            // Total surface in pixels to get an idea of the font rasterization/texture cost (not exact, we approximate the cost of padding between glyphs)
     ImU8                        Used4kPagesMap[(IM_UNICODE_CODEPOINT_MAX+1)/4096/8]; // 2 bytes if ImWchar=ImWchar16, 34 bytes if ImWchar==ImWchar32. Store 1-bit for each block of 4K codepoints that has one active glyph. This is mainly used to facilitate iterations across all used codepoints.
+    bool                        DynamicGlyphs;      // 1     // out //            // Set when one of its sources has ImFontConfig::DynamicGlyphs. Missing entries of IndexAdvanceX are then -1.0f until the codepoint was looked up.
+    int                         GlyphCacheStart;    // 4     // out //            // Glyphs[GlyphCacheStart..] were rasterized on demand, in the glyph cache pages of GlyphCachePageOf[]
+    ImVector<unsigned short>    GlyphCachePageOf;   // 12-16 // out //            // Index into ContainerAtlas->GlyphCachePages of each glyph from GlyphCacheStart
 
     // Methods
     IMGUI_API ImFont();
     IMGUI_API ~ImFont();
     IMGUI_API const ImFontGlyph*FindGlyph(ImWchar c) const;
     IMGUI_API const ImFontGlyph*FindGlyphNoFallback(ImWchar c) const;
-    float                       GetCharAdvance(ImWchar c) const     { return ((int)c < IndexAdvanceX.Size) ? IndexAdvanceX[(int)c] : FallbackAdvanceX; }
+    float                       GetCharAdvance(ImWchar c) const     { float advance_x = ((int)c < IndexAdvanceX.Size) ? IndexAdvanceX.Data[(int)c] : DynamicGlyphs ? -1.0f : FallbackAdvanceX; return (advance_x >= 0.0f) ? advance_x : FindGlyph(c)->AdvanceX; }
     bool                        IsLoaded() const                    { return ContainerAtlas != NULL; }
     const char*                 GetDebugName() const                { return ConfigData ? ConfigData->Name : "<unknown>"; }
 
@@ -2864,6 +2936,7 @@ struct ImFont
     // 'wrap_width' enable automatic word-wrapping across multiple lines to fit into given width. 0.0f to disable.
     IMGUI_API ImVec2            CalcTextSizeA(float size, float max_width, float wrap_width, const char* text_begin, const char* text_end = NULL, const char** remaining = NULL) const; // utf8
     IMGUI_API const char*       CalcWordWrapPositionA(float scale, const char* text, const char* text_end, float wrap_width) const;
+    IMGUI_API ImVec2            CalcTextLinesA(float size, float wrap_width, const char* text_begin, const char* text_end, ImVector<int>* out_lines) const; // CalcTextSizeA() without max_width, also appending the begin and end offsets from text_begin of every line as RenderText() breaks them
     IMGUI_API void              RenderChar(ImDrawList* draw_list, float size, ImVec2 pos, ImU32 col, ImWchar c) const;
     IMGUI_API void              RenderText(ImDrawList* draw_list, float size, ImVec2 pos, ImU32 col, const ImVec4& clip_rect, const char* text_begin, const char* text_end, float wrap_width = 0.0f, bool cpu_fine_clip = false) const;
 
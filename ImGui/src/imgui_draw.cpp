@@ -441,6 +441,7 @@ void ImDrawList::_ClearFreeMemory()
     _ClipRectStack.clear();
     _TextureIdStack.clear();
     _Path.clear();
+    _TempBuffer.clear();
     _Splitter.ClearFreeMemory();
 }
 
@@ -717,6 +718,101 @@ void ImDrawList::PrimQuadUV(const ImVec2& a, const ImVec2& b, const ImVec2& c, c
 #define IM_FIXNORMAL2F_MAX_INVLEN2          100.0f // 500.0f (see #4053, #3366)
 #define IM_FIXNORMAL2F(VX,VY)               { float d2 = VX*VX + VY*VY; if (d2 > 0.000001f) { float inv_len2 = 1.0f / d2; if (inv_len2 > IM_FIXNORMAL2F_MAX_INVLEN2) inv_len2 = IM_FIXNORMAL2F_MAX_INVLEN2; VX *= inv_len2; VY *= inv_len2; } } (void)0
 
+#ifdef IMGUI_ENABLE_SSE
+// SSE2 versions of the per-point math of AddPolyline(), four points per iteration. They do the same IEEE operations in the same
+// order as the macros above, and _mm_rsqrt_ps gives the same approximation as the _mm_rsqrt_ss of ImRsqrt(), so the output
+// matches the scalar code bit for bit. Both return how many segments they did, a multiple of 4; the caller does the rest.
+
+// Split 4 consecutive ImVec2 into their x and y components.
+static inline void ImLoadVec2x4_SSE(const ImVec2* v, __m128& x, __m128& y)
+{
+    __m128 a = _mm_loadu_ps(&v[0].x);
+    __m128 b = _mm_loadu_ps(&v[2].x);
+    x = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+    y = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+}
+
+// Select a where mask is set, b elsewhere.
+static inline __m128 ImSelect_SSE(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+// normals[i] for the segments from points[i] to points[i + 1], see IM_NORMALIZE2F_OVER_ZERO()
+static int ImPolylineNormals_SSE(const ImVec2* points, int segment_count, ImVec2* normals)
+{
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    int i = 0;
+    for (; i + 4 <= segment_count; i += 4)
+    {
+        __m128 x1, y1, x2, y2;
+        ImLoadVec2x4_SSE(&points[i], x1, y1);
+        ImLoadVec2x4_SSE(&points[i + 1], x2, y2);
+        __m128 dx = _mm_sub_ps(x2, x1);
+        __m128 dy = _mm_sub_ps(y2, y1);
+        __m128 d2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+        __m128 normalize = _mm_cmpgt_ps(d2, zero);
+        __m128 inv_len = _mm_rsqrt_ps(d2);
+        dx = ImSelect_SSE(normalize, _mm_mul_ps(dx, inv_len), dx);
+        dy = ImSelect_SSE(normalize, _mm_mul_ps(dy, inv_len), dy);
+
+        // normal = (dy, -dx)
+        __m128 nx = dy;
+        __m128 ny = _mm_xor_ps(dx, sign);
+        _mm_storeu_ps(&normals[i].x, _mm_unpacklo_ps(nx, ny));
+        _mm_storeu_ps(&normals[i + 2].x, _mm_unpackhi_ps(nx, ny));
+    }
+    return i;
+}
+
+// For the segments from points[i] to points[i + 1], the edge points around points[i + 1]: out[(i + 1) * scale_count + k] is
+// points[i + 1] offset by scales[k] times the averaged and fixed-up normal, see IM_FIXNORMAL2F(). scale_count is 2 or 4.
+static int ImPolylineEdges_SSE(const ImVec2* points, const ImVec2* normals, int segment_count, const float* scales, int scale_count, ImVec2* out)
+{
+    IM_ASSERT(scale_count == 2 || scale_count == 4);
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 min_d2 = _mm_set1_ps(0.000001f);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 max_inv_len2 = _mm_set1_ps(IM_FIXNORMAL2F_MAX_INVLEN2);
+    int i = 0;
+    for (; i + 4 <= segment_count; i += 4)
+    {
+        __m128 n1x, n1y, n2x, n2y, px, py;
+        ImLoadVec2x4_SSE(&normals[i], n1x, n1y);
+        ImLoadVec2x4_SSE(&normals[i + 1], n2x, n2y);
+        ImLoadVec2x4_SSE(&points[i + 1], px, py);
+
+        // Average normals
+        __m128 dm_x = _mm_mul_ps(_mm_add_ps(n1x, n2x), half);
+        __m128 dm_y = _mm_mul_ps(_mm_add_ps(n1y, n2y), half);
+        __m128 d2 = _mm_add_ps(_mm_mul_ps(dm_x, dm_x), _mm_mul_ps(dm_y, dm_y));
+        __m128 fix = _mm_cmpgt_ps(d2, min_d2);
+        __m128 inv_len2 = _mm_min_ps(_mm_div_ps(one, d2), max_inv_len2);
+        dm_x = ImSelect_SSE(fix, _mm_mul_ps(dm_x, inv_len2), dm_x);
+        dm_y = ImSelect_SSE(fix, _mm_mul_ps(dm_y, inv_len2), dm_y);
+
+        // Offset points by each scale, then transpose from one register per coordinate to one register per point.
+        // (p + dm * -s is exactly p - dm * s, so the negative scales match the scalar subtractions)
+        for (int k = 0; k < scale_count; k += 2)
+        {
+            __m128 s0 = _mm_set1_ps(scales[k]);
+            __m128 s1 = _mm_set1_ps(scales[k + 1]);
+            __m128 r0 = _mm_add_ps(px, _mm_mul_ps(dm_x, s0));
+            __m128 r1 = _mm_add_ps(py, _mm_mul_ps(dm_y, s0));
+            __m128 r2 = _mm_add_ps(px, _mm_mul_ps(dm_x, s1));
+            __m128 r3 = _mm_add_ps(py, _mm_mul_ps(dm_y, s1));
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+            _mm_storeu_ps(&out[(i + 1) * scale_count + k].x, r0);
+            _mm_storeu_ps(&out[(i + 2) * scale_count + k].x, r1);
+            _mm_storeu_ps(&out[(i + 3) * scale_count + k].x, r2);
+            _mm_storeu_ps(&out[(i + 4) * scale_count + k].x, r3);
+        }
+    }
+    return i;
+}
+#endif // #ifdef IMGUI_ENABLE_SSE
+
 // TODO: Thickness anti-aliased lines cap are missing their AA fringe.
 // We avoid using the ImVec2 math operators here to reduce cost to a minimum for debug/non-inlined builds.
 void ImDrawList::AddPolyline(const ImVec2* points, const int points_count, ImU32 col, ImDrawFlags flags, float thickness)
@@ -754,11 +850,16 @@ void ImDrawList::AddPolyline(const ImVec2* points, const int points_count, ImU32
 
         // Temporary buffer
         // The first <points_count> items are normals at each line point, then after that there are either 2 or 4 temp points for each line point
-        ImVec2* temp_normals = (ImVec2*)alloca(points_count * ((use_texture || !thick_line) ? 3 : 5) * sizeof(ImVec2)); //-V630
+        _TempBuffer.reserve(points_count * ((use_texture || !thick_line) ? 3 : 5));
+        ImVec2* temp_normals = _TempBuffer.Data;
         ImVec2* temp_points = temp_normals + points_count;
 
         // Calculate normals (tangents) for each line segment
-        for (int i1 = 0; i1 < count; i1++)
+        int i1_start = 0;
+#ifdef IMGUI_ENABLE_SSE
+        i1_start = ImPolylineNormals_SSE(points, points_count - 1, temp_normals); // Every segment but the closing one
+#endif
+        for (int i1 = i1_start; i1 < count; i1++)
         {
             const int i2 = (i1 + 1) == points_count ? 0 : i1 + 1;
             float dx = points[i2].x - points[i1].x;
@@ -795,25 +896,33 @@ void ImDrawList::AddPolyline(const ImVec2* points, const int points_count, ImU32
             // Generate the indices to form a number of triangles for each line segment, and the vertices for the line edges
             // This takes points n and n+1 and writes into n+1, with the first point in a closed line being generated from the final one (as n+1 wraps)
             // FIXME-OPT: Merge the different loops, possibly remove the temporary buffer.
+            int i1_simd_end = 0; // Segments whose outer edges the SIMD path already wrote
+#ifdef IMGUI_ENABLE_SSE
+            const float edge_scales[2] = { half_draw_size, -half_draw_size };
+            i1_simd_end = ImPolylineEdges_SSE(points, temp_normals, points_count - 1, edge_scales, 2, temp_points);
+#endif
             unsigned int idx1 = _VtxCurrentIdx; // Vertex index for start of line segment
             for (int i1 = 0; i1 < count; i1++) // i1 is the first point of the line segment
             {
                 const int i2 = (i1 + 1) == points_count ? 0 : i1 + 1; // i2 is the second point of the line segment
                 const unsigned int idx2 = ((i1 + 1) == points_count) ? _VtxCurrentIdx : (idx1 + (use_texture ? 2 : 3)); // Vertex index for end of segment
 
-                // Average normals
-                float dm_x = (temp_normals[i1].x + temp_normals[i2].x) * 0.5f;
-                float dm_y = (temp_normals[i1].y + temp_normals[i2].y) * 0.5f;
-                IM_FIXNORMAL2F(dm_x, dm_y);
-                dm_x *= half_draw_size; // dm_x, dm_y are offset to the outer edge of the AA area
-                dm_y *= half_draw_size;
-
-                // Add temporary vertexes for the outer edges
-                ImVec2* out_vtx = &temp_points[i2 * 2];
-                out_vtx[0].x = points[i2].x + dm_x;
-                out_vtx[0].y = points[i2].y + dm_y;
-                out_vtx[1].x = points[i2].x - dm_x;
-                out_vtx[1].y = points[i2].y - dm_y;
+                if (i1 >= i1_simd_end)
+                {
+                    // Average normals
+                    float dm_x = (temp_normals[i1].x + temp_normals[i2].x) * 0.5f;
+                    float dm_y = (temp_normals[i1].y + temp_normals[i2].y) * 0.5f;
+                    IM_FIXNORMAL2F(dm_x, dm_y);
+                    dm_x *= half_draw_size; // dm_x, dm_y are offset to the outer edge of the AA area
+                    dm_y *= half_draw_size;
+
+                    // Add temporary vertexes for the outer edges
+                    ImVec2* out_vtx = &temp_points[i2 * 2];
+                    out_vtx[0].x = points[i2].x + dm_x;
+                    out_vtx[0].y = points[i2].y + dm_y;
+                    out_vtx[1].x = points[i2].x - dm_x;
+                    out_vtx[1].y = points[i2].y - dm_y;
+                }
 
                 if (use_texture)
                 {
@@ -891,31 +1000,39 @@ void ImDrawList::AddPolyline(const ImVec2* points, const int points_count, ImU32
             // Generate the indices to form a number of triangles for each line segment, and the vertices for the line edges
             // This takes points n and n+1 and writes into n+1, with the first point in a closed line being generated from the final one (as n+1 wraps)
             // FIXME-OPT: Merge the different loops, possibly remove the temporary buffer.
+            int i1_simd_end = 0; // Segments whose edges the SIMD path already wrote
+#ifdef IMGUI_ENABLE_SSE
+            const float edge_scales[4] = { half_inner_thickness + AA_SIZE, half_inner_thickness, -half_inner_thickness, -(half_inner_thickness + AA_SIZE) };
+            i1_simd_end = ImPolylineEdges_SSE(points, temp_normals, points_count - 1, edge_scales, 4, temp_points);
+#endif
             unsigned int idx1 = _VtxCurrentIdx; // Vertex index for start of line segment
             for (int i1 = 0; i1 < count; i1++) // i1 is the first point of the line segment
             {
                 const int i2 = (i1 + 1) == points_count ? 0 : (i1 + 1); // i2 is the second point of the line segment
                 const unsigned int idx2 = (i1 + 1) == points_count ? _VtxCurrentIdx : (idx1 + 4); // Vertex index for end of segment
 
-                // Average normals
-                float dm_x = (temp_normals[i1].x + temp_normals[i2].x) * 0.5f;
-                float dm_y = (temp_normals[i1].y + temp_normals[i2].y) * 0.5f;
-                IM_FIXNORMAL2F(dm_x, dm_y);
-                float dm_out_x = dm_x * (half_inner_thickness + AA_SIZE);
-                float dm_out_y = dm_y * (half_inner_thickness + AA_SIZE);
-                float dm_in_x = dm_x * half_inner_thickness;
-                float dm_in_y = dm_y * half_inner_thickness;
-
-                // Add temporary vertices
-                ImVec2* out_vtx = &temp_points[i2 * 4];
-                out_vtx[0].x = points[i2].x + dm_out_x;
-                out_vtx[0].y = points[i2].y + dm_out_y;
-                out_vtx[1].x = points[i2].x + dm_in_x;
-                out_vtx[1].y = points[i2].y + dm_in_y;
-                out_vtx[2].x = points[i2].x - dm_in_x;
-                out_vtx[2].y = points[i2].y - dm_in_y;
-                out_vtx[3].x = points[i2].x - dm_out_x;
-                out_vtx[3].y = points[i2].y - dm_out_y;
+                if (i1 >= i1_simd_end)
+                {
+                    // Average normals
+                    float dm_x = (temp_normals[i1].x + temp_normals[i2].x) * 0.5f;
+                    float dm_y = (temp_normals[i1].y + temp_normals[i2].y) * 0.5f;
+                    IM_FIXNORMAL2F(dm_x, dm_y);
+                    float dm_out_x = dm_x * (half_inner_thickness + AA_SIZE);
+                    float dm_out_y = dm_y * (half_inner_thickness + AA_SIZE);
+                    float dm_in_x = dm_x * half_inner_thickness;
+                    float dm_in_y = dm_y * half_inner_thickness;
+
+                    // Add temporary vertices
+                    ImVec2* out_vtx = &temp_points[i2 * 4];
+                    out_vtx[0].x = points[i2].x + dm_out_x;
+                    out_vtx[0].y = points[i2].y + dm_out_y;
+                    out_vtx[1].x = points[i2].x + dm_in_x;
+                    out_vtx[1].y = points[i2].y + dm_in_y;
+                    out_vtx[2].x = points[i2].x - dm_in_x;
+                    out_vtx[2].y = points[i2].y - dm_in_y;
+                    out_vtx[3].x = points[i2].x - dm_out_x;
+                    out_vtx[3].y = points[i2].y - dm_out_y;
+                }
 
                 // Add indexes
                 _IdxWritePtr[0]  = (ImDrawIdx)(idx2 + 1); _IdxWritePtr[1]  = (ImDrawIdx)(idx1 + 1); _IdxWritePtr[2]  = (ImDrawIdx)(idx1 + 2);
@@ -1001,7 +1118,8 @@ void ImDrawList::AddConvexPolyFilled(const ImVec2* points, const int points_coun
         }
 
         // Compute normals
-        ImVec2* temp_normals = (ImVec2*)alloca(points_count * sizeof(ImVec2)); //-V630
+        _TempBuffer.reserve(points_count);
+        ImVec2* temp_normals = _TempBuffer.Data;
         for (int i0 = points_count - 1, i1 = 0; i1 < points_count; i0 = i1++)
         {
             const ImVec2& p0 = points[i0];
@@ -1975,6 +2093,7 @@ ImFontAtlas::ImFontAtlas()
 {
     memset(this, 0, sizeof(*this));
     TexGlyphPadding = 1;
+    GlyphCachePageSize = 256;
     PackIdMouseCursors = PackIdLines = -1;
 }
 
@@ -2003,6 +2122,7 @@ void    ImFontAtlas::ClearInputData()
         }
     ConfigData.clear();
     CustomRects.clear();
+    GlyphCachePages.clear();
     PackIdMouseCursors = PackIdLines = -1;
     TexReady = false;
 }
@@ -2017,6 +2137,7 @@ void    ImFontAtlas::ClearTexData()
     TexPixelsAlpha8 = NULL;
     TexPixelsRGBA32 = NULL;
     TexPixelsUseColors = false;
+    TexDirtyRects.clear();
     // Important: we leave TexReady untouched
 }
 
@@ -2340,11 +2461,462 @@ static void UnpackBitVectorToFlatIndexList(const ImBitVector* in, ImVector<int>*
                     out->push_back((int)(((it - it_begin) << 5) + bit_n));
 }
 
+// Rasterizing a batch of glyphs of one source font into their packed rectangles.
+// Batches write to disjoint parts of the texture, so they may run concurrently through atlas->BuildJobsFn.
+struct ImFontBuildRasterJob
+{
+    ImFontBuildSrcData* Src;
+    float               RasterizerMultiply;
+    int                 GlyphStart;
+    int                 GlyphCount;
+};
+
+struct ImFontBuildRasterJobs
+{
+    const stbtt_pack_context*       PackContext;
+    ImVector<ImFontBuildRasterJob>  Jobs;
+};
+
+static void ImFontAtlasBuildRasterizeJob(void* job_data, int index)
+{
+    const ImFontBuildRasterJobs* jobs = (const ImFontBuildRasterJobs*)job_data;
+    const ImFontBuildRasterJob& job = jobs->Jobs[index];
+    ImFontBuildSrcData& src_tmp = *job.Src;
+
+    // stb_truetype writes the oversampling into the pack context while rendering, so every job renders with its own copy
+    stbtt_pack_context spc = *jobs->PackContext;
+    stbtt_pack_range range = src_tmp.PackRange;
+    range.array_of_unicode_codepoints += job.GlyphStart;
+    range.chardata_for_range += job.GlyphStart;
+    range.num_chars = job.GlyphCount;
+    stbrp_rect* rects = src_tmp.Rects + job.GlyphStart;
+    stbtt_PackFontRangesRenderIntoRects(&spc, &src_tmp.FontInfo, &range, 1, rects);
+
+    // Apply multiply operator
+    if (job.RasterizerMultiply != 1.0f)
+    {
+        unsigned char multiply_table[256];
+        ImFontAtlasBuildMultiplyCalcLookupTable(multiply_table, job.RasterizerMultiply);
+        stbrp_rect* r = rects;
+        for (int glyph_i = 0; glyph_i < job.GlyphCount; glyph_i++, r++)
+            if (r->was_packed)
+                ImFontAtlasBuildMultiplyRectAlpha8(multiply_table, spc.pixels, r->x, r->y, r->w, r->h, spc.stride_in_bytes);
+    }
+}
+
+// Build cache (atlas->BuildCacheFilename)
+// The file holds everything steps 1-9 of ImFontAtlasBuildWithStbTruetype() produce: the packed custom rectangles, the texture with the
+// rasterized glyphs, and the arguments of every SetupFont/AddGlyph call. It is only loaded back when its key matches byte for byte:
+// the key holds every input of those steps, with the font data reduced to its size and hash. Values are stored in native byte order.
+static const ImU32 FONT_ATLAS_BUILD_CACHE_MAGIC = 0x43465449; // "ITFC"
+static const ImU32 FONT_ATLAS_BUILD_CACHE_VERSION = 1;        // Increase when the format or the output of the builder changes
+
+struct ImFontBuildCacheHeader
+{
+    ImU32               Magic;
+    ImU32               Version;
+    int                 KeySize;
+    int                 TexWidth;
+    int                 TexHeight;
+    int                 CustomRectsCount;
+    int                 SrcCount;
+    int                 GlyphsCount;
+};
+
+struct ImFontBuildCacheSrc
+{
+    int                 GlyphsCount;
+    float               Ascent;
+    float               Descent;
+
+    ImFontBuildCacheSrc() { GlyphsCount = 0; Ascent = Descent = 0.0f; }
+};
+
+struct ImFontBuildCacheGlyph
+{
+    ImU32               Codepoint;
+    float               X0, Y0, X1, Y1;
+    float               U0, V0, U1, V1;
+    float               AdvanceX;
+};
+
+template<typename T>
+static void ImFontAtlasBuildCacheAppend(ImVector<char>* buf, const T* data, int count)
+{
+    const int size = (int)sizeof(T) * count;
+    buf->resize(buf->Size + size);
+    if (size > 0)
+        memcpy(buf->Data + buf->Size - size, data, (size_t)size);
+}
+
+static void ImFontAtlasBuildCacheKey(ImFontAtlas* atlas, ImVector<ImFontBuildSrcData>& src_tmp_array, ImVector<char>* out_key)
+{
+    ImFontAtlasBuildCacheAppend(out_key, &atlas->Flags, 1);
+    ImFontAtlasBuildCacheAppend(out_key, &atlas->TexDesiredWidth, 1);
+    ImFontAtlasBuildCacheAppend(out_key, &atlas->TexGlyphPadding, 1);
+    ImFontAtlasBuildCacheAppend(out_key, &atlas->CustomRects.Size, 1);
+    for (int i = 0; i < atlas->CustomRects.Size; i++)
+    {
+        ImFontAtlasBuildCacheAppend(out_key, &atlas->CustomRects[i].Width, 1);
+        ImFontAtlasBuildCacheAppend(out_key, &atlas->CustomRects[i].Height, 1);
+    }
+    ImFontAtlasBuildCacheAppend(out_key, &src_tmp_array.Size, 1);
+    for (int src_i = 0; src_i < src_tmp_array.Size; src_i++)
+    {
+        const ImFontBuildSrcData& src_tmp = src_tmp_array[src_i];
+        const ImFontConfig& cfg = atlas->ConfigData[src_i];
+        const ImU32 font_data_hash = ImHashData(cfg.FontData, (size_t)cfg.FontDataSize);
+        ImFontAtlasBuildCacheAppend(out_key, &cfg.FontDataSize, 1);
+        ImFontAtlasBuildCacheAppend(out_key, &font_data_hash, 1);
+        ImFontAtlasBuildCacheAppend(out_key, &cfg.FontNo, 1);
+        ImFontAtlasBuildCacheAppend(out_key, &cfg.SizePixels, 1);
+        ImFontAtlasBuildCacheAppend(out_key, &cfg.OversampleH, 1);
+        ImFontAtlasBuildCacheAppend(out_key, &cfg.OversampleV, 1);
+        ImFontAtlasBuildCacheAppend(out_key, &cfg.GlyphOffset, 1);
+        ImFontAtlasBuildCacheAppend(out_key, &cfg.RasterizerMultiply, 1);
+        ImFontAtlasBuildCacheAppend(out_key, &cfg.MergeMode, 1);
+        ImFontAtlasBuildCacheAppend(out_key, &src_tmp.DstIndex, 1);
+        int ranges_count = 0;
+        while (src_tmp.SrcRanges[ranges_count] && src_tmp.SrcRanges[ranges_count + 1])
+            ranges_count += 2;
+        ImFontAtlasBuildCacheAppend(out_key, &ranges_count, 1);
+        ImFontAtlasBuildCacheAppend(out_key, src_tmp.SrcRanges, ranges_count);
+    }
+    while (out_key->Size % 4 != 0) // Keep the data after the key aligned
+        out_key->push_back(0);
+}
+
+static bool ImFontAtlasBuildLoadCache(ImFontAtlas* atlas, const ImVector<char>& key)
+{
+    size_t file_size = 0;
+    char* file_data = (char*)ImFileLoadToMemory(atlas->BuildCacheFilename, "rb", &file_size);
+    if (file_data == NULL)
+        return false;
+
+    // Validate everything before touching the atlas, so a stale, truncated or foreign file only costs the read
+    ImFontBuildCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    if (file_size >= sizeof(header))
+        memcpy(&header, file_data, sizeof(header));
+    bool valid = header.Magic == FONT_ATLAS_BUILD_CACHE_MAGIC && header.Version == FONT_ATLAS_BUILD_CACHE_VERSION && header.KeySize == key.Size
+        && header.CustomRectsCount == atlas->CustomRects.Size && header.SrcCount == atlas->ConfigData.Size
+        && header.TexWidth > 0 && header.TexHeight > 0 && header.GlyphsCount >= 0;
+    if (valid)
+        valid = file_size == sizeof(header) + (size_t)key.Size + sizeof(unsigned short) * 2 * header.CustomRectsCount + sizeof(ImFontBuildCacheSrc) * header.SrcCount
+            + sizeof(ImFontBuildCacheGlyph) * header.GlyphsCount + (size_t)header.TexWidth * header.TexHeight;
+    if (valid)
+        valid = memcmp(file_data + sizeof(header), key.Data, (size_t)key.Size) == 0;
+    if (!valid)
+    {
+        IM_FREE(file_data);
+        return false;
+    }
+    const unsigned short* rects_data = (const unsigned short*)(file_data + sizeof(header) + key.Size);
+    const ImFontBuildCacheSrc* srcs_data = (const ImFontBuildCacheSrc*)(rects_data + header.CustomRectsCount * 2);
+    const ImFontBuildCacheGlyph* glyphs_data = (const ImFontBuildCacheGlyph*)(srcs_data + header.SrcCount);
+    const unsigned char* pixels_data = (const unsigned char*)(glyphs_data + header.GlyphsCount);
+    int glyphs_total = 0;
+    for (int src_i = 0; src_i < header.SrcCount; src_i++)
+        glyphs_total += ImMax(srcs_data[src_i].GlyphsCount, 0);
+    if (glyphs_total != header.GlyphsCount)
+    {
+        IM_FREE(file_data);
+        return false;
+    }
+
+    // Restore the state steps 1-9 leave behind
+    atlas->TexWidth = header.TexWidth;
+    atlas->TexHeight = header.TexHeight;
+    atlas->TexUvScale = ImVec2(1.0f / atlas->TexWidth, 1.0f / atlas->TexHeight);
+    atlas->TexPixelsAlpha8 = (unsigned char*)IM_ALLOC(atlas->TexWidth * atlas->TexHeight);
+    memcpy(atlas->TexPixelsAlpha8, pixels_data, (size_t)atlas->TexWidth * atlas->TexHeight);
+    for (int i = 0; i < atlas->CustomRects.Size; i++)
+    {
+        atlas->CustomRects[i].X = rects_data[i * 2 + 0];
+        atlas->CustomRects[i].Y = rects_data[i * 2 + 1];
+    }
+    const ImFontBuildCacheGlyph* glyph = glyphs_data;
+    for (int src_i = 0; src_i < header.SrcCount; src_i++)
+    {
+        const ImFontBuildCacheSrc& src = srcs_data[src_i];
+        if (src.GlyphsCount == 0)
+            continue;
+        ImFontConfig& cfg = atlas->ConfigData[src_i];
+        ImFont* dst_font = cfg.DstFont;
+        ImFontAtlasBuildSetupFont(atlas, dst_font, &cfg, src.Ascent, src.Descent);
+        dst_font->Glyphs.reserve(dst_font->Glyphs.Size + src.GlyphsCount);
+        for (int glyph_i = 0; glyph_i < src.GlyphsCount; glyph_i++, glyph++)
+            dst_font->AddGlyph(&cfg, (ImWchar)glyph->Codepoint, glyph->X0, glyph->Y0, glyph->X1, glyph->Y1, glyph->U0, glyph->V0, glyph->U1, glyph->V1, glyph->AdvanceX);
+    }
+
+    IM_FREE(file_data);
+    return true;
+}
+
+static void ImFontAtlasBuildSaveCache(ImFontAtlas* atlas, const ImVector<char>& key, const ImVector<ImFontBuildCacheSrc>& srcs, const ImVector<ImFontBuildCacheGlyph>& glyphs)
+{
+    ImFileHandle f = ImFileOpen(atlas->BuildCacheFilename, "wb");
+    if (!f)
+        return;
+
+    ImFontBuildCacheHeader header;
+    header.Magic = FONT_ATLAS_BUILD_CACHE_MAGIC;
+    header.Version = FONT_ATLAS_BUILD_CACHE_VERSION;
+    header.KeySize = key.Size;
+    header.TexWidth = atlas->TexWidth;
+    header.TexHeight = atlas->TexHeight;
+    header.CustomRectsCount = atlas->CustomRects.Size;
+    header.SrcCount = srcs.Size;
+    header.GlyphsCount = glyphs.Size;
+
+    ImVector<char> buf;
+    buf.reserve((int)sizeof(header) + key.Size + atlas->CustomRects.Size * 4 + srcs.size_in_bytes() + glyphs.size_in_bytes());
+    ImFontAtlasBuildCacheAppend(&buf, &header, 1);
+    ImFontAtlasBuildCacheAppend(&buf, key.Data, key.Size);
+    for (int i = 0; i < atlas->CustomRects.Size; i++)
+    {
+        ImFontAtlasBuildCacheAppend(&buf, &atlas->CustomRects[i].X, 1);
+        ImFontAtlasBuildCacheAppend(&buf, &atlas->CustomRects[i].Y, 1);
+    }
+    ImFontAtlasBuildCacheAppend(&buf, srcs.Data, srcs.Size);
+    ImFontAtlasBuildCacheAppend(&buf, glyphs.Data, glyphs.Size);
+
+    // A partially written file fails the size check on load
+    ImFileWrite(buf.Data, 1, (ImU64)buf.Size, f);
+    ImFileWrite(atlas->TexPixelsAlpha8, 1, (ImU64)atlas->TexWidth * atlas->TexHeight, f);
+    ImFileClose(f);
+}
+
+// Glyph cache (ImFontConfig::DynamicGlyphs, ImFontAtlas::GlyphCachePageCount)
+// - Build() reserves the pages as custom rectangles, so they are packed and cached with the rest of the texture.
+// - A missing codepoint is rasterized into the current row of the first page with room for it, exactly like Build() would have
+//   rasterized it, and its region is added to atlas->TexDirtyRects.
+// - When no page has room, the least recently used page is emptied: its glyphs are removed from their fonts, to be rasterized again
+//   when they are looked up next. Pages used during the current frame are never emptied, as draw lists already point into them.
+static void ImFontAtlasBuildRegisterGlyphCachePages(ImFontAtlas* atlas)
+{
+    if (atlas->GlyphCachePages.Size > 0 || atlas->GlyphCachePageCount <= 0)
+        return;
+    IM_ASSERT(atlas->GlyphCachePageSize > 0 && atlas->GlyphCachePageSize <= 0xFFFF);
+    for (int page_i = 0; page_i < atlas->GlyphCachePageCount; page_i++)
+    {
+        ImFontGlyphCachePage page;
+        memset(&page, 0, sizeof(page));
+        page.PackId = atlas->AddCustomRectRegular(atlas->GlyphCachePageSize, atlas->GlyphCachePageSize);
+        atlas->GlyphCachePages.push_back(page);
+    }
+}
+
+static void ImFontAtlasGlyphCacheEmptyPage(ImFontAtlas* atlas, int page_i)
+{
+    // Remove the glyphs of the page, keeping the order of the others
+    for (int font_i = 0; font_i < atlas->Fonts.Size; font_i++)
+    {
+        ImFont* font = atlas->Fonts[font_i];
+        if (!font->DynamicGlyphs)
+            continue;
+        int dst_i = font->GlyphCacheStart;
+        for (int src_i = font->GlyphCacheStart; src_i < font->GlyphCacheStart + font->GlyphCachePageOf.Size; src_i++)
+        {
+            const ImFontGlyph glyph = font->Glyphs[src_i];
+            const unsigned short glyph_page_i = font->GlyphCachePageOf[src_i - font->GlyphCacheStart];
+            if (glyph_page_i == page_i)
+            {
+                font->IndexLookup[glyph.Codepoint] = (ImWchar)-1;
+                font->IndexAdvanceX[glyph.Codepoint] = -1.0f;
+                continue;
+            }
+            font->Glyphs[dst_i] = glyph;
+            font->GlyphCachePageOf[dst_i - font->GlyphCacheStart] = glyph_page_i;
+            font->IndexLookup[glyph.Codepoint] = (ImWchar)dst_i;
+            dst_i++;
+        }
+        const int removed_count = font->GlyphCachePageOf.Size - (dst_i - font->GlyphCacheStart);
+        if (removed_count > 0)
+            font->Glyphs.erase(font->Glyphs.Data + dst_i, font->Glyphs.Data + dst_i + removed_count);
+        font->GlyphCachePageOf.resize(dst_i - font->GlyphCacheStart);
+    }
+
+    // The pixels are left as they are: every glyph clears its own region first
+    ImFontGlyphCachePage& page = atlas->GlyphCachePages[page_i];
+    page.CursorX = page.RowY = page.RowHeight = 0;
+    page.GlyphsCount = 0;
+}
+
+// Find room for a w*h rectangle, which includes the padding on its left and top like the rectangles packed by Build().
+// Returns the page index and the position in the texture, or -1 when every page that is full was used during the current frame.
+static int ImFontAtlasGlyphCacheAlloc(ImFontAtlas* atlas, int w, int h, int* out_x, int* out_y)
+{
+    // Glyphs also stay clear of the right and bottom edges of a page by the padding, as the next rectangle of the texture may not start with any
+    const int page_size = atlas->GlyphCachePageSize;
+    const int pad = atlas->TexGlyphPadding;
+    int lru_page_i = -1;
+    for (int page_i = 0; page_i < atlas->GlyphCachePages.Size; page_i++)
+    {
+        ImFontGlyphCachePage& page = atlas->GlyphCachePages[page_i];
+        const ImFontAtlasCustomRect* r = atlas->GetCustomRectByIndex(page.PackId);
+        if (!r->IsPacked())
+            continue;
+        int x = page.CursorX, y = page.RowY, row_height = page.RowHeight;
+        if (x + w + pad > page_size)
+        {
+            x = 0;
+            y += row_height;
+            row_height = 0;
+        }
+        if (y + h + pad <= page_size)
+        {
+            page.CursorX = (unsigned short)(x + w);
+            page.RowY = (unsigned short)y;
+            page.RowHeight = (unsigned short)ImMax(row_height, h);
+            *out_x = r->X + x;
+            *out_y = r->Y + y;
+            return page_i;
+        }
+        if (page.LastUsedFrame != atlas->GlyphCacheFrame && (lru_page_i == -1 || page.LastUsedFrame < atlas->GlyphCachePages[lru_page_i].LastUsedFrame))
+            lru_page_i = page_i;
+    }
+    if (lru_page_i == -1)
+        return -1;
+
+    ImFontAtlasGlyphCacheEmptyPage(atlas, lru_page_i);
+    ImFontGlyphCachePage& page = atlas->GlyphCachePages[lru_page_i];
+    const ImFontAtlasCustomRect* r = atlas->GetCustomRectByIndex(page.PackId);
+    page.CursorX = (unsigned short)w;
+    page.RowHeight = (unsigned short)h;
+    *out_x = r->X;
+    *out_y = r->Y;
+    return lru_page_i;
+}
+
+// Rasterize a codepoint missing from 'font' from the first of its ImFontConfig::DynamicGlyphs sources that has it, and add it to the font.
+// Returns NULL when no source has it or it is larger than a page: it is then marked as looked up, and draws as FallbackChar until the
+// next Build(). Also returns NULL without marking it when every page is in use during the current frame, so it is tried again later.
+static const ImFontGlyph* ImFontAtlasGlyphCacheAdd(ImFontAtlas* atlas, ImFont* font, ImWchar codepoint)
+{
+    ImFontConfig* cfg = NULL;
+    stbtt_fontinfo font_info;
+    int glyph_index_in_font = 0;
+    if (atlas->TexPixelsAlpha8 != NULL && font->Glyphs.Size < 0xFFFE && font->Glyphs.Size == font->GlyphCacheStart + font->GlyphCachePageOf.Size)
+        for (int src_i = 0; src_i < atlas->ConfigData.Size && cfg == NULL; src_i++)
+        {
+            ImFontConfig& src_cfg = atlas->ConfigData[src_i];
+            if (src_cfg.DstFont != font || !src_cfg.DynamicGlyphs || src_cfg.FontData == NULL)
+                continue;
+            const int font_offset = stbtt_GetFontOffsetForIndex((unsigned char*)src_cfg.FontData, src_cfg.FontNo);
+            if (font_offset < 0 || !stbtt_InitFont(&font_info, (unsigned char*)src_cfg.FontData, font_offset))
+                continue;
+            glyph_index_in_font = stbtt_FindGlyphIndex(&font_info, codepoint);
+            if (glyph_index_in_font != 0)
+                cfg = &src_cfg;
+        }
+
+    // Measure (see step 4 of ImFontAtlasBuildWithStbTruetype)
+    const int pad = atlas->TexGlyphPadding;
+    int w = 0, h = 0;
+    if (cfg != NULL)
+    {
+        int x0, y0, x1, y1;
+        const float scale = (cfg->SizePixels > 0) ? stbtt_ScaleForPixelHeight(&font_info, cfg->SizePixels) : stbtt_ScaleForMappingEmToPixels(&font_info, -cfg->SizePixels);
+        stbtt_GetGlyphBitmapBoxSubpixel(&font_info, glyph_index_in_font, scale * cfg->OversampleH, scale * cfg->OversampleV, 0, 0, &x0, &y0, &x1, &y1);
+        w = x1 - x0 + pad + cfg->OversampleH - 1;
+        h = y1 - y0 + pad + cfg->OversampleV - 1;
+    }
+    if (cfg == NULL || w + pad > atlas->GlyphCachePageSize || h + pad > atlas->GlyphCachePageSize)
+    {
+        font->GrowIndex((int)codepoint + 1);
+        font->IndexAdvanceX[codepoint] = font->FallbackAdvanceX;
+        return NULL;
+    }
+
+    int x, y;
+    const int page_i = ImFontAtlasGlyphCacheAlloc(atlas, w, h, &x, &y);
+    if (page_i == -1)
+        return NULL;
+
+    // Clear what an earlier glyph of the page may have left, including the padding on the right and bottom
+    const int tex_w = atlas->TexWidth;
+    for (int row = 0; row < h + pad; row++)
+        memset(atlas->TexPixelsAlpha8 + x + (y + row) * tex_w, 0, (size_t)(w + pad));
+
+    // Render (see step 8)
+    stbtt_pack_context spc;
+    memset(&spc, 0, sizeof(spc));
+    spc.width = tex_w;
+    spc.height = atlas->TexHeight;
+    spc.stride_in_bytes = tex_w;
+    spc.padding = pad;
+    spc.h_oversample = spc.v_oversample = 1;
+    spc.pixels = atlas->TexPixelsAlpha8;
+    int codepoint_in_range = (int)codepoint;
+    stbtt_packedchar pc;
+    stbtt_pack_range range;
+    memset(&range, 0, sizeof(range));
+    range.font_size = cfg->SizePixels;
+    range.array_of_unicode_codepoints = &codepoint_in_range;
+    range.num_chars = 1;
+    range.chardata_for_range = &pc;
+    range.h_oversample = (unsigned char)cfg->OversampleH;
+    range.v_oversample = (unsigned char)cfg->OversampleV;
+    stbrp_rect rect;
+    memset(&rect, 0, sizeof(rect));
+    rect.x = (stbrp_coord)x;
+    rect.y = (stbrp_coord)y;
+    rect.w = (stbrp_coord)w;
+    rect.h = (stbrp_coord)h;
+    rect.was_packed = 1;
+    stbtt_PackFontRangesRenderIntoRects(&spc, &font_info, &range, 1, &rect);
+    if (cfg->RasterizerMultiply != 1.0f)
+    {
+        unsigned char multiply_table[256];
+        ImFontAtlasBuildMultiplyCalcLookupTable(multiply_table, cfg->RasterizerMultiply);
+        ImFontAtlasBuildMultiplyRectAlpha8(multiply_table, atlas->TexPixelsAlpha8, rect.x, rect.y, rect.w, rect.h, tex_w);
+    }
+
+    // Keep the RGBA32 copy made by GetTexDataAsRGBA32() in sync, and queue the upload
+    if (atlas->TexPixelsRGBA32 != NULL)
+        for (int row = 0; row < h + pad; row++)
+        {
+            const unsigned char* src = atlas->TexPixelsAlpha8 + x + (y + row) * tex_w;
+            unsigned int* dst = atlas->TexPixelsRGBA32 + x + (y + row) * tex_w;
+            for (int n = 0; n < w + pad; n++)
+                dst[n] = IM_COL32(255, 255, 255, (unsigned int)src[n]);
+        }
+    ImFontAtlasRect dirty_rect = { (unsigned short)x, (unsigned short)y, (unsigned short)(w + pad), (unsigned short)(h + pad) };
+    atlas->TexDirtyRects.push_back(dirty_rect);
+
+    // Register (see step 9). The lookup tables are updated here, so they don't need to be built again.
+    stbtt_aligned_quad q;
+    float unused_x = 0.0f, unused_y = 0.0f;
+    stbtt_GetPackedQuad(&pc, atlas->TexWidth, atlas->TexHeight, 0, &unused_x, &unused_y, &q, 0);
+    const float font_off_x = cfg->GlyphOffset.x;
+    const float font_off_y = cfg->GlyphOffset.y + IM_ROUND(font->Ascent);
+    const ImFontGlyph* old_glyphs = font->Glyphs.Data;
+    const bool dirty_lookup_tables = font->DirtyLookupTables;
+    font->AddGlyph(cfg, codepoint, q.x0 + font_off_x, q.y0 + font_off_y, q.x1 + font_off_x, q.y1 + font_off_y, q.s0, q.t0, q.s1, q.t1, pc.xadvance);
+    font->DirtyLookupTables = dirty_lookup_tables;
+    if (font->FallbackGlyph != NULL && font->Glyphs.Data != old_glyphs)
+        font->FallbackGlyph = font->Glyphs.Data + (font->FallbackGlyph - old_glyphs);
+    const ImFontGlyph* glyph = &font->Glyphs.back();
+    font->GrowIndex((int)codepoint + 1);
+    font->IndexAdvanceX[codepoint] = glyph->AdvanceX;
+    font->IndexLookup[codepoint] = (ImWchar)(font->Glyphs.Size - 1);
+    const int page_n = (int)codepoint / 4096;
+    font->Used4kPagesMap[page_n >> 3] |= 1 << (page_n & 7);
+    font->GlyphCachePageOf.push_back((unsigned short)page_i);
+
+    ImFontGlyphCachePage& page = atlas->GlyphCachePages[page_i];
+    page.GlyphsCount++;
+    page.LastUsedFrame = atlas->GlyphCacheFrame;
+    return glyph;
+}
+
 static bool ImFontAtlasBuildWithStbTruetype(ImFontAtlas* atlas)
 {
     IM_ASSERT(atlas->ConfigData.Size > 0);
 
     ImFontAtlasBuildInit(atlas);
+    ImFontAtlasBuildRegisterGlyphCachePages(atlas);
 
     // Clear atlas
     atlas->TexID = (ImTextureID)NULL;
@@ -2393,6 +2965,19 @@ static bool ImFontAtlasBuildWithStbTruetype(ImFontAtlas* atlas)
         dst_tmp.GlyphsHighest = ImMax(dst_tmp.GlyphsHighest, src_tmp.GlyphsHighest);
     }
 
+    // Load the output of steps 2-9 from the build cache if it was saved with the same inputs
+    ImVector<char> cache_key;
+    if (atlas->BuildCacheFilename)
+    {
+        ImFontAtlasBuildCacheKey(atlas, src_tmp_array, &cache_key);
+        if (ImFontAtlasBuildLoadCache(atlas, cache_key))
+        {
+            src_tmp_array.clear_destruct();
+            ImFontAtlasBuildFinish(atlas);
+            return true;
+        }
+    }
+
     // 2. For every requested codepoint, check for their presence in the font data, and handle redundancy or overlaps between source fonts to avoid unused glyphs.
     int total_glyphs_count = 0;
     for (int src_i = 0; src_i < src_tmp_array.Size; src_i++)
@@ -2523,34 +3108,45 @@ static bool ImFontAtlasBuildWithStbTruetype(ImFontAtlas* atlas)
     spc.pixels = atlas->TexPixelsAlpha8;
     spc.height = atlas->TexHeight;
 
-    // 8. Render/rasterize font characters into the texture
+    // 8. Render/rasterize font characters into the texture, in batches of glyphs that may run concurrently through atlas->BuildJobsFn
+    // (Batches are small enough to spread the work of large ranges across threads, and large enough to keep the overhead per job low)
+    const int GLYPHS_PER_JOB = 64;
+    ImFontBuildRasterJobs raster_jobs;
+    raster_jobs.PackContext = &spc;
     for (int src_i = 0; src_i < src_tmp_array.Size; src_i++)
     {
-        ImFontConfig& cfg = atlas->ConfigData[src_i];
         ImFontBuildSrcData& src_tmp = src_tmp_array[src_i];
-        if (src_tmp.GlyphsCount == 0)
-            continue;
-
-        stbtt_PackFontRangesRenderIntoRects(&spc, &src_tmp.FontInfo, &src_tmp.PackRange, 1, src_tmp.Rects);
-
-        // Apply multiply operator
-        if (cfg.RasterizerMultiply != 1.0f)
+        for (int glyph_start = 0; glyph_start < src_tmp.GlyphsCount; glyph_start += GLYPHS_PER_JOB)
         {
-            unsigned char multiply_table[256];
-            ImFontAtlasBuildMultiplyCalcLookupTable(multiply_table, cfg.RasterizerMultiply);
-            stbrp_rect* r = &src_tmp.Rects[0];
-            for (int glyph_i = 0; glyph_i < src_tmp.GlyphsCount; glyph_i++, r++)
-                if (r->was_packed)
-                    ImFontAtlasBuildMultiplyRectAlpha8(multiply_table, atlas->TexPixelsAlpha8, r->x, r->y, r->w, r->h, atlas->TexWidth * 1);
+            ImFontBuildRasterJob job;
+            job.Src = &src_tmp;
+            job.RasterizerMultiply = atlas->ConfigData[src_i].RasterizerMultiply;
+            job.GlyphStart = glyph_start;
+            job.GlyphCount = ImMin(GLYPHS_PER_JOB, src_tmp.GlyphsCount - glyph_start);
+            raster_jobs.Jobs.push_back(job);
         }
-        src_tmp.Rects = NULL;
     }
+    if (atlas->BuildJobsFn && raster_jobs.Jobs.Size > 1)
+        atlas->BuildJobsFn(atlas->BuildJobsUserData, raster_jobs.Jobs.Size, ImFontAtlasBuildRasterizeJob, &raster_jobs);
+    else
+        for (int job_i = 0; job_i < raster_jobs.Jobs.Size; job_i++)
+            ImFontAtlasBuildRasterizeJob(&raster_jobs, job_i);
+    for (int src_i = 0; src_i < src_tmp_array.Size; src_i++)
+        src_tmp_array[src_i].Rects = NULL;
 
     // End packing
     stbtt_PackEnd(&spc);
     buf_rects.clear();
 
     // 9. Setup ImFont and glyphs for runtime
+    const bool save_cache = atlas->BuildCacheFilename != NULL;
+    ImVector<ImFontBuildCacheSrc> cache_srcs;
+    ImVector<ImFontBuildCacheGlyph> cache_glyphs;
+    if (save_cache)
+    {
+        cache_srcs.resize(src_tmp_array.Size, ImFontBuildCacheSrc());
+        cache_glyphs.reserve(total_glyphs_count);
+    }
     for (int src_i = 0; src_i < src_tmp_array.Size; src_i++)
     {
         ImFontBuildSrcData& src_tmp = src_tmp_array[src_i];
@@ -2572,6 +3168,12 @@ static bool ImFontAtlasBuildWithStbTruetype(ImFontAtlas* atlas)
         ImFontAtlasBuildSetupFont(atlas, dst_font, &cfg, ascent, descent);
         const float font_off_x = cfg.GlyphOffset.x;
         const float font_off_y = cfg.GlyphOffset.y + IM_ROUND(dst_font->Ascent);
+        if (save_cache)
+        {
+            cache_srcs[src_i].GlyphsCount = src_tmp.GlyphsCount;
+            cache_srcs[src_i].Ascent = ascent;
+            cache_srcs[src_i].Descent = descent;
+        }
 
         for (int glyph_i = 0; glyph_i < src_tmp.GlyphsCount; glyph_i++)
         {
@@ -2582,12 +3184,21 @@ static bool ImFontAtlasBuildWithStbTruetype(ImFontAtlas* atlas)
             float unused_x = 0.0f, unused_y = 0.0f;
             stbtt_GetPackedQuad(src_tmp.PackedChars, atlas->TexWidth, atlas->TexHeight, glyph_i, &unused_x, &unused_y, &q, 0);
             dst_font->AddGlyph(&cfg, (ImWchar)codepoint, q.x0 + font_off_x, q.y0 + font_off_y, q.x1 + font_off_x, q.y1 + font_off_y, q.s0, q.t0, q.s1, q.t1, pc.xadvance);
+            if (save_cache)
+            {
+                ImFontBuildCacheGlyph glyph = { (ImU32)codepoint, q.x0 + font_off_x, q.y0 + font_off_y, q.x1 + font_off_x, q.y1 + font_off_y, q.s0, q.t0, q.s1, q.t1, pc.xadvance };
+                cache_glyphs.push_back(glyph);
+            }
         }
     }
 
     // Cleanup
     src_tmp_array.clear_destruct();
 
+    // Save before ImFontAtlasBuildFinish() renders the custom rectangles, which it does again after loading
+    if (save_cache)
+        ImFontAtlasBuildSaveCache(atlas, cache_key, cache_srcs, cache_glyphs);
+
     ImFontAtlasBuildFinish(atlas);
     return true;
 }
@@ -2802,6 +3413,26 @@ void ImFontAtlasBuildFinish(ImFontAtlas* atlas)
         if (atlas->Fonts[i]->DirtyLookupTables)
             atlas->Fonts[i]->BuildLookupTable();
 
+    // Start with empty glyph cache pages, and let the fonts with ImFontConfig::DynamicGlyphs sources look up the codepoints they don't have yet
+    for (int page_i = 0; page_i < atlas->GlyphCachePages.Size; page_i++)
+    {
+        ImFontGlyphCachePage& page = atlas->GlyphCachePages[page_i];
+        page.CursorX = page.RowY = page.RowHeight = 0;
+        page.GlyphsCount = 0;
+        page.LastUsedFrame = -1;
+    }
+    if (atlas->GlyphCachePages.Size > 0)
+        for (int i = 0; i < atlas->ConfigData.Size; i++)
+        {
+            ImFont* font = atlas->ConfigData[i].DstFont;
+            if (!atlas->ConfigData[i].DynamicGlyphs || font->DynamicGlyphs)
+                continue;
+            font->DynamicGlyphs = true;
+            for (int n = 0; n < font->IndexLookup.Size; n++)
+                if (font->IndexLookup[n] == (ImWchar)-1)
+                    font->IndexAdvanceX[n] = -1.0f;
+        }
+
     atlas->TexReady = true;
 }
 
@@ -3117,6 +3748,8 @@ ImFont::ImFont()
     Ascent = Descent = 0.0f;
     MetricsTotalSurface = 0;
     memset(Used4kPagesMap, 0, sizeof(Used4kPagesMap));
+    DynamicGlyphs = false;
+    GlyphCacheStart = INT_MAX;
 }
 
 ImFont::~ImFont()
@@ -3136,6 +3769,9 @@ void    ImFont::ClearOutputData()
     DirtyLookupTables = true;
     Ascent = Descent = 0.0f;
     MetricsTotalSurface = 0;
+    DynamicGlyphs = false;
+    GlyphCacheStart = INT_MAX;
+    GlyphCachePageOf.clear();
 }
 
 static ImWchar FindFirstExistingGlyph(ImFont* font, const ImWchar* candidate_chars, int candidate_chars_count)
@@ -3148,6 +3784,18 @@ static ImWchar FindFirstExistingGlyph(ImFont* font, const ImWchar* candidate_cha
 
 void ImFont::BuildLookupTable()
 {
+    // Drop the glyphs rasterized on demand, they will be rasterized again when looked up
+    const bool dynamic_glyphs = DynamicGlyphs;
+    if (GlyphCachePageOf.Size > 0)
+    {
+        for (int i = 0; i < GlyphCachePageOf.Size; i++)
+            ContainerAtlas->GlyphCachePages[GlyphCachePageOf[i]].GlyphsCount--;
+        Glyphs.erase(Glyphs.Data + GlyphCacheStart, Glyphs.Data + GlyphCacheStart + GlyphCachePageOf.Size);
+        GlyphCachePageOf.clear();
+    }
+    DynamicGlyphs = false;
+    GlyphCacheStart = INT_MAX;
+
     int max_codepoint = 0;
     for (int i = 0; i != Glyphs.Size; i++)
         max_codepoint = ImMax(max_codepoint, (int)Glyphs[i].Codepoint);
@@ -3213,9 +3861,12 @@ void ImFont::BuildLookupTable()
     }
 
     FallbackAdvanceX = FallbackGlyph->AdvanceX;
-    for (int i = 0; i < max_codepoint + 1; i++)
-        if (IndexAdvanceX[i] < 0.0f)
-            IndexAdvanceX[i] = FallbackAdvanceX;
+    DynamicGlyphs = dynamic_glyphs;
+    if (!DynamicGlyphs)
+        for (int i = 0; i < max_codepoint + 1; i++)
+            if (IndexAdvanceX[i] < 0.0f)
+                IndexAdvanceX[i] = FallbackAdvanceX;
+    GlyphCacheStart = Glyphs.Size;
 }
 
 // API is designed this way to avoid exposing the 4K page size
@@ -3308,13 +3959,90 @@ void ImFont::AddRemapChar(ImWchar dst, ImWchar src, bool overwrite_dst)
     IndexAdvanceX[dst] = (src < index_size) ? IndexAdvanceX.Data[src] : 1.0f;
 }
 
+// Lookups of the deferred draw list build running on this thread while the glyph cache is locked, see ImFontAtlasGlyphCacheBeginRequests()
+static thread_local ImFontGlyphCacheRequests* GImFontGlyphCacheRequests = NULL;
+
+void ImFontAtlasGlyphCacheBeginRequests(ImFontAtlas* atlas, ImFontGlyphCacheRequests* requests)
+{
+    requests->MissingFonts.resize(0);
+    requests->MissingCodepoints.resize(0);
+    requests->TouchedPages.Create(atlas->GlyphCachePages.Size);
+    GImFontGlyphCacheRequests = requests;
+}
+
+void ImFontAtlasGlyphCacheEndRequests()
+{
+    GImFontGlyphCacheRequests = NULL;
+}
+
+void ImFontAtlasGlyphCacheTouchRequestedPages(ImFontAtlas* atlas, const ImFontGlyphCacheRequests* requests)
+{
+    IM_ASSERT(!atlas->GlyphCacheLocked);
+    const int pages_count = ImMin(atlas->GlyphCachePages.Size, requests->TouchedPages.Storage.Size << 5);
+    for (int page_i = 0; page_i < pages_count; page_i++)
+        if (requests->TouchedPages.TestBit(page_i))
+            atlas->GlyphCachePages[page_i].LastUsedFrame = atlas->GlyphCacheFrame;
+}
+
+bool ImFontAtlasGlyphCacheAddRequestedGlyphs(ImFontAtlas* atlas, const ImFontGlyphCacheRequests* requests)
+{
+    IM_ASSERT(!atlas->GlyphCacheLocked);
+    IM_UNUSED(atlas);
+    bool added = false;
+    for (int n = 0; n < requests->MissingCodepoints.Size; n++)
+    {
+        // Rasterizes the codepoint, or finds it rasterized for an earlier request
+        const ImFont* font = requests->MissingFonts[n];
+        if (font->FindGlyph(requests->MissingCodepoints[n]) != font->FallbackGlyph)
+            added = true;
+    }
+    return added;
+}
+
+// Look up a codepoint missing from the lookup tables in the sources with ImFontConfig::DynamicGlyphs, once
+static const ImFontGlyph* FindGlyphDynamic(ImFont* font, ImWchar c)
+{
+#ifdef IMGUI_ENABLE_STB_TRUETYPE
+    const bool looked_up = (int)c < font->IndexAdvanceX.Size && font->IndexAdvanceX.Data[c] >= 0.0f;
+    if (!looked_up && !font->ContainerAtlas->GlyphCacheLocked)
+    {
+        if (const ImFontGlyph* glyph = ImFontAtlasGlyphCacheAdd(font->ContainerAtlas, font, c))
+            return glyph;
+    }
+    else if (!looked_up && GImFontGlyphCacheRequests != NULL)
+    {
+        // Text repeats codepoints: skip the request just made
+        ImFontGlyphCacheRequests* requests = GImFontGlyphCacheRequests;
+        if (requests->MissingCodepoints.Size == 0 || requests->MissingCodepoints.back() != c || requests->MissingFonts.back() != font)
+        {
+            requests->MissingFonts.push_back(font);
+            requests->MissingCodepoints.push_back(c);
+        }
+    }
+#endif
+    return font->FallbackGlyph;
+}
+
+// Mark the glyph cache page of a glyph rasterized on demand as used during the current frame
+static inline void TouchGlyphCachePage(const ImFont* font, int glyph_index)
+{
+    ImFontAtlas* atlas = font->ContainerAtlas;
+    const int page_i = font->GlyphCachePageOf.Data[glyph_index - font->GlyphCacheStart];
+    if (!atlas->GlyphCacheLocked)
+        atlas->GlyphCachePages.Data[page_i].LastUsedFrame = atlas->GlyphCacheFrame;
+    else if (GImFontGlyphCacheRequests != NULL)
+        GImFontGlyphCacheRequests->TouchedPages.SetBit(page_i);
+}
+
 const ImFontGlyph* ImFont::FindGlyph(ImWchar c) const
 {
     if (c >= (size_t)IndexLookup.Size)
-        return FallbackGlyph;
+        return DynamicGlyphs ? FindGlyphDynamic((ImFont*)this, c) : FallbackGlyph;
     const ImWchar i = IndexLookup.Data[c];
     if (i == (ImWchar)-1)
-        return FallbackGlyph;
+        return DynamicGlyphs ? FindGlyphDynamic((ImFont*)this, c) : FallbackGlyph;
+    if ((int)i >= GlyphCacheStart)
+        TouchGlyphCachePage(this, (int)i);
     return &Glyphs.Data[i];
 }
 
@@ -3325,9 +4053,53 @@ const ImFontGlyph* ImFont::FindGlyphNoFallback(ImWchar c) const
     const ImWchar i = IndexLookup.Data[c];
     if (i == (ImWchar)-1)
         return NULL;
+    if ((int)i >= GlyphCacheStart)
+        TouchGlyphCachePage(this, (int)i);
     return &Glyphs.Data[i];
 }
 
+// Text measurement fast paths: most text is runs of printable ASCII characters, which need no UTF-8 decoding nor special handling.
+// SSE2 finds where a run ends 16 bytes at a time; the advances are still added one after the other, in the same order as the
+// character by character loops, so the results don't change. Bytes 0x80 and above are negative as signed chars.
+
+// End of the run of bytes from s that are printable ASCII characters, 0x20 to 0x7F
+static inline const char* ImTextFindEndOfPrintableAscii(const char* s, const char* s_end)
+{
+#ifdef IMGUI_ENABLE_SSE
+    const __m128i space = _mm_set1_epi8(' ');
+    for (; s_end - s >= 16; s += 16)
+        if (_mm_movemask_epi8(_mm_cmplt_epi8(_mm_loadu_si128((const __m128i*)(const void*)s), space)) != 0)
+            break;
+#endif
+    while (s < s_end && (signed char)*s >= ' ')
+        s++;
+    return s;
+}
+
+// Same, also ending at the blanks and punctuation that CalcWordWrapPositionA() may wrap after
+static inline bool ImCharIsAsciiWordA(char c)     { return (signed char)c > ' ' && c != '.' && c != ',' && c != ';' && c != '!' && c != '?' && c != '\"'; }
+static inline const char* ImTextFindEndOfAsciiWord(const char* s, const char* s_end)
+{
+#ifdef IMGUI_ENABLE_SSE
+    const __m128i space = _mm_set1_epi8(' ');
+    for (; s_end - s >= 16; s += 16)
+    {
+        const __m128i bytes = _mm_loadu_si128((const __m128i*)(const void*)s);
+        __m128i separators = _mm_cmpeq_epi8(bytes, _mm_set1_epi8('.'));
+        separators = _mm_or_si128(separators, _mm_cmpeq_epi8(bytes, _mm_set1_epi8(',')));
+        separators = _mm_or_si128(separators, _mm_cmpeq_epi8(bytes, _mm_set1_epi8(';')));
+        separators = _mm_or_si128(separators, _mm_cmpeq_epi8(bytes, _mm_set1_epi8('!')));
+        separators = _mm_or_si128(separators, _mm_cmpeq_epi8(bytes, _mm_set1_epi8('?')));
+        separators = _mm_or_si128(separators, _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\"')));
+        if (_mm_movemask_epi8(_mm_andnot_si128(separators, _mm_cmpgt_epi8(bytes, space))) != 0xFFFF)
+            break;
+    }
+#endif
+    while (s < s_end && ImCharIsAsciiWordA(*s))
+        s++;
+    return s;
+}
+
 const char* ImFont::CalcWordWrapPositionA(float scale, const char* text, const char* text_end, float wrap_width) const
 {
     // Simple word-wrapping for English, not full-featured. Please submit failing cases!
@@ -3354,9 +4126,34 @@ const char* ImFont::CalcWordWrapPositionA(float scale, const char* text, const c
     const char* prev_word_end = NULL;
     bool inside_word = true;
 
+    const float* advance_x = IndexAdvanceX.Data;
+    const bool ascii_fast_path = IndexAdvanceX.Size >= 0x80;
+
     const char* s = text;
     while (s < text_end)
     {
+        // The rest of a word only adds to its width (see the non-blank case below)
+        if (inside_word && ascii_fast_path)
+        {
+            const char* run_end = ImTextFindEndOfAsciiWord(s, text_end);
+            for (; s < run_end; s++)
+            {
+                const float char_width = advance_x[(unsigned char)*s];
+                if (char_width < 0.0f) // Not looked up yet, see GetCharAdvance()
+                    break;
+                word_width += char_width;
+                word_end = s + 1;
+                if (line_width + word_width > wrap_width)
+                {
+                    if (word_width < wrap_width)
+                        s = prev_word_end ? prev_word_end : word_end;
+                    return s;
+                }
+            }
+            if (s == text_end)
+                break;
+        }
+
         unsigned int c = (unsigned int)*s;
         const char* next_s;
         if (c < 0x80)
@@ -3382,7 +4179,7 @@ const char* ImFont::CalcWordWrapPositionA(float scale, const char* text, const c
             }
         }
 
-        const float char_width = ((int)c < IndexAdvanceX.Size ? IndexAdvanceX.Data[c] : FallbackAdvanceX);
+        const float char_width = GetCharAdvance((ImWchar)c);
         if (ImCharIsBlankW(c))
         {
             if (inside_word)
@@ -3427,13 +4224,14 @@ const char* ImFont::CalcWordWrapPositionA(float scale, const char* text, const c
     return s;
 }
 
-ImVec2 ImFont::CalcTextSizeA(float size, float max_width, float wrap_width, const char* text_begin, const char* text_end, const char** remaining) const
+// Shared by CalcTextSizeA() and CalcTextLinesA(). out_lines receives the begin and end offsets of every line, as RenderText() breaks them.
+static ImVec2 ImFontCalcTextSize(const ImFont* font, float size, float max_width, float wrap_width, const char* text_begin, const char* text_end, const char** remaining, ImVector<int>* out_lines)
 {
     if (!text_end)
         text_end = text_begin + strlen(text_begin); // FIXME-OPT: Need to avoid this.
 
     const float line_height = size;
-    const float scale = size / FontSize;
+    const float scale = size / font->FontSize;
 
     ImVec2 text_size = ImVec2(0, 0);
     float line_width = 0.0f;
@@ -3441,7 +4239,11 @@ ImVec2 ImFont::CalcTextSizeA(float size, float max_width, float wrap_width, cons
     const bool word_wrap_enabled = (wrap_width > 0.0f);
     const char* word_wrap_eol = NULL;
 
+    const float* advance_x = font->IndexAdvanceX.Data;
+    const bool ascii_fast_path = font->IndexAdvanceX.Size >= 0x80;
+
     const char* s = text_begin;
+    const char* line_begin = s;
     while (s < text_end)
     {
         if (word_wrap_enabled)
@@ -3449,7 +4251,7 @@ ImVec2 ImFont::CalcTextSizeA(float size, float max_width, float wrap_width, cons
             // Calculate how far we can render. Requires two passes on the string data but keeps the code simple and not intrusive for what's essentially an uncommon feature.
             if (!word_wrap_eol)
             {
-                word_wrap_eol = CalcWordWrapPositionA(scale, s, text_end, wrap_width - line_width);
+                word_wrap_eol = font->CalcWordWrapPositionA(scale, s, text_end, wrap_width - line_width);
                 if (word_wrap_eol == s) // Wrap_width is too small to fit anything. Force displaying 1 character to minimize the height discontinuity.
                     word_wrap_eol++;    // +1 may not be a character start point in UTF-8 but it's ok because we use s >= word_wrap_eol below
             }
@@ -3461,6 +4263,11 @@ ImVec2 ImFont::CalcTextSizeA(float size, float max_width, float wrap_width, cons
                 text_size.y += line_height;
                 line_width = 0.0f;
                 word_wrap_eol = NULL;
+                if (out_lines)
+                {
+                    out_lines->push_back((int)(line_begin - text_begin));
+                    out_lines->push_back((int)(s - text_begin));
+                }
 
                 // Wrapping skips upcoming blanks
                 while (s < text_end)
@@ -3468,10 +4275,35 @@ ImVec2 ImFont::CalcTextSizeA(float size, float max_width, float wrap_width, cons
                     const char c = *s;
                     if (ImCharIsBlankA(c)) { s++; } else if (c == '\n') { s++; break; } else { break; }
                 }
+                line_begin = s;
                 continue;
             }
         }
 
+        // Runs of printable ASCII characters, up to the wrapping point
+        if (ascii_fast_path && (signed char)*s >= ' ')
+        {
+            const char* run_end = ImTextFindEndOfPrintableAscii(s, word_wrap_eol ? word_wrap_eol : text_end);
+            bool max_width_reached = false;
+            for (; s < run_end; s++)
+            {
+                const float advance = advance_x[(unsigned char)*s];
+                if (advance < 0.0f) // Not looked up yet, see GetCharAdvance()
+                    break;
+                const float char_width = advance * scale;
+                if (line_width + char_width >= max_width)
+                {
+                    max_width_reached = true;
+                    break;
+                }
+                line_width += char_width;
+            }
+            if (max_width_reached)
+                break;
+            if (s == run_end)
+                continue;
+        }
+
         // Decode and advance source
         const char* prev_s = s;
         unsigned int c = (unsigned int)*s;
@@ -3493,13 +4325,19 @@ ImVec2 ImFont::CalcTextSizeA(float size, float max_width, float wrap_width, cons
                 text_size.x = ImMax(text_size.x, line_width);
                 text_size.y += line_height;
                 line_width = 0.0f;
+                if (out_lines)
+                {
+                    out_lines->push_back((int)(line_begin - text_begin));
+                    out_lines->push_back((int)(prev_s - text_begin));
+                }
+                line_begin = s;
                 continue;
             }
             if (c == '\r')
                 continue;
         }
 
-        const float char_width = ((int)c < IndexAdvanceX.Size ? IndexAdvanceX.Data[c] : FallbackAdvanceX) * scale;
+        const float char_width = font->GetCharAdvance((ImWchar)c) * scale;
         if (line_width + char_width >= max_width)
         {
             s = prev_s;
@@ -3517,10 +4355,25 @@ ImVec2 ImFont::CalcTextSizeA(float size, float max_width, float wrap_width, cons
 
     if (remaining)
         *remaining = s;
+    if (out_lines)
+    {
+        out_lines->push_back((int)(line_begin - text_begin));
+        out_lines->push_back((int)(s - text_begin));
+    }
 
     return text_size;
 }
 
+ImVec2 ImFont::CalcTextSizeA(float size, float max_width, float wrap_width, const char* text_begin, const char* text_end, const char** remaining) const
+{
+    return ImFontCalcTextSize(this, size, max_width, wrap_width, text_begin, text_end, remaining, NULL);
+}
+
+ImVec2 ImFont::CalcTextLinesA(float size, float wrap_width, const char* text_begin, const char* text_end, ImVector<int>* out_lines) const
+{
+    return ImFontCalcTextSize(this, size, FLT_MAX, wrap_width, text_begin, text_end, NULL, out_lines);
+}
+
 // Note: as with every ImDrawList drawing function, this expects that the font atlas texture is bound.
 void ImFont::RenderChar(ImDrawList* draw_list, float size, ImVec2 pos, ImU32 col, ImWchar c) const
 {
@@ -117,6 +117,7 @@ struct ImBitVector;                 // Store 1-bit per value
 struct ImRect;                      // An axis-aligned rectangle (2 points)
 struct ImDrawDataBuilder;           // Helper to build a ImDrawData instance
 struct ImDrawListSharedData;        // Data shared between all ImDrawList instances
+struct ImFontGlyphCacheRequests;    // Glyph cache lookups recorded by a deferred draw list build
 struct ImGuiColorMod;               // Stacked color modifier, backup of modified data so we can restore it
 struct ImGuiContext;                // Main Dear ImGui context
 struct ImGuiContextHook;            // Hook for extensions like ImGuiTestEngine
@@ -733,6 +734,30 @@ struct IMGUI_API ImDrawListSharedData
     void SetCircleTessellationMaxError(float max_error);
 };
 
+// Storage for AddDeferredDrawList()
+struct ImGuiDeferredDrawList
+{
+    ImGuiWindow*            Window;
+    ImDrawListBuildCallback BuildFunc;
+    void*                   UserData;
+    ImVec4                  ClipRect;
+    ImTextureID             TextureId;
+    ImFont*                 Font;
+    float                   FontSize;
+};
+
+// Size and lines of a text measured by CalcTextSize(), kept for as long as the same text is measured every frame
+struct ImGuiTextLayout
+{
+    ImGuiID                 Key;            // Hash of the text, font, font size and wrap width
+    int                     TextOffset;     // Copy of the text in g.TextLayoutText[], compared on a hit so that a hash collision is measured instead
+    int                     TextLength;
+    ImVec2                  Size;           // ImFont::CalcTextSizeA() output, before the rounding done by CalcTextSize()
+    int                     LinesOffset;    // Wrapped text only: begin and end offsets of every line in g.TextLayoutLines[], see ImFont::CalcTextLinesA()
+    int                     LinesCount;
+    int                     LastFrameUsed;
+};
+
 struct ImDrawDataBuilder
 {
     ImVector<ImDrawList*>   Layers[2];           // Global layers for: regular, tooltip
@@ -1597,6 +1622,14 @@ struct ImGuiContext
     float                   FontSize;                           // (Shortcut) == FontBaseSize * g.CurrentWindow->FontWindowScale == window->FontSize(). Text height for current window.
     float                   FontBaseSize;                       // (Shortcut) == IO.FontGlobalScale * Font->Scale * Font->FontSize. Base text height.
     ImDrawListSharedData    DrawListSharedData;
+    ImVector<ImGuiDeferredDrawList> DeferredDrawLists;          // Queued by AddDeferredDrawList() this frame, built by Render()
+    ImVector<ImDrawList*>   DeferredDrawListPool;               // One draw list per entry of DeferredDrawLists[], kept between frames
+    ImVector<ImDrawListSharedData*> DeferredDrawListSharedData; // One copy of DrawListSharedData per draw list, so concurrent builds share nothing they write
+    ImVector<ImFontGlyphCacheRequests*> DeferredDrawListGlyphRequests; // Glyph cache lookups of each draw list build, applied once all builds are done
+    ImVector<ImGuiTextLayout> TextLayouts;                      // Shared by CalcTextSize() and RenderTextWrapped(), dropped by NewFrame() when not used during the last frame
+    ImVector<int>           TextLayoutLines;
+    ImVector<char>          TextLayoutText;
+    ImGuiStorage            TextLayoutsMap;                     // Key -> index into TextLayouts[] + 1
     double                  Time;
     int                     FrameCount;
     int                     FrameCountEnded;
@@ -2153,6 +2186,7 @@ struct IMGUI_API ImGuiWindow
 
     ImDrawList*             DrawList;                           // == &DrawListInst (for backward compatibility reason with code using imgui_internal.h we keep this a pointer)
     ImDrawList              DrawListInst;
+    ImVector<int>           DeferredDrawLists;                  // Indices into g.DeferredDrawLists[] queued this frame, drawn after DrawList
     ImGuiWindow*            ParentWindow;                       // If we are a child _or_ popup window, this is pointing to our parent. Otherwise NULL.
     ImGuiWindow*            RootWindow;                         // Point to ourself or first ancestor that is not a child window. Doesn't cross through dock nodes. We use this so IsWindowFocused() can behave consistently regardless of docking state.
     ImGuiWindow*            RootWindowDockTree;                 // Point to ourself or first ancestor that is not a child window. Cross through dock nodes.
@@ -2999,6 +3033,20 @@ IMGUI_API void      ImFontAtlasBuildRender32bppRectFromString(ImFontAtlas* atlas
 IMGUI_API void      ImFontAtlasBuildMultiplyCalcLookupTable(unsigned char out_table[256], float in_multiply_factor);
 IMGUI_API void      ImFontAtlasBuildMultiplyRectAlpha8(const unsigned char table[256], unsigned char* pixels, int x, int y, int w, int h, int stride);
 
+// Glyph cache lookups made while ImFontAtlas::GlyphCacheLocked is set, by the deferred draw list build running on the calling thread.
+// The build draws the missing codepoints as their fallback glyph; once every build is done, the main thread touches the pages of all
+// of them first, so none is emptied, then rasterizes the missing codepoints.
+struct ImFontGlyphCacheRequests
+{
+    ImVector<ImFont*>   MissingFonts;       // Codepoints to rasterize, with the font each one was looked up in
+    ImVector<ImWchar>   MissingCodepoints;
+    ImBitVector         TouchedPages;       // Indices into ImFontAtlas::GlyphCachePages[] of the pages looked up
+};
+IMGUI_API void      ImFontAtlasGlyphCacheBeginRequests(ImFontAtlas* atlas, ImFontGlyphCacheRequests* requests);  // Record this thread's lookups into 'requests', cleared first
+IMGUI_API void      ImFontAtlasGlyphCacheEndRequests();
+IMGUI_API void      ImFontAtlasGlyphCacheTouchRequestedPages(ImFontAtlas* atlas, const ImFontGlyphCacheRequests* requests);
+IMGUI_API bool      ImFontAtlasGlyphCacheAddRequestedGlyphs(ImFontAtlas* atlas, const ImFontGlyphCacheRequests* requests);   // Return true when a missing codepoint now has a glyph
+
 //-----------------------------------------------------------------------------
 // [SECTION] Test Engine specific hooks (imgui_test_engine)
 //-----------------------------------------------------------------------------
@@ -0,0 +1,40 @@
+//
+// Check.h - Assertions for the tests, kept in release builds
+//
+
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+
+
+// Prints the failed expression with its location and fails the test.
+#define CHECK(expression) \
+    do \
+    { \
+        if (!(expression)) \
+        { \
+            std::fprintf(stderr, "%s(%d): CHECK(%s) failed\n", __FILE__, __LINE__, #expression); \
+            std::exit(EXIT_FAILURE); \
+        } \
+    } while (false)
+
+// Fails the test unless the statement throws the given exception type.
+#define CHECK_THROWS(statement, exceptionType) \
+    do \
+    { \
+        bool threw = false; \
+        try \
+        { \
+            statement; \
+        } \
+        catch (const exceptionType&) \
+        { \
+            threw = true; \
+        } \
+        if (!threw) \
+        { \
+            std::fprintf(stderr, "%s(%d): %s did not throw %s\n", __FILE__, __LINE__, #statement, #exceptionType); \
+            std::exit(EXIT_FAILURE); \
+        } \
+    } while (false)
@@ -0,0 +1,223 @@
+//
+// CookedTextureTests.cpp - Cooking mip chains and round-tripping them through the cooked texture container
+//
+
+#include "Check.h"
+
+#include "CookedTexture.h"
+#include "TextureCooker.h"
+
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    // A single-mip RGBA8 image of a gradient, opaque or with a varying alpha.
+    StreamedImage MakeSource(uint32_t width, uint32_t height, bool opaque)
+    {
+        StreamedImage image = {};
+        image.width = width;
+        image.height = height;
+        image.mipLevels = 1;
+        image.format = c_FormatR8G8B8A8Unorm;
+        image.blockSize = 1;
+        image.bytesPerBlock = 4;
+
+        uint8_t* texels = AllocateTexels(image);
+        for (uint32_t y = 0; y < height; y++)
+        {
+            for (uint32_t x = 0; x < width; x++)
+            {
+                uint8_t* texel = texels + (size_t(y) * width + x) * 4;
+                texel[0] = static_cast<uint8_t>(x * 255 / width);
+                texel[1] = static_cast<uint8_t>(y * 255 / height);
+                texel[2] = static_cast<uint8_t>((x + y) * 7);
+                texel[3] = opaque ? 255 : static_cast<uint8_t>(x * 13 + y);
+            }
+        }
+        return image;
+    }
+
+    std::vector<char> ReadFile(const std::filesystem::path& path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    void WriteFile(const std::filesystem::path& path, const std::vector<char>& bytes)
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    }
+
+    // Writes the cooked image, loads it back from the mapping and checks every mip level and the table on disk.
+    void CheckRoundTrip(const StreamedImage& cooked, const std::filesystem::path& path)
+    {
+        WriteCookedTexture(path, cooked);
+
+        auto temporaryPath = path;
+        temporaryPath += L".tmp";
+        CHECK(!std::filesystem::exists(temporaryPath));
+
+        StreamedImage loaded = {};
+        LoadCookedTexture(path, loaded);
+
+        CHECK(loaded.width == cooked.width);
+        CHECK(loaded.height == cooked.height);
+        CHECK(loaded.mipLevels == cooked.mipLevels);
+        CHECK(loaded.format == cooked.format);
+        CHECK(loaded.blockSize == cooked.blockSize);
+        CHECK(loaded.bytesPerBlock == cooked.bytesPerBlock);
+        CHECK(reinterpret_cast<uintptr_t>(loaded.texels.get()) % 16 == 0);
+
+        for (uint32_t mip = 0; mip <= cooked.mipLevels; mip++)
+        {
+            CHECK(loaded.GetMipOffset(mip) == cooked.GetMipOffset(mip));
+        }
+        for (uint32_t mip = 0; mip < cooked.mipLevels; mip++)
+        {
+            CHECK(loaded.GetMipSize(mip) == cooked.GetMipSize(mip));
+            CHECK(std::memcmp(loaded.GetMipData(mip), cooked.GetMipData(mip), cooked.GetMipSize(mip)) == 0);
+        }
+
+        // The table on disk points at the texel data, which starts at the first 16-byte boundary after it.
+        const auto bytes = ReadFile(path);
+        const uint64_t tableEnd = sizeof(CookedTextureHeader) + uint64_t(cooked.mipLevels) * sizeof(CookedTextureMip);
+        const uint64_t dataOffset = (tableEnd + 15) / 16 * 16;
+        CHECK(bytes.size() == dataOffset + cooked.GetMipOffset(cooked.mipLevels));
+        for (uint32_t mip = 0; mip < cooked.mipLevels; mip++)
+        {
+            CookedTextureMip entry;
+            std::memcpy(&entry, bytes.data() + sizeof(CookedTextureHeader) + mip * sizeof(entry), sizeof(entry));
+            CHECK(entry.offset == dataOffset + cooked.GetMipOffset(mip));
+            CHECK(entry.size == cooked.GetMipSize(mip));
+        }
+    }
+
+    // Odd sizes keep a full chain down to 1x1, box filtered from the level above.
+    void TestRGBA8()
+    {
+        const StreamedImage source = MakeSource(37, 19, false);
+        TextureCookOptions options;
+        options.compress = true;
+        const StreamedImage cooked = CookTexture(source, options);
+
+        // Not opaque, so it stays RGBA8 despite the option.
+        CHECK(cooked.format == c_FormatR8G8B8A8Unorm);
+        CHECK(cooked.blockSize == 1 && cooked.bytesPerBlock == 4);
+        CHECK(cooked.mipLevels == 6);
+        CHECK(cooked.GetMipWidth(5) == 1 && cooked.GetMipHeight(5) == 1);
+        CHECK(cooked.GetMipSize(0) == 37 * 19 * 4);
+        CHECK(cooked.GetMipSize(1) == 18 * 9 * 4);
+        CHECK(std::memcmp(cooked.GetMipData(0), source.GetMipData(0), cooked.GetMipSize(0)) == 0);
+
+        CheckRoundTrip(cooked, "CookedTextureTests_rgba8.ttex");
+
+        // Without mips the chain is the source.
+        options.generateMips = false;
+        const StreamedImage single = CookTexture(source, options);
+        CHECK(single.mipLevels == 1);
+        CheckRoundTrip(single, "CookedTextureTests_rgba8.ttex");
+
+        std::filesystem::remove("CookedTextureTests_rgba8.ttex");
+    }
+
+    // A multiple of 4 is only required of the top level: the mip tail is rounded up to whole blocks.
+    void TestBC1()
+    {
+        const StreamedImage source = MakeSource(20, 12, true);
+        TextureCookOptions options;
+        options.compress = true;
+        const StreamedImage cooked = CookTexture(source, options);
+
+        CHECK(cooked.format == c_FormatBC1Unorm);
+        CHECK(cooked.blockSize == 4 && cooked.bytesPerBlock == 8);
+        CHECK(cooked.mipLevels == 5);
+
+        // 20x12, 10x6, 5x3, 2x1, 1x1 texels.
+        const uint64_t blocks[] = { 5 * 3, 3 * 2, 2 * 1, 1, 1 };
+        for (uint32_t mip = 0; mip < cooked.mipLevels; mip++)
+        {
+            CHECK(cooked.GetMipSize(mip) == blocks[mip] * 8);
+        }
+        CHECK(cooked.GetRowCount(2) == 1 && cooked.GetRowSize(2) == 16);
+
+        CheckRoundTrip(cooked, "CookedTextureTests_bc1.ttex");
+
+        // A top level that is not a multiple of 4 stays RGBA8.
+        const StreamedImage odd = CookTexture(MakeSource(18, 12, true), options);
+        CHECK(odd.format == c_FormatR8G8B8A8Unorm);
+
+        std::filesystem::remove("CookedTextureTests_bc1.ttex");
+    }
+
+    // Anything but a complete file of this version is rejected rather than mapped.
+    void TestRejected()
+    {
+        const std::filesystem::path path = "CookedTextureTests_bad.ttex";
+        TextureCookOptions options;
+        options.compress = true;
+        WriteCookedTexture(path, CookTexture(MakeSource(20, 12, true), options));
+        const auto bytes = ReadFile(path);
+
+        StreamedImage image = {};
+
+        // Cut in the texel data, in the mip table and in the header.
+        for (const size_t size : { bytes.size() - 1, sizeof(CookedTextureHeader) + 4, sizeof(CookedTextureHeader) - 1 })
+        {
+            WriteFile(path, std::vector<char>(bytes.begin(), bytes.begin() + static_cast<std::ptrdiff_t>(size)));
+            CHECK_THROWS(LoadCookedTexture(path, image), std::runtime_error);
+        }
+
+        WriteFile(path, {});
+        CHECK_THROWS(LoadCookedTexture(path, image), std::runtime_error);
+
+        auto wrongMagic = bytes;
+        wrongMagic[0] = 'X';
+        WriteFile(path, wrongMagic);
+        CHECK_THROWS(LoadCookedTexture(path, image), std::runtime_error);
+
+        auto wrongVersion = bytes;
+        wrongVersion[offsetof(CookedTextureHeader, version)]++;
+        WriteFile(path, wrongVersion);
+        CHECK_THROWS(LoadCookedTexture(path, image), std::runtime_error);
+
+        // More mip levels than the top level has.
+        auto tooManyMips = bytes;
+        tooManyMips[offsetof(CookedTextureHeader, mipLevels)] = 6;
+        WriteFile(path, tooManyMips);
+        CHECK_THROWS(LoadCookedTexture(path, image), std::runtime_error);
+
+        auto wrongTable = bytes;
+        wrongTable[sizeof(CookedTextureHeader) + sizeof(CookedTextureMip)]++;
+        WriteFile(path, wrongTable);
+        CHECK_THROWS(LoadCookedTexture(path, image), std::runtime_error);
+
+        // The untouched file still loads.
+        WriteFile(path, bytes);
+        LoadCookedTexture(path, image);
+        CHECK(image.mipLevels == 5);
+
+        std::filesystem::remove(path);
+        CHECK_THROWS(LoadCookedTexture(path, image), std::runtime_error);
+
+        CHECK(GetCookedTexturePath("textures/kiti.jpg") == std::filesystem::path("textures/kiti.ttex"));
+    }
+}
+
+int main()
+{
+    TestRGBA8();
+    TestBC1();
+    TestRejected();
+
+    std::puts("CookedTextureTests: passed");
+    return 0;
+}
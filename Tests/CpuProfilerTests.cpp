@@ -0,0 +1,270 @@
+//
+// CpuProfilerTests.cpp - Scope pairing when a thread's ring is full, and the Chrome trace it writes
+//
+
+#include "Check.h"
+
+#include "CpuProfiler.h"
+
+#include <cstdlib>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    // One event of a trace written by WriteChromeTrace, which puts every event on its own line.
+    struct TraceEvent
+    {
+        std::string name;
+        std::string phase;
+        int         tid;
+        double      ts;
+    };
+
+    std::string GetField(const std::string& line, const std::string& key)
+    {
+        const auto start = line.find("\"" + key + "\":");
+        if (start == std::string::npos)
+            return {};
+
+        size_t begin = start + key.size() + 3;
+        if (line[begin] == '"')
+        {
+            begin++;
+            return line.substr(begin, line.find('"', begin) - begin);
+        }
+        return line.substr(begin, line.find_first_of(",}", begin) - begin);
+    }
+
+    std::vector<TraceEvent> ParseTrace(const std::string& trace)
+    {
+        CHECK(trace.rfind("{\"traceEvents\":[\n", 0) == 0);
+        CHECK(trace.size() > 4 && trace.compare(trace.size() - 4, 4, "\n]}\n") == 0);
+
+        std::vector<TraceEvent> events;
+        std::istringstream stream(trace);
+        std::string line;
+        std::getline(stream, line);
+        while (std::getline(stream, line) && line != "]}")
+        {
+            // An empty trace has an empty line between its brackets.
+            if (line.empty())
+                continue;
+
+            CHECK(line.front() == '{');
+            events.push_back({ GetField(line, "name"), GetField(line, "ph"),
+                               std::atoi(GetField(line, "tid").c_str()), std::atof(GetField(line, "ts").c_str()) });
+        }
+        return events;
+    }
+
+    // Every begin event is closed by an end event of the same name on its thread, in nesting order and time order.
+    // Returns the number of begin events.
+    size_t CheckBalanced(const std::vector<TraceEvent>& events)
+    {
+        std::map<int, std::vector<const TraceEvent*>> open;
+        std::map<int, double> lastTime;
+        size_t begins = 0;
+        for (const auto& event : events)
+        {
+            if (event.phase != "B" && event.phase != "E")
+                continue;
+
+            CHECK(!lastTime.count(event.tid) || event.ts >= lastTime[event.tid]);
+            lastTime[event.tid] = event.ts;
+
+            auto& stack = open[event.tid];
+            if (event.phase == "B")
+            {
+                stack.push_back(&event);
+                begins++;
+            }
+            else
+            {
+                CHECK(!stack.empty());
+                CHECK(stack.back()->name == event.name);
+                stack.pop_back();
+            }
+        }
+
+        for (const auto& thread : open)
+        {
+            CHECK(thread.second.empty());
+        }
+        return begins;
+    }
+
+    // A scope that would not leave room for the ends of the open scopes is dropped with everything nested in it,
+    // and every recorded begin still pairs with its end.
+    void TestFullRing()
+    {
+        CpuProfiler profiler(8, 4);
+
+        // Four nested scopes use four events and reserve four for their ends.
+        CHECK(profiler.BeginScope("A"));
+        CHECK(profiler.BeginScope("B"));
+        CHECK(profiler.BeginScope("C"));
+        CHECK(profiler.BeginScope("D"));
+        {
+            // Dropped, and F with it. Only E counts as dropped.
+            ProfileScope e(profiler, "E");
+            ProfileScope f(profiler, "F");
+        }
+        CHECK(profiler.GetDroppedScopeCount() == 1);
+        profiler.EndScope();
+        profiler.EndScope();
+        profiler.EndScope();
+        profiler.EndScope();
+
+        // The ring is full until it is collected.
+        {
+            ProfileScope g(profiler, "G");
+        }
+        CHECK(profiler.GetDroppedScopeCount() == 2);
+
+        // An end without a begin is ignored.
+        profiler.EndScope();
+
+        profiler.EndFrame();
+        const ProfileFrame* frame = profiler.GetLastFrame();
+        CHECK(frame && frame->number == 0);
+        CHECK(frame->samples.size() == 4);
+        const char* names[] = { "A", "B", "C", "D" };
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            const auto& sample = frame->samples[i];
+            CHECK(std::string(sample.name) == names[i]);
+            CHECK(sample.depth == i);
+            CHECK(sample.thread == 0);
+            CHECK(sample.begin <= sample.end);
+            CHECK(sample.begin >= frame->begin && sample.end <= frame->end);
+        }
+        CHECK(frame->samples[0].end >= frame->samples[1].end);
+
+        // Collecting made room again.
+        {
+            ProfileScope h(profiler, "H");
+            ProfileScope i(profiler, "I");
+        }
+        profiler.EndFrame();
+        CHECK(profiler.GetLastFrame()->samples.size() == 2);
+        CHECK(profiler.GetDroppedScopeCount() == 2);
+
+        // Disabled, nothing is recorded and EndScope must not be called.
+        profiler.SetEnabled(false);
+        CHECK(!profiler.BeginScope("Disabled"));
+        profiler.SetEnabled(true);
+        profiler.EndFrame();
+        CHECK(profiler.GetLastFrame()->samples.empty());
+
+        CHECK_THROWS(CpuProfiler(1), std::out_of_range);
+        CHECK_THROWS(CpuProfiler(8, 0), std::out_of_range);
+    }
+
+    // A scope that spans frames is collected with the frame it ends in; frames beyond the history are discarded.
+    void TestFrames()
+    {
+        CpuProfiler profiler(64, 2);
+
+        CHECK(profiler.BeginScope("Long"));
+        profiler.EndFrame();
+        CHECK(profiler.GetLastFrame()->samples.empty());
+
+        {
+            ProfileScope child(profiler, "Child");
+        }
+        profiler.EndScope();
+        profiler.EndFrame();
+
+        const ProfileFrame* frame = profiler.GetLastFrame();
+        CHECK(frame->number == 1);
+        CHECK(frame->samples.size() == 2);
+        CHECK(std::string(frame->samples[0].name) == "Long");
+        CHECK(frame->samples[0].begin < frame->begin);
+        CHECK(std::string(frame->samples[1].name) == "Child");
+        CHECK(frame->samples[1].depth == 1);
+
+        profiler.EndFrame();
+        CHECK(profiler.GetFrames().size() == 2);
+        CHECK(profiler.GetFrames().front().number == 1);
+    }
+
+    // Nested scopes on several threads, one of them left open by an earlier frame, and a ring that drops scopes:
+    // the trace still has one balanced begin and end per collected sample.
+    void TestChromeTrace()
+    {
+        CpuProfiler profiler(16, 8);
+        profiler.SetThreadName("Main \"thread\"");
+
+        CHECK(profiler.BeginScope("Frame"));
+        profiler.EndFrame();
+
+        for (int i = 0; i < 3; i++)
+        {
+            ProfileScope update(profiler, "Update");
+            {
+                ProfileScope physics(profiler, "Physics");
+            }
+            ProfileScope render(profiler, "Render");
+        }
+        profiler.EndScope();
+
+        std::thread worker([&]()
+        {
+            profiler.SetThreadName("Worker");
+            for (int i = 0; i < 20; i++)
+            {
+                ProfileScope job(profiler, "Job");
+                ProfileScope nested(profiler, "Nested");
+            }
+        });
+        worker.join();
+        profiler.EndFrame();
+
+        CHECK(profiler.GetDroppedScopeCount() > 0);
+
+        size_t sampleCount = 0;
+        for (const auto& frame : profiler.GetFrames())
+        {
+            sampleCount += frame.samples.size();
+        }
+
+        std::ostringstream stream;
+        profiler.WriteChromeTrace(stream);
+        const auto events = ParseTrace(stream.str());
+        CHECK(CheckBalanced(events) == sampleCount);
+
+        // Thread names are escaped, and each frame is marked.
+        CHECK(stream.str().find("\"Main \\\"thread\\\"\"") != std::string::npos);
+        size_t threadNames = 0, frameMarkers = 0;
+        for (const auto& event : events)
+        {
+            threadNames += event.phase == "M" ? 1 : 0;
+            frameMarkers += event.phase == "i" ? 1 : 0;
+        }
+        CHECK(threadNames == 2);
+        CHECK(frameMarkers == 2);
+
+        // An empty profiler writes an empty trace.
+        CpuProfiler empty;
+        std::ostringstream emptyStream;
+        empty.WriteChromeTrace(emptyStream);
+        CHECK(CheckBalanced(ParseTrace(emptyStream.str())) == 0);
+    }
+}
+
+int main()
+{
+    TestFullRing();
+    TestFrames();
+    TestChromeTrace();
+
+    std::puts("CpuProfilerTests: passed");
+    return 0;
+}
@@ -0,0 +1,197 @@
+//
+// DescriptorAllocatorTests.cpp - Persistent and transient descriptor slots, with frees deferred by fence
+//
+
+#include "Check.h"
+
+#include "DescriptorAllocator.h"
+
+#include <atomic>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    // Freeing a slot bumps its generation, so handles kept after Free are stale, and freeing them again throws.
+    void TestGenerations()
+    {
+        DescriptorAllocator allocator(4, 8, 3);
+        CHECK(allocator.GetDescriptorCount() == 4 + 3 * 8);
+
+        const auto first = allocator.Allocate();
+        const auto second = allocator.Allocate();
+        CHECK(first.IsValid() && second.IsValid());
+        CHECK(first.index != second.index);
+        CHECK(allocator.IsCurrent(first) && allocator.IsCurrent(second));
+        CHECK(allocator.GetAllocatedCount() == 2);
+
+        allocator.Free(second);
+        CHECK(!allocator.IsCurrent(second));
+        CHECK(allocator.IsCurrent(first));
+        CHECK(allocator.GetAllocatedCount() == 1);
+
+        CHECK_THROWS(allocator.Free(second), std::invalid_argument);
+
+        DescriptorHandle outOfRange;
+        outOfRange.index = allocator.GetPersistentCount();
+        CHECK(!allocator.IsCurrent(outOfRange));
+        CHECK_THROWS(allocator.Free(outOfRange), std::invalid_argument);
+    }
+
+    // A freed slot is reused only once the fence of the frame that freed it has completed, with a new generation.
+    void TestDeferredRecycle()
+    {
+        DescriptorAllocator allocator(4, 8, 3);
+
+        DescriptorHandle handles[4];
+        for (auto& handle : handles)
+        {
+            handle = allocator.Allocate();
+        }
+        CHECK(!allocator.TryAllocate().IsValid());
+        CHECK_THROWS(allocator.Allocate(), std::length_error);
+
+        const auto freed = handles[1];
+        allocator.Free(freed);
+
+        // Not reusable until the frame that freed it has ended...
+        allocator.BeginFrame(0, 0);
+        CHECK(!allocator.TryAllocate().IsValid());
+        allocator.EndFrame(1);
+
+        // ...and its fence value has completed.
+        allocator.BeginFrame(1, 0);
+        CHECK(!allocator.TryAllocate().IsValid());
+        allocator.EndFrame(2);
+
+        allocator.BeginFrame(2, 1);
+        const auto reused = allocator.TryAllocate();
+        CHECK(reused.IsValid());
+        CHECK(reused.index == freed.index);
+        CHECK(reused.generation != freed.generation);
+        CHECK(allocator.IsCurrent(reused));
+        CHECK(!allocator.IsCurrent(freed));
+        allocator.EndFrame(3);
+
+        // RetireAll recycles the frees of ended frames without waiting for their fence.
+        allocator.BeginFrame(0, 1);
+        allocator.Free(reused);
+        allocator.EndFrame(4);
+        allocator.RetireAll();
+        CHECK(allocator.TryAllocate().IsValid());
+    }
+
+    // Each frame bump allocates from its own region, which is reset when the frame index comes around again.
+    void TestTransientRegions()
+    {
+        const uint32_t persistentCount = 4;
+        const uint32_t transientCount = 8;
+        DescriptorAllocator allocator(persistentCount, transientCount, 3);
+
+        allocator.BeginFrame(2, 0);
+        const uint32_t regionBase = persistentCount + 2 * transientCount;
+        CHECK(allocator.AllocateTransient(3) == regionBase);
+        CHECK(allocator.AllocateTransient(5) == regionBase + 3);
+        CHECK(allocator.GetTransientUsedCount() == transientCount);
+
+        // The region is exhausted; a failed allocation does not eat into the next frame's region.
+        CHECK(allocator.AllocateTransient(1) == DescriptorHandle::c_InvalidIndex);
+        allocator.EndFrame(1);
+
+        allocator.BeginFrame(0, 1);
+        CHECK(allocator.GetTransientUsedCount() == 0);
+        CHECK(allocator.AllocateTransient(transientCount) == persistentCount);
+        CHECK(allocator.AllocateTransient(transientCount + 1) == DescriptorHandle::c_InvalidIndex);
+        allocator.EndFrame(2);
+
+        allocator.BeginFrame(2, 2);
+        CHECK(allocator.AllocateTransient() == regionBase);
+        allocator.EndFrame(3);
+    }
+
+    // Threads allocate and free concurrently while the frame loop recycles; every slot is recovered exactly once.
+    void TestConcurrentAllocateFree()
+    {
+        const uint32_t persistentCount = 1000;
+        DescriptorAllocator allocator(persistentCount, 64, 2);
+
+        std::atomic<uint32_t> staleHandles{ 0 };
+        std::atomic<uint32_t> runningThreads{ 4 };
+        std::vector<std::thread> threads;
+        for (int thread = 0; thread < 4; thread++)
+        {
+            threads.emplace_back([&]()
+            {
+                std::vector<DescriptorHandle> handles;
+                for (int i = 0; i < 50000; i++)
+                {
+                    if (handles.size() < 50)
+                    {
+                        const auto handle = allocator.TryAllocate();
+                        if (handle.IsValid())
+                        {
+                            if (!allocator.IsCurrent(handle))
+                            {
+                                staleHandles++;
+                            }
+                            handles.push_back(handle);
+                        }
+                    }
+                    else
+                    {
+                        allocator.Free(handles.back());
+                        handles.pop_back();
+                    }
+                }
+
+                for (const auto& handle : handles)
+                {
+                    allocator.Free(handle);
+                }
+                runningThreads--;
+            });
+        }
+
+        // The GPU runs two frames behind.
+        uint64_t fenceValue = 0;
+        for (unsigned frame = 0; runningThreads != 0; frame++)
+        {
+            allocator.BeginFrame(frame % 2, fenceValue > 2 ? fenceValue - 2 : 0);
+            allocator.EndFrame(++fenceValue);
+            std::this_thread::yield();
+        }
+
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+
+        allocator.EndFrame(++fenceValue);
+        allocator.RetireAll();
+        CHECK(staleHandles == 0);
+        CHECK(allocator.GetAllocatedCount() == 0);
+
+        std::set<uint32_t> indices;
+        for (DescriptorHandle handle = allocator.TryAllocate(); handle.IsValid(); handle = allocator.TryAllocate())
+        {
+            CHECK(handle.index < persistentCount);
+            CHECK(indices.insert(handle.index).second);
+        }
+        CHECK(indices.size() == persistentCount);
+    }
+}
+
+int main()
+{
+    TestGenerations();
+    TestDeferredRecycle();
+    TestTransientRegions();
+    TestConcurrentAllocateFree();
+
+    std::puts("DescriptorAllocatorTests: passed");
+    return 0;
+}
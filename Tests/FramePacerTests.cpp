@@ -0,0 +1,147 @@
+//
+// FramePacerTests.cpp - Frames in flight paced against a simulated fence
+//
+
+#include "Check.h"
+
+#include "FramePacer.h"
+#include "NullRenderBackend.h"
+
+#include <stdexcept>
+
+using namespace DX;
+
+namespace
+{
+    // The CPU never records more than framesInFlight frames ahead of what the GPU completed.
+    void EndFrames(FramePacer& pacer, int frameCount)
+    {
+        for (int frame = 0; frame < frameCount; frame++)
+        {
+            pacer.EndFrame();
+            CHECK(pacer.GetCurrentFenceValue() - pacer.GetCompletedFenceValue() <= pacer.GetFramesInFlight());
+        }
+    }
+
+    // The CPU only waits once the GPU is as many frames behind as there are slots.
+    void TestStalls()
+    {
+        for (unsigned int framesInFlight = 1; framesInFlight <= 3; framesInFlight++)
+        {
+            // One frame short of filling the ring: never stalls.
+            {
+                SimulatedFence fence(framesInFlight - 1);
+                FramePacer pacer(framesInFlight);
+                pacer.SetFence(&fence);
+                EndFrames(pacer, 10);
+                CHECK(pacer.GetStalledFrameCount() == 0);
+                CHECK(pacer.GetTotalStallSeconds() == 0);
+                CHECK(fence.GetWaitCount() == 0);
+            }
+
+            // Once the ring is full, every frame waits for the oldest one.
+            for (uint64_t latency = framesInFlight; latency <= framesInFlight + 2; latency++)
+            {
+                SimulatedFence fence(latency);
+                FramePacer pacer(framesInFlight);
+                pacer.SetFence(&fence);
+                EndFrames(pacer, 10);
+                CHECK(pacer.GetStalledFrameCount() == 10 - (framesInFlight - 1));
+                CHECK(fence.GetWaitCount() == pacer.GetStalledFrameCount());
+                CHECK(pacer.GetFrameCount() == 10);
+                CHECK(pacer.GetFrameIndex() == 10 % framesInFlight);
+            }
+        }
+    }
+
+    // Resizing the ring waits for idle and starts over at slot 0; the requested size is clamped.
+    void TestSetFramesInFlight()
+    {
+        SimulatedFence fence(1);
+        FramePacer pacer(3);
+        pacer.SetFence(&fence);
+        EndFrames(pacer, 4);
+        CHECK(pacer.GetFrameIndex() == 1);
+        CHECK(pacer.GetCompletedFenceValue() == 3);
+
+        // Shrinking.
+        pacer.SetFramesInFlight(1);
+        CHECK(pacer.GetFramesInFlight() == 1);
+        CHECK(pacer.GetFrameIndex() == 0);
+        CHECK(pacer.GetCompletedFenceValue() == 4);
+        EndFrames(pacer, 3);
+        CHECK(pacer.GetFrameIndex() == 0);
+        CHECK(pacer.GetStalledFrameCount() == 3);
+
+        // Growing: the new slots have nothing in flight.
+        pacer.SetFramesInFlight(4);
+        CHECK(pacer.GetFramesInFlight() == 4);
+        CHECK(pacer.GetFrameIndex() == 0);
+        const unsigned int indices[] = { 1, 2, 3, 0, 1 };
+        for (const unsigned int index : indices)
+        {
+            EndFrames(pacer, 1);
+            CHECK(pacer.GetFrameIndex() == index);
+        }
+        CHECK(pacer.GetStalledFrameCount() == 3);
+
+        // The same size again neither waits nor moves the slot.
+        const uint64_t waits = fence.GetWaitCount();
+        pacer.SetFramesInFlight(4);
+        CHECK(fence.GetWaitCount() == waits);
+        CHECK(pacer.GetFrameIndex() == 1);
+
+        pacer.SetFramesInFlight(FramePacer::c_MaxFramesInFlight + 5);
+        CHECK(pacer.GetFramesInFlight() == FramePacer::c_MaxFramesInFlight);
+        fence.SetLatency(FramePacer::c_MaxFramesInFlight - 1);
+        EndFrames(pacer, 20);
+        CHECK(pacer.GetStalledFrameCount() == 3);
+
+        pacer.SetFramesInFlight(0);
+        CHECK(pacer.GetFramesInFlight() == 1);
+
+        // Constructed with a bad size is a programming error.
+        CHECK_THROWS(FramePacer(0), std::out_of_range);
+        CHECK_THROWS(FramePacer(FramePacer::c_MaxFramesInFlight + 1), std::out_of_range);
+    }
+
+    // WaitForIdle completes every submitted frame without signaling the one being recorded.
+    void TestWaitForIdle()
+    {
+        SimulatedFence fence(3);
+        FramePacer pacer(2);
+        pacer.SetFence(&fence);
+        EndFrames(pacer, 5);
+        CHECK(pacer.GetCompletedFenceValue() < pacer.GetCurrentFenceValue() - 1);
+
+        pacer.WaitForIdle();
+        CHECK(pacer.GetCompletedFenceValue() == pacer.GetCurrentFenceValue() - 1);
+        CHECK(fence.GetSignaledValue() == pacer.GetCompletedFenceValue());
+        CHECK(pacer.GetCurrentFenceValue() == 6);
+
+        // After the fence is recreated the values start over.
+        SimulatedFence newFence(1);
+        pacer.SetFence(&newFence);
+        pacer.Reset();
+        CHECK(pacer.GetFrameIndex() == 0);
+        CHECK(pacer.GetCurrentFenceValue() == 1);
+        EndFrames(pacer, 3);
+        CHECK(newFence.GetSignaledValue() == 3);
+
+        // Without a fence every submitted frame counts as complete, and nothing can be submitted.
+        FramePacer unfenced(2);
+        unfenced.WaitForIdle();
+        CHECK(unfenced.GetCompletedFenceValue() == 0);
+        CHECK_THROWS(unfenced.EndFrame(), std::logic_error);
+    }
+}
+
+int main()
+{
+    TestStalls();
+    TestSetFramesInFlight();
+    TestWaitForIdle();
+
+    std::puts("FramePacerTests: passed");
+    return 0;
+}
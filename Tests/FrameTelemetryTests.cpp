@@ -0,0 +1,286 @@
+//
+// FrameTelemetryTests.cpp - Frame time percentiles, stutter detection and the binary log
+//
+
+#include "Check.h"
+
+#include "FrameTelemetry.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+using namespace DX;
+
+namespace
+{
+    // 60 frames per second, in StepTimer ticks.
+    const uint64_t c_Frame = 166667;
+
+    bool StatsEqual(const FrameTimeStats& a, const FrameTimeStats& b)
+    {
+        return std::memcmp(&a, &b, sizeof(FrameTimeStats)) == 0;
+    }
+
+    // Every bucket holds the values between its bounds and no others, and above c_SubBucketCount a bucket is
+    // never wider than 1/c_SubBucketHalfCount of its lower bound.
+    void TestBuckets()
+    {
+        for (uint64_t value = 0; value < FrameTimeHistogram::c_SubBucketCount; value++)
+        {
+            CHECK(FrameTimeHistogram::GetBucketIndex(value) == value);
+            CHECK(FrameTimeHistogram::GetBucketLowerBound(value) == value);
+            CHECK(FrameTimeHistogram::GetBucketUpperBound(value) == value);
+        }
+
+        CHECK(FrameTimeHistogram::GetBucketIndex(1024) == 1024);
+        CHECK(FrameTimeHistogram::GetBucketIndex(1025) == 1024);
+        CHECK(FrameTimeHistogram::GetBucketIndex(1026) == 1025);
+        CHECK(FrameTimeHistogram::GetBucketIndex(2047) == 1535);
+        CHECK(FrameTimeHistogram::GetBucketIndex(2048) == 1536);
+        CHECK(FrameTimeHistogram::GetBucketLowerBound(1536) == 2048);
+        CHECK(FrameTimeHistogram::GetBucketUpperBound(1536) == 2051);
+        CHECK(FrameTimeHistogram::GetBucketIndex(UINT64_MAX) == FrameTimeHistogram::c_BucketCount - 1);
+
+        for (size_t index = FrameTimeHistogram::c_SubBucketCount; index < FrameTimeHistogram::c_BucketCount; index++)
+        {
+            const uint64_t lower = FrameTimeHistogram::GetBucketLowerBound(index);
+            const uint64_t upper = FrameTimeHistogram::GetBucketUpperBound(index);
+            CHECK(lower == FrameTimeHistogram::GetBucketUpperBound(index - 1) + 1);
+            CHECK(FrameTimeHistogram::GetBucketIndex(lower) == index);
+            CHECK(FrameTimeHistogram::GetBucketIndex(upper) == index);
+            CHECK(upper - lower < lower / FrameTimeHistogram::c_SubBucketHalfCount);
+        }
+        CHECK(FrameTimeHistogram::GetBucketUpperBound(FrameTimeHistogram::c_BucketCount - 1) == UINT64_MAX);
+    }
+
+    // Below c_SubBucketCount the percentiles are exact.
+    void TestExactPercentiles()
+    {
+        FrameTimeHistogram histogram;
+        CHECK(histogram.GetValueAtPercentile(50.0) == 0);
+
+        for (uint64_t value = 1000; value >= 1; value--)
+        {
+            histogram.Record(value);
+        }
+
+        CHECK(histogram.GetCount() == 1000);
+        CHECK(histogram.GetMin() == 1);
+        CHECK(histogram.GetMax() == 1000);
+        CHECK(histogram.GetMean() == 500);
+        CHECK(histogram.GetValueAtPercentile(0.0) == 1);
+        CHECK(histogram.GetValueAtPercentile(50.0) == 500);
+        CHECK(histogram.GetValueAtPercentile(95.0) == 950);
+        CHECK(histogram.GetValueAtPercentile(99.0) == 990);
+        CHECK(histogram.GetValueAtPercentile(99.9) == 999);
+        CHECK(histogram.GetValueAtPercentile(100.0) == 1000);
+        CHECK(histogram.GetValueAtPercentile(250.0) == 1000);
+
+        histogram.Reset();
+        CHECK(histogram.GetCount() == 0);
+        CHECK(histogram.GetMin() == 0);
+        CHECK(histogram.GetMax() == 0);
+        CHECK(histogram.GetValueAtPercentile(99.0) == 0);
+    }
+
+    // Above 2^10 ticks a percentile is the top of its bucket: never below the exact value, and at most
+    // 1/c_SubBucketHalfCount above it.
+    void TestBucketedPercentiles()
+    {
+        FrameTimeHistogram histogram;
+        for (uint64_t i = 0; i < 1000; i++)
+        {
+            histogram.Record(100000 + i * 1000);
+        }
+
+        const struct
+        {
+            double percentile;
+            uint64_t exact;
+        } expectations[] = {
+            { 50.0, 100000 + 499 * 1000 },
+            { 95.0, 100000 + 949 * 1000 },
+            { 99.0, 100000 + 989 * 1000 },
+            { 99.9, 100000 + 998 * 1000 },
+        };
+        for (const auto& expectation : expectations)
+        {
+            const uint64_t value = histogram.GetValueAtPercentile(expectation.percentile);
+            CHECK(value >= expectation.exact);
+            CHECK(value - expectation.exact <= expectation.exact / FrameTimeHistogram::c_SubBucketHalfCount);
+        }
+        CHECK(histogram.GetValueAtPercentile(100.0) == 100000 + 999 * 1000);
+
+        // A steady frame rate with one hitch in a hundred frames: only p99.9 sees the hitch, as the largest value.
+        histogram.Reset();
+        for (int i = 0; i < 1000; i++)
+        {
+            histogram.Record(i % 100 == 99 ? 10 * c_Frame : c_Frame);
+        }
+
+        for (const double percentile : { 50.0, 95.0, 99.0 })
+        {
+            const uint64_t value = histogram.GetValueAtPercentile(percentile);
+            CHECK(value >= c_Frame && value - c_Frame <= c_Frame / FrameTimeHistogram::c_SubBucketHalfCount);
+        }
+        CHECK(histogram.GetValueAtPercentile(99.9) == 10 * c_Frame);
+        CHECK(histogram.GetMax() == 10 * c_Frame);
+    }
+
+    // A stutter stands out from the baseline by the factor and the minimum excess; the baseline follows a lasting
+    // slowdown, and a frame StepTimer clamped is always a stutter.
+    void TestStutters()
+    {
+        FrameTelemetry telemetry(4, 2.0, 10000);
+
+        CHECK(!telemetry.RecordFrame(c_Frame, false));
+        CHECK(telemetry.GetBaselineTicks() == double(c_Frame));
+        for (int i = 0; i < 20; i++)
+        {
+            CHECK(!telemetry.RecordFrame(c_Frame, false));
+        }
+        CHECK(telemetry.GetBaselineTicks() == double(c_Frame));
+
+        // Just under twice the baseline is not a stutter, three times is; the baseline moves a sixteenth of the way
+        // to the threshold, not to the hitch.
+        CHECK(!telemetry.RecordFrame(2 * c_Frame - 1, false));
+        const double baseline = telemetry.GetBaselineTicks();
+        CHECK(baseline == double(c_Frame) + double(c_Frame - 1) / 16.0);
+
+        CHECK(telemetry.RecordFrame(3 * c_Frame, false));
+        CHECK(telemetry.WasLastFrameStutter());
+        CHECK(telemetry.GetBaselineTicks() == baseline + baseline / 16.0);
+        CHECK(telemetry.GetStutterCount() == 1);
+
+        // A clamped frame is a stutter however short it is.
+        CHECK(telemetry.RecordFrame(c_Frame / 2, true));
+        CHECK(telemetry.GetStutterCount() == 2);
+        CHECK(telemetry.GetClampedCount() == 1);
+        CHECK(!telemetry.RecordFrame(c_Frame, false));
+        CHECK(!telemetry.WasLastFrameStutter());
+
+        // A lasting slowdown stutters for a few frames, until it becomes the baseline.
+        uint32_t slowStutters = 0;
+        for (int i = 0; i < 100; i++)
+        {
+            slowStutters += telemetry.RecordFrame(3 * c_Frame, false) ? 1 : 0;
+        }
+        CHECK(slowStutters > 0 && slowStutters < 20);
+        CHECK(!telemetry.WasLastFrameStutter());
+        CHECK(telemetry.GetBaselineTicks() > 2.9 * double(c_Frame));
+
+        // Twice a short baseline is not a stutter when it is less than the minimum excess longer.
+        FrameTelemetry fast(4, 2.0, 10000);
+        CHECK(!fast.RecordFrame(1000, false));
+        CHECK(!fast.RecordFrame(5000, false));
+        CHECK(fast.GetStutterCount() == 0);
+
+        // Not even the first frame, which only seeds the baseline otherwise, hides a clamp.
+        FrameTelemetry clamped(4, 2.0, 10000);
+        CHECK(clamped.RecordFrame(c_Frame, true));
+        CHECK(clamped.GetStutterCount() == 1);
+        CHECK(clamped.GetClampedCount() == 1);
+
+        const FrameTimeStats total = telemetry.GetTotalStats();
+        CHECK(total.frameCount == telemetry.GetFrameCount());
+        CHECK(total.stutterCount == telemetry.GetStutterCount());
+        CHECK(total.clampedCount == 1);
+        CHECK(total.minTicks == c_Frame / 2);
+        CHECK(total.maxTicks == 3 * c_Frame);
+
+        // Windows close every four frames.
+        CHECK(telemetry.GetWindowStats().frameCount == 4);
+        CHECK(telemetry.GetWindowStats().firstFrame % 4 == 0);
+    }
+
+    // The log holds one record per window, the last one closed early by CloseLog, and ignores a partly written record.
+    void TestLogRoundTrip()
+    {
+        const std::filesystem::path path = "FrameTelemetryTests.log";
+
+        FrameTelemetry telemetry(4);
+        CHECK_THROWS(FrameTelemetry(0), std::out_of_range);
+        CHECK_THROWS(FrameTelemetry(4, 1.0), std::out_of_range);
+
+        telemetry.OpenLog(path);
+        CHECK(telemetry.IsLogOpen());
+
+        FrameTimeStats windows[3] = {};
+        for (uint64_t frame = 0; frame < 10; frame++)
+        {
+            telemetry.RecordFrame(c_Frame + frame * 1000, frame == 6);
+            if (frame == 3 || frame == 7)
+            {
+                windows[frame / 4] = telemetry.GetWindowStats();
+            }
+        }
+        telemetry.CloseLog();
+        CHECK(!telemetry.IsLogOpen());
+        windows[2] = telemetry.GetWindowStats();
+
+        auto read = ReadFrameTelemetryLog(path);
+        CHECK(read.size() == 3);
+        for (size_t i = 0; i < 3; i++)
+        {
+            CHECK(StatsEqual(read[i], windows[i]));
+            CHECK(read[i].firstFrame == 4 * i);
+        }
+        CHECK(read[0].frameCount == 4 && read[1].frameCount == 4 && read[2].frameCount == 2);
+        CHECK(read[0].minTicks == c_Frame && read[0].maxTicks == c_Frame + 3000);
+        CHECK(read[1].clampedCount == 1 && read[1].stutterCount == 1);
+        CHECK(read[2].p50Ticks >= c_Frame + 8000 && read[2].maxTicks == c_Frame + 9000);
+
+        // A run that crashed while writing a window.
+        {
+            std::ofstream file(path, std::ios::binary | std::ios::app);
+            file.write(reinterpret_cast<const char*>(&windows[0]), sizeof(FrameTimeStats) / 2);
+        }
+        read = ReadFrameTelemetryLog(path);
+        CHECK(read.size() == 3);
+        CHECK(StatsEqual(read[2], windows[2]));
+
+        // Another file.
+        {
+            FrameTelemetryHeader header = {};
+            header.magic = 0x464C4F57;
+            header.version = c_FrameTelemetryVersion;
+            std::ofstream file(path, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        }
+        CHECK_THROWS(ReadFrameTelemetryLog(path), std::runtime_error);
+
+        // A newer version.
+        {
+            FrameTelemetryHeader header = {};
+            header.magic = c_FrameTelemetryMagic;
+            header.version = c_FrameTelemetryVersion + 1;
+            std::ofstream file(path, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        }
+        CHECK_THROWS(ReadFrameTelemetryLog(path), std::runtime_error);
+
+        // A file shorter than the header, and no file at all.
+        {
+            std::ofstream file(path, std::ios::binary | std::ios::trunc);
+            file.write("FTEL", 4);
+        }
+        CHECK_THROWS(ReadFrameTelemetryLog(path), std::runtime_error);
+
+        std::filesystem::remove(path);
+        CHECK_THROWS(ReadFrameTelemetryLog(path), std::runtime_error);
+    }
+}
+
+int main()
+{
+    TestBuckets();
+    TestExactPercentiles();
+    TestBucketedPercentiles();
+    TestStutters();
+    TestLogRoundTrip();
+
+    std::puts("FrameTelemetryTests: passed");
+    return 0;
+}
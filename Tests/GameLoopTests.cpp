@@ -0,0 +1,221 @@
+//
+// GameLoopTests.cpp - The platform-neutral frame loop on the null render backend
+//
+
+#include "Check.h"
+
+#include "GameLoop.h"
+#include "NullRenderBackend.h"
+
+#include "backends/imgui_impl_headless.h"
+
+#include <filesystem>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    const uint64_t c_FrameTicks = 166667;
+
+    std::vector<RecordedCommand> GetFrameCommands(const NullRenderBackend& backend, uint64_t frame)
+    {
+        std::vector<RecordedCommand> commands;
+        for (const auto& command : backend.GetRecordedCommands())
+        {
+            if (command.frame == frame)
+            {
+                commands.push_back(command);
+            }
+        }
+        return commands;
+    }
+
+    // Checks that commands[index] begins the named pass and returns the index of its first command.
+    size_t CheckBeginEvent(const std::vector<RecordedCommand>& commands, size_t index, const std::wstring& name)
+    {
+        CHECK(index < commands.size());
+        CHECK(commands[index].type == CommandType::BeginEvent);
+        CHECK(commands[index].name == name);
+        return index + 1;
+    }
+
+    size_t CheckTransition(const std::vector<RecordedCommand>& commands, size_t index, ResourceHandle resource,
+                           ResourceState before, ResourceState after)
+    {
+        CHECK(index < commands.size());
+        CHECK(commands[index].type == CommandType::ResourceBarrier);
+        CHECK(commands[index].barrier.type == BarrierType::Transition);
+        CHECK(commands[index].barrier.resource == resource);
+        CHECK(commands[index].barrier.before == before);
+        CHECK(commands[index].barrier.after == after);
+        return index + 1;
+    }
+
+    size_t CheckCommand(const std::vector<RecordedCommand>& commands, size_t index, CommandType type)
+    {
+        CHECK(index < commands.size());
+        CHECK(commands[index].type == type);
+        return index + 1;
+    }
+
+    size_t CheckDraw(const std::vector<RecordedCommand>& commands, size_t index, uint32_t vertexCount, uint32_t instanceCount)
+    {
+        index = CheckCommand(commands, index, CommandType::Draw);
+        CHECK(commands[index - 1].counts[0] == vertexCount);
+        CHECK(commands[index - 1].counts[1] == instanceCount);
+        return index;
+    }
+
+    // Every frame runs the four passes of GameLoop::BuildRenderGraph, on the back buffer of its frame.
+    void CheckFrame(const NullRenderBackend& backend, uint64_t frame)
+    {
+        const auto commands = GetFrameCommands(backend, frame);
+        const ResourceHandle backBuffer = NullRenderBackend::c_backBufferHandleBase + frame % backend.GetBackBufferCount();
+        const ResourceHandle sceneColor = NullTransientResourceAllocator::c_transientHandleBase;
+
+        // The scene color target starts the first frame in the render target state it is acquired in,
+        // later frames in the shader resource state the post-process left it in.
+        size_t i = 0;
+        if (frame != 0)
+        {
+            i = CheckTransition(commands, i, sceneColor, ResourceState::PixelShaderResource, ResourceState::RenderTarget);
+        }
+        else
+        {
+            i = CheckTransition(commands, i, sceneColor, ResourceState::Common, ResourceState::RenderTarget);
+        }
+
+        i = CheckBeginEvent(commands, i, L"Clear");
+        i = CheckCommand(commands, i, CommandType::ClearRenderTarget);
+        CHECK(commands[i - 1].values[0] > 0.39f && commands[i - 1].values[0] < 0.40f);
+        CHECK(commands[i - 1].values[2] > 0.92f && commands[i - 1].values[2] < 0.93f);
+        i = CheckCommand(commands, i, CommandType::ClearDepthStencil);
+        CHECK(commands[i - 1].values[0] == 1.f);
+        i = CheckCommand(commands, i, CommandType::EndEvent);
+
+        // The triangle and the two posters: one batch per primitive, as the posters share a texture while streaming is off.
+        i = CheckBeginEvent(commands, i, L"Scene");
+        i = CheckCommand(commands, i, CommandType::SetRenderTarget);
+        i = CheckDraw(commands, i, 3, 1);
+        i = CheckDraw(commands, i, 6, 2);
+        i = CheckCommand(commands, i, CommandType::EndEvent);
+
+        i = CheckTransition(commands, i, sceneColor, ResourceState::RenderTarget, ResourceState::PixelShaderResource);
+        i = CheckTransition(commands, i, backBuffer, ResourceState::Present, ResourceState::RenderTarget);
+        i = CheckBeginEvent(commands, i, L"PostProcess");
+        i = CheckCommand(commands, i, CommandType::SetRenderTarget);
+        i = CheckDraw(commands, i, 3, 1);
+        i = CheckCommand(commands, i, CommandType::EndEvent);
+
+        // The headless ImGui backend counts the UI instead of drawing it.
+        i = CheckBeginEvent(commands, i, L"UI");
+        i = CheckCommand(commands, i, CommandType::SetRenderTarget);
+        i = CheckCommand(commands, i, CommandType::EndEvent);
+
+        i = CheckTransition(commands, i, backBuffer, ResourceState::RenderTarget, ResourceState::Present);
+        i = CheckCommand(commands, i, CommandType::ExecuteCommandList);
+        i = CheckCommand(commands, i, CommandType::Present);
+        CHECK(i == commands.size());
+    }
+
+    void TestHeadlessFrames()
+    {
+        auto backend = std::make_unique<NullRenderBackend>(640, 480, 2);
+        auto& nullBackend = *backend;
+
+        ReplayClock clock(ReplayClock::c_DefaultFrequency, c_FrameTicks);
+        GameLoop game(std::move(backend));
+        game.SetClock(&clock);
+        game.InitializeHeadless();
+
+        // The first tick only starts the first update.
+        game.Tick();
+        CHECK(nullBackend.GetRecordedCommands().empty());
+        CHECK(game.GetImguiLayer().GetRebuiltFrameCount() == 0);
+
+        const uint64_t frameCount = 5;
+        for (uint64_t frame = 0; frame < frameCount; frame++)
+        {
+            game.Tick();
+        }
+
+        CHECK(nullBackend.GetPresentedFrameCount() == frameCount);
+        for (uint64_t frame = 0; frame < frameCount; frame++)
+        {
+            CheckFrame(nullBackend, frame);
+        }
+
+        // The passes are recorded on the job system, one context each.
+        CHECK(nullBackend.GetSubmittedContextCount() == 4 * frameCount);
+
+        // The UI is built every frame, and its draw data walked by the headless backend.
+        CHECK(game.GetImguiLayer().GetRebuiltFrameCount() == frameCount);
+        CHECK(ImGui_ImplHeadless_GetLastFrameStats().Vertices > 0);
+        CHECK(ImGui_ImplHeadless_GetLastFrameStats().DrawCalls > 0);
+    }
+
+    // A lost device releases the pooled contexts; recording continues with new ones after the restore.
+    void TestDeviceLost()
+    {
+        auto backend = std::make_unique<NullRenderBackend>(320, 200, 3);
+        auto& nullBackend = *backend;
+
+        ReplayClock clock(ReplayClock::c_DefaultFrequency, c_FrameTicks);
+        GameLoop game(std::move(backend));
+        game.SetClock(&clock);
+        game.InitializeHeadless();
+
+        for (int frame = 0; frame < 4; frame++)
+        {
+            game.Tick();
+        }
+
+        game.OnDeviceLost();
+        game.OnDeviceRestored();
+        game.Tick();
+
+        CHECK(nullBackend.GetPresentedFrameCount() == 4);
+        CheckFrame(nullBackend, 3);
+    }
+
+    // Every tick after the first is recorded by the update job, handed to the UI with the next tick, and logged.
+    void TestTelemetry()
+    {
+        const std::filesystem::path path = "GameLoopTests.telemetry";
+        {
+            ReplayClock clock(ReplayClock::c_DefaultFrequency, c_FrameTicks);
+            GameLoop game(std::make_unique<NullRenderBackend>(320, 200, 2));
+            game.SetClock(&clock);
+            game.InitializeHeadless();
+            game.OpenTelemetryLog(path);
+
+            for (int tick = 0; tick < 6; tick++)
+            {
+                game.Tick();
+            }
+
+            const auto& stats = game.GetImguiLayer().GetTotalFrameTimeStats();
+            CHECK(stats.frameCount == 4);
+            CHECK(stats.minTicks == c_FrameTicks && stats.p99Ticks == c_FrameTicks);
+            CHECK(stats.stutterCount == 0);
+        }
+
+        // The game finishes the log with the frame of its last tick.
+        const auto windows = ReadFrameTelemetryLog(path);
+        CHECK(windows.size() == 1);
+        CHECK(windows[0].frameCount == 5);
+        CHECK(windows[0].maxTicks == c_FrameTicks);
+        std::filesystem::remove(path);
+    }
+}
+
+int main()
+{
+    TestHeadlessFrames();
+    TestDeviceLost();
+    TestTelemetry();
+
+    std::puts("GameLoopTests: passed");
+    return 0;
+}
@@ -0,0 +1,190 @@
+//
+// GpuProfilerTests.cpp - Scope timings resolved from a fake timestamp source
+//
+
+#include "Check.h"
+
+#include "GpuProfiler.h"
+
+#include <cmath>
+#include <map>
+#include <stdexcept>
+
+using namespace DX;
+
+namespace
+{
+    // Timestamps written by the test, by query index. Queries survive from frame to frame, like a query heap.
+    class FakeTimestampSource : public ITimestampSource
+    {
+    public:
+        uint64_t GetTimestampFrequency() override { return 1000000; }
+
+        void ReadTimestamps(uint32_t first, uint32_t count, uint64_t* timestamps) override
+        {
+            m_readCount++;
+            for (uint32_t i = 0; i < count; i++)
+            {
+                timestamps[i] = m_queries[first + i];
+            }
+        }
+
+        // Microseconds, as the frequency is 1 MHz.
+        void Write(uint32_t query, uint64_t timestamp) { m_queries[query] = timestamp; }
+
+        int GetReadCount() const noexcept { return m_readCount; }
+
+    private:
+        std::map<uint32_t, uint64_t>    m_queries;
+        int                             m_readCount = 0;
+    };
+
+    bool IsNear(double value, double expected)
+    {
+        return std::fabs(value - expected) < 1e-9;
+    }
+
+    // Writes both timestamps of a scope and ends it, as DeviceResources::EndGpuScope does.
+    uint32_t TimeScope(GpuProfiler& profiler, FakeTimestampSource& source, const wchar_t* name, uint64_t begin, uint64_t end)
+    {
+        const uint32_t scope = profiler.BeginScope(name);
+        CHECK(scope != GpuProfiler::c_InvalidScope);
+        source.Write(profiler.GetBeginQuery(scope), begin);
+        source.Write(profiler.GetEndQuery(scope), end);
+        profiler.EndScope(scope);
+        return scope;
+    }
+
+    // A frame is read once its fence has completed; scopes with one name in a frame add up.
+    void TestResolve()
+    {
+        GpuProfiler profiler(4, 2, 8);
+        FakeTimestampSource source;
+        CHECK(profiler.GetQueryCount() == 16);
+
+        profiler.BeginFrame(0, 0, source);
+        const uint32_t frameScope = TimeScope(profiler, source, L"Frame", 1000, 11000);
+        TimeScope(profiler, source, L"Pass", 2000, 3000);
+        const uint32_t lastScope = TimeScope(profiler, source, L"Pass", 4000, 6000);
+        CHECK(profiler.GetBeginQuery(frameScope) == 0);
+        CHECK(profiler.GetEndQuery(lastScope) == 5);
+
+        uint32_t first = 0;
+        uint32_t count = 0;
+        profiler.GetFrameQueries(first, count);
+        CHECK(first == 0 && count == 6);
+        profiler.EndFrame(1);
+
+        // Frame 0 has not completed: nothing is read.
+        profiler.BeginFrame(1, 0, source);
+        CHECK(source.GetReadCount() == 0);
+        CHECK(profiler.GetTimings().empty());
+        CHECK(profiler.GetBeginQuery(TimeScope(profiler, source, L"Frame", 0, 5000)) == 8);
+        profiler.EndFrame(2);
+
+        // Its queries cannot be handed out again while it is in flight.
+        CHECK_THROWS(profiler.BeginFrame(0, 0, source), std::logic_error);
+
+        profiler.BeginFrame(0, 2, source);
+        CHECK(source.GetReadCount() == 2);
+        CHECK(profiler.GetResolvedFrameCount() == 2);
+
+        const auto timings = profiler.GetTimings();
+        CHECK(timings.size() == 2);
+        CHECK(timings[0].name == "Frame");
+        CHECK(timings[0].sampleCount == 2);
+        CHECK(IsNear(timings[0].lastMs, 5.0));
+        CHECK(IsNear(timings[0].maxMs, 10.0));
+        CHECK(timings[1].name == "Pass");
+        CHECK(timings[1].sampleCount == 1);
+        CHECK(IsNear(timings[1].lastMs, 3.0));
+    }
+
+    // A scope that is begun but never ended is skipped, although its end query still holds a later
+    // timestamp written by the previous frame that used it.
+    void TestUnendedScope()
+    {
+        GpuProfiler profiler(2, 1, 8);
+        FakeTimestampSource source;
+
+        profiler.BeginFrame(0, 0, source);
+        TimeScope(profiler, source, L"Frame", 0, 4000);
+        TimeScope(profiler, source, L"Pass", 1000, 2000);
+        profiler.EndFrame(1);
+
+        profiler.BeginFrame(0, 1, source);
+        TimeScope(profiler, source, L"Frame", 10000, 13000);
+        const uint32_t scope = profiler.BeginScope(L"Pass");
+        source.Write(profiler.GetBeginQuery(scope), 500);
+        profiler.EndFrame(2);
+
+        profiler.BeginFrame(0, 2, source);
+        const auto timings = profiler.GetTimings();
+        CHECK(timings.size() == 2);
+        CHECK(timings[0].sampleCount == 2);
+        CHECK(IsNear(timings[0].lastMs, 3.0));
+        CHECK(timings[1].sampleCount == 1);
+        CHECK(IsNear(timings[1].lastMs, 1.0));
+
+        // Ending an invalid scope is ignored.
+        profiler.EndScope(GpuProfiler::c_InvalidScope);
+    }
+
+    // Scopes beyond the frame's budget are counted and get no queries.
+    void TestOverflow()
+    {
+        GpuProfiler profiler(4, 1, 8);
+        FakeTimestampSource source;
+
+        profiler.BeginFrame(0, 0, source);
+        for (int i = 0; i < 6; i++)
+        {
+            const uint32_t scope = profiler.BeginScope(L"Pass");
+            CHECK((scope == GpuProfiler::c_InvalidScope) == (i >= 4));
+        }
+        CHECK(profiler.GetOverflowCount() == 2);
+
+        uint32_t first = 0;
+        uint32_t count = 0;
+        profiler.GetFrameQueries(first, count);
+        CHECK(first == 0 && count == 8);
+    }
+
+    // The history keeps the last historyLength frames; percentiles are nearest-rank.
+    void TestHistory()
+    {
+        GpuProfiler profiler(1, 1, 100);
+        FakeTimestampSource source;
+
+        for (uint64_t frame = 1; frame <= 150; frame++)
+        {
+            profiler.BeginFrame(0, frame - 1, source);
+            TimeScope(profiler, source, L"Pass", 0, frame * 1000);
+            profiler.EndFrame(frame);
+        }
+        profiler.BeginFrame(0, 150, source);
+
+        const auto timings = profiler.GetTimings();
+        CHECK(timings.size() == 1);
+        CHECK(timings[0].sampleCount == 100);
+        CHECK(IsNear(timings[0].lastMs, 150.0));
+        CHECK(IsNear(timings[0].averageMs, 100.5));
+        CHECK(IsNear(timings[0].p50Ms, 100.0));
+        CHECK(IsNear(timings[0].p95Ms, 145.0));
+        CHECK(IsNear(timings[0].p99Ms, 149.0));
+        CHECK(IsNear(timings[0].maxMs, 150.0));
+
+        CHECK_THROWS(GpuProfiler(0, 1), std::out_of_range);
+    }
+}
+
+int main()
+{
+    TestResolve();
+    TestUnendedScope();
+    TestOverflow();
+    TestHistory();
+
+    std::puts("GpuProfilerTests: passed");
+    return 0;
+}
@@ -0,0 +1,288 @@
+//
+// ImguiDx12StreamTests.cpp - Placement of the DirectX 12 ImGui backend's uploads, on chunks from a fake allocator
+//
+
+#include "Check.h"
+
+#include "backends/imgui_impl_dx12_stream.h"
+#include "imgui_internal.h"
+
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace
+{
+    // Fake GPU addresses: the n-th chunk created starts at n * c_GpuAddressStride, whichever stream it is for.
+    const ImU64 c_GpuAddressStride = 1ull << 32;
+
+    const size_t c_MinChunkSize = 1024;
+
+    // Chunks handed out by CreateChunk, in creation order, kept until the next test resets them.
+    std::vector<std::unique_ptr<char[]>> g_chunkMemory;
+    bool g_failCreate = false;
+
+    bool CreateChunk(size_t size, ImGui_ImplDX12_BufferChunk* out_chunk)
+    {
+        if (g_failCreate)
+        {
+            return false;
+        }
+
+        g_chunkMemory.push_back(std::make_unique<char[]>(size));
+        out_chunk->Resource = nullptr;
+        out_chunk->CpuAddress = g_chunkMemory.back().get();
+        out_chunk->GpuAddress = g_chunkMemory.size() * c_GpuAddressStride;
+        out_chunk->Size = size;
+        return true;
+    }
+
+    void ResetChunks()
+    {
+        g_chunkMemory.clear();
+        g_failCreate = false;
+    }
+
+    int Reserve(ImGui_ImplDX12_BufferStream& stream, size_t size, size_t* offset)
+    {
+        return ImGui_ImplDX12_ReserveStream(&stream, size, c_MinChunkSize, CreateChunk, offset);
+    }
+
+    // A frame that outgrows its chunk moves on to a new one twice as large; the next frames reuse them in the same order.
+    void TestGrowth()
+    {
+        ResetChunks();
+        ImGui_ImplDX12_BufferStream stream;
+
+        size_t offset = 1;
+        CHECK(Reserve(stream, 600, &offset) == 0);
+        CHECK(offset == 0);
+        CHECK(stream.Chunks.Size == 1 && stream.Chunks[0].Size == c_MinChunkSize);
+
+        CHECK(Reserve(stream, 400, &offset) == 0);
+        CHECK(offset == 600);
+
+        // 24 bytes are left in the first chunk.
+        CHECK(Reserve(stream, 100, &offset) == 1);
+        CHECK(offset == 0);
+        CHECK(stream.Chunks.Size == 2 && stream.Chunks[1].Size == 2 * c_MinChunkSize);
+
+        CHECK(Reserve(stream, 2000, &offset) == 2);
+        CHECK(stream.Chunks.Size == 3 && stream.Chunks[2].Size == 4 * c_MinChunkSize);
+        CHECK(g_chunkMemory.size() == 3);
+
+        // The same frame again fills the same chunks without creating any.
+        ImGui_ImplDX12_BeginStream(&stream);
+        CHECK(Reserve(stream, 600, &offset) == 0 && offset == 0);
+        CHECK(Reserve(stream, 400, &offset) == 0 && offset == 600);
+        CHECK(Reserve(stream, 100, &offset) == 1 && offset == 0);
+        CHECK(Reserve(stream, 2000, &offset) == 2 && offset == 0);
+        CHECK(g_chunkMemory.size() == 3);
+
+        // A smaller frame leaves the later chunks unused, a reservation never goes back to an earlier chunk.
+        ImGui_ImplDX12_BeginStream(&stream);
+        CHECK(Reserve(stream, 3000, &offset) == 2 && offset == 0);
+        CHECK(Reserve(stream, 10, &offset) == 2 && offset == 3000);
+        CHECK(stream.Chunks.Size == 3);
+    }
+
+    // A reservation larger than the next chunk size doubles it until it fits.
+    void TestOversize()
+    {
+        ResetChunks();
+        ImGui_ImplDX12_BufferStream stream;
+
+        size_t offset = 1;
+        CHECK(Reserve(stream, 10 * c_MinChunkSize, &offset) == 0);
+        CHECK(offset == 0);
+        CHECK(stream.Chunks[0].Size == 16 * c_MinChunkSize);
+
+        CHECK(Reserve(stream, 16 * c_MinChunkSize, &offset) == 1);
+        CHECK(stream.Chunks[1].Size == 32 * c_MinChunkSize);
+
+        CHECK(Reserve(stream, 100 * c_MinChunkSize, &offset) == 2);
+        CHECK(stream.Chunks[2].Size == 128 * c_MinChunkSize);
+
+        // Exactly the size of a chunk fits in it.
+        ImGui_ImplDX12_BeginStream(&stream);
+        CHECK(Reserve(stream, 16 * c_MinChunkSize, &offset) == 0 && offset == 0);
+        CHECK(Reserve(stream, 1, &offset) == 1 && offset == 0);
+        CHECK(stream.Chunks.Size == 3);
+    }
+
+    // A chunk that cannot be created fails the reservation and leaves the stream as it was.
+    void TestCreateFailure()
+    {
+        ResetChunks();
+        ImGui_ImplDX12_BufferStream stream;
+
+        size_t offset = 0;
+        CHECK(Reserve(stream, 100, &offset) == 0);
+
+        g_failCreate = true;
+        CHECK(Reserve(stream, 100, &offset) == 0 && offset == 100);
+        CHECK(Reserve(stream, c_MinChunkSize, &offset) == -1);
+        CHECK(stream.Chunks.Size == 1);
+
+        g_failCreate = false;
+        CHECK(Reserve(stream, c_MinChunkSize, &offset) == 1 && offset == 0);
+        CHECK(stream.Chunks[1].Size == 2 * c_MinChunkSize);
+    }
+
+    void FillDrawList(ImDrawList& drawList, int vertexCount, int indexCount, int seed)
+    {
+        drawList.VtxBuffer.resize(vertexCount);
+        for (int i = 0; i < vertexCount; i++)
+        {
+            drawList.VtxBuffer[i].pos = ImVec2(float(seed), float(i));
+            drawList.VtxBuffer[i].uv = ImVec2(0.f, 0.f);
+            drawList.VtxBuffer[i].col = ImU32(seed);
+        }
+        drawList.IdxBuffer.resize(indexCount);
+        for (int i = 0; i < indexCount; i++)
+        {
+            drawList.IdxBuffer[i] = static_cast<ImDrawIdx>((seed * 7 + i) % vertexCount);
+        }
+    }
+
+    const char* GetCpuAddress(const ImGui_ImplDX12_BufferStream& stream, ImU64 gpuAddress)
+    {
+        for (const ImGui_ImplDX12_BufferChunk& chunk : stream.Chunks)
+        {
+            if (gpuAddress >= chunk.GpuAddress && gpuAddress < chunk.GpuAddress + chunk.Size)
+            {
+                return static_cast<const char*>(chunk.CpuAddress) + (gpuAddress - chunk.GpuAddress);
+            }
+        }
+        CHECK(false);
+        return nullptr;
+    }
+
+    // Consecutive command lists share a segment until either stream moves to another chunk.
+    void TestSegmentSplit()
+    {
+        ResetChunks();
+        ImGui_ImplDX12_BufferStream vertices, indices;
+        ImVector<ImGui_ImplDX12_RenderSegment> segments;
+
+        ImDrawListSharedData sharedData;
+        ImDrawList drawLists[4] = { ImDrawList(&sharedData), ImDrawList(&sharedData), ImDrawList(&sharedData), ImDrawList(&sharedData) };
+
+        // The first vertex chunk holds 5000 vertices and the first index chunk 10000 indices: the third list moves the
+        // vertices to a second chunk, the fourth the indices.
+        const int vertexCounts[4] = { 3000, 1500, 1000, 2000 };
+        const int indexCounts[4] = { 3000, 3000, 3000, 3000 };
+        ImDrawList* cmdLists[4];
+        for (int n = 0; n < 4; n++)
+        {
+            FillDrawList(drawLists[n], vertexCounts[n], indexCounts[n], n + 1);
+            cmdLists[n] = &drawLists[n];
+        }
+
+        ImDrawData drawData;
+        drawData.Valid = true;
+        drawData.CmdLists = cmdLists;
+        drawData.CmdListsCount = 4;
+        drawData.TotalVtxCount = 7500;
+        drawData.TotalIdxCount = 12000;
+
+        CHECK(ImGui_ImplDX12_StreamDrawData(&drawData, &vertices, &indices, CreateChunk, &segments));
+        CHECK(vertices.Chunks.Size == 2 && indices.Chunks.Size == 2);
+        CHECK(vertices.Chunks[0].Size == IMGUI_IMPL_DX12_MIN_VERTEX_CHUNK_SIZE);
+        CHECK(indices.Chunks[0].Size == IMGUI_IMPL_DX12_MIN_INDEX_CHUNK_SIZE);
+
+        CHECK(segments.Size == 3);
+        const int segmentListCounts[3] = { 2, 1, 1 };
+        int n = 0;
+        for (int s = 0; s < segments.Size; s++)
+        {
+            const ImGui_ImplDX12_RenderSegment& segment = segments[s];
+            CHECK(segment.CmdListsCount == segmentListCounts[s]);
+
+            // The lists of a segment are packed back to back from its buffer locations.
+            const char* vertexData = GetCpuAddress(vertices, segment.VertexBufferLocation);
+            const char* indexData = GetCpuAddress(indices, segment.IndexBufferLocation);
+            size_t vertexSize = 0, indexSize = 0;
+            for (int i = 0; i < segment.CmdListsCount; i++, n++)
+            {
+                const ImDrawList& drawList = drawLists[n];
+                CHECK(std::memcmp(vertexData + vertexSize, drawList.VtxBuffer.Data, drawList.VtxBuffer.size_in_bytes()) == 0);
+                CHECK(std::memcmp(indexData + indexSize, drawList.IdxBuffer.Data, drawList.IdxBuffer.size_in_bytes()) == 0);
+                vertexSize += drawList.VtxBuffer.size_in_bytes();
+                indexSize += drawList.IdxBuffer.size_in_bytes();
+            }
+            CHECK(segment.VertexBufferViewSize == vertexSize);
+            CHECK(segment.IndexBufferViewSize == indexSize);
+        }
+        CHECK(n == 4);
+
+        // The second segment continues the first index chunk, the third continues the second vertex chunk.
+        CHECK(segments[0].VertexBufferLocation == vertices.Chunks[0].GpuAddress);
+        CHECK(segments[0].IndexBufferLocation == indices.Chunks[0].GpuAddress);
+        CHECK(segments[1].VertexBufferLocation == vertices.Chunks[1].GpuAddress);
+        CHECK(segments[1].IndexBufferLocation == indices.Chunks[0].GpuAddress + 6000 * sizeof(ImDrawIdx));
+        CHECK(segments[2].VertexBufferLocation == vertices.Chunks[1].GpuAddress + 1000 * sizeof(ImDrawVert));
+        CHECK(segments[2].IndexBufferLocation == indices.Chunks[1].GpuAddress);
+
+        // The next frame starts over in the first chunks and reuses them all.
+        CHECK(ImGui_ImplDX12_StreamDrawData(&drawData, &vertices, &indices, CreateChunk, &segments));
+        CHECK(segments.Size == 3);
+        CHECK(g_chunkMemory.size() == 4);
+
+        // A frame that fits in the first chunks is a single segment.
+        drawData.CmdListsCount = 2;
+        CHECK(ImGui_ImplDX12_StreamDrawData(&drawData, &vertices, &indices, CreateChunk, &segments));
+        CHECK(segments.Size == 1 && segments[0].CmdListsCount == 2);
+
+        drawData.CmdListsCount = 0;
+        CHECK(ImGui_ImplDX12_StreamDrawData(&drawData, &vertices, &indices, CreateChunk, &segments));
+        CHECK(segments.Size == 0);
+    }
+
+    // A chunk that cannot be created drops the whole frame.
+    void TestSegmentCreateFailure()
+    {
+        ResetChunks();
+        ImGui_ImplDX12_BufferStream vertices, indices;
+        ImVector<ImGui_ImplDX12_RenderSegment> segments;
+
+        ImDrawListSharedData sharedData;
+        ImDrawList drawLists[2] = { ImDrawList(&sharedData), ImDrawList(&sharedData) };
+        FillDrawList(drawLists[0], 4000, 6000, 1);
+        FillDrawList(drawLists[1], 4000, 6000, 2);
+        ImDrawList* cmdLists[2] = { &drawLists[0], &drawLists[1] };
+
+        ImDrawData drawData;
+        drawData.Valid = true;
+        drawData.CmdLists = cmdLists;
+        drawData.CmdListsCount = 1;
+        drawData.TotalVtxCount = 4000;
+        drawData.TotalIdxCount = 6000;
+        CHECK(ImGui_ImplDX12_StreamDrawData(&drawData, &vertices, &indices, CreateChunk, &segments));
+        CHECK(segments.Size == 1);
+
+        g_failCreate = true;
+        drawData.CmdListsCount = 2;
+        drawData.TotalVtxCount = 8000;
+        drawData.TotalIdxCount = 12000;
+        CHECK(!ImGui_ImplDX12_StreamDrawData(&drawData, &vertices, &indices, CreateChunk, &segments));
+        CHECK(segments.Size == 0);
+
+        g_failCreate = false;
+        CHECK(ImGui_ImplDX12_StreamDrawData(&drawData, &vertices, &indices, CreateChunk, &segments));
+        CHECK(segments.Size == 2);
+    }
+}
+
+int main()
+{
+    TestGrowth();
+    TestOversize();
+    TestCreateFailure();
+    TestSegmentSplit();
+    TestSegmentCreateFailure();
+
+    ResetChunks();
+    std::puts("ImguiDx12StreamTests: passed");
+    return 0;
+}
@@ -0,0 +1,184 @@
+//
+// ImguiGlyphCacheTests.cpp - Glyphs rasterized on demand by draw lists deferred to the job system
+//
+
+#include "Check.h"
+
+#include "JobSystem.h"
+
+#include "imgui.h"
+#include "backends/imgui_impl_headless.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    // Only ASCII is baked: every other codepoint goes through the glyph cache.
+    const ImWchar c_AsciiRanges[] = { 0x0020, 0x007E, 0 };
+
+    // io.RunDrawListJobsFn on a DX::JobSystem, one job per draw list, as ImguiLayerBase::SetJobSystem sets it up.
+    void RunJobs(void* userData, int count, void (*job)(void* jobData, int index), void* jobData)
+    {
+        static_cast<JobSystem*>(userData)->ParallelFor(size_t(count), 1, [job, jobData](size_t begin, size_t end)
+        {
+            for (size_t index = begin; index < end; index++)
+            {
+                job(jobData, int(index));
+            }
+        });
+    }
+
+    void DrawText(ImDrawList* drawList, void* userData)
+    {
+        drawList->AddText(drawList->GetClipRectMin(), IM_COL32_WHITE, static_cast<const char*>(userData));
+    }
+
+    // A headless context whose default font has a two page glyph cache, with deferred draw lists on a job system.
+    ImFont* CreateContext(JobSystem& jobSystem)
+    {
+        ImGui::CreateContext();
+        ImGuiIO& io = ImGui::GetIO();
+        io.IniFilename = nullptr;
+        io.RunDrawListJobsFn = RunJobs;
+        io.RunDrawListJobsUserData = &jobSystem;
+        io.Fonts->GlyphCachePageCount = 2;
+        io.Fonts->GlyphCachePageSize = 32;
+
+        ImFontConfig config;
+        config.GlyphRanges = c_AsciiRanges;
+        config.DynamicGlyphs = true;
+        ImFont* font = io.Fonts->AddFontDefault(&config);
+        ImGui_ImplHeadless_Init(ImVec2(640.f, 480.f));
+        return font;
+    }
+
+    void DestroyContext()
+    {
+        ImGui_ImplHeadless_Shutdown();
+        ImGui::DestroyContext();
+    }
+
+    // Runs one frame of a window with a line of main thread text and a deferred draw list for each of deferredTexts.
+    void RunFrame(const char* text, const std::vector<const char*>& deferredTexts)
+    {
+        ImGui_ImplHeadless_NewFrame();
+        ImGui::NewFrame();
+        ImGui::SetNextWindowPos(ImVec2(0.f, 0.f), ImGuiCond_Always);
+        ImGui::SetNextWindowSize(ImVec2(400.f, 300.f), ImGuiCond_Always);
+        ImGui::Begin("Glyphs");
+        ImGui::TextUnformatted(text);
+        for (const char* deferredText : deferredTexts)
+        {
+            ImGui::AddDeferredDrawList(DrawText, const_cast<char*>(deferredText));
+        }
+        ImGui::End();
+        ImGui::Render();
+        ImGui_ImplHeadless_RenderDrawData(ImGui::GetDrawData());
+    }
+
+    // The vertices of the first deferred draw list of the last frame.
+    std::vector<ImDrawVert> GetDeferredVertices()
+    {
+        const ImDrawData* drawData = ImGui::GetDrawData();
+        for (int list = 0; list < drawData->CmdListsCount; list++)
+        {
+            const ImDrawList* drawList = drawData->CmdLists[list];
+            if (drawList->_OwnerName != nullptr && std::strcmp(drawList->_OwnerName, "##DeferredDrawList") == 0)
+            {
+                return std::vector<ImDrawVert>(drawList->VtxBuffer.begin(), drawList->VtxBuffer.end());
+            }
+        }
+        return {};
+    }
+
+    bool SameVertices(const std::vector<ImDrawVert>& a, const std::vector<ImDrawVert>& b)
+    {
+        return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(ImDrawVert)) == 0;
+    }
+
+    const ImFontGlyphCachePage& GetPageOf(const ImFont* font, ImWchar codepoint)
+    {
+        const int glyphIndex = font->IndexLookup[codepoint];
+        return font->ContainerAtlas->GlyphCachePages[font->GlyphCachePageOf[glyphIndex - font->GlyphCacheStart]];
+    }
+
+    // A codepoint first drawn by a deferred draw list is rasterized after the jobs, and the list rebuilt with it:
+    // the frame draws what the next ones do, not the fallback glyph.
+    void TestMissingGlyphs(JobSystem& jobSystem)
+    {
+        ImFont* font = CreateContext(jobSystem);
+        const char* const text = "caf\xC3\xA9 \xC3\xBC\xC3\xB1";
+
+        RunFrame("ASCII", { text });
+        CHECK(font->FindGlyphNoFallback(0xE9) != nullptr);
+        CHECK(font->FindGlyphNoFallback(0xFC) != nullptr);
+        CHECK(font->FindGlyphNoFallback(0xF1) != nullptr);
+        const std::vector<ImDrawVert> first = GetDeferredVertices();
+        CHECK(!first.empty());
+
+        const int glyphCount = font->Glyphs.Size;
+        RunFrame("ASCII", { text });
+        CHECK(font->Glyphs.Size == glyphCount);
+        CHECK(SameVertices(GetDeferredVertices(), first));
+
+        DestroyContext();
+    }
+
+    // Pages only deferred draw lists draw from are marked as used this frame, so they are not emptied under them.
+    void TestTouchedPages(JobSystem& jobSystem)
+    {
+        ImFont* font = CreateContext(jobSystem);
+        const ImFontAtlas* atlas = ImGui::GetIO().Fonts;
+
+        RunFrame("ASCII", { "\xC3\xA9" });
+        for (int frame = 0; frame < 3; frame++)
+        {
+            RunFrame("ASCII", { "\xC3\xA9" });
+            CHECK(GetPageOf(font, 0xE9).LastUsedFrame == atlas->GlyphCacheFrame);
+        }
+
+        DestroyContext();
+    }
+
+    // Every list's pages are marked before any list's glyphs are rasterized: glyphs missing from the second list
+    // fill the cache, but never by emptying the page the first list drew from.
+    void TestPagesTouchedBeforeRasterizing(JobSystem& jobSystem)
+    {
+        ImFont* font = CreateContext(jobSystem);
+
+        RunFrame("\xC3\xA9", {});
+        RunFrame("ASCII", {});
+
+        std::string manyGlyphs;
+        for (unsigned codepoint = 0xC0; codepoint <= 0xFF; codepoint++)
+        {
+            if (codepoint != 0xE9)
+            {
+                manyGlyphs += char(0xC0 | (codepoint >> 6));
+                manyGlyphs += char(0x80 | (codepoint & 0x3F));
+            }
+        }
+        RunFrame("ASCII", { "\xC3\xA9", manyGlyphs.c_str() });
+        CHECK(font->FindGlyphNoFallback(0xE9) != nullptr);
+        CHECK(GetPageOf(font, 0xE9).LastUsedFrame == font->ContainerAtlas->GlyphCacheFrame);
+
+        DestroyContext();
+    }
+}
+
+int main()
+{
+    JobSystem jobSystem(3);
+
+    TestMissingGlyphs(jobSystem);
+    TestTouchedPages(jobSystem);
+    TestPagesTouchedBeforeRasterizing(jobSystem);
+
+    std::puts("ImguiGlyphCacheTests: passed");
+    return 0;
+}
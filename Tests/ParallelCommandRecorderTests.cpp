@@ -0,0 +1,210 @@
+//
+// ParallelCommandRecorderTests.cpp - Pooled command contexts recorded on the job system and submitted in pass order
+//
+
+#include "Check.h"
+
+#include "NullRenderBackend.h"
+#include "ParallelCommandRecorder.h"
+
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    // Counts the contexts it creates per frame slot and keeps every batch it is asked to submit.
+    class CountingContextFactory final : public ICommandContextFactory
+    {
+    public:
+        std::unique_ptr<ICommandContext> CreateContext(unsigned int frameIndex, unsigned int slot) override
+        {
+            createdCounts[frameIndex]++;
+            return std::make_unique<NullCommandContext>(frameIndex, slot);
+        }
+
+        void Submit(unsigned int count, ICommandContext* const* contexts) override
+        {
+            submissions.emplace_back(contexts, contexts + count);
+        }
+
+        unsigned int GetCreatedCount() const
+        {
+            unsigned int total = 0;
+            for (const auto count : createdCounts)
+            {
+                total += count;
+            }
+            return total;
+        }
+
+        unsigned int                                createdCounts[FramePacer::c_MaxFramesInFlight] = {};
+        std::vector<std::vector<ICommandContext*>>  submissions;
+    };
+
+    // Each pass draws its own index, so a submitted context can be traced back to the pass that filled it.
+    std::vector<ParallelCommandRecorder::RecordFunction> MakePasses(size_t count)
+    {
+        std::vector<ParallelCommandRecorder::RecordFunction> passes;
+        for (size_t i = 0; i < count; i++)
+        {
+            passes.push_back([i](ICommandContext& context)
+            {
+                context.GetCommandSink()->Draw(static_cast<uint32_t>(i), 1);
+            });
+        }
+        return passes;
+    }
+
+    void CheckSubmission(const std::vector<ICommandContext*>& contexts, unsigned int frameIndex, size_t passCount)
+    {
+        CHECK(contexts.size() == passCount);
+        for (size_t i = 0; i < contexts.size(); i++)
+        {
+            auto context = static_cast<const NullCommandContext*>(contexts[i]);
+            CHECK(context->GetFrameIndex() == frameIndex);
+            CHECK(context->GetSlot() == i);
+
+            const auto& sink = context->GetRecordingSink();
+            CHECK(!sink.IsOpen());
+            CHECK(sink.GetCommands().size() == 1);
+            CHECK(sink.GetCommands()[0].type == CommandType::Draw);
+            CHECK(sink.GetCommands()[0].counts[0] == i);
+        }
+    }
+
+    // Contexts are created the first time a frame slot needs them and reused every time the slot comes round.
+    void TestContextReuse()
+    {
+        CountingContextFactory factory;
+        JobSystem jobSystem(2);
+        ParallelCommandRecorder recorder(&factory, &jobSystem);
+
+        const auto passes = MakePasses(3);
+        std::vector<ICommandContext*> firstContexts[2];
+        for (unsigned int frame = 0; frame < 6; frame++)
+        {
+            const unsigned int frameIndex = frame % 2;
+            recorder.Record(frameIndex, passes.size(), passes.data());
+            recorder.Submit();
+
+            CHECK(factory.submissions.size() == frame + 1);
+            const auto& submitted = factory.submissions.back();
+            CheckSubmission(submitted, frameIndex, passes.size());
+            if (frame < 2)
+            {
+                firstContexts[frameIndex] = submitted;
+            }
+            CHECK(submitted == firstContexts[frameIndex]);
+            CHECK(static_cast<const NullCommandContext*>(submitted[0])->GetBeginCount() == frame / 2 + 1);
+        }
+        CHECK(factory.createdCounts[0] == 3 && factory.createdCounts[1] == 3);
+        CHECK(factory.GetCreatedCount() == 6);
+
+        // More passes only add the missing contexts; fewer leave the rest pooled.
+        const auto morePasses = MakePasses(5);
+        recorder.Record(0, morePasses.size(), morePasses.data());
+        recorder.Submit();
+        CHECK(factory.createdCounts[0] == 5);
+        CheckSubmission(factory.submissions.back(), 0, morePasses.size());
+
+        recorder.Record(0, 1, passes.data());
+        recorder.Submit();
+        CHECK(factory.createdCounts[0] == 5);
+        CheckSubmission(factory.submissions.back(), 0, 1);
+
+        // Submit hands over one recording once.
+        recorder.Submit();
+        CHECK(factory.submissions.size() == 8);
+
+        // After ReleaseContexts, e.g. on device lost, the pool is refilled from the factory.
+        recorder.ReleaseContexts();
+        recorder.Submit();
+        CHECK(factory.submissions.size() == 8);
+        recorder.Record(1, passes.size(), passes.data());
+        CHECK(factory.createdCounts[1] == 6);
+        recorder.Submit();
+        CheckSubmission(factory.submissions.back(), 1, passes.size());
+
+        CHECK_THROWS(recorder.Record(FramePacer::c_MaxFramesInFlight, passes.size(), passes.data()), std::out_of_range);
+        CHECK_THROWS(ParallelCommandRecorder(nullptr, &jobSystem), std::invalid_argument);
+        CHECK_THROWS(ParallelCommandRecorder(&factory, nullptr), std::invalid_argument);
+    }
+
+    // The first pass finishes last, yet is still submitted first.
+    void TestSubmitOrder()
+    {
+        CountingContextFactory factory;
+        JobSystem jobSystem(3);
+        ParallelCommandRecorder recorder(&factory, &jobSystem);
+
+        const size_t passCount = 4;
+        std::atomic<size_t> finishedCount{ 0 };
+        std::mutex finishedMutex;
+        std::vector<size_t> finishOrder;
+        auto finish = [&](size_t pass)
+        {
+            std::lock_guard<std::mutex> lock(finishedMutex);
+            finishOrder.push_back(pass);
+            finishedCount.fetch_add(1);
+        };
+
+        std::vector<ParallelCommandRecorder::RecordFunction> passes;
+        for (size_t i = 0; i < passCount; i++)
+        {
+            passes.push_back([&, i](ICommandContext& context)
+            {
+                // Every other thread keeps taking jobs while this one waits.
+                while (i == 0 && finishedCount.load() != passCount - 1)
+                {
+                    std::this_thread::yield();
+                }
+                context.GetCommandSink()->Draw(static_cast<uint32_t>(i), 1);
+                finish(i);
+            });
+        }
+
+        recorder.Record(0, passes.size(), passes.data());
+        CHECK(finishOrder.size() == passCount);
+        CHECK(finishOrder.back() == 0);
+
+        recorder.Submit();
+        CHECK(factory.submissions.size() == 1);
+        CheckSubmission(factory.submissions.back(), 0, passCount);
+    }
+
+    // A failing pass is rethrown after every pass has finished, with every context closed and nothing to submit.
+    void TestFailedPass()
+    {
+        CountingContextFactory factory;
+        JobSystem jobSystem(2);
+        ParallelCommandRecorder recorder(&factory, &jobSystem);
+
+        auto passes = MakePasses(3);
+        passes[1] = [](ICommandContext&) { throw std::runtime_error("pass failed"); };
+        CHECK_THROWS(recorder.Record(0, passes.size(), passes.data()), std::runtime_error);
+        recorder.Submit();
+        CHECK(factory.submissions.empty());
+
+        // The failed context is reset and reused by the next frame in its slot.
+        passes = MakePasses(3);
+        recorder.Record(0, passes.size(), passes.data());
+        recorder.Submit();
+        CHECK(factory.createdCounts[0] == 3);
+        CheckSubmission(factory.submissions.back(), 0, passes.size());
+    }
+}
+
+int main()
+{
+    TestContextReuse();
+    TestSubmitOrder();
+    TestFailedPass();
+
+    std::puts("ParallelCommandRecorderTests: passed");
+    return 0;
+}
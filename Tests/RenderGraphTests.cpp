@@ -0,0 +1,381 @@
+//
+// RenderGraphTests.cpp - Pass culling, transient aliasing and barrier batching of the render graph
+//
+
+#include "Check.h"
+
+#include "NullRenderBackend.h"
+#include "RenderGraph.h"
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    const ResourceHandle c_BackBuffer = NullRenderBackend::c_backBufferHandleBase;
+    const ResourceHandle c_Transient = NullTransientResourceAllocator::c_transientHandleBase;
+    const uint64_t c_Alignment = NullTransientResourceAllocator::c_placementAlignment;
+
+    // One ICommandSink call: a barrier batch, or the event of a pass.
+    struct SinkCall
+    {
+        std::vector<ResourceBarrier>    barriers;
+        const wchar_t*                  event;
+    };
+
+    // Keeps every barrier batch as it was passed, where RecordingCommandSink splits batches into single commands.
+    class CallRecordingSink final : public ICommandSink
+    {
+    public:
+        void BeginEvent(const wchar_t* name) override { calls.push_back({ {}, name }); }
+        void EndEvent() override {}
+        void ResourceBarriers(uint32_t count, const ResourceBarrier* barriers) override
+        {
+            calls.push_back({ std::vector<ResourceBarrier>(barriers, barriers + count), nullptr });
+        }
+        void SetRenderTarget() override {}
+        void ClearRenderTarget(const float[4]) override {}
+        void ClearDepthStencil(float) override {}
+        void Draw(uint32_t, uint32_t) override {}
+
+        std::vector<SinkCall> calls;
+    };
+
+    class CallRecordingContext final : public ICommandContext
+    {
+    public:
+        void Begin() override { sink.calls.clear(); }
+        void End() override {}
+        ICommandSink* GetCommandSink() noexcept override { return &sink; }
+
+        CallRecordingSink sink;
+    };
+
+    // Appends the calls of submitted contexts in submission order.
+    class CallRecordingFactory final : public ICommandContextFactory
+    {
+    public:
+        std::unique_ptr<ICommandContext> CreateContext(unsigned int, unsigned int) override
+        {
+            return std::make_unique<CallRecordingContext>();
+        }
+
+        void Submit(unsigned int count, ICommandContext* const* contexts) override
+        {
+            for (unsigned int i = 0; i < count; i++)
+            {
+                const auto& sink = static_cast<CallRecordingContext*>(contexts[i])->sink;
+                calls.insert(calls.end(), sink.calls.begin(), sink.calls.end());
+            }
+        }
+
+        std::vector<SinkCall> calls;
+    };
+
+    // A render target of width x height texels, 4 bytes each on the null allocator.
+    TransientResourceDesc RenderTarget(uint32_t width, uint32_t height)
+    {
+        TransientResourceDesc desc = {};
+        desc.type = TransientResourceType::Texture2D;
+        desc.width = width;
+        desc.height = height;
+        desc.format = 28;
+        desc.flags = TransientResourceFlags_RenderTarget;
+        return desc;
+    }
+
+    TransientResourceDesc Buffer(uint32_t size)
+    {
+        TransientResourceDesc desc = {};
+        desc.type = TransientResourceType::Buffer;
+        desc.width = size;
+        desc.flags = TransientResourceFlags_UnorderedAccess;
+        return desc;
+    }
+
+    RenderGraph::ExecuteFunction NoCommands()
+    {
+        return [](ICommandContext&, const RenderGraph&) {};
+    }
+
+    bool IsTransition(const ResourceBarrier& barrier, ResourceHandle resource, ResourceState before, ResourceState after)
+    {
+        return barrier.type == BarrierType::Transition && barrier.resource == resource
+            && barrier.before == before && barrier.after == after;
+    }
+
+    bool IsAliasing(const ResourceBarrier& barrier, ResourceHandle resource)
+    {
+        return barrier.type == BarrierType::Aliasing && barrier.resource == resource;
+    }
+
+    // Passes whose writes nobody reads are culled, along with the passes only they depended on, unless they have a
+    // side effect or write an imported resource.
+    void TestCulling()
+    {
+        NullTransientResourceAllocator allocator;
+        RenderGraph graph;
+
+        const auto backBuffer = graph.ImportResource(L"BackBuffer", c_BackBuffer, ResourceState::Present, ResourceState::Present);
+        const auto scene = graph.CreateTransient(L"Scene", RenderTarget(64, 64));
+        const auto orphan = graph.CreateTransient(L"Orphan", RenderTarget(64, 64));
+        const auto chained = graph.CreateTransient(L"Chained", Buffer(1024));
+        const auto readback = graph.CreateTransient(L"Readback", Buffer(1024));
+
+        const size_t drawScene = graph.AddPass(L"DrawScene",
+            [&](RenderGraphBuilder& builder) { builder.Write(scene, ResourceState::RenderTarget); }, NoCommands());
+        const size_t writeOrphan = graph.AddPass(L"WriteOrphan",
+            [&](RenderGraphBuilder& builder) { builder.Write(orphan, ResourceState::RenderTarget); }, NoCommands());
+        const size_t writeChained = graph.AddPass(L"WriteChained",
+            [&](RenderGraphBuilder& builder) { builder.Write(chained, ResourceState::UnorderedAccess); }, NoCommands());
+        const size_t readChained = graph.AddPass(L"ReadChained",
+            [&](RenderGraphBuilder& builder)
+            {
+                builder.Read(chained, ResourceState::NonPixelShaderResource);
+                builder.Write(orphan, ResourceState::RenderTarget);
+            }, NoCommands());
+        const size_t sideEffect = graph.AddPass(L"SideEffect",
+            [&](RenderGraphBuilder& builder)
+            {
+                builder.Write(readback, ResourceState::CopyDest);
+                builder.SetSideEffect();
+            }, NoCommands());
+        const size_t readOnly = graph.AddPass(L"ReadOnly",
+            [&](RenderGraphBuilder& builder) { builder.Read(scene, ResourceState::PixelShaderResource); }, NoCommands());
+        const size_t present = graph.AddPass(L"Present",
+            [&](RenderGraphBuilder& builder)
+            {
+                builder.Read(scene, ResourceState::PixelShaderResource);
+                builder.Write(backBuffer, ResourceState::RenderTarget);
+            }, NoCommands());
+
+        graph.Compile(&allocator);
+
+        CHECK(graph.GetPassCount() == 7);
+        CHECK(!graph.IsPassCulled(drawScene));
+        CHECK(graph.IsPassCulled(writeOrphan));
+        CHECK(graph.IsPassCulled(writeChained));
+        CHECK(graph.IsPassCulled(readChained));
+        CHECK(!graph.IsPassCulled(sideEffect));
+        CHECK(graph.IsPassCulled(readOnly));
+        CHECK(!graph.IsPassCulled(present));
+        CHECK(graph.GetCulledPassCount() == 4);
+        CHECK_THROWS(graph.IsPassCulled(7), std::out_of_range);
+
+        // Resources of culled passes get no memory.
+        CHECK(graph.GetResource(scene) != 0);
+        CHECK(graph.GetResource(readback) != 0);
+        CHECK_THROWS(graph.GetResource(orphan), std::logic_error);
+        CHECK_THROWS(graph.GetResource(chained), std::logic_error);
+        CHECK(allocator.GetResourceCount() == 2);
+
+        // Only the surviving passes are recorded, in order.
+        CallRecordingFactory factory;
+        JobSystem jobSystem(2);
+        ParallelCommandRecorder recorder(&factory, &jobSystem);
+        CallRecordingSink sink;
+        graph.Execute(recorder, 0, sink);
+
+        std::vector<const wchar_t*> events;
+        for (const auto& call : factory.calls)
+        {
+            if (call.event)
+            {
+                events.push_back(call.event);
+            }
+        }
+        CHECK(events.size() == 3);
+        CHECK(std::wstring(events[0]) == L"DrawScene");
+        CHECK(std::wstring(events[1]) == L"SideEffect");
+        CHECK(std::wstring(events[2]) == L"Present");
+    }
+
+    // A and B live in disjoint runs of passes and share offset 0; C overlaps both and is placed after them.
+    // Transients of the same description at the same offset are one placed resource, with no aliasing barrier.
+    void TestAliasing()
+    {
+        NullTransientResourceAllocator allocator;
+        RenderGraph graph;
+
+        const auto backBuffer = graph.ImportResource(L"BackBuffer", c_BackBuffer, ResourceState::Present, ResourceState::Present);
+        const auto a = graph.CreateTransient(L"A", RenderTarget(256, 256));
+        const auto b = graph.CreateTransient(L"B", RenderTarget(128, 512));
+        const auto c = graph.CreateTransient(L"C", Buffer(1000));
+
+        graph.AddPass(L"WriteA",
+            [&](RenderGraphBuilder& builder) { builder.Write(a, ResourceState::RenderTarget); }, NoCommands());
+        graph.AddPass(L"AToC",
+            [&](RenderGraphBuilder& builder)
+            {
+                builder.Read(a, ResourceState::PixelShaderResource);
+                builder.Write(c, ResourceState::UnorderedAccess);
+            }, NoCommands());
+        graph.AddPass(L"CToB",
+            [&](RenderGraphBuilder& builder)
+            {
+                builder.Read(c, ResourceState::NonPixelShaderResource);
+                builder.Write(b, ResourceState::RenderTarget);
+            }, NoCommands());
+        graph.AddPass(L"BToBackBuffer",
+            [&](RenderGraphBuilder& builder)
+            {
+                builder.Read(b, ResourceState::PixelShaderResource);
+                builder.Write(backBuffer, ResourceState::RenderTarget);
+            }, NoCommands());
+
+        graph.Compile(&allocator);
+
+        const uint64_t textureSize = 256 * 256 * 4;
+        CHECK(graph.GetTransientOffset(a) == 0);
+        CHECK(graph.GetTransientOffset(b) == 0);
+        CHECK(graph.GetTransientOffset(c) == textureSize);
+        CHECK(graph.GetTransientHeapSize() == textureSize + c_Alignment);
+        CHECK(allocator.GetHeapSize() == graph.GetTransientHeapSize());
+
+        CHECK(graph.IsTransientAliased(a));
+        CHECK(graph.IsTransientAliased(b));
+        CHECK(!graph.IsTransientAliased(c));
+        CHECK(graph.GetResource(a) != graph.GetResource(b));
+
+        // The same graph with a B that looks like A: it reuses A's placed resource, and the state A left it in.
+        RenderGraph same;
+        const auto sameA = same.CreateTransient(L"A", RenderTarget(256, 256));
+        const auto sameB = same.CreateTransient(L"B", RenderTarget(256, 256));
+        const auto sameBackBuffer = same.ImportResource(L"BackBuffer", c_BackBuffer, ResourceState::Present, ResourceState::Present);
+        same.AddPass(L"WriteA",
+            [&](RenderGraphBuilder& builder) { builder.Write(sameA, ResourceState::RenderTarget); }, NoCommands());
+        same.AddPass(L"AToBackBuffer",
+            [&](RenderGraphBuilder& builder)
+            {
+                builder.Read(sameA, ResourceState::PixelShaderResource);
+                builder.Write(sameBackBuffer, ResourceState::RenderTarget);
+            }, NoCommands());
+        same.AddPass(L"WriteB",
+            [&](RenderGraphBuilder& builder) { builder.Write(sameB, ResourceState::RenderTarget); }, NoCommands());
+        same.AddPass(L"BToBackBuffer",
+            [&](RenderGraphBuilder& builder)
+            {
+                builder.Read(sameB, ResourceState::PixelShaderResource);
+                builder.Write(sameBackBuffer, ResourceState::RenderTarget);
+            }, NoCommands());
+        same.Compile(&allocator);
+
+        CHECK(same.GetTransientOffset(sameA) == 0 && same.GetTransientOffset(sameB) == 0);
+        CHECK(same.GetResource(sameA) == same.GetResource(sameB));
+        CHECK(!same.IsTransientAliased(sameA) && !same.IsTransientAliased(sameB));
+        // One transition per pass for the shared resource, plus the back buffer's first use and final transition.
+        CHECK(same.GetBarrierCount() == 1 + 2 + 1 + 1 + 1);
+
+        // Two transients written by the same pass overlap in time and never share memory.
+        RenderGraph overlapping;
+        const auto first = overlapping.CreateTransient(L"First", RenderTarget(256, 256));
+        const auto second = overlapping.CreateTransient(L"Second", RenderTarget(128, 128));
+        overlapping.AddPass(L"WriteBoth",
+            [&](RenderGraphBuilder& builder)
+            {
+                builder.Write(first, ResourceState::RenderTarget);
+                builder.Write(second, ResourceState::RenderTarget);
+                builder.SetSideEffect();
+            }, NoCommands());
+        overlapping.Compile(&allocator);
+
+        CHECK(overlapping.GetTransientOffset(first) == 0);
+        CHECK(overlapping.GetTransientOffset(second) == textureSize);
+        CHECK(overlapping.GetTransientHeapSize() == textureSize + 128 * 128 * 4);
+        CHECK(!overlapping.IsTransientAliased(first) && !overlapping.IsTransientAliased(second));
+
+        // Compiling transients without an allocator is a mistake.
+        CHECK_THROWS(overlapping.Compile(nullptr), std::logic_error);
+    }
+
+    // Every transition a pass needs is issued in one ResourceBarriers call in front of the pass, and the final
+    // transitions of imported resources in one call on the frame's sink.
+    void TestBarrierBatching()
+    {
+        NullTransientResourceAllocator allocator;
+        RenderGraph graph;
+
+        const auto backBuffer = graph.ImportResource(L"BackBuffer", c_BackBuffer, ResourceState::Present, ResourceState::Present);
+        const auto a = graph.CreateTransient(L"A", RenderTarget(256, 256));
+        const auto b = graph.CreateTransient(L"B", RenderTarget(128, 512));
+        const auto c = graph.CreateTransient(L"C", Buffer(1000));
+
+        graph.AddPass(L"WriteA",
+            [&](RenderGraphBuilder& builder) { builder.Write(a, ResourceState::RenderTarget); }, NoCommands());
+        graph.AddPass(L"AToC",
+            [&](RenderGraphBuilder& builder)
+            {
+                builder.Read(a, ResourceState::PixelShaderResource);
+                builder.Write(c, ResourceState::UnorderedAccess);
+            }, NoCommands());
+        graph.AddPass(L"CToB",
+            [&](RenderGraphBuilder& builder)
+            {
+                builder.Read(c, ResourceState::NonPixelShaderResource);
+                builder.Write(b, ResourceState::RenderTarget);
+            }, NoCommands());
+        graph.AddPass(L"BToBackBuffer",
+            [&](RenderGraphBuilder& builder)
+            {
+                builder.Read(b, ResourceState::PixelShaderResource);
+                builder.Write(backBuffer, ResourceState::RenderTarget);
+            }, NoCommands());
+
+        graph.Compile(&allocator);
+        CHECK(graph.GetBarrierCount() == 2 + 2 + 3 + 2 + 1);
+
+        const ResourceHandle handleA = graph.GetResource(a);
+        const ResourceHandle handleB = graph.GetResource(b);
+        const ResourceHandle handleC = graph.GetResource(c);
+        CHECK(handleA == c_Transient && handleB == c_Transient + 1 && handleC == c_Transient + 2);
+
+        CallRecordingFactory factory;
+        JobSystem jobSystem(2);
+        ParallelCommandRecorder recorder(&factory, &jobSystem);
+        CallRecordingSink sink;
+        graph.Execute(recorder, 0, sink);
+
+        // Batch, event, batch, event...
+        const auto& calls = factory.calls;
+        CHECK(calls.size() == 8);
+        for (size_t i = 0; i < calls.size(); i += 2)
+        {
+            CHECK(!calls[i].event && calls[i + 1].event);
+        }
+
+        CHECK(calls[0].barriers.size() == 2);
+        CHECK(IsAliasing(calls[0].barriers[0], handleA));
+        CHECK(IsTransition(calls[0].barriers[1], handleA, ResourceState::Common, ResourceState::RenderTarget));
+
+        CHECK(calls[2].barriers.size() == 2);
+        CHECK(IsTransition(calls[2].barriers[0], handleA, ResourceState::RenderTarget, ResourceState::PixelShaderResource));
+        CHECK(IsTransition(calls[2].barriers[1], handleC, ResourceState::Common, ResourceState::UnorderedAccess));
+
+        CHECK(calls[4].barriers.size() == 3);
+        CHECK(IsTransition(calls[4].barriers[0], handleC, ResourceState::UnorderedAccess, ResourceState::NonPixelShaderResource));
+        CHECK(IsAliasing(calls[4].barriers[1], handleB));
+        CHECK(IsTransition(calls[4].barriers[2], handleB, ResourceState::Common, ResourceState::RenderTarget));
+
+        CHECK(calls[6].barriers.size() == 2);
+        CHECK(IsTransition(calls[6].barriers[0], handleB, ResourceState::RenderTarget, ResourceState::PixelShaderResource));
+        CHECK(IsTransition(calls[6].barriers[1], c_BackBuffer, ResourceState::Present, ResourceState::RenderTarget));
+
+        CHECK(sink.calls.size() == 1);
+        CHECK(sink.calls[0].barriers.size() == 1);
+        CHECK(IsTransition(sink.calls[0].barriers[0], c_BackBuffer, ResourceState::RenderTarget, ResourceState::Present));
+    }
+}
+
+int main()
+{
+    TestCulling();
+    TestAliasing();
+    TestBarrierBatching();
+
+    std::puts("RenderGraphTests: passed");
+    return 0;
+}
@@ -0,0 +1,161 @@
+//
+// StepTimerTests.cpp - Fixed timestep updates driven by a replayed clock
+//
+
+#include "Check.h"
+
+#include "StepTimer.h"
+
+#include <cmath>
+
+using namespace DX;
+
+namespace
+{
+    // 60 updates per second, in StepTimer ticks. ReplayClock's default frequency is StepTimer's tick rate.
+    const uint64_t c_Step = 166667;
+
+    // Queues one delta and ticks the timer, returning the number of updates it ran.
+    uint32_t Tick(StepTimer& timer, ReplayClock& clock, uint64_t delta)
+    {
+        uint32_t updateCount = 0;
+        clock.Queue(delta);
+        timer.Tick([&]() { updateCount++; });
+        return updateCount;
+    }
+
+    bool IsNear(double value, double expected)
+    {
+        return std::fabs(value - expected) < 1e-12;
+    }
+
+    // Without a cap every whole step of a long frame is updated; the rest is the interpolation alpha.
+    void TestUncapped()
+    {
+        ReplayClock clock;
+        StepTimer timer(&clock);
+        timer.SetFixedTimeStep(true);
+        timer.SetTargetElapsedTicks(c_Step);
+
+        CHECK(Tick(timer, clock, 510000) == 3);
+        CHECK(timer.GetFrameCount() == 3);
+        CHECK(timer.GetElapsedTicks() == c_Step);
+        CHECK(timer.GetDroppedTicks() == 0);
+        CHECK(IsNear(timer.GetInterpolationAlpha(), double(510000 - 3 * c_Step) / double(c_Step)));
+
+        // The left over time counts towards the next step.
+        CHECK(Tick(timer, clock, c_Step - 10000) == 0);
+        CHECK(Tick(timer, clock, 2) == 1);
+        CHECK(IsNear(timer.GetInterpolationAlpha(), 1.0 / double(c_Step)));
+    }
+
+    // The cap bounds the updates per Tick and drops whole steps of the backlog, keeping the phase of the next step.
+    void TestCapped()
+    {
+        ReplayClock clock;
+        StepTimer timer(&clock);
+        timer.SetFixedTimeStep(true);
+        timer.SetTargetElapsedTicks(c_Step);
+        timer.SetMaxUpdatesPerTick(2);
+
+        // A hitch of six steps less two ticks: two updates, three steps dropped, the rest kept.
+        const uint64_t hitch = 6 * c_Step - 2;
+        CHECK(Tick(timer, clock, hitch) == 2);
+        CHECK(timer.GetDroppedTicks() == 3 * c_Step);
+        CHECK(IsNear(timer.GetInterpolationAlpha(), double(c_Step - 2) / double(c_Step)));
+
+        // Without the adaptive timestep the step never changes.
+        CHECK(timer.GetCurrentTargetElapsedTicks() == c_Step);
+
+        CHECK(Tick(timer, clock, c_Step) == 1);
+        CHECK(Tick(timer, clock, 10) == 1);
+        CHECK(timer.GetDroppedTicks() == 3 * c_Step);
+        CHECK(timer.GetFrameCount() == 4);
+    }
+
+    // Sustained overload lengthens the step until the cap keeps up, and calm Ticks shorten it back.
+    void TestAdaptive()
+    {
+        ReplayClock clock;
+        StepTimer timer(&clock);
+        timer.SetFixedTimeStep(true);
+        timer.SetTargetElapsedTicks(c_Step);
+        timer.SetMaxUpdatesPerTick(2);
+        timer.SetAdaptiveTimeStep(true, 3 * c_Step);
+
+        // Every frame takes three steps: the step grows by a quarter after each run of overloaded Ticks.
+        for (uint32_t i = 1; i < StepTimer::c_OverloadedTicksBeforeSlowdown; i++)
+        {
+            CHECK(Tick(timer, clock, 3 * c_Step) == 2);
+        }
+        CHECK(timer.GetCurrentTargetElapsedTicks() == c_Step);
+        CHECK(timer.GetDroppedTicks() > 0);
+
+        Tick(timer, clock, 3 * c_Step);
+        CHECK(timer.GetCurrentTargetElapsedTicks() == c_Step * 5 / 4);
+
+        for (uint32_t i = 0; i < StepTimer::c_OverloadedTicksBeforeSlowdown; i++)
+        {
+            Tick(timer, clock, 3 * c_Step);
+        }
+        const uint64_t slowStep = c_Step * 5 / 4 * 5 / 4;
+        CHECK(timer.GetCurrentTargetElapsedTicks() == slowStep);
+
+        // Two of the longer steps cover a frame, so nothing is dropped any more and the step stays.
+        const uint64_t droppedTicks = timer.GetDroppedTicks();
+        for (int i = 0; i < 100; i++)
+        {
+            CHECK(Tick(timer, clock, 3 * c_Step) <= 2);
+            CHECK(timer.GetCurrentTargetElapsedTicks() == slowStep);
+        }
+        CHECK(timer.GetDroppedTicks() == droppedTicks);
+        CHECK(timer.GetElapsedTicks() == slowStep);
+
+        // The load goes away: the step shortens by a fifth once the Ticks have been calm for long enough.
+        uint32_t calmTicks = 0;
+        while (timer.GetCurrentTargetElapsedTicks() == slowStep)
+        {
+            Tick(timer, clock, c_Step);
+            calmTicks++;
+            CHECK(calmTicks < 1000);
+        }
+        CHECK(calmTicks >= StepTimer::c_CalmTicksBeforeSpeedup);
+        CHECK(timer.GetCurrentTargetElapsedTicks() == slowStep * 4 / 5);
+
+        for (int i = 0; i < 1000; i++)
+        {
+            Tick(timer, clock, c_Step);
+        }
+        CHECK(timer.GetCurrentTargetElapsedTicks() == c_Step);
+        CHECK(timer.GetDroppedTicks() == droppedTicks);
+    }
+
+    // Variable timestep mode updates once per Tick with the real delta, and never interpolates.
+    void TestVariable()
+    {
+        ReplayClock clock(ReplayClock::c_DefaultFrequency, c_Step);
+        StepTimer timer(&clock);
+
+        CHECK(Tick(timer, clock, 123456) == 1);
+        CHECK(timer.GetElapsedTicks() == 123456);
+        CHECK(timer.GetInterpolationAlpha() == 1.0);
+
+        // A delta over a tenth of a second is clamped, and reported as such.
+        CHECK(Tick(timer, clock, 3 * StepTimer::TicksPerSecond) == 1);
+        CHECK(timer.GetElapsedTicks() == StepTimer::TicksPerSecond / 10);
+        CHECK(timer.GetRawElapsedTicks() == 3 * StepTimer::TicksPerSecond);
+        CHECK(timer.WasLastDeltaClamped());
+        CHECK(timer.GetClampedDeltaCount() == 1);
+    }
+}
+
+int main()
+{
+    TestUncapped();
+    TestCapped();
+    TestAdaptive();
+    TestVariable();
+
+    std::puts("StepTimerTests: passed");
+    return 0;
+}
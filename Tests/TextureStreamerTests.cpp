@@ -0,0 +1,328 @@
+//
+// TextureStreamerTests.cpp - Streaming textures through the null backend against a simulated fence
+//
+
+#include "Check.h"
+
+#include "FenceRingAllocator.h"
+#include "NullRenderBackend.h"
+#include "TextureStreamer.h"
+
+#include <chrono>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    // Every default-sized image takes one placement of the null backend.
+    const uint64_t c_TextureSize = NullTextureStreamingBackend::c_placementAlignment;
+
+    // A streamer on the null backend, driven the way the frame loop drives it: retire the upload ring,
+    // update the streamer while the frame is recorded, then tag the frame's staging memory and signal its fence.
+    class StreamerFixture
+    {
+    public:
+        explicit StreamerFixture(uint64_t fenceLatency = 1, uint64_t ringSize = 256 * 1024) :
+            fence(fenceLatency),
+            memory(ringSize),
+            jobSystem(2),
+            backend(&uploadRing),
+            currentFenceValue(1)
+        {
+            uploadRing.Initialize(memory.data(), 0x10000, memory.size());
+            streamer = std::make_unique<TextureStreamer>(&backend, &jobSystem, &uploadRing, 16);
+        }
+
+        void RunFrame()
+        {
+            uploadRing.Retire(fence.GetCompletedValue());
+            streamer->Update(fence.GetCompletedValue(), currentFenceValue);
+            uploadRing.Finish(currentFenceValue);
+            fence.Signal(currentFenceValue);
+            currentFenceValue++;
+        }
+
+        // Decodes finish on the workers, so frames run until the condition holds, with a bound against hanging.
+        void RunUntil(const std::function<bool()>& condition)
+        {
+            for (int frame = 0; !condition(); frame++)
+            {
+                CHECK(frame < 10000);
+                RunFrame();
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        }
+
+        void RunUntilState(TextureStreamer::TextureId texture, StreamedTextureState state)
+        {
+            RunUntil([&]() { return streamer->GetState(texture) == state; });
+        }
+
+        SimulatedFence                      fence;
+        std::vector<uint8_t>                memory;
+        UploadRing                          uploadRing;
+        JobSystem                           jobSystem;
+        NullTextureStreamingBackend         backend;
+        std::unique_ptr<TextureStreamer>    streamer;
+        uint64_t                            currentFenceValue;
+    };
+
+    // Images that decoded but do not fit the budget give up their decode slots to a higher priority request,
+    // which then evicts the lower priority resident texture.
+    void TestPriorityNotStarved()
+    {
+        StreamerFixture fixture;
+        auto& streamer = *fixture.streamer;
+        streamer.SetMemoryBudget(c_TextureSize);
+
+        const auto resident = streamer.Request(L"resident.png", 5);
+        fixture.RunUntilState(resident, StreamedTextureState::Resident);
+
+        std::vector<TextureStreamer::TextureId> parked;
+        for (const auto path : { L"parked0.png", L"parked1.png", L"parked2.png", L"parked3.png" })
+        {
+            parked.push_back(streamer.Request(path, 0));
+        }
+        fixture.RunUntil([&]()
+        {
+            for (const auto texture : parked)
+            {
+                if (streamer.GetState(texture) != StreamedTextureState::Decoded)
+                    return false;
+            }
+            return true;
+        });
+
+        const auto urgent = streamer.Request(L"urgent.png", 10);
+        fixture.RunUntilState(urgent, StreamedTextureState::Resident);
+        CHECK(streamer.GetState(resident) == StreamedTextureState::Evicted);
+        CHECK(streamer.GetEvictionCount() == 1);
+        CHECK(streamer.GetRequeueCount() == 1);
+        CHECK(streamer.GetResidentBytes() == c_TextureSize);
+        CHECK(fixture.backend.GetPublishedTexture(streamer.GetDescriptorSlot(urgent)) != 0);
+
+        // The requeued image decodes again once a slot is free, and parks like the others.
+        fixture.RunUntil([&]()
+        {
+            for (const auto texture : parked)
+            {
+                if (streamer.GetState(texture) != StreamedTextureState::Decoded)
+                    return false;
+            }
+            return true;
+        });
+        CHECK(fixture.backend.GetDecodeCount() == 7);
+        CHECK(streamer.GetDescriptorSlot(parked[0]) == TextureStreamer::c_PlaceholderSlot);
+    }
+
+    // A lowered budget evicts the lowest priority first, the most recently requested among equals.
+    void TestEvictionOrder()
+    {
+        StreamerFixture fixture;
+        auto& streamer = *fixture.streamer;
+        streamer.SetMemoryBudget(4 * c_TextureSize);
+
+        const TextureStreamer::TextureId textures[] =
+        {
+            streamer.Request(L"high.png", 3),
+            streamer.Request(L"low0.png", 1),
+            streamer.Request(L"middle.png", 2),
+            streamer.Request(L"low1.png", 1),
+        };
+        fixture.RunUntil([&]()
+        {
+            for (const auto texture : textures)
+            {
+                if (!streamer.IsResident(texture))
+                    return false;
+            }
+            return true;
+        });
+        CHECK(streamer.GetResidentBytes() == 4 * c_TextureSize);
+
+        const size_t evictionOrder[] = { 3, 1, 2 };
+        for (size_t i = 0; i < 3; i++)
+        {
+            streamer.SetMemoryBudget((3 - i) * c_TextureSize);
+            fixture.RunFrame();
+            CHECK(streamer.GetEvictionCount() == i + 1);
+            CHECK(streamer.GetResidentBytes() == (3 - i) * c_TextureSize);
+            for (size_t j = 0; j <= i; j++)
+            {
+                CHECK(streamer.GetState(textures[evictionOrder[j]]) == StreamedTextureState::Evicted);
+                CHECK(streamer.GetDescriptorSlot(textures[evictionOrder[j]]) == TextureStreamer::c_PlaceholderSlot);
+            }
+        }
+        CHECK(streamer.IsResident(textures[0]));
+    }
+
+    // An evicted texture keeps its resource, and a reload its slot, until the frame that evicted it completes.
+    void TestReloadWaitsForFence()
+    {
+        StreamerFixture fixture(3);
+        auto& streamer = *fixture.streamer;
+
+        const auto texture = streamer.Request(L"reloaded.png");
+        fixture.RunUntilState(texture, StreamedTextureState::Resident);
+        const uint32_t slot = streamer.GetDescriptorSlot(texture);
+        const ResourceHandle oldResource = fixture.backend.GetPublishedTexture(slot);
+        CHECK(fixture.backend.GetTextureCount() == 1);
+
+        streamer.SetMemoryBudget(0);
+        const uint64_t evictedFenceValue = fixture.currentFenceValue;
+        fixture.RunFrame();
+        CHECK(streamer.GetState(texture) == StreamedTextureState::Evicted);
+
+        streamer.SetMemoryBudget(c_TextureSize);
+        CHECK(streamer.Request(L"reloaded.png") == texture);
+        const uint64_t decodes = fixture.backend.GetDecodeCount();
+        while (fixture.fence.GetCompletedValue() < evictedFenceValue)
+        {
+            CHECK(streamer.GetState(texture) == StreamedTextureState::Queued);
+            CHECK(fixture.backend.GetDecodeCount() == decodes);
+            CHECK(fixture.backend.GetTextureCount() == 1);
+            CHECK(fixture.backend.GetPublishedTexture(slot) == oldResource);
+            fixture.RunFrame();
+        }
+
+        fixture.RunUntilState(texture, StreamedTextureState::Resident);
+        CHECK(fixture.backend.GetDecodeCount() == decodes + 1);
+        CHECK(fixture.backend.GetTextureCount() == 1);
+        CHECK(fixture.backend.GetPublishedTexture(slot) != oldResource);
+        CHECK(streamer.GetDescriptorSlot(texture) == slot);
+    }
+
+    // The per-frame upload budget splits a texture's rows across frames; it is published after the last one.
+    void TestUploadSplitAcrossFrames()
+    {
+        StreamerFixture fixture;
+        auto& streamer = *fixture.streamer;
+
+        // Rows of 1024 bytes are already pitch aligned: 16 rows a frame, 4 frames for 64 rows.
+        fixture.backend.SetImageSize(L"wide.png", 256, 64);
+        streamer.SetUploadBytesPerFrame(16 * 1024);
+
+        const auto texture = streamer.Request(L"wide.png");
+        fixture.RunUntilState(texture, StreamedTextureState::Uploading);
+        CHECK(fixture.backend.GetCopyCount() == 1);
+        CHECK(streamer.GetUploadedBytes() == 16 * 1024);
+
+        for (uint64_t frame = 2; frame <= 4; frame++)
+        {
+            CHECK(streamer.GetDescriptorSlot(texture) == TextureStreamer::c_PlaceholderSlot);
+            fixture.RunFrame();
+            CHECK(fixture.backend.GetCopyCount() == frame);
+            CHECK(streamer.GetUploadedBytes() == frame * 16 * 1024);
+        }
+        CHECK(streamer.IsResident(texture));
+        CHECK(fixture.backend.GetPublishedTexture(streamer.GetDescriptorSlot(texture)) != 0);
+
+        // A single row larger than the budget still uploads, one row a frame.
+        fixture.backend.SetImageSize(L"rows.png", 256, 2);
+        streamer.SetUploadBytesPerFrame(100);
+        const auto rows = streamer.Request(L"rows.png");
+        fixture.RunUntilState(rows, StreamedTextureState::Uploading);
+        fixture.RunFrame();
+        CHECK(streamer.IsResident(rows));
+        CHECK(fixture.backend.GetCopyCount() == 6);
+    }
+
+    // A texture that fails to decode or could never fit is marked failed and gives its decode slot back.
+    void TestFailures()
+    {
+        StreamerFixture fixture;
+        auto& streamer = *fixture.streamer;
+        streamer.SetMaxPendingDecodes(1);
+        streamer.SetMemoryBudget(c_TextureSize);
+
+        const auto missing = streamer.Request(L"missing.ttex", 2);
+        fixture.backend.SetImageSize(L"huge.png", 256, 128);
+        const auto huge = streamer.Request(L"huge.png", 1);
+        const auto fine = streamer.Request(L"fine.png");
+
+        fixture.RunUntilState(fine, StreamedTextureState::Resident);
+        CHECK(streamer.GetState(missing) == StreamedTextureState::Failed);
+        CHECK(streamer.GetState(huge) == StreamedTextureState::Failed);
+        CHECK(streamer.GetDescriptorSlot(huge) == TextureStreamer::c_PlaceholderSlot);
+        CHECK(fixture.backend.GetTextureCount() == 1);
+
+        // Requested again, a failed texture is retried.
+        CHECK(streamer.Request(L"missing.ttex") == missing);
+        CHECK(streamer.GetState(missing) == StreamedTextureState::Queued);
+        fixture.RunUntilState(missing, StreamedTextureState::Failed);
+        CHECK(fixture.backend.GetDecodeCount() == 4);
+
+        TextureStreamer limited(&fixture.backend, &fixture.jobSystem, &fixture.uploadRing, 1);
+        limited.Request(L"one.png");
+        CHECK_THROWS(limited.Request(L"two.png"), std::out_of_range);
+        CHECK_THROWS(TextureStreamer(nullptr, &fixture.jobSystem, &fixture.uploadRing, 1), std::invalid_argument);
+    }
+
+    // Allocations never straddle the end of the ring, and space comes back exactly as fence values complete.
+    void TestFenceRingAllocator()
+    {
+        FenceRingAllocator ring(100);
+        CHECK(ring.Allocate(60) == 0);
+        ring.Finish(1);
+        CHECK(ring.Allocate(30) == 60);
+        ring.Finish(2);
+
+        // 10 bytes are left at the end, and the start is still in use.
+        CHECK(ring.Allocate(20) == FenceRingAllocator::c_InvalidOffset);
+        CHECK(ring.GetUsedSize() == 90);
+
+        // Once fence 1 completes the allocation skips the tail and starts over at 0.
+        ring.Retire(1);
+        CHECK(ring.GetUsedSize() == 30);
+        CHECK(ring.Allocate(20) == 0);
+        CHECK(ring.GetWrapCount() == 1);
+        CHECK(ring.GetUsedSize() == 30 + 10 + 20);
+        ring.Finish(3);
+
+        // The rest of the ring up to fence 2's allocation.
+        CHECK(ring.Allocate(40) == 20);
+        CHECK(ring.GetFreeSize() == 0);
+        CHECK(ring.Allocate(1) == FenceRingAllocator::c_InvalidOffset);
+        ring.Finish(4);
+
+        // Fence 2 frees only its own bytes; the skipped tail belongs to fence 3.
+        ring.Retire(2);
+        CHECK(ring.GetUsedSize() == 70);
+        ring.Retire(3);
+        CHECK(ring.GetUsedSize() == 40);
+        CHECK(ring.Allocate(10) == 60);
+        CHECK_THROWS(ring.Finish(3), std::logic_error);
+        ring.Finish(5);
+
+        ring.Retire(4);
+        CHECK(ring.GetUsedSize() == 10);
+        ring.Retire(5);
+        CHECK(ring.GetUsedSize() == 0);
+        CHECK(ring.Allocate(100, 64) == 0);
+        ring.Reset();
+
+        CHECK(ring.Allocate(10) == 0);
+        CHECK(ring.Allocate(10, 16) == 16);
+        CHECK(ring.GetUsedSize() == 26);
+        CHECK_THROWS(ring.Allocate(10, 3), std::invalid_argument);
+        CHECK(ring.Allocate(0) == FenceRingAllocator::c_InvalidOffset);
+        CHECK(ring.Allocate(101) == FenceRingAllocator::c_InvalidOffset);
+    }
+}
+
+int main()
+{
+    TestPriorityNotStarved();
+    TestEvictionOrder();
+    TestReloadWaitsForFence();
+    TestUploadSplitAcrossFrames();
+    TestFailures();
+    TestFenceRingAllocator();
+
+    std::puts("TextureStreamerTests: passed");
+    return 0;
+}
@@ -0,0 +1,203 @@
+//
+// UploadRingTests.cpp - Upload sub-allocation retired by simulated fence values
+//
+
+#include "Check.h"
+
+#include "NullRenderBackend.h"
+#include "UploadRing.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    const uint64_t c_GpuBase = 0x10000;
+
+    // The frame loop's order: retire what the GPU finished, record, then tag the frame and signal its fence.
+    struct Frame
+    {
+        UploadRing&     ring;
+        SimulatedFence& fence;
+        uint64_t        fenceValue;
+
+        Frame(UploadRing& ring_, SimulatedFence& fence_, uint64_t fenceValue_) :
+            ring(ring_), fence(fence_), fenceValue(fenceValue_)
+        {
+            ring.Retire(fence.GetCompletedValue());
+        }
+
+        ~Frame()
+        {
+            ring.Finish(fenceValue);
+            fence.Signal(fenceValue);
+        }
+    };
+
+    void CheckAllocation(const UploadAllocation& allocation, const std::vector<uint8_t>& memory, uint64_t offset, uint64_t size)
+    {
+        CHECK(allocation);
+        CHECK(allocation.offset == offset);
+        CHECK(allocation.cpuAddress == memory.data() + offset);
+        CHECK(allocation.gpuAddress == c_GpuBase + offset);
+        CHECK(allocation.offset + size <= memory.size());
+    }
+
+    // Padding to the alignment counts as used until the allocation's frame retires.
+    void TestAlignment()
+    {
+        std::vector<uint8_t> memory(1024);
+        UploadRing ring;
+        ring.Initialize(memory.data(), c_GpuBase, memory.size());
+
+        CheckAllocation(ring.Allocate(10, 1), memory, 0, 10);
+        CheckAllocation(ring.Allocate(16, 256), memory, 256, 16);
+        CHECK(ring.GetUsedSize() == 272);
+        CheckAllocation(ring.Allocate(1, 4), memory, 272, 1);
+        CheckAllocation(ring.Allocate(8, 8), memory, 280, 8);
+        CHECK(ring.GetUsedSize() == 288);
+
+        CHECK_THROWS(ring.Allocate(16, 3), std::invalid_argument);
+        CHECK_THROWS(ring.Allocate(16, 0), std::invalid_argument);
+
+        // Larger than the ring, or empty: never fits.
+        CHECK(!ring.TryAllocate(2048, 1));
+        CHECK(!ring.TryAllocate(0, 1));
+        CHECK(ring.GetFailedAllocationCount() == 2);
+
+        CHECK_THROWS(ring.Initialize(nullptr, c_GpuBase, 1024), std::invalid_argument);
+        CHECK_THROWS(ring.Initialize(memory.data(), c_GpuBase, 0), std::invalid_argument);
+    }
+
+    // With the GPU two frames behind, an allocation that does not fit before the end of the ring waits for the
+    // start to retire, then skips the tail rather than wrapping. Retire frees exactly the completed frames.
+    void TestFrames()
+    {
+        std::vector<uint8_t> memory(1024);
+        UploadRing ring;
+        ring.Initialize(memory.data(), c_GpuBase, memory.size());
+        SimulatedFence fence(2);
+
+        {
+            Frame frame(ring, fence, 1);
+            CheckAllocation(ring.Allocate(400, 16), memory, 0, 400);
+        }
+        {
+            Frame frame(ring, fence, 2);
+            CheckAllocation(ring.Allocate(400, 16), memory, 400, 400);
+        }
+        CHECK(fence.GetCompletedValue() == 0);
+
+        // 224 bytes are left at the end, and nothing at the start has retired.
+        {
+            Frame frame(ring, fence, 3);
+            CHECK(!ring.TryAllocate(300, 16));
+            CHECK_THROWS(ring.Allocate(300, 16), std::length_error);
+            CHECK(ring.GetFailedAllocationCount() == 2);
+            CHECK(ring.GetUsedSize() == 800);
+        }
+        CHECK(fence.GetCompletedValue() == 1);
+
+        // Frame 1 retired: the allocation starts over at 0, and the skipped tail is charged to this frame.
+        {
+            Frame frame(ring, fence, 4);
+            CHECK(ring.GetUsedSize() == 400);
+            CheckAllocation(ring.Allocate(300, 16), memory, 0, 300);
+            CHECK(ring.GetUsedSize() == 400 + 224 + 300);
+        }
+        CHECK(fence.GetCompletedValue() == 2);
+
+        // Frame 2 retired: what is left between this frame's head and frame 4's start fills the ring.
+        {
+            Frame frame(ring, fence, 5);
+            CHECK(ring.GetUsedSize() == 224 + 300);
+            CheckAllocation(ring.Allocate(500, 4), memory, 300, 500);
+            CHECK(ring.GetUsedSize() == memory.size());
+            CHECK(ring.GetPeakUsedSize() == memory.size());
+            CHECK(!ring.TryAllocate(1, 1));
+        }
+        CHECK(fence.GetCompletedValue() == 3);
+
+        // Frame 3 allocated nothing, so nothing is freed until frame 4 completes, and then only frame 4.
+        ring.Retire(3);
+        CHECK(ring.GetUsedSize() == memory.size());
+        fence.Complete(4);
+        ring.Retire(fence.GetCompletedValue());
+        CHECK(ring.GetUsedSize() == 500);
+
+        // Fence values of frames must not go back.
+        ring.Allocate(4, 4);
+        CHECK_THROWS(ring.Finish(4), std::logic_error);
+        ring.Finish(6);
+        fence.Signal(6);
+
+        // Once everything has retired the whole ring is one free block again, from offset 0.
+        fence.Complete(6);
+        ring.Retire(fence.GetCompletedValue());
+        CHECK(ring.GetUsedSize() == 0);
+        CheckAllocation(ring.Allocate(memory.size(), 256), memory, 0, memory.size());
+
+        // Reset forgets the memory.
+        ring.Reset();
+        CHECK(ring.GetCapacity() == 0);
+        CHECK(!ring.TryAllocate(1, 1));
+    }
+
+    // Passes record in parallel and allocate from the same ring: no two allocations overlap.
+    void TestConcurrentAllocation()
+    {
+        const unsigned threadCount = 4;
+        const size_t allocationsPerThread = 200;
+        std::vector<uint8_t> memory(threadCount * allocationsPerThread * 32);
+        UploadRing ring;
+        ring.Initialize(memory.data(), c_GpuBase, memory.size());
+
+        std::vector<std::vector<UploadAllocation>> allocations(threadCount);
+        std::vector<std::thread> threads;
+        for (unsigned thread = 0; thread < threadCount; thread++)
+        {
+            threads.emplace_back([&, thread]()
+            {
+                for (size_t i = 0; i < allocationsPerThread; i++)
+                {
+                    allocations[thread].push_back(ring.Allocate(20, 16));
+                }
+            });
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+
+        std::vector<uint64_t> offsets;
+        for (const auto& threadAllocations : allocations)
+        {
+            for (const auto& allocation : threadAllocations)
+            {
+                CHECK(allocation.offset % 16 == 0);
+                offsets.push_back(allocation.offset);
+            }
+        }
+        std::sort(offsets.begin(), offsets.end());
+        for (size_t i = 1; i < offsets.size(); i++)
+        {
+            CHECK(offsets[i] >= offsets[i - 1] + 20);
+        }
+        CHECK(offsets.back() + 20 <= memory.size());
+        CHECK(ring.GetUsedSize() == (offsets.size() - 1) * 32 + 20);
+    }
+}
+
+int main()
+{
+    TestAlignment();
+    TestFrames();
+    TestConcurrentAllocation();
+
+    std::puts("UploadRingTests: passed");
+    return 0;
+}